@@ -0,0 +1,23 @@
+Battleships
+Made by bap generate
+10x10  1 2 3 4
+
+  - - - - - - - - - -
+ |                   |1
+ |                   |0
+ |            <      |7
+ |                   |1
+ |                  .|2
+ |                   |2
+ |          O        |1
+ |                   |2
+ |                   |0
+ |      <   +        |4
+  - - - - - - - - - -
+  4 0 2 3 2 2 2 1 3 1
+
+  <++>
+  <+>  <+>
+  <>  <>  <>
+  O  O  O  O
+end
@@ -0,0 +1,23 @@
+Battleships
+Made by bap generate
+10x10  1 2 3 4
+
+  - - - - - - - - - -
+ |                   |2
+ |          <        |2
+ |                   |1
+ |                   |1
+ |            .      |4
+ |  +                |2
+ |                >  |4
+ |                   |2
+ |                   |1
+ |                   |1
+  - - - - - - - - - -
+  1 4 0 4 0 2 2 2 1 4
+
+  <++>
+  <+>  <+>
+  <>  <>  <>
+  O  O  O  O
+end
@@ -0,0 +1,23 @@
+Battleships
+Made by bap generate
+10x10  1 2 3 4
+
+  - - - - - - - - - -
+ |.         <        |7
+ |                   |0
+ |                   |0
+ |                   |4
+ |                   |0
+ |                   |1
+ |                  O|3
+ |.                  |1
+ |                   |1
+ |                   |3
+  - - - - - - - - - -
+  1 2 1 1 2 4 1 3 3 2
+
+  <++>
+  <+>  <+>
+  <>  <>  <>
+  O  O  O  O
+end
@@ -38,6 +38,58 @@ grids can be handled by changing some of the #defines.
 The puzzle statement can have water and/or known ship parts in it,
 but not unknown ship parts.
 
+When guessing, each guess is normally tried on a fresh copy of the
+world. If the --trail argument is given, each guess is instead tried in
+place on the one world, and the changes it led to are undone afterwards
+from a trail of old values (see try_guess_in_place).
+
+Besides the array of squares, the world keeps bit masks of the ship
+parts and water in each row and column (see set_square). These are used
+to reject ship placements quickly (bits_fit_row_col, bits_fit_col_row)
+and to find blank squares no ship can cover (try_square_blank). The
+--no-bits argument makes these checks look at squares one at a time,
+as before, which gives the same answers more slowly.
+
+If "-j N" is given with N greater than 1, the search is shared among N
+threads (see run_pool). Guesses near the top of the search tree become
+tasks on per-thread queues, and idle threads take tasks from the queues
+of busy ones. With "all", the answers are printed in the same order as
+with one thread.
+
+States from which guessing has failed are recorded in a transposition
+table keyed by a Zobrist hash of the squares and the ship counters (see
+try_guessing), so that the same state reached by another order of
+guesses is not searched again. --table=N sets the size of the table in
+megabytes (0 for none), --replace=always|shallow sets which key is kept
+when two want the same slot, and --stats prints how often the table was
+used.
+
+If --batch is given, the file name is instead a directory of problem
+files, or a file listing them, and every puzzle in it is solved in
+this one process (see run_batch), with -j N setting how many puzzles
+are solved at once. One line is printed for each puzzle, giving how it
+came out, how long it took, and whether the answer matches the answer
+file of the puzzle, if there is one.
+
+If bap is compiled with -DBAP_PROFILE (see the bap_profile target of
+the Makefile), each rule called by solve_problem is counted and timed,
+and --profile or --profile=json prints a report of the counts at the
+end (see report_profile). Otherwise, the counting is compiled out.
+
+If bap is compiled with -DBAP_LIBRARY (see the libbap target of the
+Makefile), main is left out, and what is made is libbap, a library with
+the interface of libbap.h: bap_solve solves a puzzle given as text and
+returns its answers in a result, printing nothing. The messages of CHB
+are then kept in the result instead of being printed (see the message
+of the world). The count mode of bap (with one thread) is solved
+through bap_solve.
+
+If "serve" is given, bap runs as a server (see serve_bap). Puzzles are
+sent to it, each as a line giving the length of its text followed by
+the text, on standard input or through a Unix socket, and it writes
+one line for each, as long as it runs. The arena and trail are made
+once, not for each puzzle, and nothing is started or read from a file
+for a puzzle.
 
 */
 
@@ -50,6 +102,16 @@ but not unknown ship parts.
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "libbap.h"
 
 /*************************************************************************/
 
@@ -62,6 +124,68 @@ ship_fits_col_row, try_full_but_one_col, and try_full_but_one_row.
 Using [MAX_NUMBER_ROWS + 2] in those functions stumps the gen_gen_C
 parser.
 
+MAX_NUMBER_ROWS and MAX_NUMBER_COLS are the largest grid that can be
+read. They bound only the scratch arrays that functions keep on the
+stack. Everything in the world that is sized by the grid is allocated
+for the grid actually read (see size_block and size_branch).
+
+LINE_SIZE is the size of the buffer a line of the problem file is read
+into. It must hold a row of MAX_NUMBER_COLS squares and a line of ships.
+TEXT_SIZE bounds the reason and action of a line of explanation; the
+rest of the line is the list of strips (see size_branch).
+
+ARENA_CHUNK is the size of each piece of memory an arena gets from
+malloc (see arena_take). Most puzzles never need a second piece.
+
+MAX_THREADS is the largest number of threads that may be asked for with
+-j. MAX_TASKS is the number of tasks each thread's queue can hold. A
+thread that finds its queue full runs the guess itself instead. Guesses
+made at depths less than SPLIT_DEPTH are put on the queues as tasks
+when there is more than one thread; deeper guesses are followed up by
+the thread that made them.
+
+TABLE_MEGABYTES is the default size of the transposition table, which
+may be changed with --table=N. REPLACE_ALWAYS and REPLACE_SHALLOW are
+the two ways a full slot of the table may be reused (see store_table).
+
+JOB_SOLVED, JOB_NO_ANSWER, and JOB_ERROR are the ways solving a puzzle
+of a batch may come out (see run_batch). They index the counts of each.
+They are the BAP_XXX of libbap.h, since bap_solve comes out the same
+ways.
+
+FIXED_SIZE is N if bap is compiled with -DBAP_FIXED_SIZE=N, and 0
+otherwise. bap so compiled solves only NxN puzzles (see ROWS and COLS).
+
+PROFILING is 1 if bap is compiled with -DBAP_PROFILE, and 0 otherwise.
+RULE_VERIFY_SQUARES and the other RULE_XXX values number the rules
+solve_problem calls, in the order it calls them, and index the names in
+rule_names and the counts in rule_counts. NUMBER_RULES is the number of
+rules. Counts are kept separately for depths of guessing from 0 to
+PROFILE_DEPTHS - 1; deeper counts are added to those of the last depth.
+PROFILE_TEXT and PROFILE_JSON are the two forms of the report.
+
+ALL_RULES has a bit on for each rule. STRATEGY_CONSTRUCT,
+STRATEGY_SEARCH_WATER, and STRATEGY_SEARCH_PURE are the strategies that
+may be chosen with --strategy (see the structures section).
+SEARCH_WATER_RULES and SEARCH_PURE_RULES are the rules the two search
+strategies run; the constructive strategy runs them all.
+
+ENGINE_RULES and ENGINE_DLX are the engines that may be chosen with
+--engine: the rules of solve_problem and guessing, or the exact cover
+search of dlx_search (see the structures section). DLX_SHIP and
+DLX_WATER are the colors of the nodes of a secondary item (a blank
+square), and DLX_NODES bounds the nodes of one option, which has at
+most 24 (for a battleship lying inside the grid).
+
+BRANCH_LARGEST and BRANCH_FEWEST are the orders of branching that may
+be chosen with --branch: guessing where the largest remaining type of
+ship goes, or where the type with the fewest places left goes (see
+try_guessing and make_guesses_fewest).
+
+The engines, strategies, and orders of branching are those of
+libbap.h, so that the values a program using the library gives in a
+bap_request may be used as they are.
+
 */
 
 #define AND       &&
@@ -73,10 +197,71 @@ parser.
 #define OK        0
 #define ERROR     -1
 #define TEXT_SIZE 128
-#define MAX_NUMBER_ROWS 20
-#define MAX_NUMBER_COLS 20
-#define MAX_TEST 22
-#define MAX_GUESSES 20
+#define LINE_SIZE 4096
+#define MAX_NUMBER_ROWS 128
+#define MAX_NUMBER_COLS 128
+#define MAX_TEST 130
+#define ARENA_CHUNK 262144
+#define MAX_THREADS 64
+#define MAX_TASKS 1024
+#define SPLIT_DEPTH 3
+#define TABLE_MEGABYTES 16
+#define REPLACE_ALWAYS 0
+#define REPLACE_SHALLOW 1
+#define JOB_SOLVED BAP_SOLVED
+#define JOB_NO_ANSWER BAP_NO_ANSWER
+#define JOB_ERROR BAP_ERROR
+#ifdef BAP_FIXED_SIZE
+#define FIXED_SIZE BAP_FIXED_SIZE
+#else
+#define FIXED_SIZE 0
+#endif
+#ifdef BAP_PROFILE
+#define PROFILING 1
+#else
+#define PROFILING 0
+#endif
+#define RULE_VERIFY_SQUARES 0
+#define RULE_LOCATE_SHIPS 1
+#define RULE_MARK_DONES 2
+#define RULE_FILL_BAP 3
+#define RULE_EXTEND_MIDDLES 4
+#define RULE_DEX_SQUARES 5
+#define RULE_TRY_FULL 6
+#define RULE_TRY_FULL_BUT_ONE 7
+#define RULE_ASSIGN_BATTLESHIPS 8
+#define RULE_PLACE_BATTLESHIPS 9
+#define RULE_ASSIGN_CRUISERS 10
+#define RULE_PLACE_CRUISERS 11
+#define RULE_ASSIGN_DESTROYERS 12
+#define RULE_PLACE_DESTROYERS 13
+#define RULE_ASSIGN_SUBMARINES 14
+#define RULE_TRY_SQUARE_BLANK 15
+#define RULE_TRY_FULL_BUT_TWO 16
+#define RULE_TRY_CROSS 17
+#define NUMBER_RULES 18
+#define PROFILE_DEPTHS 16
+#define PROFILE_TEXT 1
+#define PROFILE_JSON 2
+#define ALL_RULES ((1 << NUMBER_RULES) - 1)
+#define STRATEGY_CONSTRUCT BAP_STRATEGY_CONSTRUCT
+#define STRATEGY_SEARCH_WATER BAP_STRATEGY_SEARCH_WATER
+#define STRATEGY_SEARCH_PURE BAP_STRATEGY_SEARCH_PURE
+#define SEARCH_PURE_RULES ((1 << RULE_VERIFY_SQUARES) | \
+			   (1 << RULE_LOCATE_SHIPS) |   \
+			   (1 << RULE_MARK_DONES))
+#define SEARCH_WATER_RULES (SEARCH_PURE_RULES | (1 << RULE_FILL_BAP))
+#define ENGINE_RULES BAP_ENGINE_RULES
+#define ENGINE_DLX BAP_ENGINE_DLX
+#define DLX_SHIP 1
+#define DLX_WATER 2
+#define DLX_NODES 32
+#define BRANCH_LARGEST BAP_BRANCH_LARGEST
+#define BRANCH_FEWEST BAP_BRANCH_FEWEST
+#define TRACE_WRITE 1
+#define TRACE_REPLAY 2
+#define TRACE_SUMMARY 3
+#define TRACE_MAGIC "BAPTRC01"
 
 /*************************************************************************/
 
@@ -91,10 +276,14 @@ parser.
    return ERROR; }                        \
  else
 
-#define CHB(testbad, error_msg)         \
- if (testbad){                          \
-   printf("%s: %s\n", name, error_msg); \
-   return ERROR; }                      \
+#define CHB(testbad, error_msg)                     \
+ if (testbad){                                      \
+   if (world->message IS NULL)                      \
+     printf("%s: %s\n", name, error_msg);           \
+   else if (world->message[0] IS 0)                 \
+     snprintf(world->message, BAP_MESSAGE_SIZE,     \
+	      "%s: %s", name, error_msg);           \
+   return ERROR; }                                  \
  else
 
 #define IFF(tryit)         \
@@ -104,6 +293,68 @@ parser.
    return ERROR; }         \
  else
 
+/* RUN_RULE is IFF for the rules called by solve_problem. It does
+nothing if the bit of the rule is off in world->rules. It first
+brings the slack of the strips up to date (see slack_strips), and if
+the rule makes no progress, it records the clock as the time at which
+the rule was last clean (see QUEUED). When PROFILING is 1, it also
+counts the call, whether the rule made progress, and the time it took
+(see profile_rule). */
+
+#if PROFILING
+#define RUN_RULE(rule, tryit)                               \
+ if (world->rules & (1 << (rule)))                          \
+ { int rule_progress;                                       \
+   int rule_result;                                         \
+   long long rule_start;                                    \
+   long long rule_clock;                                    \
+   IFF(slack_strips(world));                                \
+   rule_clock SET_TO world->clock;                          \
+   rule_progress SET_TO world->progress;                    \
+   profile_clock(&rule_start);                              \
+   rule_result SET_TO (tryit);                              \
+   profile_rule(rule, rule_start, rule_progress, world);    \
+   IFF(rule_result);                                        \
+   if (NOT (world->progress))                               \
+     world->clean[rule] SET_TO rule_clock; }                \
+ else
+#else
+#define RUN_RULE(rule, tryit)                               \
+ if (world->rules & (1 << (rule)))                          \
+ { long long rule_clock;                                    \
+   IFF(slack_strips(world));                                \
+   rule_clock SET_TO world->clock;                          \
+   IFF(tryit);                                              \
+   if (NOT (world->progress))                               \
+     world->clean[rule] SET_TO rule_clock; }                \
+ else
+#endif
+
+/* ROWS and COLS are the number of rows and columns of the world. When
+FIXED_SIZE is not 0, they are FIXED_SIZE instead, so the functions
+that use them (the legal_, ship_fits_, bits_, try_full, and try_cross
+functions, verify_squares, and square) are compiled for that size
+alone, as a solver made for one size would be. read_puzzle and
+generate_bap then refuse a puzzle of another size. See item P of 9. in
+text/bap.txt for how it compares. */
+
+#if FIXED_SIZE
+#define ROWS FIXED_SIZE
+#define COLS FIXED_SIZE
+#else
+#define ROWS (world->number_rows)
+#define COLS (world->number_cols)
+#endif
+
+/* QUEUED is 1 if the given strip has been touched (see touch_strips)
+since the given rule was last clean, so the rule must look at it again,
+and 0 if nothing the rule reads about the strip has changed since. It
+is always 1 when world->worklist is 0. */
+
+#define QUEUED(rule, the_strip)                            \
+ ((world->worklist IS 0) OR                                \
+  ((the_strip).changed > world->clean[rule]))
+
 /*************************************************************************/
 
 /* structures
@@ -119,8 +370,226 @@ its top end at that row. The value is the negative of the length of
 the ship. Otherwise, the integer is zero. Currently, all the tests
 of the locations array only check for zero or non-zero.
 
+The squares are also represented by bit masks, kept up to date by
+set_square. Bit col of ship_rows[row] is set if the square at row and
+col is a ship part (X or known part), and bit col of water_rows[row] is
+set if it is water. ship_cols and water_cols are the same with bit row
+of the mask for col. A square with neither bit set is blank. The masks
+are 64 bits wide, so they are used only for grids of at most 64 rows
+and 64 columns; for larger grids world->bits is set to 0 and the masks
+are not kept. Squares outside the puzzle are water, as in square(),
+but have no bits set, so callers mask off the edges.
+
+The arrays sized by the grid (the strips, the masks, the squares, and
+the locations) are all in one block of memory, laid out by attach_block,
+so that copy_bap can copy them with one memcpy. squares and locations
+are arrays of pointers to rows, so they are indexed as before.
+
+The explanation (logic), the list of guesses tried, and the path only
+ever grow at the end on the way down a branch of the search and are cut
+back on the way up. So all the worlds on a branch share one copy of
+each (made by make_branch), and copy_bap copies only the pointers and
+counts. A world that leaves its branch (a task for another thread or a
+saved answer) gets its own copy (see clone_bap).
+
+A line of the explanation is kept as an event, not as text. An event
+points at its reason and action, which are string constants, and lists
+its rows and then its columns in logic_strips, starting at first_strip.
+The text is made only when a line is printed (see render_event), so
+the rules pay for copying a few numbers, and with --no-explain
+(world->explain set to 0) they do not record anything.
+
+An arena hands out memory from the bottom up and takes it back by
+going back to a mark (see arena_take, arena_mark, arena_release). Each
+thread searching has one. try_guessing takes its guesses and the block
+of its copy of the world from the arena and gives them back when it is
+done, so no memory sized by the grid is put on the stack.
+
+A trail records the old values of squares and counters as they are
+changed, so that the changes can be undone. Each change records either
+a square or a counter, never both. A trail is used only when searching
+in place (see try_guess_in_place); otherwise world->trail is NULL and
+nothing is recorded.
+
+When searching with more than one thread (see run_pool), each guess
+made near the top of the search tree becomes a task holding its own
+copy of the world. Each thread has a queue of tasks. A thread takes the
+task it added most recently from its own queue, and when its queue is
+empty, it takes the oldest task from another thread's queue. The
+queues, the count of tasks not yet finished, and the answers found are
+all guarded by the one lock in the pool. Answers are saved with the
+path of guess indexes that led to them, so that they can be printed in
+the order a single thread would have found them.
+
+The transposition table holds the keys of states from which guessing
+has already failed (see try_guessing). The key of a state is the
+Zobrist hash of its squares, kept up to date by set_square, with the
+ship counters folded in when the table is used (see table_key). Each
+slot holds one key and the depth at which it was stored. A key of zero
+marks an empty slot. The table is shared by all threads, those of one
+puzzle or those of a batch, and is guarded by its own lock, which is
+taken only when the table is marked shared (see make_table).
+
+When solving a batch of puzzles (see run_batch), there is a job for
+each puzzle, in which the thread solving it records how it came out.
+A world solving a puzzle of a batch points to its job, and counts the
+calls to solve_problem and the guesses tried there. The next job to be
+started is the only thing guarded by the lock of the batch. bap_solve
+makes a job of its own for the puzzle it solves, which also points to
+the request, so that each answer is handed to the caller and the first
+is kept (see check_answer).
+
+A server holds what is kept from one puzzle it serves to the next (see
+serve_bap): the request made from the arguments, the room the text of
+a puzzle is read into, and the arena and trail of the last world a
+puzzle was solved in, which are given to the next.
+
+A session holds one puzzle being played through libbap (see
+bap_open_session). Its world always searches in place, and the trail is
+its undo stack: each move records the length the trail had before it
+was made, so taking a move back is undoing the trail to that length
+(see retract_move). A hint is found by running the rules on top of the
+moves and undoing what they did (see find_hint), so the world only ever
+holds the puzzle as given and the moves. The session keeps the room the
+hint it gives back points to.
+
+A trace records the search tree (see --trace in read_arguments). The
+file begins with a trace_head giving the options that decide the
+search, followed by the text of the puzzle, and then has one
+trace_record for each guess tried, written when the search under the
+guess is over (see trace_guess). The records are written as they are
+in memory, so a trace is read on the same kind of machine it was made
+on. The key of the state guessed from is the key it would have in the
+transposition table (see table_key). When a trace is replayed (see
+replay_trace), the records are read back and compared with the search
+instead of being written. A trace_depth holds the counts made at one
+depth when a trace is summarized (see summarize_trace).
+
+A rule_count holds the counts for one rule at one depth of guessing
+(see profile_rule). The counts are kept in the global rule_counts, so
+that all threads and all puzzles of a batch add to the same report.
+They are written only when PROFILING is 1, so libbap, which is built
+without it, has no global that changes.
+
+Each strip records the time on the world's clock at which it was last
+touched (changed), and the world records, for each rule, the time at
+which the rule last ran without making progress (clean). A strip
+touched since then is queued for the rule (see QUEUED). The slack and
+fits of a strip are kept so that the worklist can tell what changed
+(see slack_strips and assign_battleships). All of these are in the
+block or the world, so they are copied with it.
+
+The strategy of the world says how much is constructed before
+guessing. The constructive strategy runs every rule. The two search
+strategies run only the rules in world->rules that construct no ship
+(SEARCH_WATER_RULES and SEARCH_PURE_RULES), as bap_search1 and
+bap_search2 did, and a pure search makes no water at all (see
+make_water, mark_dones, and finish_pure). Guessing is the same for all
+three.
+
+With --engine=dlx, none of that is used. The puzzle as read is made
+into an exact cover problem (a dlx, see dlx_make) and solved by
+dancing links (see dlx_search). Each option is one legal placement of
+one ship. Each primary item must get exactly the total weight it needs
+from the options chosen: an item for each size of ship (one for each
+ship), each row and column (its number of ship parts), and each ship
+part given (one). The secondary items are the blank squares, which
+need nothing, but an option colors each square of its ship DLX_SHIP
+and each square around it DLX_WATER, and options may share a square
+only if both color it DLX_WATER. So the ships never touch. The nodes of
+each option are stored together, and the list of each item links its
+nodes through ulink and dlink. The strategy and rules are ignored.
+
 */
 
+struct chunk
+{
+  char * memory;        /* memory handed out                          */
+  struct chunk * next;  /* chunk to use when this one is full, or NULL */
+  long size;            /* number of bytes in memory                  */
+  long used;            /* number of bytes handed out                 */
+};
+
+struct arena
+{
+  struct chunk * chunk; /* chunk memory is being handed out from      */
+  struct chunk * first; /* first chunk                                */
+};
+
+struct arena_mark
+{
+  struct chunk * chunk; /* chunk in use when mark made                */
+  long used;            /* bytes of chunk handed out when mark made   */
+};
+
+struct change
+{
+  int * number;   /* counter that was changed, or NULL for a square     */
+  int row;        /* row index of square that was changed               */
+  int col;        /* column index of square that was changed            */
+  int value;      /* value of square or counter before the change       */
+};
+
+struct dlx
+{
+  int answers;               /* number of answers found                     */
+  int * chosen;              /* options chosen, in the order chosen         */
+  int * color;               /* color of each node, or 0 for primary        */
+  int * dlink;               /* next node down in list of item              */
+  char * given;              /* squares as read, row by row                 */
+  char * hidden;             /* set to 1 for each option hidden             */
+  int * items;               /* item of each square, or -1 for water        */
+  int * len;                 /* number of options in list of each item      */
+  int * need;                /* total weight each primary item still needs  */
+  long long nodes;           /* number of calls to dlx_search               */
+  int * node_option;         /* option of each node, or -1 for header       */
+  int number_chosen;         /* number of options chosen                    */
+  int number_hidden;         /* number of options on stack                  */
+  int number_items;          /* number of items, primary first              */
+  int number_nodes;          /* number of nodes, including headers          */
+  int number_options;        /* number of options                           */
+  int number_primary;        /* number of primary items                     */
+  int * option_first;        /* first node of each option, and one past end */
+  struct guess * placements; /* ship placed by each option                  */
+  int * room;                /* total weight of options left in each item   */
+  int * stack;               /* options hidden, in the order hidden         */
+  int stop;                  /* set to 1 to stop search                     */
+  int * top;                 /* item of each node                           */
+  int * ulink;               /* next node up in list of item                */
+  int * weight;              /* weight of each node                         */
+};
+
+struct entry
+{
+  unsigned long long key; /* key of state that failed, or zero if empty */
+  int depth;              /* number of guesses made to reach the state  */
+};
+
+struct event
+{
+  char * action;    /* text describing action taken, or NULL for none     */
+  int first_strip;  /* index in logic_strips of first row or column listed */
+  int number_cols;  /* number of columns listed, after the rows            */
+  int number_rows;  /* number of rows listed                               */
+  char * reason;    /* text giving reason for action                       */
+};
+
+struct job
+{
+  char * answer;          /* squares of answer file, row by row, or NULL */
+  char * file_name;       /* name of problem file                        */
+  char * first;           /* room for squares of first answer, or NULL   */
+  long long guesses;      /* number of guesses tried                     */
+  int matched;            /* set to 1 if an answer matches answer file   */
+  long long nodes;        /* number of calls to solve_problem            */
+  int number_answers;     /* number of answers found                     */
+  char * other;           /* room for squares of an answer that differs  */
+                          /* from answer, or NULL                        */
+  struct bap_request * request; /* request of bap_solve, or NULL         */
+  double seconds;         /* time taken to solve puzzle                  */
+  int status;             /* JOB_SOLVED, JOB_NO_ANSWER, or JOB_ERROR     */
+};
+
 struct guess
 {
   int row;     /* row at left or top of ship                         */
@@ -129,51 +598,258 @@ struct guess
   int in_row;  /* non-zero means ship lies in row, zero means column */
 };
 
+struct move
+{
+  char item;    /* character put in square                         */
+  int mark;     /* number of changes on trail before move was made */
+  int row;      /* row index of square                             */
+  int col;      /* column index of square                          */
+};
+
+struct rule_count
+{
+  long long calls;        /* number of times rule called               */
+  long long fires;        /* number of calls that made progress        */
+  long long nanoseconds;  /* total time taken by calls                 */
+};
+
 struct strip
 {
-  int aim;          /* number of squares to fill altogether              */
-  int battleships;  /* number battleships assigned but not fully located */
-  int cruisers;     /* number cruisers assigned but not fully located    */
-  int destroyers;   /* number destroyers assigned but not fully located  */
-  int done;         /* set to 1 if strip is done, 0 otherwise            */
-  int dry;          /* number of squares not yet marked water            */
-  int exes;         /* number of X's                                     */
-  int got;          /* number of squares filled so far                   */
-  int submarines;   /* number submarines assigned but not fully located  */
+  int aim;           /* number of squares to fill altogether              */
+  int battleships;   /* number battleships assigned but not fully located */
+  long long changed; /* clock when strip last touched (see touch_strips)  */
+  int cruisers;      /* number cruisers assigned but not fully located    */
+  int destroyers;    /* number destroyers assigned but not fully located  */
+  int done;          /* set to 1 if strip is done, 0 otherwise            */
+  int dry;           /* number of squares not yet marked water            */
+  int exes;          /* number of X's                                     */
+  int fits[5];       /* number of each size that fit, when last counted   */
+  int got;           /* number of squares filled so far                   */
+  int slack;         /* slack of strip when last looked at                */
+  int submarines;    /* number submarines assigned but not fully located  */
+};
+
+struct table
+{
+  struct entry * entries;         /* slots, number_entries long          */
+  long long hits;                 /* number of probes that found key     */
+  pthread_mutex_t lock;           /* lock on table when shared           */
+  unsigned long long mask;        /* number_entries - 1                  */
+  long long number_entries;       /* number of slots, a power of 2       */
+  long long probes;               /* number of times table searched      */
+  int replace;                    /* REPLACE_ALWAYS or REPLACE_SHALLOW   */
+  long long replaced;             /* stores that pushed out another key  */
+  int shared;                     /* 1 if threads use table at once      */
+  long long stores;               /* number of keys stored               */
+};
+
+struct trace
+{
+  long long differ;         /* number of first record that differs, or 0 */
+  long long nodes;          /* number of calls to solve_problem          */
+  long long number_records; /* number of records written or compared     */
+  FILE * port;              /* port to trace file                        */
+  int replay;               /* 1 if records compared with file, 0 if     */
+                            /* written to it                             */
+};
+
+struct trace_depth
+{
+  long long failed;             /* guesses with no answer under them     */
+  long long guesses;            /* guesses tried                         */
+  long long offered;            /* guesses in the sets of guesses        */
+  long long sets;               /* sets of guesses made                  */
+  long long wasted;             /* calls to solve_problem under failed   */
+                                /* guesses                               */
+  long long wasted_nanoseconds; /* time taken under failed guesses       */
+};
+
+struct trace_head
+{
+  char magic[8];            /* TRACE_MAGIC, not terminated               */
+  int bits;                 /* world->bits of search traced              */
+  int branch;               /* world->branch of search traced            */
+  int explain;              /* world->explain of search traced           */
+  int find_all;             /* world->find_all of search traced          */
+  int in_place;             /* world->in_place of search traced          */
+  int replace;              /* world->replace of search traced           */
+  int rules;                /* world->rules of search traced             */
+  int strategy;             /* world->strategy of search traced          */
+  int table_megabytes;      /* world->table_megabytes of search traced   */
+  int text_length;          /* number of characters of puzzle text       */
+  int worklist;             /* world->worklist of search traced          */
+};
+
+struct trace_record
+{
+  unsigned long long key;   /* key of state guessed from (see table_key) */
+  long long nanoseconds;    /* time taken by guess and search under it   */
+  long long nodes;          /* calls to solve_problem under guess        */
+  int depth;                /* number of guesses made before this one    */
+  int found;                /* 1 if an answer was found under guess      */
+  int index;                /* index of guess in its set of guesses      */
+  int number_guesses;       /* number of guesses in its set              */
+  struct guess the_guess;   /* guess tried                               */
+};
+
+struct trail
+{
+  struct change * changes;  /* changes in the order they were made */
+  int number_changes;       /* number of changes recorded          */
+  int size;                 /* number of changes there is room for */
 };
 
 struct bap_world
 {
+  struct arena * arena;           /* memory for guesses and copies of world  */
+  int batch;                      /* set to 1 to solve a batch of puzzles    */
   int battleships_ass;            /* number battleships assigned, unlocated  */
   int battleships_left;           /* number battleships unassigned unlocated */
-  struct strip cols[MAX_NUMBER_COLS]; /* data on columns                     */
-  int cols_in[MAX_NUMBER_COLS];   /* columns on which progress made          */
+  int bits;                       /* set to 1 to use the bit masks           */
+  char * block;                   /* memory holding arrays sized by grid     */
+  int branch;                     /* BRANCH_LARGEST or BRANCH_FEWEST         */
+  long block_bytes;               /* bytes of block copied by copy_bap       */
+  long long clean[NUMBER_RULES];  /* clock when each rule was last clean     */
+  long long clock;                /* number of times strips touched          */
+  struct strip * cols;            /* data on columns                         */
+  int * cols_in;                  /* columns on which progress made          */
+  int count;                      /* number of answers to count to, or 0     */
   int cruisers_ass;               /* number cruisers assigned, unlocated     */
   int cruisers_left;              /* number cruisers unassigned, unlocated   */
+  int depth;                      /* number of guesses made on this branch   */
   int destroyers_ass;             /* number destroyers assigned, unlocated   */
   int destroyers_left;            /* number destroyers unassigned unlocated  */
+  int engine;                     /* ENGINE_RULES or ENGINE_DLX              */
   int exes;                       /* number of X's                           */
+  int explain;                    /* set to 1 to keep explanation            */
   int find_all;                   /* set to 1 if all answers to be found     */
-  struct guess guesses_tried[MAX_GUESSES]; /* guesses already tried          */
-  int locations[MAX_NUMBER_ROWS][MAX_NUMBER_COLS]; /* ship end locations     */
-  char logic[TEXT_SIZE][TEXT_SIZE]; /* explanation of changes in puzzle      */
+  int generate;                   /* number of puzzles to make, or 0         */
+  struct guess * guesses_tried;   /* guesses already tried, shared on branch */
+  unsigned long long hash;        /* Zobrist hash of squares, if table used  */
+  int in_place;                   /* set to 1 to search in place using trail */
+  struct job * job;               /* job of puzzle in batch, or NULL         */
+  int jobs;                       /* number of threads to search with        */
+  int ** locations;               /* ship end locations                      */
+  struct event * logic;           /* explanation, shared on branch           */
   int logic_line;                 /* number of next line of logic to write   */
+  int logic_lines;                /* number of lines logic has room for      */
+  int logic_room;                 /* number of strips logic_strips holds     */
+  int logic_strip;                /* index of next strip in logic_strips     */
+  int * logic_strips;             /* strips listed by lines of logic         */
+  int logic_width;                /* number of characters in line of logic   */
+  int max_depth;                  /* size of path                            */
+  int max_guesses;                /* most guesses in one set of guesses      */
+  int max_tried;                  /* size of guesses_tried                   */
+  char * message;                 /* room for first error, or NULL to print  */
   int number_cols;                /* number of columns in puzzle             */
   int number_in_cols;             /* number of colums on which progress made */
   int number_guesses_tried;       /* number of guesses tried                 */
   int number_rows;                /* number of rows in puzzle                */
   int number_in_rows;             /* number of rows on which progress made   */
+  int * path;                     /* index of guess taken at each depth      */
+  struct pool * pool;             /* pool of threads searching, or NULL      */
   int print_all;                  /* set to 1 for printing partial solutions */
+  int profile;                    /* PROFILE_TEXT, PROFILE_JSON, or 0        */
   int progress;                   /* set to 1 if progress made by solve loop */
-  struct strip rows[MAX_NUMBER_ROWS]; /* data on rows                        */
-  int rows_in[MAX_NUMBER_ROWS];   /* rows on which progress made             */
-  char squares[MAX_NUMBER_ROWS][MAX_NUMBER_COLS]; /* array of squares        */
+  int replace;                    /* replacement policy for table            */
+  struct strip * rows;            /* data on rows                            */
+  int * rows_in;                  /* rows on which progress made             */
+  int rules;                      /* bit on for each rule solve_problem runs */
+  unsigned long long seed;        /* state of random numbers (random_index)  */
+  int serve;                      /* set to 1 to serve puzzles (serve_bap)   */
+  unsigned long long * ship_cols; /* ship parts in columns                   */
+  unsigned long long * ship_rows; /* ship parts in rows                      */
+  int slack;                      /* kinds of ship left when last looked at  */
+  char ** squares;                /* array of squares                        */
+  int stats;                      /* set to 1 to print table statistics      */
+  int strategy;                   /* STRATEGY_CONSTRUCT or a search strategy */
   int submarines_ass_col;         /* number subs in cols assigned unlocated  */
   int submarines_ass_row;         /* number subs in rows assigned unlocated  */
   int submarines_left_col;        /* number subs in cols unassigned unlocated*/
   int submarines_left_row;        /* number subs in rows unassigned unlocated*/
+  struct table * table;           /* transposition table or NULL             */
+  int table_megabytes;            /* size of table to make, 0 for none       */
+  struct trace * trace;           /* trace being written or replayed, or NULL*/
+  int trace_mode;                 /* TRACE_XXX if tracing, or 0              */
+  char * trace_name;              /* name of trace file to write, or NULL    */
+  struct trail * trail;           /* undo trail if searching in place or NULL*/
   int undone;                     /* number of strips not done               */
   int verbose;                    /* verbose (non-zero) or not (zero)        */
+  unsigned long long * water_cols; /* water in columns                      */
+  unsigned long long * water_rows; /* water in rows                         */
+  int worker;                     /* index of thread working on this world   */
+  int worklist;                   /* set to 1 to look only at touched strips */
+};
+
+struct task
+{
+  struct bap_world world;   /* world in which to follow up the guess,    */
+                            /* made by clone_bap                         */
+  struct guess the_guess;   /* guess to insert into world before solving */
+  int has_guess;            /* zero for the first task, which has no guess */
+};
+
+struct queue
+{
+  struct task * tasks[MAX_TASKS]; /* tasks waiting, oldest at first      */
+  struct arena * arena;           /* arena for thread                    */
+  int first;                      /* index of oldest task in tasks       */
+  struct guess * guesses_tried;   /* guesses tried on branch of thread   */
+  struct event * logic;           /* explanation on branch of thread     */
+  int * logic_strips;             /* strips listed in explanation        */
+  int number_tasks;               /* number of tasks waiting             */
+  int * path;                     /* path of branch of thread            */
+  struct pool * pool;             /* pool the queue belongs to           */
+  pthread_t thread;               /* thread that owns the queue          */
+  struct trail * trail;           /* trail for thread or NULL            */
+  int worker;                     /* index of queue in pool              */
+};
+
+struct pool
+{
+  struct bap_world ** answers;    /* answers found, in order found       */
+  int cancel;                     /* set to 1 to stop all searching; once */
+                                  /* threads run, read and set atomically */
+  int find_all;                   /* set to 1 if all answers to be found */
+  pthread_mutex_t lock;           /* lock on everything in pool          */
+  int number_answers;             /* number of answers found             */
+  int number_threads;             /* number of threads searching         */
+  int pending;                    /* tasks queued or running             */
+  struct queue queues[MAX_THREADS]; /* one queue of tasks per thread     */
+  int size_answers;               /* number of answers there is room for */
+  pthread_cond_t wake;            /* signalled when task added or done   */
+};
+
+struct batch
+{
+  struct job * jobs;              /* one job for each puzzle             */
+  pthread_mutex_t lock;           /* lock on next                        */
+  int next;                       /* index of next job to be started     */
+  int number_jobs;                /* number of jobs                      */
+  int size_jobs;                  /* number of jobs there is room for    */
+  struct bap_world * world;       /* world holding options for all jobs  */
+};
+
+struct server
+{
+  struct arena * arena;           /* arena of last puzzle, or NULL       */
+  int number_served;              /* number of puzzles served            */
+  struct bap_request request;     /* options for every puzzle            */
+  long room;                      /* size of text                        */
+  char * text;                    /* text of puzzle served, or NULL      */
+  struct trail * trail;           /* trail of last puzzle, or NULL       */
+};
+
+struct bap_session
+{
+  int * changed;                  /* squares set by hint (see bap_hint)  */
+  char * listed;                  /* 1 for each square in changed        */
+  struct move * moves;            /* moves made, in the order made       */
+  int number_moves;               /* number of moves made                */
+  char * squares;                 /* squares of hint, row by row         */
+  char * text;                    /* explanation of hint                 */
+  int text_size;                  /* number of characters text holds     */
+  struct bap_world world;         /* puzzle model, searched in place     */
 };
 
 /*************************************************************************/
@@ -182,25 +858,69 @@ struct bap_world
 
 */
 
+int add_job(char * file_name, struct batch * the_batch,
+	    struct bap_world * world);
 int allocate_ship_col(int row, int col, int length, struct bap_world * world);
 int allocate_ship_row(int row, int col, int length, struct bap_world * world);
 int already_tried(int row, int col, int size, int in_row, int * newby,
   struct bap_world * world);
+int arena_mark(struct arena_mark * the_mark, struct bap_world * world);
+int arena_release(struct arena_mark * the_mark, struct bap_world * world);
+int arena_shrink(void * memory, long bytes, struct bap_world * world);
+int arena_take(long bytes, void ** memory, struct bap_world * world);
 int assign_battleships(struct bap_world * world);
 int assign_cruisers(struct bap_world * world);
 int assign_destroyers(struct bap_world * world);
 int assign_submarines(struct bap_world * world);
 int assign_submarines_cols(int * total_assigned, struct bap_world * world);
 int assign_submarines_rows(int * total_assigned, struct bap_world * world);
+int attach_block(char * block, int number_rows, int number_cols,
+  struct bap_world * world);
+int bap_close_session(struct bap_session * session);
+int bap_free_result(struct bap_result * result);
+int bap_init_request(struct bap_request * request);
+int bap_next_hint(struct bap_session * session, struct bap_hint * hint);
+int bap_open_session(struct bap_request * request,
+  struct bap_session ** session, char * message);
+int bap_retract_square(struct bap_session * session, int row, int col,
+  struct bap_hint * hint);
+int bap_set_square(struct bap_session * session, int row, int col,
+  char item, struct bap_hint * hint);
+int bap_solve(struct bap_request * request, struct bap_result * result);
+int bits_cover_col(int col, unsigned long long * cover,
+  struct bap_world * world);
+int bits_cover_row(int row, unsigned long long * cover,
+  struct bap_world * world);
+int bits_fit_col_row(int col, int row, int size, int * is_legal,
+  struct bap_world * world);
+int bits_fit_row_col(int row, int col, int size, int * is_legal,
+  struct bap_world * world);
+int blanks_col(int col, unsigned long long * blanks,
+  struct bap_world * world);
+int blanks_row(int row, unsigned long long * blanks,
+  struct bap_world * world);
+int check_answer(struct bap_world * world);
+int clear_hint(struct bap_session * session, struct bap_hint * hint);
+int clone_bap(struct bap_world * world_copy, struct bap_world * world);
 int copy_bap(struct bap_world * world_copy, struct bap_world * world);
 int copy_guess(struct guess * guess_copy, struct guess * guess_original);
 int copy_guesses(struct guess * guesses_copy, struct guess * guesses,
   int number_guesses);
-int copy_strip(struct strip * strip_copy, struct strip * strip_old);
 int dex_ends_col(int col, struct bap_world * world);
 int dex_ends_row(int row, struct bap_world * world);
 int dex_square(int row, int col, struct bap_world * world);
 int dex_squares(struct bap_world * world);
+int dlx_answer(struct dlx * the_dlx, struct bap_world * world);
+int dlx_commit(struct dlx * the_dlx, int option, struct bap_world * world);
+int dlx_hide(struct dlx * the_dlx, int option);
+int dlx_make(struct dlx ** the_dlx, struct bap_world * world);
+int dlx_option(struct dlx * the_dlx, int row, int col, int size, int in_row,
+  struct bap_world * world);
+char dlx_part(struct guess * ship, int k);
+int dlx_room(struct dlx * the_dlx, struct bap_world * world);
+int dlx_search(struct dlx * the_dlx, struct bap_world * world);
+int dlx_uncommit(struct dlx * the_dlx, int option, int mark);
+int dlx_unhide(struct dlx * the_dlx, int mark);
 int enx_square(int row, int col, struct bap_world * world);
 int explain_bap(struct bap_world * world);
 int extend_ends(struct bap_world * world);
@@ -209,6 +929,8 @@ int extend_middle(int row, int col, struct bap_world * world);
 int extend_middles(struct bap_world * world);
 int extend_vertical(int row, int col, struct bap_world * world);
 int fill_bap(struct bap_world * world);
+int fill_request(struct bap_request * request, struct bap_world * world);
+int find_hint(struct bap_session * session, struct bap_hint * hint);
 int find_max_starts_col(int col, int size, int assigned, int * max_starts,
   struct bap_world * world);
 int find_max_starts_row(int row, int size, int assigned, int * max_starts,
@@ -217,6 +939,24 @@ int find_min_starts_col(int col, int size, int assigned, int * min_starts,
   struct bap_world * world);
 int find_min_starts_row(int row, int size, int assigned, int * min_starts,
   struct bap_world * world);
+int finish_pure(struct bap_world * world);
+int finish_trace(struct bap_world * world);
+int free_arena(struct arena * the_arena);
+int free_bap(struct bap_world * world);
+int free_dlx(struct dlx * the_dlx);
+int generate_bap(char * directory, struct bap_world * world);
+int generate_clear(char * solution, struct bap_world * world);
+int generate_count(struct bap_world * work, int * answers,
+  struct bap_world * world);
+int generate_fits(char * solution, int row, int col, int size, int in_row,
+  int * fits, struct bap_world * world);
+int generate_fleet(char * solution, struct bap_world * world);
+int generate_give(int row, int col, char item, struct bap_world * world);
+int generate_givens(char * solution, int * order, struct bap_world * work,
+  int * givens, int * checks, struct bap_world * world);
+int generate_ship(char * solution, int size, int * placed,
+  struct bap_world * world);
+int hash_squares(struct bap_world * world);
 int init_solution(struct bap_world * world);
 int init_world(struct bap_world * world);
 int insert_guess_col(struct guess * the_guess, struct bap_world * world);
@@ -237,8 +977,14 @@ int legal_row_beside(char * test, int row, int * is_legal,
   struct bap_world * world);
 int legal_row_ships(char * test, int row, int * is_legal,
   struct bap_world * world);
+int list_batch(char * list_name, struct batch * the_batch,
+	       struct bap_world * world);
 int locate_ships(struct bap_world * world);
 int main(int argc, char ** argv);
+int make_arena(struct arena ** the_arena, struct bap_world * world);
+int make_block(int number_rows, int number_cols, struct bap_world * world);
+int make_branch(struct event ** logic, int ** strips, struct guess ** tried,
+  int ** path, struct bap_world * world);
 int make_guess_ship_col(int size, int col, int * number_guesses, int limit,
   struct guess * guesses, struct bap_world * world);
 int make_guess_ship_row(int size, int row, int * number_guesses, int limit,
@@ -249,12 +995,23 @@ int make_guesses_cruisers(int * number_guesses, struct guess * guesses,
   struct bap_world * world);
 int make_guesses_destroyers(int * number_guesses, struct guess * guesses,
   struct bap_world * world);
+int make_guesses_fewest(int * number_guesses, struct guess * guesses,
+  struct bap_world * world);
 int make_guesses_submarines(int * number_guesses, struct guess * guesses,
   struct bap_world * world);
+int make_logic(struct event ** logic, int ** strips, int number_lines,
+  int number_strips, struct bap_world * world);
+int make_move(int row, int col, char item, struct bap_world * world);
+int make_table(struct bap_world * world);
+int make_trace(char * file_name, struct bap_world * world);
+int make_trail(struct trail ** the_trail, struct bap_world * world);
 int make_water(int row, int col, struct bap_world * world);
 int mark_dones(struct bap_world * world);
+int measure_slack(struct strip * the_strip, int * slack);
 int pad_bap(struct bap_world * world);
 int pad_square(char item, int row, int col, struct bap_world * world);
+int path_before(struct bap_world * world1, struct bap_world * world2,
+  int * before);
 int place_battleships(struct bap_world * world);
 int place_cruisers(struct bap_world * world);
 int place_destroyers(struct bap_world * world);
@@ -266,18 +1023,57 @@ int place_ships_row(int row, int size, int assigned,
   struct bap_world * world);
 int place_ships_row_water(int row, int size, int assigned, int * min_starts,
   int * max_starts, int * placed, struct bap_world * world);
+int play_move(int row, int col, char item, struct bap_session * session,
+  struct bap_hint * hint);
 int print_bap(struct bap_world * world);
+int print_event(struct event * the_event, struct bap_world * world);
+int probe_table(unsigned long long key, int * found,
+  struct bap_world * world);
+int profile_clock(long long * now);
+int profile_rule(int rule, long long start, int progress,
+		 struct bap_world * world);
+int queue_guess(struct guess * the_guess, int index, int * queued,
+  struct bap_world * world);
+int random_index(int limit, int * index, struct bap_world * world);
+int read_answer(struct job * the_job, struct bap_world * world);
 int read_arguments(int argc, char ** argv, struct bap_world * world);
 int read_column_numbers(FILE * in_port, char * buffer,
   struct bap_world * world);
 int read_dashes(FILE * in_port, char * dashes, int * row_length,
   struct bap_world * world);
 int read_problem(char * file_name, struct bap_world * world);
+int read_puzzle(FILE * in_port, struct bap_world * world);
 int read_row(char * buffer, struct bap_world * world);
 int read_rows(FILE * in_port, char * buffer, int row_length,
   struct bap_world * world);
 int read_ships(FILE * in_port, char * buffer, struct bap_world * world);
+int read_text(char * file_name, char ** text, struct bap_world * world);
+int read_trace(FILE * in_port, struct trace_head * head, char ** text,
+  struct bap_world * world);
+int record_line(char * text, struct bap_world * world);
 int record_progress(char * reason, char * action, struct bap_world * world);
+int render_event(struct event * the_event, char * text,
+  struct bap_world * world);
+int replay_trace(char * file_name, struct bap_world * world);
+int report_count(int answers, struct bap_world * world);
+int report_profile(struct bap_world * world);
+int report_table(struct bap_world * world);
+int retract_move(int row, int col, struct bap_session * session,
+  struct bap_hint * hint);
+int run_batch(char * list_name, struct bap_world * world);
+void * run_batch_thread(void * batch_pointer);
+int run_pool(struct bap_world * world);
+void * run_queue(void * queue_pointer);
+int run_rules(int * fired, struct bap_world * world);
+int run_task(struct queue * the_queue, struct task * the_task);
+int save_answer(struct bap_world * world);
+int scramble_key(unsigned long long * key);
+int serve_bap(char * place, struct bap_world * world);
+int serve_port(FILE * in_port, FILE * out_port, struct server * the_server,
+  int * stop, struct bap_world * world);
+int serve_request(struct server * the_server, FILE * out_port,
+  struct bap_world * world);
+int set_square(int row, int col, char item, struct bap_world * world);
 int ship_covers_col(int row, int col, int size, int * cover,
   struct bap_world * world);
 int ship_covers_row(int row, int col, int size, int * cover,
@@ -288,9 +1084,36 @@ int ship_fits_col_row(int col, int row, int size, int * ys, int * is_legal,
 int ship_fits_row(int row, int size, int * fits, struct bap_world * world);
 int ship_fits_row_col(int row, int col, int size, int * ys, int * is_legal,
   struct bap_world * world);
+int size_block(int number_rows, int number_cols, long * copied,
+  long * bytes);
+int size_branch(struct bap_world * world);
+int slack_strips(struct bap_world * world);
+int solve_dlx(struct bap_world * world);
+int solve_job(struct job * the_job, struct batch * the_batch);
 int solve_problem(struct bap_world * world);
+int solve_request(struct bap_request * request, struct bap_world * world);
+int solve_result(struct bap_request * request, struct bap_result * result,
+  struct bap_world * world);
+int sort_answers(struct pool * the_pool);
+int sort_jobs(struct batch * the_batch);
 char square(int row, int col, struct bap_world * world);
+int start_session(struct bap_request * request,
+  struct bap_session * session);
+int store_table(unsigned long long key, struct bap_world * world);
 int submarine_covers(int row, int col, int * cover, struct bap_world * world);
+int summarize_trace(char * file_name, int number,
+  struct bap_world * world);
+int table_key(unsigned long long * key, struct bap_world * world);
+int take_task(struct queue * the_queue, struct task ** the_task);
+int touch_number(int * number, struct bap_world * world);
+int touch_strips(int first_row, int last_row, int first_col, int last_col,
+  struct bap_world * world);
+int trace_guess(struct trace_record * record, long long start,
+  struct bap_world * world);
+int trace_slot(unsigned long long key, unsigned long long * keys,
+  unsigned long long mask, long long * slot);
+int trail_number(int * number, struct bap_world * world);
+int trail_square(int row, int col, struct bap_world * world);
 int try_cross(struct bap_world * world);
 int try_cross_col(struct bap_world * world);
 int try_cross_col_fill_col(int col, int row1, int row2,
@@ -313,17 +1136,38 @@ int try_full_but_one_row(int row, struct bap_world * world);
 int try_full_but_two(struct bap_world * world);
 int try_full_but_two_col(int col, struct bap_world * world);
 int try_full_but_two_row(int row, struct bap_world * world);
+int try_guess_in_place(struct guess * the_guess, int * result,
+  struct bap_world * world);
 int try_guessing(struct bap_world * world);
 int try_square_blank(struct bap_world * world);
+int undo_trail(int mark, struct bap_world * world);
 int verify_square(char item, int row, int col, struct bap_world * world);
 int verify_squares(struct bap_world * world);
+int work_batch(struct batch * the_batch);
+int work_queue(struct queue * the_queue);
+int write_problem(char * file_name, struct bap_world * world);
+int zobrist_key(int row, int col, char item, unsigned long long * key);
 
 /*************************************************************************/
 
 /* globals
 
+rule_names holds the name of each rule solve_problem calls, and
+rule_counts the counts made for each rule and depth of guessing when
+PROFILING is 1 (see profile_rule and report_profile).
+
 */
 
+const char * rule_names[NUMBER_RULES] SET_TO
+  {"verify_squares", "locate_ships", "mark_dones", "fill_bap",
+   "extend_middles", "dex_squares", "try_full", "try_full_but_one",
+   "assign_battleships", "place_battleships", "assign_cruisers",
+   "place_cruisers", "assign_destroyers", "place_destroyers",
+   "assign_submarines", "try_square_blank", "try_full_but_two",
+   "try_cross"};
+
+struct rule_count rule_counts[NUMBER_RULES][PROFILE_DEPTHS];
+
 /*************************************************************************/
 
 /* define_functions
@@ -332,6 +1176,59 @@ int verify_squares(struct bap_world * world);
 
 /*************************************************************************/
 
+/* add_job
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for a longer list of jobs or for the file name:
+     "Out of memory".
+
+Called By:  list_batch
+
+Side Effects: This adds a job for the problem file with the given name
+to the end of the list of jobs in the batch, making the list longer if
+it is full. The job starts with no answers and a status of JOB_ERROR.
+
+*/
+
+int add_job(               /* ARGUMENTS                      */
+ char * file_name,         /* name of problem file           */
+ struct batch * the_batch, /* batch of puzzles to add job to */
+ struct bap_world * world) /* puzzle model, for messages     */
+{
+  const char * name SET_TO "add_job";
+  struct job * jobs;       /* longer list of jobs  */
+  struct job * the_job;    /* job added            */
+
+  if (the_batch->number_jobs IS the_batch->size_jobs)
+    {
+      jobs SET_TO (struct job *)
+	realloc(the_batch->jobs,
+		((2 * the_batch->size_jobs) + 16) * sizeof(struct job));
+      CHB((jobs IS NULL), "Out of memory");
+      the_batch->jobs SET_TO jobs;
+      the_batch->size_jobs SET_TO ((2 * the_batch->size_jobs) + 16);
+    }
+  the_job SET_TO &(the_batch->jobs[the_batch->number_jobs++]);
+  the_job->answer SET_TO NULL;
+  the_job->file_name SET_TO (char *)malloc(strlen(file_name) + 1);
+  CHB((the_job->file_name IS NULL), "Out of memory");
+  strcpy(the_job->file_name, file_name);
+  the_job->first SET_TO NULL;
+  the_job->guesses SET_TO 0;
+  the_job->matched SET_TO 0;
+  the_job->nodes SET_TO 0;
+  the_job->number_answers SET_TO 0;
+  the_job->other SET_TO NULL;
+  the_job->request SET_TO NULL;
+  the_job->seconds SET_TO 0.0;
+  the_job->status SET_TO JOB_ERROR;
+  return OK;
+}
+
+/*************************************************************************/
+
 /* allocate_ship_col
 
 Returned Value: int
@@ -346,6 +1243,7 @@ Returned Value: int
      "Puzzle has no answer too many battleships".
   5. The length of the ship is not 1, 2, 3, or 4:
      "Puzzle has no answer bad ship length".
+  6. trail_number returns ERROR.
 
 Called By:  locate_ships
 
@@ -386,45 +1284,57 @@ int allocate_ship_col(     /* ARGUMENTS                 */
 	    {
 	      if (world->cols[col].destroyers > 0)
 		{
+		  IFF(trail_number(&(world->cols[col].destroyers), world));
 		  world->cols[col].destroyers--;
+		  IFF(trail_number(&(world->destroyers_ass), world));
 		  world->destroyers_ass--;
 		}
 	      else
 		{
 		  CHK((world->destroyers_left < 1),
 		      "Puzzle has no answer too many destroyers");
+		  IFF(trail_number(&(world->destroyers_left), world));
 		  world->destroyers_left--;
 		}
+	      IFF(trail_number(&(world->locations[row][col]), world));
 	      world->locations[row][col] SET_TO -2;
 	    }
 	  else if (switcher IS 3)
 	    {
 	      if (world->cols[col].cruisers > 0)
 		{
+		  IFF(trail_number(&(world->cols[col].cruisers), world));
 		  world->cols[col].cruisers--;
+		  IFF(trail_number(&(world->cruisers_ass), world));
 		  world->cruisers_ass--;
 		}
 	      else
 		{
 		  CHK((world->cruisers_left < 1),
 		      "Puzzle has no answer too many cruisers");
+		  IFF(trail_number(&(world->cruisers_left), world));
 		  world->cruisers_left--;
 		}
+	      IFF(trail_number(&(world->locations[row][col]), world));
 	      world->locations[row][col] SET_TO -3;
 	    }
 	  else if (switcher IS 4)
 	    {
 	      if (world->cols[col].battleships > 0)
 		{
+		  IFF(trail_number(&(world->cols[col].battleships), world));
 		  world->cols[col].battleships--;
+		  IFF(trail_number(&(world->battleships_ass), world));
 		  world->battleships_ass--;
 		}
 	      else
 		{
 		  CHK((world->battleships_left < 1),
 		      "Puzzle has no answer too many battleships");
+		  IFF(trail_number(&(world->battleships_left), world));
 		  world->battleships_left--;
 		}
+	      IFF(trail_number(&(world->locations[row][col]), world));
 	      world->locations[row][col] SET_TO -4;
 	    }
 	  else if (switcher IS 1)
@@ -455,6 +1365,7 @@ Returned Value: int
      "Puzzle has no answer too many battleships".
   5. The length of the ship is not 1, 2, 3, or 4:
      "Puzzle has no answer bad ship length".
+  6. trail_number returns ERROR.
 
 Called By:  locate_ships
 
@@ -503,71 +1414,90 @@ int allocate_ship_row(     /* ARGUMENTS                  */
 	    {
 	      if (world->rows[row].submarines > 0)
 		{
+		  IFF(trail_number(&(world->rows[row].submarines), world));
 		  world->rows[row].submarines--;
+		  IFF(trail_number(&(world->submarines_ass_row), world));
 		  world->submarines_ass_row--;
 		}
 	      else
 		{
 		  CHK((world->submarines_left_row < 1),
 		      "Puzzle has no answer too many submarines");
+		  IFF(trail_number(&(world->submarines_left_row), world));
 		  world->submarines_left_row--;
 		}
 	      if (world->cols[col].submarines > 0)
 		{
+		  IFF(trail_number(&(world->cols[col].submarines), world));
 		  world->cols[col].submarines--;
+		  IFF(trail_number(&(world->submarines_ass_col), world));
 		  world->submarines_ass_col--;
 		}
 	      else
 		{
 		  CHK((world->submarines_left_col < 1),
 		      "Puzzle has no answer too many submarines");
+		  IFF(trail_number(&(world->submarines_left_col), world));
 		  world->submarines_left_col--;
 		}
+	      IFF(trail_number(&(world->locations[row][col]), world));
 	      world->locations[row][col] SET_TO 1;
 	    }
 	  else if (switcher IS 2)
 	    {
 	      if (world->rows[row].destroyers > 0)
 		{
+		  IFF(trail_number(&(world->rows[row].destroyers), world));
 		  world->rows[row].destroyers--;
+		  IFF(trail_number(&(world->destroyers_ass), world));
 		  world->destroyers_ass--;
 		}
 	      else
 		{
 		  CHK((world->destroyers_left < 1),
 		      "Puzzle has no answer too many destroyers");
+		  IFF(trail_number(&(world->destroyers_left), world));
 		  world->destroyers_left--;
 		}
+	      IFF(trail_number(&(world->locations[row][col]), world));
 	      world->locations[row][col] SET_TO 2;
 	    }
 	  else if (switcher IS 3)
 	    {
 	      if (world->rows[row].cruisers > 0)
 		{
+		  IFF(trail_number(&(world->rows[row].cruisers), world));
 		  world->rows[row].cruisers--;
+		  IFF(trail_number(&(world->cruisers_ass), world));
 		  world->cruisers_ass--;
 		}
 	      else
 		{
 		  CHK((world->cruisers_left < 1),
 		      "Puzzle has no answer too many cruisers");
+		  IFF(trail_number(&(world->cruisers_left), world));
 		  world->cruisers_left--;
 		}
+	      IFF(trail_number(&(world->locations[row][col]), world));
 	      world->locations[row][col] SET_TO 3;
 	    }
 	  else if (switcher IS 4)
 	    {
 	      if (world->rows[row].battleships > 0)
 		{
+		  IFF(trail_number(&(world->rows[row].battleships), world));
 		  world->rows[row].battleships--;
+		  IFF(trail_number(&(world->battleships_ass), world));
 		  world->battleships_ass--;
 		}
 	      else
 		{
 		  CHK((world->battleships_left < 1),
 		      "Puzzle has no answer too many battleships");
+		  IFF(trail_number(&(world->battleships_left), world));
 		  world->battleships_left--;
 		}
+	      IFF(trail_number(&(world->locations[row][col]), world));
 	      world->locations[row][col] SET_TO 4;
 	    }
 	  else
@@ -591,10 +1521,20 @@ Called By:
   make_guess_ship_col
   make_guess_ship_row
 
-Side Effects:
+Side Effects: This sets *newby to 0 if a ship of the given size was
+already guessed at the given place, in the given direction, on this
+branch (see guesses_tried), and to 1 if not.
 
 Notes:
 
+A submarine has no direction. It is guessed in a row or in a column
+(make_guess_ship_row or make_guess_ship_col), but the rules locate it
+in a row (allocate_ship_row), so for a submarine the direction is not
+compared. When it was, a submarine guessed in a column and tried could
+be located again by the rules on a later branch, and the same answer
+was found twice (with --branch=fewest, which guesses submarines before
+the other ships are placed).
+
 */
 
 int already_tried(         /* ARGUMENTS              */
@@ -614,7 +1554,7 @@ int already_tried(         /* ARGUMENTS              */
       if ((world->guesses_tried[n].row IS row) AND
 	  (world->guesses_tried[n].col IS col) AND
 	  (world->guesses_tried[n].size IS size) AND
-	  (world->guesses_tried[n].in_row IS in_row))
+	  ((world->guesses_tried[n].in_row IS in_row) OR (size IS 1)))
 	{
 	  *newby SET_TO 0;
 	  break;
@@ -625,6 +1565,178 @@ int already_tried(         /* ARGUMENTS              */
 
 /*************************************************************************/
 
+/* arena_mark
+
+Returned Value: int (OK)
+
+Called By:
+  make_guesses_battleships
+  make_guesses_cruisers
+  make_guesses_destroyers
+  make_guesses_fewest
+  make_guesses_submarines
+  try_guessing
+
+Side Effects: This records in the_mark how much of world->arena has
+been handed out, so that arena_release can take back everything handed
+out after this.
+
+*/
+
+int arena_mark(                 /* ARGUMENTS                */
+ struct arena_mark * the_mark,  /* mark, set here           */
+ struct bap_world * world)      /* puzzle model             */
+{
+  const char * name SET_TO "arena_mark";
+
+  the_mark->chunk SET_TO world->arena->chunk;
+  the_mark->used SET_TO world->arena->chunk->used;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* arena_release
+
+Returned Value: int (OK)
+
+Called By:
+  generate_count
+  make_guesses_battleships
+  make_guesses_cruisers
+  make_guesses_destroyers
+  make_guesses_fewest
+  make_guesses_submarines
+  run_task
+  serve_request
+  try_guessing
+
+Side Effects: This takes back everything handed out from world->arena
+since the_mark was made. Chunks after the chunk of the mark are kept
+for reuse, but nothing in them is in use any more. Chunks after the
+chunk in use are always empty, so only the chunks up to the one in use
+need to be emptied.
+
+*/
+
+int arena_release(              /* ARGUMENTS                */
+ struct arena_mark * the_mark,  /* mark made by arena_mark  */
+ struct bap_world * world)      /* puzzle model             */
+{
+  const char * name SET_TO "arena_release";
+  struct chunk * the_chunk;
+
+  for (the_chunk SET_TO the_mark->chunk;
+       the_chunk ISNT world->arena->chunk;
+       the_chunk SET_TO the_chunk->next)
+    the_chunk->next->used SET_TO 0;
+  the_mark->chunk->used SET_TO the_mark->used;
+  world->arena->chunk SET_TO the_mark->chunk;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* arena_shrink
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The memory is not the last thing taken from the arena, or it would
+     grow: "Bug arena_shrink".
+
+Called By:  try_guessing
+
+Side Effects: This gives back the end of the last piece of memory taken
+from world->arena, keeping only the first "bytes" bytes of it.
+
+*/
+
+int arena_shrink(          /* ARGUMENTS                            */
+ void * memory,            /* memory last taken from the arena     */
+ long bytes,               /* number of bytes of memory to keep    */
+ struct bap_world * world) /* puzzle model                         */
+{
+  const char * name SET_TO "arena_shrink";
+  struct chunk * the_chunk;
+  long used;               /* bytes of chunk in use after shrinking */
+
+  the_chunk SET_TO world->arena->chunk;
+  used SET_TO (((char *)memory - the_chunk->memory) + ((bytes + 7) & ~7L));
+  CHB(((used < 0) OR (used > the_chunk->used)), "Bug arena_shrink");
+  the_chunk->used SET_TO used;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* arena_take
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for a new chunk: "Out of memory".
+
+Called By:
+  make_guesses_battleships
+  make_guesses_cruisers
+  make_guesses_destroyers
+  make_guesses_fewest
+  make_guesses_submarines
+  try_guessing
+
+Side Effects: This sets memory to point to the given number of bytes
+taken from world->arena. The number of bytes is rounded up to a
+multiple of 8, so that everything taken is aligned.
+
+Notes:
+
+If the chunk in use is full, the next chunk is used if there is one
+and it is big enough. Otherwise, a new chunk of at least ARENA_CHUNK
+bytes is malloc'ed and put after the chunk in use. A chunk that is
+skipped stays on the list and is used again after the memory is given
+back. Chunks are never freed, so once the search has gone as deep as
+it will go, nothing more is malloc'ed.
+
+*/
+
+int arena_take(            /* ARGUMENTS                        */
+ long bytes,               /* number of bytes wanted           */
+ void ** memory,           /* memory taken, set here           */
+ struct bap_world * world) /* puzzle model                     */
+{
+  const char * name SET_TO "arena_take";
+  struct arena * the_arena;
+  struct chunk * the_chunk;
+  long size;               /* size of new chunk */
+
+  the_arena SET_TO world->arena;
+  bytes SET_TO ((bytes + 7) & ~7L);
+  the_chunk SET_TO the_arena->chunk;
+  if ((the_chunk->used + bytes) > the_chunk->size)
+    {
+      the_chunk SET_TO the_chunk->next;
+      if ((the_chunk IS NULL) OR (bytes > the_chunk->size))
+	{
+	  size SET_TO ((bytes > ARENA_CHUNK) ? bytes : ARENA_CHUNK);
+	  the_chunk SET_TO (struct chunk *)malloc(sizeof(struct chunk));
+	  CHB((the_chunk IS NULL), "Out of memory");
+	  the_chunk->memory SET_TO (char *)malloc(size);
+	  CHB((the_chunk->memory IS NULL), "Out of memory");
+	  the_chunk->next SET_TO the_arena->chunk->next;
+	  the_chunk->size SET_TO size;
+	  the_chunk->used SET_TO 0;
+	  the_arena->chunk->next SET_TO the_chunk;
+	}
+      the_arena->chunk SET_TO the_chunk;
+    }
+  *memory SET_TO (the_chunk->memory + the_chunk->used);
+  the_chunk->used SET_TO (the_chunk->used + bytes);
+  return OK;
+}
+
+/*************************************************************************/
+
 /* assign_battleships
 
 Returned Value: int
@@ -635,8 +1747,9 @@ Returned Value: int
   2. ship_fits_row returns ERROR.
   3. ship_fits_col returns ERROR.
   4. record_progress returns ERROR.
+  5. trail_number returns ERROR.
 
-Called By:  solve_problem
+Called By:  run_rules
 
 Side Effects: This tries to assign battleships to strips. This
 determines how many battleships will fit in each strip in addition to
@@ -657,6 +1770,10 @@ others. This can happen only if the puzzle has no solution.
 
 The ship_fits_row and ship_fits_col functions set the value of fits.
 
+The number that fit in a strip is kept in the fits of the strip, and
+it is counted again only if the strip is queued (see QUEUED). Nothing
+it depends on has changed in a strip that is not queued.
+
 */
 
 int assign_battleships(     /* ARGUMENTS    */
@@ -687,7 +1804,11 @@ int assign_battleships(     /* ARGUMENTS    */
 	 ((rown->cruisers * 3) + (rown->destroyers * 2) + (rown->submarines)));
       if (spares < 4)
 	continue;
-      IFF(ship_fits_row(row, 4, &fits, world));
+      if (QUEUED(RULE_ASSIGN_BATTLESHIPS, *rown))
+	{
+	  IFF(ship_fits_row(row, 4, &(rown->fits[4]), world));
+	}
+      fits SET_TO rown->fits[4];
       rows_fits[row] SET_TO
 	(((fits - rown->battleships) > 0) ? (fits - rown->battleships) : 0);
       total_fits SET_TO (total_fits + rows_fits[row]);
@@ -703,7 +1824,11 @@ int assign_battleships(     /* ARGUMENTS    */
 	 ((coln->cruisers * 3) + (coln->destroyers * 2) + (coln->submarines)));
       if (spares < 4)
 	continue;
-      IFF(ship_fits_col(col, 4, &fits, world));
+      if (QUEUED(RULE_ASSIGN_BATTLESHIPS, *coln))
+	{
+	  IFF(ship_fits_col(col, 4, &(coln->fits[4]), world));
+	}
+      fits SET_TO coln->fits[4];
       cols_fits[col] SET_TO
 	(((fits - coln->battleships) > 0) ? (fits - coln->battleships) : 0);
       total_fits SET_TO (total_fits + cols_fits[col]);
@@ -716,6 +1841,7 @@ int assign_battleships(     /* ARGUMENTS    */
       assign SET_TO (world->battleships_left - (total_fits - rows_fits[row]));
       if (assign > 0)
 	{
+	  IFF(trail_number(&(world->rows[row].battleships), world));
 	  world->rows[row].battleships SET_TO
 	    (world->rows[row].battleships + assign);
 	  world->rows_in[world->number_in_rows++] SET_TO row;
@@ -728,6 +1854,7 @@ int assign_battleships(     /* ARGUMENTS    */
       assign SET_TO (world->battleships_left - (total_fits - cols_fits[col]));
       if (assign > 0)
 	{
+	  IFF(trail_number(&(world->cols[col].battleships), world));
 	  world->cols[col].battleships SET_TO
 	    (world->cols[col].battleships + assign);
 	  world->cols_in[world->number_in_cols++] SET_TO col;
@@ -741,8 +1868,10 @@ int assign_battleships(     /* ARGUMENTS    */
 	IFF(record_progress("assign battleship", "to", world));
       else
 	IFF(record_progress("assign battleships", "to", world));
+      IFF(trail_number(&(world->battleships_left), world));
       world->battleships_left SET_TO
 	(world->battleships_left - total_assigned);
+      IFF(trail_number(&(world->battleships_ass), world));
       world->battleships_ass SET_TO (world->battleships_ass + total_assigned);
     }
   return OK;
@@ -760,8 +1889,9 @@ Returned Value: int
   2. ship_fits_row returns ERROR.
   3. ship_fits_col returns ERROR.
   4. record_progress returns ERROR.
+  5. trail_number returns ERROR.
 
-Called By:  solve_problem
+Called By:  run_rules
 
 Side Effects: See assign_battleships
 
@@ -797,7 +1927,11 @@ int assign_cruisers(       /* ARGUMENTS    */
 	  (rown->submarines)));
       if (spares < 3)
 	continue;
-      IFF(ship_fits_row(row, 3, &fits, world));
+      if (QUEUED(RULE_ASSIGN_CRUISERS, *rown))
+	{
+	  IFF(ship_fits_row(row, 3, &(rown->fits[3]), world));
+	}
+      fits SET_TO rown->fits[3];
       rows_fits[row] SET_TO
 	(((fits - rown->cruisers) > 0) ? (fits - rown->cruisers) : 0);
       total_fits SET_TO (total_fits + rows_fits[row]);
@@ -815,7 +1949,11 @@ int assign_cruisers(       /* ARGUMENTS    */
 	  (coln->submarines)));
       if (spares < 3)
 	continue;
-      IFF(ship_fits_col(col, 3, &fits, world));
+      if (QUEUED(RULE_ASSIGN_CRUISERS, *coln))
+	{
+	  IFF(ship_fits_col(col, 3, &(coln->fits[3]), world));
+	}
+      fits SET_TO coln->fits[3];
       cols_fits[col] SET_TO
 	(((fits - coln->cruisers) > 0) ? (fits - coln->cruisers) : 0);
       total_fits SET_TO (total_fits + cols_fits[col]);
@@ -828,6 +1966,7 @@ int assign_cruisers(       /* ARGUMENTS    */
       assign SET_TO (world->cruisers_left - (total_fits - rows_fits[row]));
       if (assign > 0)
 	{
+	  IFF(trail_number(&(world->rows[row].cruisers), world));
 	  world->rows[row].cruisers SET_TO
 	    (world->rows[row].cruisers + assign);
 	  world->rows_in[world->number_in_rows++] SET_TO row;
@@ -840,6 +1979,7 @@ int assign_cruisers(       /* ARGUMENTS    */
       assign SET_TO (world->cruisers_left - (total_fits - cols_fits[col]));
       if (assign > 0)
 	{
+	  IFF(trail_number(&(world->cols[col].cruisers), world));
 	  world->cols[col].cruisers SET_TO
 	    (world->cols[col].cruisers + assign);
 	  world->cols_in[world->number_in_cols++] SET_TO col;
@@ -853,7 +1993,9 @@ int assign_cruisers(       /* ARGUMENTS    */
 	IFF(record_progress("assign cruiser", "to", world));
       else
 	IFF(record_progress("assign cruisers", "to", world));
+      IFF(trail_number(&(world->cruisers_left), world));
       world->cruisers_left SET_TO (world->cruisers_left - total_assigned);
+      IFF(trail_number(&(world->cruisers_ass), world));
       world->cruisers_ass SET_TO (world->cruisers_ass + total_assigned);
     }
   return OK;
@@ -871,8 +2013,9 @@ Returned Value: int
   2. ship_fits_row returns ERROR.
   3. ship_fits_col returns ERROR.
   4. record_progress returns ERROR.
+  5. trail_number returns ERROR.
 
-Called By:  solve_problem
+Called By:  run_rules
 
 Side Effects: See assign_battleships
 
@@ -908,7 +2051,11 @@ int assign_destroyers(     /* ARGUMENTS    */
 	  (rown->submarines)));
       if (spares < 2)
 	continue;
-      IFF(ship_fits_row(row, 2, &fits, world));
+      if (QUEUED(RULE_ASSIGN_DESTROYERS, *rown))
+	{
+	  IFF(ship_fits_row(row, 2, &(rown->fits[2]), world));
+	}
+      fits SET_TO rown->fits[2];
       rows_fits[row] SET_TO
 	(((fits - rown->destroyers) > 0) ? (fits - rown->destroyers) : 0);
       total_fits SET_TO (total_fits + rows_fits[row]);
@@ -926,7 +2073,11 @@ int assign_destroyers(     /* ARGUMENTS    */
 	  (coln->submarines)));
       if (spares < 2)
 	continue;
-      IFF(ship_fits_col(col, 2, &fits, world));
+      if (QUEUED(RULE_ASSIGN_DESTROYERS, *coln))
+	{
+	  IFF(ship_fits_col(col, 2, &(coln->fits[2]), world));
+	}
+      fits SET_TO coln->fits[2];
       cols_fits[col] SET_TO
 	(((fits - coln->destroyers) > 0) ? (fits - coln->destroyers) : 0);
       total_fits SET_TO (total_fits + cols_fits[col]);
@@ -939,6 +2090,7 @@ int assign_destroyers(     /* ARGUMENTS    */
       assign SET_TO (world->destroyers_left - (total_fits - rows_fits[row]));
       if (assign > 0)
 	{
+	  IFF(trail_number(&(world->rows[row].destroyers), world));
 	  world->rows[row].destroyers SET_TO
 	    (world->rows[row].destroyers + assign);
 	  world->rows_in[world->number_in_rows++] SET_TO row;
@@ -951,6 +2103,7 @@ int assign_destroyers(     /* ARGUMENTS    */
       assign SET_TO (world->destroyers_left - (total_fits - cols_fits[col]));
       if (assign > 0)
 	{
+	  IFF(trail_number(&(world->cols[col].destroyers), world));
 	  world->cols[col].destroyers SET_TO
 	    (world->cols[col].destroyers + assign);
 	  world->cols_in[world->number_in_cols++] SET_TO col;
@@ -964,7 +2117,9 @@ int assign_destroyers(     /* ARGUMENTS    */
 	IFF(record_progress("assign destroyer", "to", world));
       else
 	IFF(record_progress("assign destroyers", "to", world));
+      IFF(trail_number(&(world->destroyers_left), world));
       world->destroyers_left SET_TO (world->destroyers_left - total_assigned);
+      IFF(trail_number(&(world->destroyers_ass), world));
       world->destroyers_ass SET_TO (world->destroyers_ass + total_assigned);
     }
   return OK;
@@ -980,8 +2135,9 @@ Returned Value: int
   1. assign_submarines_rows returns ERROR.
   2. assign_submarines_cols returns ERROR.
   3. record_progress returns ERROR.
+  4. trail_number returns ERROR.
 
-Called By:  solve_problem
+Called By:  run_rules
 
 Side Effects: This assigns submarines to rows and/or columns, if possible,
 and reports progress, if any.
@@ -1006,16 +2162,20 @@ int assign_submarines(     /* ARGUMENTS    */
   if (world->submarines_left_row ISNT 0)
     {
       IFF(assign_submarines_rows(&total_assigned_row, world));
+      IFF(trail_number(&(world->submarines_left_row), world));
       world->submarines_left_row SET_TO
 	(world->submarines_left_row - total_assigned_row);
+      IFF(trail_number(&(world->submarines_ass_row), world));
       world->submarines_ass_row SET_TO
 	(world->submarines_ass_row + total_assigned_row);
     }
   if (world->submarines_left_col ISNT 0)
     {
       IFF(assign_submarines_cols(&total_assigned_col, world));
+      IFF(trail_number(&(world->submarines_left_col), world));
       world->submarines_left_col SET_TO
 	(world->submarines_left_col - total_assigned_col);
+      IFF(trail_number(&(world->submarines_ass_col), world));
       world->submarines_ass_col SET_TO
 	(world->submarines_ass_col + total_assigned_col);
     }
@@ -1043,6 +2203,7 @@ Returned Value: int
   1. ship_fits_col returns ERROR.
   2. The unassigned submarines do not all fit somewhere in the puzzle:
      "Puzzle has no answer".
+  3. trail_number returns ERROR.
 
 Called By:  assign_submarines
 
@@ -1062,6 +2223,11 @@ is assigned to the column.
 This is not called unless world->submarines_left_col is not 0, so it
 is not necessary to check that.
 
+As in assign_battleships, the number that fit is counted again only in
+columns that are queued. A column that is not queued is not looked at
+for the other way of assigning a submarine either, since it did not
+get one the last time this found nothing to assign.
+
 */
 
 int assign_submarines_cols( /* ARGUMENTS                                 */
@@ -1093,7 +2259,11 @@ int assign_submarines_cols( /* ARGUMENTS                                 */
 	  (coln->destroyers * 2)));
       if (spares < 1)
 	continue;
-      IFF(ship_fits_col(col, 1, &fits, world));
+      if (QUEUED(RULE_ASSIGN_SUBMARINES, *coln))
+	{
+	  IFF(ship_fits_col(col, 1, &(coln->fits[1]), world));
+	}
+      fits SET_TO coln->fits[1];
       if ((fits - coln->submarines) > 0)
 	{
 	  cols_fits[col] SET_TO (fits - coln->submarines);
@@ -1108,11 +2278,12 @@ int assign_submarines_cols( /* ARGUMENTS                                 */
 	(world->submarines_left_col - (total_fits - cols_fits[col]));
       if (assign > 0)
 	{
+	  IFF(trail_number(&(coln->submarines), world));
 	  coln->submarines SET_TO (coln->submarines + assign);
 	  *total_assigned SET_TO (*total_assigned + assign);
 	  world->cols_in[world->number_in_cols++] SET_TO col;
 	}
-      else
+      else if (QUEUED(RULE_ASSIGN_SUBMARINES, *coln))
 	{
 	  singles SET_TO 1;
 	  for (row SET_TO 0; row < world->number_rows; row++)
@@ -1140,6 +2311,7 @@ int assign_submarines_cols( /* ARGUMENTS                                 */
 		assign SET_TO ((coln->aim - coln->got) - coln->submarines);
 	      if (assign > 0)
 		{
+		  IFF(trail_number(&(coln->submarines), world));
 		  coln->submarines SET_TO (coln->submarines + assign);
 		  *total_assigned SET_TO (*total_assigned + assign);
 		  world->cols_in[world->number_in_cols++] SET_TO col;
@@ -1160,6 +2332,7 @@ Returned Value: int
   1. ship_fits_row returns ERROR.
   2. The unassigned submarines do not all fit somewhere in the puzzle:
      "Puzzle has no answer".
+  3. trail_number returns ERROR.
 
 Called By:  assign_submarines
 
@@ -1181,6 +2354,11 @@ Notes:
 This is not called unless world->submarines_left_row is not 0, so it
 is not necessary to check that.
 
+As in assign_battleships, the number that fit is counted again only in
+rows that are queued. A row that is not queued is not looked at for
+the other way of assigning a submarine either, since it did not get
+one the last time this found nothing to assign.
+
 The ship_fits_row function sets the value of fits.
 
 */
@@ -1214,7 +2392,11 @@ int assign_submarines_rows( /* ARGUMENTS                                 */
 	  (rown->destroyers * 2)));
       if (spares < 1)
 	continue;
-      IFF(ship_fits_row(row, 1, &fits, world));
+      if (QUEUED(RULE_ASSIGN_SUBMARINES, *rown))
+	{
+	  IFF(ship_fits_row(row, 1, &(rown->fits[1]), world));
+	}
+      fits SET_TO rown->fits[1];
       if ((fits - rown->submarines) > 0)
 	{
 	  rows_fits[row] SET_TO (fits - rown->submarines);
@@ -1229,11 +2411,12 @@ int assign_submarines_rows( /* ARGUMENTS                                 */
 	(world->submarines_left_row - (total_fits - rows_fits[row]));
       if (assign > 0)
 	{
+	  IFF(trail_number(&(rown->submarines), world));
 	  rown->submarines SET_TO (rown->submarines + assign);
 	  *total_assigned SET_TO (*total_assigned + assign);
 	  world->rows_in[world->number_in_rows++] SET_TO row;
 	}
-      else
+      else if (QUEUED(RULE_ASSIGN_SUBMARINES, *rown))
 	{
 	  singles SET_TO 1;
 	  for (col SET_TO 0; col < world->number_cols; col++)
@@ -1261,6 +2444,7 @@ int assign_submarines_rows( /* ARGUMENTS                                 */
 		assign SET_TO ((rown->aim - rown->got) - rown->submarines);
 	      if (assign > 0)
 		{
+		  IFF(trail_number(&(rown->submarines), world));
 		  rown->submarines SET_TO (rown->submarines + assign);
 		  *total_assigned SET_TO (*total_assigned + assign);
 		  world->rows_in[world->number_in_rows++] SET_TO row;
@@ -1273,2880 +2457,3423 @@ int assign_submarines_rows( /* ARGUMENTS                                 */
 
 /*************************************************************************/
 
-/* copy_bap
+/* attach_block
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. copy_strip returns ERROR.
-  2. copy_guesses returns ERROR.
+Returned Value: int (OK)
 
-Called By:  try_guessing
+Called By:
+  clone_bap
+  generate_bap
+  make_block
+  try_guessing
+
+Side Effects: This lays out the arrays of a world sized by the grid in
+the given block of memory, which must be at least as long as
+size_block says, and points the world at them. The block is not
+cleared or filled in here.
+
+Notes:
 
-Side Effects: This copies the world model into the world_copy model,
-except that rows_in and cols_in are not copied.
+The bit masks come first so that they are aligned, then the strips,
+then the lists of strips on which progress was made, then the
+locations, and then the squares, each row of them after the one
+before. world->block_bytes is set to the size of all that, which is
+what copy_bap copies. The row pointers of locations and squares come
+last. They point into the same block, so they are never copied; they
+are set up here for each block.
 
 */
 
-int copy_bap(                   /* ARGUMENTS                      */
- struct bap_world * world_copy, /* puzzle model being copied into */
- struct bap_world * world)      /* puzzle model being copied from */
+int attach_block(          /* ARGUMENTS                         */
+ char * block,             /* memory to lay out arrays in       */
+ int number_rows,          /* number of rows in puzzle          */
+ int number_cols,          /* number of columns in puzzle       */
+ struct bap_world * world) /* puzzle model, pointed at block    */
 {
-  const char * name SET_TO "copy_bap";
-  int row;         /* index of row being processed         */
-  int col;         /* index of column being processed      */
-  int n;           /* index of other array being processed */
+  const char * name SET_TO "attach_block";
+  long copied;       /* bytes of block copied by copy_bap        */
+  long bytes;        /* bytes of block altogether                */
+  char * next;       /* next unused byte of block                */
+  int * locations;   /* first row of locations                   */
+  char * squares;    /* first row of squares                     */
+  int row;
 
-  world_copy->battleships_ass SET_TO world->battleships_ass;
-  world_copy->battleships_left SET_TO world->battleships_left;
-  for (col SET_TO 0; col < world->number_cols; col++)
-    {
-      IFF(copy_strip(&(world_copy->cols[col]), &(world->cols[col])));
-    }
-  world_copy->cruisers_ass SET_TO world->cruisers_ass;
-  world_copy->cruisers_left SET_TO world->cruisers_left;
-  world_copy->destroyers_ass SET_TO world->destroyers_ass;
-  world_copy->destroyers_left SET_TO world->destroyers_left;
-  world_copy->exes SET_TO world->exes;
-  world_copy->find_all SET_TO world->find_all;
-  for (n SET_TO 0; n < world->logic_line; n++)
+  IFF(size_block(number_rows, number_cols, &copied, &bytes));
+  world->block SET_TO block;
+  world->block_bytes SET_TO copied;
+  next SET_TO block;
+  world->ship_rows SET_TO (unsigned long long *)next;
+  next SET_TO (next + (number_rows * sizeof(unsigned long long)));
+  world->water_rows SET_TO (unsigned long long *)next;
+  next SET_TO (next + (number_rows * sizeof(unsigned long long)));
+  world->ship_cols SET_TO (unsigned long long *)next;
+  next SET_TO (next + (number_cols * sizeof(unsigned long long)));
+  world->water_cols SET_TO (unsigned long long *)next;
+  next SET_TO (next + (number_cols * sizeof(unsigned long long)));
+  world->rows SET_TO (struct strip *)next;
+  next SET_TO (next + (number_rows * sizeof(struct strip)));
+  world->cols SET_TO (struct strip *)next;
+  next SET_TO (next + (number_cols * sizeof(struct strip)));
+  world->rows_in SET_TO (int *)next;
+  next SET_TO (next + (number_rows * sizeof(int)));
+  world->cols_in SET_TO (int *)next;
+  next SET_TO (next + (number_cols * sizeof(int)));
+  locations SET_TO (int *)next;
+  next SET_TO (next + ((long)number_rows * number_cols * sizeof(int)));
+  squares SET_TO next;
+  next SET_TO (block + ((copied + 7) & ~7L));
+  world->locations SET_TO (int **)next;
+  next SET_TO (next + (number_rows * sizeof(int *)));
+  world->squares SET_TO (char **)next;
+  for (row SET_TO 0; row < number_rows; row++)
     {
-      strcpy(world_copy->logic[n], world->logic[n]);
+      world->locations[row] SET_TO (locations + (row * number_cols));
+      world->squares[row] SET_TO (squares + (row * number_cols));
     }
-  IFF(copy_guesses(world_copy->guesses_tried, world->guesses_tried,
-		   world->number_guesses_tried));
-  world_copy->logic_line SET_TO world->logic_line;
-  world_copy->number_cols SET_TO world->number_cols;
-  world_copy->number_in_cols SET_TO 0;
-  world_copy->number_guesses_tried SET_TO world->number_guesses_tried;
-  world_copy->number_rows SET_TO world->number_rows;
-  world_copy->number_in_rows SET_TO 0;
-  world_copy->print_all SET_TO world->print_all;
-  world_copy->progress SET_TO 0;
-  for (row SET_TO 0; row < world->number_rows; row++)
+  return OK;
+}
+
+/*************************************************************************/
+
+/* bap_close_session
+
+Returned Value: int (OK)
+
+Called By:  bap_open_session (and programs using libbap)
+
+Side Effects: This frees everything made for the session, and the
+session itself. A NULL session is ignored.
+
+*/
+
+int bap_close_session(         /* ARGUMENTS                  */
+ struct bap_session * session) /* session to close, or NULL  */
+{
+  const char * name SET_TO "bap_close_session";
+  struct bap_world * world;
+
+  if (session ISNT NULL)
     {
-      IFF(copy_strip(&(world_copy->rows[row]), &(world->rows[row])));
-      for (col SET_TO 0; col < world->number_cols; col++)
-	{
-	  world_copy->squares[row][col] SET_TO world->squares[row][col];
-	  world_copy->locations[row][col] SET_TO world->locations[row][col];
-	}
+      world SET_TO &(session->world);
+      free(world->block);
+      free(world->logic);
+      free(world->guesses_tried);
+      free(world->path);
+      if (world->trail)
+	free(world->trail->changes);
+      free(world->trail);
+      free(session->changed);
+      free(session->listed);
+      free(session->moves);
+      free(session->squares);
+      free(session->text);
+      free(session);
     }
-  world_copy->submarines_ass_col SET_TO world->submarines_ass_col;
-  world_copy->submarines_ass_row SET_TO world->submarines_ass_row;
-  world_copy->submarines_left_col SET_TO world->submarines_left_col;
-  world_copy->submarines_left_row SET_TO world->submarines_left_row;
-  world_copy->undone SET_TO world->undone;
-  world_copy->verbose SET_TO world->verbose;
   return OK;
 }
 
 /*************************************************************************/
 
-/* copy_guess
+/* bap_free_result
 
 Returned Value: int (OK)
 
 Called By:
-  copy_guesses
-  try_guessing
+  main
+  serve_request
+  (and programs using libbap)
 
-Side Effects: This copies the guess_original into the guess_copy.
+Side Effects: This frees the answer of a result filled in by bap_solve
+(or solve_result).
+The rest of the result may still be read.
 
 */
 
-int copy_guess(                 /* ARGUMENTS          */
- struct guess * guess_copy,     /* guess to copy into */
- struct guess * guess_original) /* guess to copy from */
+int bap_free_result(          /* ARGUMENTS                    */
+ struct bap_result * result)  /* result of bap_solve to free  */
 {
-  const char * name SET_TO "copy_guess";
+  const char * name SET_TO "bap_free_result";
 
-  guess_copy->row SET_TO guess_original->row;
-  guess_copy->col SET_TO guess_original->col;
-  guess_copy->size SET_TO guess_original->size;
-  guess_copy->in_row SET_TO guess_original->in_row;
+  free(result->answer);
+  result->answer SET_TO NULL;
   return OK;
 }
 
 /*************************************************************************/
 
-/* copy_guesses
+/* bap_init_request
+
+Returned Value: int (OK)
+
+Called By:  fill_request (and programs using libbap)
+
+Side Effects: This sets every field of the request to its default (see
+libbap.h): one answer is found by the rules of the constructive
+strategy, using the bit masks and the worklist, with no trail and no
+function taking answers. The text must be set before the request is
+given to bap_solve.
+
+*/
+
+int bap_init_request(           /* ARGUMENTS                  */
+ struct bap_request * request)  /* request, filled in here    */
+{
+  const char * name SET_TO "bap_init_request";
+
+  request->bits SET_TO 1;
+  request->branch SET_TO BRANCH_LARGEST;
+  request->data SET_TO NULL;
+  request->engine SET_TO ENGINE_RULES;
+  request->find_all SET_TO 0;
+  request->in_place SET_TO 0;
+  request->limit SET_TO 0;
+  request->rules SET_TO 0;
+  request->strategy SET_TO STRATEGY_CONSTRUCT;
+  request->take_answer SET_TO NULL;
+  request->text SET_TO NULL;
+  request->worklist SET_TO 1;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* bap_next_hint
 
 Returned Value: int
-  If any of the following errors occur, this returns ERROR.
+  If the status of the hint is BAP_ERROR, this returns ERROR.
   Otherwise, it returns OK.
-  1. copy_guess returns ERROR. (not currently checked)
 
-Called By:
-  copy_bap
-  make_guesses_battleships
-  make_guesses_cruisers
-  make_guesses_destroyers
-  make_guesses_submarines
+Called By:  programs using libbap
 
-Side Effects: This copies the first number_guesses entries from the
-guesses array into the guesses_copy array.
+Side Effects: This fills in the hint with the next rule that sets
+squares of the session as they are (see find_hint). The squares are
+left as they were.
 
 */
 
-int copy_guesses(             /* ARGUMENTS                     */
- struct guess * guesses_copy, /* array of guesses to copy into */
- struct guess * guesses,      /* array of guesses to copy from */
- int number_guesses)          /* number of guesses to copy     */
+int bap_next_hint(             /* ARGUMENTS                  */
+ struct bap_session * session, /* session to give hint for   */
+ struct bap_hint * hint)       /* hint, filled in here       */
 {
-  const char * name SET_TO "copy_guesses";
-  int n; /* index for guesses          */
+  const char * name SET_TO "bap_next_hint";
+  struct bap_world * world;
+  int failed;        /* set to ERROR if status is BAP_ERROR */
+
+  world SET_TO &(session->world);
+  hint->message[0] SET_TO 0;
+  world->message SET_TO hint->message;
+  failed SET_TO find_hint(session, hint);
+  world->message SET_TO NULL;
+  if (failed ISNT OK)
+    hint->status SET_TO BAP_ERROR;
+  IFF(failed);
+  return OK;
+}
 
-  for (n SET_TO 0; n < number_guesses; n++)
+/*************************************************************************/
+
+/* bap_open_session
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the session: "Out of memory".
+  2. start_session returns ERROR.
+
+Called By:  programs using libbap
+
+Side Effects: This makes a session for the puzzle given as text in the
+request (see start_session) and sets *session to point to it. If
+anything goes wrong, *session is set to NULL, everything made is freed,
+and the message says what went wrong.
+
+Notes:
+
+The message has room for BAP_MESSAGE_SIZE characters. It is filled in
+here directly if the session cannot be made, since there is no world
+yet for CHB to put it in.
+
+*/
+
+int bap_open_session(            /* ARGUMENTS                          */
+ struct bap_request * request,   /* puzzle to play, and how            */
+ struct bap_session ** session,  /* session made, set here             */
+ char * message)                 /* error, or empty if none, set here  */
+{
+  const char * name SET_TO "bap_open_session";
+  struct bap_session * the_session; /* session being made              */
+  struct bap_world * world;         /* world of the_session            */
+  int failed;                       /* value returned by start_session */
+
+  *session SET_TO NULL;
+  message[0] SET_TO 0;
+  the_session SET_TO (struct bap_session *)malloc(sizeof(struct bap_session));
+  if (the_session IS NULL)
     {
-      copy_guess(&(guesses_copy[n]), &(guesses[n]));
+      snprintf(message, BAP_MESSAGE_SIZE, "%s: %s", name, "Out of memory");
+      return ERROR;
     }
+  the_session->changed SET_TO NULL;
+  the_session->listed SET_TO NULL;
+  the_session->moves SET_TO NULL;
+  the_session->number_moves SET_TO 0;
+  the_session->squares SET_TO NULL;
+  the_session->text SET_TO NULL;
+  the_session->text_size SET_TO 0;
+  world SET_TO &(the_session->world);
+  init_world(world);
+  world->message SET_TO message;
+  failed SET_TO start_session(request, the_session);
+  world->message SET_TO NULL;
+  if (failed ISNT OK)
+    bap_close_session(the_session);
+  else
+    *session SET_TO the_session;
+  IFF(failed);
   return OK;
 }
 
 /*************************************************************************/
 
-/* copy_strip
+/* bap_retract_square
 
-Returned Value: int (OK)
+Returned Value: int
+  If the status of the hint is BAP_ERROR, this returns ERROR.
+  Otherwise, it returns OK.
 
-Called By:  copy_bap
+Called By:  programs using libbap
 
-Side Effects: This copies the strip_old into the strip_copy.
+Side Effects: This takes back the last move made in the square at the
+given row and column (see retract_move) and fills in the hint with the
+next rule that sets squares once it is taken back.
 
 */
 
-int copy_strip(             /* ARGUMENTS          */
- struct strip * strip_copy, /* strip to copy into */
- struct strip * strip_old)  /* strip to copy from */
+int bap_retract_square(        /* ARGUMENTS                    */
+ struct bap_session * session, /* session to take move back in */
+ int row,                      /* row index of square          */
+ int col,                      /* column index of square       */
+ struct bap_hint * hint)       /* hint, filled in here         */
 {
-  const char * name SET_TO "copy_strip";
+  const char * name SET_TO "bap_retract_square";
+  struct bap_world * world;
+  int failed;        /* set to ERROR if status is BAP_ERROR */
+
+  world SET_TO &(session->world);
+  hint->message[0] SET_TO 0;
+  world->message SET_TO hint->message;
+  failed SET_TO retract_move(row, col, session, hint);
+  world->message SET_TO NULL;
+  if (failed ISNT OK)
+    hint->status SET_TO BAP_ERROR;
+  IFF(failed);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* bap_set_square
+
+Returned Value: int
+  If the status of the hint is BAP_ERROR, this returns ERROR.
+  Otherwise, it returns OK.
+
+Called By:  programs using libbap
+
+Side Effects: This puts the given character in the square at the given
+row and column as a move of the session (see play_move) and fills in
+the hint with the next rule that sets squares once it is made.
 
-  strip_copy->aim SET_TO strip_old->aim;
-  strip_copy->battleships SET_TO strip_old->battleships;
-  strip_copy->cruisers SET_TO strip_old->cruisers;
-  strip_copy->destroyers SET_TO strip_old->destroyers;
-  strip_copy->done SET_TO strip_old->done;
-  strip_copy->dry SET_TO strip_old->dry;
-  strip_copy->exes SET_TO strip_old->exes;
-  strip_copy->got SET_TO strip_old->got;
-  strip_copy->submarines SET_TO strip_old->submarines;
+*/
+
+int bap_set_square(            /* ARGUMENTS                    */
+ struct bap_session * session, /* session to make move in      */
+ int row,                      /* row index of square          */
+ int col,                      /* column index of square       */
+ char item,                    /* character to put in square   */
+ struct bap_hint * hint)       /* hint, filled in here         */
+{
+  const char * name SET_TO "bap_set_square";
+  struct bap_world * world;
+  int failed;        /* set to ERROR if status is BAP_ERROR */
+
+  world SET_TO &(session->world);
+  hint->message[0] SET_TO 0;
+  world->message SET_TO hint->message;
+  failed SET_TO play_move(row, col, item, session, hint);
+  world->message SET_TO NULL;
+  if (failed ISNT OK)
+    hint->status SET_TO BAP_ERROR;
+  IFF(failed);
   return OK;
 }
 
 /*************************************************************************/
 
-/* dex_ends_col
+/* bap_solve
 
 Returned Value: int
-  If any of the following errors occur, this returns ERROR.
+  If the status of the result is BAP_ERROR, this returns ERROR.
   Otherwise, it returns OK.
-  1. make_water returns ERROR.
 
-Called By:  dex_squares
+Called By:  main (and programs using libbap)
 
-Side Effects: This puts water at the ends of sets of consecutive ship
-parts if they are ships.
+Side Effects: This solves the puzzle given as text in the request, as
+the request says, and fills in the result (see solve_result). The first
+answer is made by solve_result and freed by bap_free_result. Everything
+else made for the puzzle is freed before this returns.
 
 Notes:
 
-See documentation of dex_squares.
+This is the entry point of libbap (see libbap.h). It prints nothing
+and keeps nothing between calls. The world is on the stack, and the
+arena and trail solve_result leaves in it are freed here.
 
-This iterates beyond the end of the column so that no special code is
-required for what to do at the end.
+*/
+
+int bap_solve(                  /* ARGUMENTS                    */
+ struct bap_request * request,  /* puzzle to solve, and how     */
+ struct bap_result * result)    /* how solving came out         */
+{
+  const char * name SET_TO "bap_solve";
+  struct bap_world world1;
+  struct bap_world * world;
+  int failed;          /* set to ERROR if status is BAP_ERROR */
+
+  world SET_TO &world1;
+  init_world(world);
+  failed SET_TO solve_result(request, result, world);
+  if (world->arena)
+    free_arena(world->arena);
+  if (world->trail)
+    free(world->trail->changes);
+  free(world->trail);
+  IFF(failed);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* bits_cover_col
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. bits_fit_col_row returns ERROR.
+
+Called By:  try_square_blank
+
+Side Effects: This sets bit row of *cover for each square in the given
+column that might be covered by a destroyer, cruiser, or battleship
+lying in the column, according to bits_fit_col_row. Only ships that are
+assigned to the column or not yet assigned are considered.
+
+Notes:
+
+A square whose bit is not set cannot be covered by any such ship, but a
+square whose bit is set may not be coverable either. Submarines are not
+considered here, since try_square_blank checks them as lying in rows.
 
 */
 
-int dex_ends_col(          /* ARGUMENTS                        */
- int col,                  /* index of column being processed  */
- struct bap_world * world) /* puzzle model                     */
+int bits_cover_col(          /* ARGUMENTS                          */
+ int col,                    /* index of column being checked      */
+ unsigned long long * cover, /* set here to squares maybe coverable */
+ struct bap_world * world)   /* puzzle model                       */
 {
-  const char * name SET_TO "dex_ends_col";
-  int row;        /* index of row being processed     */
-  int length;     /* number of consecutive ship parts */
+  const char * name SET_TO "bits_cover_col";
+  int row;
+  int size;
+  int is_legal;
+  int allowed;  /* set to 1 if a ship of the given size may be in col */
 
-  length SET_TO 0;
-  for (row SET_TO 0; row <= world->number_rows; row++)
+  *cover SET_TO 0;
+  for (size SET_TO 2; size < 5; size++)
     {
-      if ((square(row, col, world) IS '.') OR (square(row, col, world) IS ' '))
+      if (size IS 2)
+	allowed SET_TO
+	  ((world->cols[col].destroyers) OR (world->destroyers_left));
+      else if (size IS 3)
+	allowed SET_TO ((world->cols[col].cruisers) OR (world->cruisers_left));
+      else
+	allowed SET_TO
+	  ((world->cols[col].battleships) OR (world->battleships_left));
+      if (NOT allowed)
+	continue;
+      for (row SET_TO 0; row < (ROWS - (size - 1)); row++)
 	{
-	  if ((length IS 4) OR
-	      ((length IS 3) AND
-	       (((world->cols[col].cruisers) AND
-		 (world->cols[col].aim < 7)) OR
-		((world->cols[col].battleships IS 0) AND
-		 (world->battleships_left IS 0)))) OR
-	      ((length IS 2) AND
-	       (((world->cols[col].destroyers) AND
-		 (world->cols[col].aim < 5)) OR
-		((world->cols[col].battleships IS 0) AND
-		 (world->battleships_left IS 0) AND
-		 (world->cols[col].cruisers IS 0) AND
-		 (world->cruisers_left IS 0)))))
-	    {
-	      if (square(row, col, world) IS ' ')
-		IFF(make_water(row, col, world));
-	      if (square((row - length - 1), col, world) IS ' ')
-		IFF(make_water((row - length - 1), col, world));
-	    }
-	  length SET_TO 0;
+	  is_legal SET_TO 1;
+	  IFF(bits_fit_col_row(col, row, size, &is_legal, world));
+	  if (is_legal)
+	    *cover SET_TO (*cover | (((1ULL << size) - 1) << row));
 	}
-      else
-	length++;
     }
   return OK;
 }
 
 /*************************************************************************/
 
-/* dex_ends_row
+/* bits_cover_row
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. make_water returns ERROR.
+  1. bits_fit_row_col returns ERROR.
 
-Called By:  dex_squares
+Called By:  try_square_blank
 
-Side Effects: This puts water at the ends of sets of consecutive ship
-parts if they are ships.
+Side Effects: This sets bit col of *cover for each square in the given
+row that might be covered by a ship lying in the row, according to
+bits_fit_row_col. Only ships that are assigned to the row or not yet
+assigned are considered.
 
 Notes:
 
-See documentation of dex_squares.
-
-This iterates beyond the end of the row so that no special code is
-required for what to do at the end.
+A square whose bit is not set cannot be covered by any such ship, but a
+square whose bit is set may not be coverable either. Submarines are
+included here, since a submarine that fits in a row also has water or
+blanks all around it.
 
 */
 
-int dex_ends_row(          /* ARGUMENTS                     */
- int row,                  /* index of row being processed  */
- struct bap_world * world) /* puzzle model                  */
+int bits_cover_row(          /* ARGUMENTS                          */
+ int row,                    /* index of row being checked         */
+ unsigned long long * cover, /* set here to squares maybe coverable */
+ struct bap_world * world)   /* puzzle model                       */
 {
-  const char * name SET_TO "dex_ends_row";
-  int col;        /* index of column being processed  */
-  int length;     /* number of consecutive ship parts */
+  const char * name SET_TO "bits_cover_row";
+  int col;
+  int size;
+  int is_legal;
+  int allowed;  /* set to 1 if a ship of the given size may be in row */
 
-  length SET_TO 0;
-  for (col SET_TO 0; col <= world->number_cols; col++)
+  *cover SET_TO 0;
+  for (size SET_TO 1; size < 5; size++)
     {
-      if ((square(row, col, world) IS '.') OR (square(row, col, world) IS ' '))
+      if (size IS 1)
+	allowed SET_TO
+	  ((world->rows[row].submarines) OR (world->submarines_left_row));
+      else if (size IS 2)
+	allowed SET_TO
+	  ((world->rows[row].destroyers) OR (world->destroyers_left));
+      else if (size IS 3)
+	allowed SET_TO ((world->rows[row].cruisers) OR (world->cruisers_left));
+      else
+	allowed SET_TO
+	  ((world->rows[row].battleships) OR (world->battleships_left));
+      if (NOT allowed)
+	continue;
+      for (col SET_TO 0; col < (COLS - (size - 1)); col++)
 	{
-	  if ((length IS 4) OR
-	      ((length IS 3) AND
-	       (((world->rows[row].cruisers) AND
-		 (world->rows[row].aim < 7)) OR
-		((world->rows[row].battleships IS 0) AND
-		 (world->battleships_left IS 0)))) OR
-	      ((length IS 2) AND
-	       (((world->rows[row].destroyers) AND
-		 (world->rows[row].aim < 5)) OR
-		((world->rows[row].battleships IS 0) AND
-		 (world->battleships_left IS 0) AND
-		 (world->rows[row].cruisers IS 0) AND
-		 (world->cruisers_left IS 0)))))
-	    {
-	      if (square(row, col, world) IS ' ')
-		IFF(make_water(row, col, world));
-	      if (square(row, (col - length - 1), world) IS ' ')
-		IFF(make_water(row, (col - length - 1), world));
-	    }
-	  length SET_TO 0;
+	  is_legal SET_TO 1;
+	  IFF(bits_fit_row_col(row, col, size, &is_legal, world));
+	  if (is_legal)
+	    *cover SET_TO (*cover | (((1ULL << size) - 1) << col));
 	}
-      else
-	length++;
     }
   return OK;
 }
 
 /*************************************************************************/
 
-/* dex_square
+/* bits_fit_col_row
 
 Returned Value: int (OK)
 
-Called By:  dex_squares
+Called By:
+  bits_cover_col
+  ship_fits_col_row
 
-Side Effects: This changes an X to a known ship part if it is possible
-to infer what the X must be by looking at the squares above, below,
-right, and left of the given square. If the X is changed, exes for the
-row, column and whole puzzle are updated, and world->progress is set to 1.
+Side Effects: This sets *is_legal to 0 if the bit masks show that a
+ship of the given size cannot be put in the given column with its top
+end at the given row. That is the case if:
+1. any square the ship would cover is water,
+2. any square next to the ship (including diagonally and at the ends)
+   is a ship part, or
+3. the column would have more ship parts than its aim.
+
+Notes:
+
+Is_legal should be set to 1 when this is called. If this leaves it at
+1, the placement may still be illegal for other reasons, which
+ship_fits_col_row checks.
+
+The ship must lie within the puzzle.
 
 */
 
-int dex_square(            /* ARGUMENTS                        */
- int row,                  /* index of row being processed     */
- int col,                  /* index of column being processed  */
- struct bap_world * world) /* puzzle model                     */
+int bits_fit_col_row(      /* ARGUMENTS                           */
+ int col,                  /* index of column being checked       */
+ int row,                  /* index of row of top end of ship     */
+ int size,                 /* size of ship                        */
+ int * is_legal,           /* set here to 0 if ship cannot fit    */
+ struct bap_world * world) /* puzzle model                        */
 {
-  const char * name SET_TO "dex_square";
-  char up;
-  char down;
-  char left;
-  char right;
-
-  up SET_TO square(row - 1, col, world);
-  down SET_TO square(row + 1, col, world);
-  left SET_TO square(row, col - 1, world);
-  right SET_TO square(row, col + 1, world);
-  if ((up IS '.') AND (down IS '.') AND (left IS '.') AND (right IS '.'))
-    {
-      world->squares[row][col] SET_TO 'O';
-      world->rows[row].exes--;
-      world->cols[col].exes--;
-      world->exes--;
-      world->progress SET_TO 1;
-    }
-  else if ((up IS '.') AND ((down IS 'v') OR (down IS '+') OR (down IS 'X')))
-    {
-      world->squares[row][col] SET_TO '^';
-      world->rows[row].exes--;
-      world->cols[col].exes--;
-      world->exes--;
-      world->progress SET_TO 1;
-    }
-  else if ((down IS '.') AND ((up IS '^') OR (up IS '+') OR (up IS 'X')))
-    {
-      world->squares[row][col] SET_TO 'v';
-      world->rows[row].exes--;
-      world->cols[col].exes--;
-      world->exes--;
-      world->progress SET_TO 1;
-    }
-  else if ((left IS '.') AND
-	   ((right IS '>') OR (right IS '+') OR (right IS 'X')))
-    {
-      world->squares[row][col] SET_TO '<';
-      world->rows[row].exes--;
-      world->cols[col].exes--;
-      world->exes--;
-      world->progress SET_TO 1;
-    }
-  else if ((right IS '.') AND
-	   ((left IS '<') OR (left IS '+') OR (left IS 'X')))
-    {
-      world->squares[row][col] SET_TO '>';
-      world->rows[row].exes--;
-      world->cols[col].exes--;
-      world->exes--;
-      world->progress SET_TO 1;
-    }
-  else if ((((up IS '^') OR (up IS 'X') OR (up IS '+')) AND
-	    ((down IS 'v') OR (down IS 'X') OR (down IS '+'))) OR
-	   (((left IS '<') OR (left IS 'X') OR (left IS '+')) AND
-	    ((right IS '>') OR (right IS 'X') OR (right IS '+'))))
-    {
-      world->squares[row][col] SET_TO '+';
-      world->rows[row].exes--;
-      world->cols[col].exes--;
-      world->exes--;
-      world->progress SET_TO 1;
-    }
-  return OK;
-}
+  const char * name SET_TO "bits_fit_col_row";
+  unsigned long long span;  /* squares the ship would cover         */
+  unsigned long long halo;  /* span plus one square at each end     */
+  unsigned long long near;  /* ship parts in columns left and right */
+  int total;                /* ship parts in column with the ship   */
+
+  span SET_TO (((1ULL << size) - 1) << row);
+  halo SET_TO
+    ((span | (span << 1) | (span >> 1)) &
+     (~0ULL >> (64 - ROWS)));
+  near SET_TO 0;
+  if (col > 0)
+    near SET_TO world->ship_cols[col - 1];
+  if (col < (COLS - 1))
+    near SET_TO (near | world->ship_cols[col + 1]);
+  total SET_TO (size + __builtin_popcountll(world->ship_cols[col] & ~span));
+  if ((near & halo) OR
+      (world->ship_cols[col] & halo & ~span) OR
+      (world->water_cols[col] & span) OR
+      (total > world->cols[col].aim))
+    *is_legal SET_TO 0;
+  return OK;
+}
 
 /*************************************************************************/
 
-/* dex_squares
+/* bits_fit_row_col
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. dex_square returns ERROR.
-  2. dex_ends_row returns ERROR.
-  3. dex_ends_col returns ERROR.
+Returned Value: int (OK)
 
-Called By:  solve_problem
+Called By:
+  bits_cover_row
+  ship_fits_row_col
 
-Side Effects: This changes all X's in the puzzle to known ship parts,
-if possible, and puts water next to any ship ends it makes from Xs, if
-water is not already there. See dex_square and the Notes here for
-details. If any squares are de-exed, this reports that fact.
+Side Effects: This sets *is_legal to 0 if the bit masks show that a
+ship of the given size cannot be put in the given row with its left
+end at the given column. That is the case if:
+1. any square the ship would cover is water,
+2. any square next to the ship (including diagonally and at the ends)
+   is a ship part, or
+3. the row would have more ship parts than its aim.
 
 Notes:
 
-There may be situations in which calling dex_squares twice in a row will
-produce changes both times. Have not yet found an example or disproved.
-
-For the purpose of reporting progress, this assumes world->progress is
-set to 0 before it starts.
-
-This checks if several ship parts next to each other along a strip
-make a ship. If so, it changes the ends and middles if necessary, and
-puts water next to the ends if water is not already there.
-
-A set of adjacent ship parts in a strip makes a ship if any of
-the following apply:
-1. there are four ship parts - must be a battleship.
-2. there are three ship parts and either:
-   a. a cruiser is assigned to the strip, and the aim for strip is
-      less than 7, or
-   b. no larger ship is available to go in the strip,
-   in both cases, there cannot be a larger ship covering the three ship parts.
-3. there are two ship parts and either:
-   a. a destroyer is assigned to the strip, and the aim for strip is
-      less than 5, or
-   b. no larger ship is available to go in the strip,
-   in both cases there cannot be a larger ship covering the two ship parts.
-
-There are other cases in which the adjacent squares must be a ship.
-The simple ones are picked up by other functions if the strip is full
-(try_full) or only one more ship part is needed in the strip
-(try_full_but_one).
-
-In the configurations: "X XXX" and "XX XX", the blank space in the
-middle will be made water by try_square_blank. Then dex_square will
-recognize that the Xs on either side of the blank square that are part
-of XXX or XX are ship ends.
+Is_legal should be set to 1 when this is called. If this leaves it at
+1, the placement may still be illegal for other reasons, which
+ship_fits_row_col checks.
 
-The two dex_ends_... functions just put water at the ends. Then dex_square
-changes the Xs.
+The ship must lie within the puzzle.
 
 */
 
-int dex_squares(           /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int bits_fit_row_col(      /* ARGUMENTS                           */
+ int row,                  /* index of row being checked          */
+ int col,                  /* index of column of left end of ship */
+ int size,                 /* size of ship                        */
+ int * is_legal,           /* set here to 0 if ship cannot fit    */
+ struct bap_world * world) /* puzzle model                        */
 {
-  const char * name SET_TO "dex_squares";
-  int row;       /* index of row being processed     */
-  int col;       /* index of column being processed  */
-
-  if (world->exes)
-    {
-      for (row SET_TO 0; row < world->number_rows; row++)
-	{
-	  if (world->rows[row].exes)
-	    IFF(dex_ends_row(row, world));
-	}
-      for (col SET_TO 0; col < world->number_cols; col++)
-	{
-	  if (world->cols[col].exes)
-	    IFF(dex_ends_col(col, world));
-	}
-      for (row SET_TO 0; row < world->number_rows; row++)
-	{
-	  if (world->rows[row].exes)
-	    {
-	      for (col SET_TO 0; col < world->number_cols; col++)
-		{
-		  if (world->squares[row][col] IS 'X')
-		    IFF(dex_square(row, col, world));
-		}
-	    }
-	}
-    }
-  if (world->progress)
-    {
-      strcpy(world->logic[world->logic_line++], "identify ship parts:");
-      if (world->print_all)
-	{
-	  print_bap(world);
-	  printf("%s\n\n", world->logic[world->logic_line - 1]);
-	}
-    }
+  const char * name SET_TO "bits_fit_row_col";
+  unsigned long long span;  /* squares the ship would cover         */
+  unsigned long long halo;  /* span plus one square at each end     */
+  unsigned long long near;  /* ship parts in rows above and below   */
+  int total;                /* ship parts in row with the ship      */
+
+  span SET_TO (((1ULL << size) - 1) << col);
+  halo SET_TO
+    ((span | (span << 1) | (span >> 1)) &
+     (~0ULL >> (64 - COLS)));
+  near SET_TO 0;
+  if (row > 0)
+    near SET_TO world->ship_rows[row - 1];
+  if (row < (ROWS - 1))
+    near SET_TO (near | world->ship_rows[row + 1]);
+  total SET_TO (size + __builtin_popcountll(world->ship_rows[row] & ~span));
+  if ((near & halo) OR
+      (world->ship_rows[row] & halo & ~span) OR
+      (world->water_rows[row] & span) OR
+      (total > world->rows[row].aim))
+    *is_legal SET_TO 0;
   return OK;
 }
 
 /*************************************************************************/
 
-/* enx_square
+/* blanks_col
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. make_water returns ERROR.
+Returned Value: int (OK)
 
 Called By:
-  extend_ends
-  extend_horizontal
-  extend_vertical
-  place_ships_col
-  place_ships_row
-  try_cross_col_fill_row
-  try_cross_row_fill_col
-  try_full
-  try_full_but_one_col
-  try_full_but_one_row
-  try_full_but_two_col
-  try_full_but_two_row
+  legal_col_across
+  legal_col_beside
 
-Side Effects: This puts an X in the square world->squares[row][col],
-puts water in the squares adjacent to its corners, updates the
-row and column got for the square, updates the row and column exes
-for the square, updates the exes for the puzzle, and sets world->progress
-to 1.
+Side Effects: This sets bit row of *blanks for each blank square in
+the given column. If the column is outside the puzzle, *blanks is set
+to 0, since squares outside the puzzle are water.
+
+Notes:
+
+This is called only if world->bits is 1, since the masks are not kept
+for larger grids. Otherwise the callers look at the squares one at a
+time.
 
 */
 
-int enx_square(            /* ARGUMENTS                        */
- int row,                  /* index of row being processed     */
- int col,                  /* index of column being processed  */
- struct bap_world * world) /* puzzle model                     */
+int blanks_col(               /* ARGUMENTS                        */
+ int col,                     /* index of column being checked    */
+ unsigned long long * blanks, /* set here to blank squares in col */
+ struct bap_world * world)    /* puzzle model                     */
 {
-  const char * name SET_TO "enx_square";
+  const char * name SET_TO "blanks_col";
 
-  world->squares[row][col] SET_TO 'X';
-  world->rows[row].exes++;
-  world->cols[col].exes++;
-  world->exes++;
-  world->rows[row].got++;
-  world->cols[col].got++;
-  IFF(make_water(row - 1, col - 1, world));
-  IFF(make_water(row - 1, col + 1, world));
-  IFF(make_water(row + 1, col - 1, world));
-  IFF(make_water(row + 1, col + 1, world));
-  world->progress SET_TO 1;
+  *blanks SET_TO 0;
+  if ((col < 0) OR (col >= world->number_cols));
+  else
+    *blanks SET_TO
+      (~(world->ship_cols[col] | world->water_cols[col]) &
+       (~0ULL >> (64 - world->number_rows)));
   return OK;
 }
 
 /*************************************************************************/
 
-/* explain_bap
+/* blanks_row
 
 Returned Value: int (OK)
 
-Called By:  solve_problem
+Called By:
+  legal_row_across
+  legal_row_beside
 
-Side Effects: This prints the explanation of the steps in solving the
-puzzle, which has been accumulated in the world->logic array of strings.
+Side Effects: This sets bit col of *blanks for each blank square in
+the given row. If the row is outside the puzzle, *blanks is set to 0,
+since squares outside the puzzle are water.
+
+Notes:
+
+This is called only if world->bits is 1, since the masks are not kept
+for larger grids. Otherwise the callers look at the squares one at a
+time.
 
 */
 
-int explain_bap(           /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int blanks_row(               /* ARGUMENTS                        */
+ int row,                     /* index of row being checked       */
+ unsigned long long * blanks, /* set here to blank squares in row */
+ struct bap_world * world)    /* puzzle model                     */
 {
-  const char * name SET_TO "explain_bap";
-  int line;      /* index of logic line */
+  const char * name SET_TO "blanks_row";
 
-  printf("\nEXPLANATION\n-----------\n");
-  for (line SET_TO 0; line < world->logic_line; line++)
-    printf("%s\n", world->logic[line]);
+  *blanks SET_TO 0;
+  if ((row < 0) OR (row >= world->number_rows));
+  else
+    *blanks SET_TO
+      (~(world->ship_rows[row] | world->water_rows[row]) &
+       (~0ULL >> (64 - world->number_cols)));
   return OK;
 }
 
 /*************************************************************************/
 
-/* extend_ends
+/* check_answer
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. enx_square returns ERROR.
-
-Called By:  init_solution
+  1. The take_answer function of the request of the job does not
+     return OK: "Answer not taken".
 
-Side Effects: This looks at ship ends and extends them if
-possible. If any ship end is extended, this reports that fact.
+Called By:
+  dlx_answer
+  solve_problem
 
-Notes:
+Side Effects: This counts an answer found while solving a batch of
+puzzles (see run_batch). If the problem has an answer file, and the
+answer is the same as the one in the file, the job is marked as
+matched. Nothing is printed. An answer that is not the same is copied
+into the job, if it has room for one (see generate_givens).
 
-This needs to be called only once, since an end with a blank square
-by its open end can only occur in the original puzzle statement. The
-solution process does not create an end with a blank by its open end.
+When the job is that of bap_solve, the first answer is copied into the
+job, and each answer is handed to the take_answer function of the
+request, if it has one.
 
 */
 
-int extend_ends(           /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int check_answer(          /* ARGUMENTS            */
+ struct bap_world * world) /* puzzle model, solved */
 {
-  const char * name SET_TO "extend_ends";
+  const char * name SET_TO "check_answer";
+  struct job * the_job; /* job for puzzle being solved         */
+  int same;             /* set to 0 if a square is different  */
   int row;
   int col;
-  char item;
 
-  world->progress SET_TO 0;
-  for (row SET_TO 0; row < world->number_rows; row++)
+  the_job SET_TO world->job;
+  the_job->number_answers++;
+  if (the_job->answer ISNT NULL)
     {
-      for (col SET_TO 0; col < world->number_cols; col++)
+      same SET_TO 1;
+      for (row SET_TO 0; row < world->number_rows; row++)
 	{
-	  item SET_TO world->squares[row][col];
-	  if (item IS '<')
-	    {
-	      if (square(row, col + 1, world) IS ' ')
-		IFF(enx_square(row, col + 1, world));
-	    }
-	  else if (item IS '>')
-	    {
-	      if (square(row, col - 1, world) IS ' ')
-		IFF(enx_square(row, col - 1, world));
-	    }
-	  else if (item IS 'v')
-	    {
-	      if (square(row - 1, col, world) IS ' ')
-		IFF(enx_square(row - 1, col, world));
-	    }
-	  else if (item IS '^')
+	  for (col SET_TO 0; col < world->number_cols; col++)
 	    {
-	      if (square(row + 1, col, world) IS ' ')
-		IFF(enx_square(row + 1, col, world));
+	      if (world->squares[row][col] ISNT
+		  the_job->answer[(row * world->number_cols) + col])
+		same SET_TO 0;
 	    }
 	}
-    }
-  if (world->progress)
-    {
-      strcpy(world->logic[world->logic_line++], "extend ship ends");
-      if (world->print_all)
+      if (same)
+	the_job->matched SET_TO 1;
+      else if (the_job->other ISNT NULL)
 	{
-	  print_bap(world);
-	  printf("%s\n\n", world->logic[world->logic_line - 1]);
+	  for (row SET_TO 0; row < world->number_rows; row++)
+	    memcpy((the_job->other + (row * world->number_cols)),
+		   world->squares[row], world->number_cols);
 	}
     }
+  if ((the_job->first ISNT NULL) AND (the_job->number_answers IS 1))
+    {
+      for (row SET_TO 0; row < world->number_rows; row++)
+	memcpy((the_job->first + (row * world->number_cols)),
+	       world->squares[row], world->number_cols);
+    }
+  if ((the_job->request ISNT NULL) AND
+      (the_job->request->take_answer ISNT NULL))
+    CHB((the_job->request->take_answer(world->squares, world->number_rows,
+					world->number_cols,
+					the_job->request->data) ISNT OK),
+	"Answer not taken");
   return OK;
 }
 
 /*************************************************************************/
 
-/* extend_horizontal
+/* clear_hint
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. make_water returns ERROR.
-  2. enx_square returns ERROR.
-  3. record_progress returns ERROR.
+Returned Value: int (OK)
 
-Called By:  extend_middle
+Called By:
+  find_hint
+  play_move
 
-Side Effects: This extends a ship middle horizontally. The squares
-above and below the ship middle are set to water if not already
-water. The squares right and left, if blank, are set to unknown ship
-part and are padded with water.
+Side Effects: This points the hint at the room the session keeps for
+it, sets it to list no squares, no rule, and no explanation, and copies
+the squares of the session as they are now into it. The status is left
+for the caller to set.
 
 */
 
-int extend_horizontal(     /* ARGUMENTS                                      */
- int row,                  /* the row in which the ship middle is located    */
- int col,                  /* the column in which the ship middle is located */
- struct bap_world * world) /* puzzle model                                   */
+int clear_hint(                /* ARGUMENTS                  */
+ struct bap_session * session, /* session giving hint        */
+ struct bap_hint * hint)       /* hint, filled in here       */
 {
-  const char * name SET_TO "extend_horizontal";
+  const char * name SET_TO "clear_hint";
+  struct bap_world * world;
+  int row;
 
-  CHK(((square(row, col + 1, world) IS '.') OR
-       (square(row, col - 1, world) IS '.')), "Puzzle has no answer");
-  IFF(make_water(row - 1, col, world));
-  IFF(make_water(row + 1, col, world));
-  if (square(row, col + 1, world) IS ' ')
-    IFF(enx_square(row, col + 1, world));
-  if (square(row, col - 1, world) IS ' ')
-    IFF(enx_square(row, col - 1, world));
-  if (world->progress)
-    {
-      world->number_in_rows SET_TO 1;
-      world->number_in_cols SET_TO 1;
-      world->rows_in[0] SET_TO row;
-      world->cols_in[0] SET_TO col;
-      IFF(record_progress("extend horizontally", "ship middle at", world));
-    }
+  world SET_TO &(session->world);
+  session->text[0] SET_TO 0;
+  hint->changed SET_TO session->changed;
+  hint->explanation SET_TO session->text;
+  hint->number_changed SET_TO 0;
+  hint->number_cols SET_TO world->number_cols;
+  hint->number_rows SET_TO world->number_rows;
+  hint->rule SET_TO NULL;
+  hint->squares SET_TO session->squares;
+  for (row SET_TO 0; row < world->number_rows; row++)
+    memcpy((session->squares + (row * world->number_cols)),
+	   world->squares[row], world->number_cols);
   return OK;
 }
 
 /*************************************************************************/
 
-/* extend_middle
+/* clone_bap
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. extend_horizontal returns ERROR.
-  2. extend_vertical returns ERROR.
+  1. There is no memory for the block or the branch: "Out of memory".
+  2. size_block, attach_block, copy_bap, make_logic, or copy_guesses
+     returns ERROR.
 
-Called By:  extend_middles
+Called By:
+  queue_guess
+  run_pool
+  save_answer
 
-Side Effects: This extends one middle if possible. If a ship middle is
-extended, this reports that fact.
+Side Effects: This makes world_copy a copy of the world that does not
+share anything sized by the grid or the branch with it. world_copy gets
+its own malloc'ed block and its own copies of the explanation, the list
+of guesses tried, and the path, each only as long as it is in world
+(the path has room for one more guess). free_bap frees them.
 
 */
 
-int extend_middle(         /* ARGUMENTS                 */
- int row,                  /* index of row of middle    */
- int col,                  /* index of column of middle */
- struct bap_world * world) /* puzzle model              */
+int clone_bap(                  /* ARGUMENTS                      */
+ struct bap_world * world_copy, /* puzzle model being copied into */
+ struct bap_world * world)      /* puzzle model being copied from */
 {
-  const char * name SET_TO "extend_middle";
+  const char * name SET_TO "clone_bap";
+  long copied;       /* bytes of block copied by copy_bap */
+  long bytes;        /* bytes of block altogether         */
+  char * block;      /* block for world_copy              */
+  int n;
 
-  if ((square(row - 1, col, world) IS '.') OR
-      (square(row + 1, col, world) IS '.'))
-    IFF(extend_horizontal(row, col, world));
-  else if ((square(row, col - 1, world) IS '.') OR
-	   (square(row, col + 1, world) IS '.'))
-    IFF(extend_vertical(row, col, world));
-  else if ((world->cols[col].aim - world->cols[col].got) < 2)
-    IFF(extend_horizontal(row, col, world));
-  else if ((world->rows[row].aim - world->rows[row].got) < 2)
-    IFF(extend_vertical(row, col, world));
+  IFF(size_block(world->number_rows, world->number_cols, &copied, &bytes));
+  block SET_TO (char *)malloc(bytes);
+  CHB((block IS NULL), "Out of memory");
+  IFF(attach_block(block, world->number_rows, world->number_cols,
+		   world_copy));
+  IFF(copy_bap(world_copy, world));
+  IFF(make_logic(&(world_copy->logic), &(world_copy->logic_strips),
+		 (world->logic_line + 1), (world->logic_strip + 1), world));
+  memcpy(world_copy->logic, world->logic,
+	 (world->logic_line * sizeof(struct event)));
+  memcpy(world_copy->logic_strips, world->logic_strips,
+	 (world->logic_strip * sizeof(int)));
+  world_copy->guesses_tried SET_TO (struct guess *)
+    malloc((world->number_guesses_tried + 1) * sizeof(struct guess));
+  CHB((world_copy->guesses_tried IS NULL), "Out of memory");
+  IFF(copy_guesses(world_copy->guesses_tried, world->guesses_tried,
+		   world->number_guesses_tried));
+  world_copy->path SET_TO (int *)malloc((world->depth + 1) * sizeof(int));
+  CHB((world_copy->path IS NULL), "Out of memory");
+  for (n SET_TO 0; n < world->depth; n++)
+    world_copy->path[n] SET_TO world->path[n];
   return OK;
 }
 
 /*************************************************************************/
 
-/* extend_middles
+/* copy_bap
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. extend_middle returns ERROR.
+Returned Value: int (OK)
 
-Called By:  solve_problem
+Called By:
+  clone_bap
+  generate_count
+  try_guessing
 
-Side Effects: This looks at ship middles and extends one middle if
-possible. If a ship middle is extended, this reports that fact.
+Side Effects: This copies the world model into the world_copy model.
+world_copy must already have a block of its own for the same size of
+grid (see attach_block). The block is copied with one memcpy.
+
+Notes:
+
+The explanation, the list of guesses tried, and the path are not
+copied. world_copy is given pointers to the same ones as world, since
+all worlds on a branch of the search share them (see the structures
+section). The arena, trail, pool, table, trace, and job pointers are
+also shared.
+
+The clock and the times at which the rules were last clean are copied,
+so that the rules in the copy look only at the strips touched after the
+copy is made, such as by inserting a guess.
 
 */
 
-int extend_middles(        /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int copy_bap(                   /* ARGUMENTS                      */
+ struct bap_world * world_copy, /* puzzle model being copied into */
+ struct bap_world * world)      /* puzzle model being copied from */
 {
-  const char * name SET_TO "extend_middles";
-  int row;
-  int col;
+  const char * name SET_TO "copy_bap";
+  int rule;
 
-  for (row SET_TO 0; row < world->number_rows; row++)
-    {
-      for (col SET_TO 0; col < world->number_cols; col++)
-	{
-	  if (world->squares[row][col] IS '+')
-	    IFF(extend_middle(row, col, world));
-	  if (world->progress)
-	    break;
-	}
-      if (world->progress)
-	break;
-    }
+  memcpy(world_copy->block, world->block, world->block_bytes);
+  world_copy->arena SET_TO world->arena;
+  world_copy->batch SET_TO world->batch;
+  world_copy->battleships_ass SET_TO world->battleships_ass;
+  world_copy->battleships_left SET_TO world->battleships_left;
+  world_copy->bits SET_TO world->bits;
+  world_copy->branch SET_TO world->branch;
+  for (rule SET_TO 0; rule < NUMBER_RULES; rule++)
+    world_copy->clean[rule] SET_TO world->clean[rule];
+  world_copy->clock SET_TO world->clock;
+  world_copy->count SET_TO world->count;
+  world_copy->cruisers_ass SET_TO world->cruisers_ass;
+  world_copy->cruisers_left SET_TO world->cruisers_left;
+  world_copy->depth SET_TO world->depth;
+  world_copy->destroyers_ass SET_TO world->destroyers_ass;
+  world_copy->destroyers_left SET_TO world->destroyers_left;
+  world_copy->engine SET_TO world->engine;
+  world_copy->exes SET_TO world->exes;
+  world_copy->explain SET_TO world->explain;
+  world_copy->find_all SET_TO world->find_all;
+  world_copy->generate SET_TO world->generate;
+  world_copy->guesses_tried SET_TO world->guesses_tried;
+  world_copy->hash SET_TO world->hash;
+  world_copy->in_place SET_TO world->in_place;
+  world_copy->job SET_TO world->job;
+  world_copy->jobs SET_TO world->jobs;
+  world_copy->logic SET_TO world->logic;
+  world_copy->logic_line SET_TO world->logic_line;
+  world_copy->logic_lines SET_TO world->logic_lines;
+  world_copy->logic_room SET_TO world->logic_room;
+  world_copy->logic_strip SET_TO world->logic_strip;
+  world_copy->logic_strips SET_TO world->logic_strips;
+  world_copy->logic_width SET_TO world->logic_width;
+  world_copy->max_depth SET_TO world->max_depth;
+  world_copy->max_guesses SET_TO world->max_guesses;
+  world_copy->max_tried SET_TO world->max_tried;
+  world_copy->message SET_TO world->message;
+  world_copy->number_cols SET_TO world->number_cols;
+  world_copy->number_in_cols SET_TO 0;
+  world_copy->number_guesses_tried SET_TO world->number_guesses_tried;
+  world_copy->number_rows SET_TO world->number_rows;
+  world_copy->number_in_rows SET_TO 0;
+  world_copy->path SET_TO world->path;
+  world_copy->pool SET_TO world->pool;
+  world_copy->print_all SET_TO world->print_all;
+  world_copy->profile SET_TO world->profile;
+  world_copy->progress SET_TO 0;
+  world_copy->replace SET_TO world->replace;
+  world_copy->rules SET_TO world->rules;
+  world_copy->seed SET_TO world->seed;
+  world_copy->serve SET_TO world->serve;
+  world_copy->slack SET_TO world->slack;
+  world_copy->stats SET_TO world->stats;
+  world_copy->strategy SET_TO world->strategy;
+  world_copy->submarines_ass_col SET_TO world->submarines_ass_col;
+  world_copy->submarines_ass_row SET_TO world->submarines_ass_row;
+  world_copy->submarines_left_col SET_TO world->submarines_left_col;
+  world_copy->submarines_left_row SET_TO world->submarines_left_row;
+  world_copy->table SET_TO world->table;
+  world_copy->table_megabytes SET_TO world->table_megabytes;
+  world_copy->trace SET_TO world->trace;
+  world_copy->trace_mode SET_TO world->trace_mode;
+  world_copy->trace_name SET_TO world->trace_name;
+  world_copy->trail SET_TO world->trail;
+  world_copy->undone SET_TO world->undone;
+  world_copy->verbose SET_TO world->verbose;
+  world_copy->worker SET_TO world->worker;
+  world_copy->worklist SET_TO world->worklist;
   return OK;
 }
 
 /*************************************************************************/
 
-/* extend_vertical
+/* copy_guess
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. make_water returns ERROR.
-  2. enx_square returns ERROR.
-  3. record_progress returns ERROR.
+Returned Value: int (OK)
 
-Called By:  extend_middle
+Called By:
+  copy_guesses
+  try_guessing
 
-Side Effects: This extends a ship middle vertically. The squares to
-the right and left of the ship middle are set to water if not already
-water. The squares above and below, if blank, are set to unknown ship
-part and are padded with water.
+Side Effects: This copies the guess_original into the guess_copy.
 
 */
 
-int extend_vertical(       /* ARGUMENTS                                      */
- int row,                  /* the row in which the ship middle is located    */
- int col,                  /* the column in which the ship middle is located */
- struct bap_world * world) /* puzzle model                                   */
+int copy_guess(                 /* ARGUMENTS          */
+ struct guess * guess_copy,     /* guess to copy into */
+ struct guess * guess_original) /* guess to copy from */
 {
-  const char * name SET_TO "extend_vertical";
+  const char * name SET_TO "copy_guess";
 
-  IFF(make_water(row, col - 1, world));
-  IFF(make_water(row, col + 1, world));
-  if (square(row - 1, col, world) IS ' ')
-    IFF(enx_square(row - 1, col, world));
-  if (square(row + 1, col, world) IS ' ')
-    IFF(enx_square(row + 1, col, world));
-  if (world->progress)
-    {
-      world->number_in_rows SET_TO 1;
-      world->number_in_cols SET_TO 1;
-      world->rows_in[0] SET_TO row;
-      world->cols_in[0] SET_TO col;
-      IFF(record_progress("extend vertically", "ship middle at", world));
-    }
+  guess_copy->row SET_TO guess_original->row;
+  guess_copy->col SET_TO guess_original->col;
+  guess_copy->size SET_TO guess_original->size;
+  guess_copy->in_row SET_TO guess_original->in_row;
   return OK;
 }
 
 /*************************************************************************/
 
-/* fill_bap
+/* copy_guesses
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. make_water returns ERROR.
-  2. record_progress returns ERROR.
-
-Called By:  solve_problem
-
-Side Effects: If any strip (row or column) has (got = aim) but (dry >
-aim), this fills the empty squares of the strip with water. This also
-reports any strip that is filled.
+  1. copy_guess returns ERROR. (not currently checked)
 
-Notes:
+Called By:
+  clone_bap
+  make_guesses_battleships
+  make_guesses_cruisers
+  make_guesses_destroyers
+  make_guesses_fewest
+  make_guesses_submarines
+  run_task
 
-For the purposes of reporting, this assumes world->progress is 0 before it
-starts.
+Side Effects: This copies the first number_guesses entries from the
+guesses array into the guesses_copy array.
 
 */
 
-int fill_bap(              /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int copy_guesses(             /* ARGUMENTS                     */
+ struct guess * guesses_copy, /* array of guesses to copy into */
+ struct guess * guesses,      /* array of guesses to copy from */
+ int number_guesses)          /* number of guesses to copy     */
 {
-  const char * name SET_TO "fill_bap";
-  int row;
-  int col;
+  const char * name SET_TO "copy_guesses";
+  int n; /* index for guesses          */
 
-  world->number_in_rows SET_TO 0;
-  world->number_in_cols SET_TO 0;
-  for (row SET_TO 0; row < world->number_rows; row++)
-    {
-      if ((world->rows[row].aim IS world->rows[row].got) AND
-	  (world->rows[row].aim ISNT world->rows[row].dry))
-	{
-	  for (col SET_TO 0; col < world->number_cols; col++)
-	    {
-	      if (world->squares[row][col] IS ' ')
-		IFF(make_water(row, col, world));
-	    }
-	  world->rows_in[world->number_in_rows++] SET_TO row;
-	}
-    }
-  for (col SET_TO 0; col < world->number_cols; col++)
+  for (n SET_TO 0; n < number_guesses; n++)
     {
-      if ((world->cols[col].aim IS world->cols[col].got) AND
-	  (world->cols[col].aim ISNT world->cols[col].dry))
-	{
-	  for (row SET_TO 0; row < world->number_rows; row++)
-	    {
-	      if (world->squares[row][col] IS ' ')
-		IFF(make_water(row, col, world));
-	    }
-	  world->cols_in[world->number_in_cols++] SET_TO col;
-	}
+      copy_guess(&(guesses_copy[n]), &(guesses[n]));
     }
-  IFF(record_progress
-      ("all blanks must be water", "fill all blanks with water in", world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* find_max_starts_col
+/* dex_ends_col
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. ship_fits_col_row returns ERROR.
-  2. The assigned ships do not fit in the column: "Puzzle has no answer".
+  1. make_water returns ERROR.
 
-Called By:  place_ships_col
+Called By:  dex_squares
 
-Side Effects:  The max_starts array is filled in with the row
-numbers of squares where successive ships of the given size and not
-already located can last be started.
+Side Effects: This puts water at the ends of sets of consecutive ship
+parts if they are ships.
 
 Notes:
 
-ys is used only because ship_fits_col_row requires it.
+See documentation of dex_squares.
 
-Where row is set to (row - size), we really want it set to (row - size - 1)
-but row-- gets the 1 when the loop loops.
+This iterates beyond the end of the column so that no special code is
+required for what to do at the end.
 
 */
 
-int find_max_starts_col(   /* ARGUMENTS                                     */
- int col,                  /* column for which max_starts are being found   */
- int size,                 /* size of assigned ships                        */
- int assigned,             /* number of ships of given size assigned to col */
- int * max_starts,         /* array of maximum starting locations, set here */
- struct bap_world * world) /* puzzle model                                  */
+int dex_ends_col(          /* ARGUMENTS                        */
+ int col,                  /* index of column being processed  */
+ struct bap_world * world) /* puzzle model                     */
 {
-  const char * name SET_TO "find_max_starts_col";
-  int row;
-  int places;
-  int ys;
-  int is_legal;
+  const char * name SET_TO "dex_ends_col";
+  int row;        /* index of row being processed     */
+  int length;     /* number of consecutive ship parts */
 
-  places SET_TO assigned;
-  for (row SET_TO (world->number_rows - size);
-       ((row > -1) AND (places ISNT 0));
-       row--)
+  length SET_TO 0;
+  for (row SET_TO 0; row <= world->number_rows; row++)
     {
-      IFF(ship_fits_col_row(col, row, size, &ys, &is_legal, world));
-      if (is_legal)
+      if ((square(row, col, world) IS '.') OR (square(row, col, world) IS ' '))
 	{
-	  if (NOT (world->locations[row][col]))
+	  if ((length IS 4) OR
+	      ((length IS 3) AND
+	       (((world->cols[col].cruisers) AND
+		 (world->cols[col].aim < 7)) OR
+		((world->cols[col].battleships IS 0) AND
+		 (world->battleships_left IS 0)))) OR
+	      ((length IS 2) AND
+	       (((world->cols[col].destroyers) AND
+		 (world->cols[col].aim < 5)) OR
+		((world->cols[col].battleships IS 0) AND
+		 (world->battleships_left IS 0) AND
+		 (world->cols[col].cruisers IS 0) AND
+		 (world->cruisers_left IS 0)))))
 	    {
-	      places--;
-	      max_starts[places] SET_TO row;
+	      if (square(row, col, world) IS ' ')
+		IFF(make_water(row, col, world));
+	      if (square((row - length - 1), col, world) IS ' ')
+		IFF(make_water((row - length - 1), col, world));
 	    }
-	  row SET_TO (row - size);
+	  length SET_TO 0;
 	}
+      else
+	length++;
     }
-  CHK((places ISNT 0), "Puzzle has no answer");
   return OK;
 }
 
 /*************************************************************************/
 
-/* find_max_starts_row
+/* dex_ends_row
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. ship_fits_row_col returns ERROR.
-  2. The assigned ships do not fit in the row: "Puzzle has no answer"
+  1. make_water returns ERROR.
 
-Called By:  place_ships_row
+Called By:  dex_squares
 
-Side Effects:  The max_starts array is filled in with the column
-numbers of squares where successive ships of the given size and not
-already located can last be started.
+Side Effects: This puts water at the ends of sets of consecutive ship
+parts if they are ships.
 
 Notes:
 
-ys is used only because ship_fits_row_col requires it.
+See documentation of dex_squares.
 
-Where col is set to (col - size), we really want it set to (col - size - 1)
-but col-- gets the 1 when the loop loops.
+This iterates beyond the end of the row so that no special code is
+required for what to do at the end.
 
 */
 
-int find_max_starts_row(   /* ARGUMENTS                                     */
- int row,                  /* row for which max_starts are being found      */
- int size,                 /* size of assigned ships                        */
- int assigned,             /* number of ships of given size assigned to row */
- int * max_starts,         /* array of maximum starting locations, set here */
- struct bap_world * world) /* puzzle model                                  */
+int dex_ends_row(          /* ARGUMENTS                     */
+ int row,                  /* index of row being processed  */
+ struct bap_world * world) /* puzzle model                  */
 {
-  const char * name SET_TO "find_max_starts_row";
-  int col;
-  int places;
-  int ys;
-  int is_legal;
+  const char * name SET_TO "dex_ends_row";
+  int col;        /* index of column being processed  */
+  int length;     /* number of consecutive ship parts */
 
-  places SET_TO assigned;
-  for (col SET_TO (world->number_cols - size);
-       ((col > -1) AND (places ISNT 0));
-       col--)
+  length SET_TO 0;
+  for (col SET_TO 0; col <= world->number_cols; col++)
     {
-      IFF(ship_fits_row_col(row, col, size, &ys, &is_legal, world));
-      if (is_legal)
+      if ((square(row, col, world) IS '.') OR (square(row, col, world) IS ' '))
 	{
-	  if (NOT (world->locations[row][col]))
+	  if ((length IS 4) OR
+	      ((length IS 3) AND
+	       (((world->rows[row].cruisers) AND
+		 (world->rows[row].aim < 7)) OR
+		((world->rows[row].battleships IS 0) AND
+		 (world->battleships_left IS 0)))) OR
+	      ((length IS 2) AND
+	       (((world->rows[row].destroyers) AND
+		 (world->rows[row].aim < 5)) OR
+		((world->rows[row].battleships IS 0) AND
+		 (world->battleships_left IS 0) AND
+		 (world->rows[row].cruisers IS 0) AND
+		 (world->cruisers_left IS 0)))))
 	    {
-	      places--;
-	      max_starts[places] SET_TO col;
+	      if (square(row, col, world) IS ' ')
+		IFF(make_water(row, col, world));
+	      if (square(row, (col - length - 1), world) IS ' ')
+		IFF(make_water(row, (col - length - 1), world));
 	    }
-	  col SET_TO (col - size);
+	  length SET_TO 0;
 	}
+      else
+	length++;
     }
-  CHK((places ISNT 0), "Puzzle has no answer");
   return OK;
 }
 
 /*************************************************************************/
 
-/* find_min_starts_col
+/* dex_square
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. ship_fits_col_row returns ERROR.
-  2. The assigned ships do not fit in the column: "Puzzle has no answer".
-
-Called By:  place_ships_col
-
-Side Effects: The min_starts array is filled in with the row
-numbers of squares where successive ships of the given size and not
-already located can first be started.
-
-Notes:
+  1. trail_square or trail_number returns ERROR.
 
-ys is used only because ship_fits_col_row requires it.
+Called By:  dex_squares
 
-Where row is set to (row + size), we really want it set to (row + size + 1)
-but row++ gets the 1 when the loop loops.
+Side Effects: This changes an X to a known ship part if it is possible
+to infer what the X must be by looking at the squares above, below,
+right, and left of the given square. If the X is changed, exes for the
+row, column and whole puzzle are updated, and world->progress is set to 1.
 
 */
 
-int find_min_starts_col(   /* ARGUMENTS                                     */
- int col,                  /* column for which min_starts are being found   */
- int size,                 /* size of assigned ships                        */
- int assigned,             /* number of ships of given size assigned to col */
- int * min_starts,         /* array of minimum starting locations, set here */
- struct bap_world * world) /* puzzle model                                  */
+int dex_square(            /* ARGUMENTS                        */
+ int row,                  /* index of row being processed     */
+ int col,                  /* index of column being processed  */
+ struct bap_world * world) /* puzzle model                     */
 {
-  const char * name SET_TO "find_min_starts_col";
-  int row;
-  int stop;
-  int places;
-  int ys;
-  int is_legal;
+  const char * name SET_TO "dex_square";
+  char up;
+  char down;
+  char left;
+  char right;
+  char item;  /* known ship part the X must be, or X if not known */
 
-  stop SET_TO (world->number_rows - (size - 1));
-  places SET_TO 0;
-  for (row SET_TO 0; ((row < stop) AND (places < assigned)); row++)
+  up SET_TO square(row - 1, col, world);
+  down SET_TO square(row + 1, col, world);
+  left SET_TO square(row, col - 1, world);
+  right SET_TO square(row, col + 1, world);
+  item SET_TO 'X';
+  if ((up IS '.') AND (down IS '.') AND (left IS '.') AND (right IS '.'))
+    item SET_TO 'O';
+  else if ((up IS '.') AND ((down IS 'v') OR (down IS '+') OR (down IS 'X')))
+    item SET_TO '^';
+  else if ((down IS '.') AND ((up IS '^') OR (up IS '+') OR (up IS 'X')))
+    item SET_TO 'v';
+  else if ((left IS '.') AND
+	   ((right IS '>') OR (right IS '+') OR (right IS 'X')))
+    item SET_TO '<';
+  else if ((right IS '.') AND
+	   ((left IS '<') OR (left IS '+') OR (left IS 'X')))
+    item SET_TO '>';
+  else if ((((up IS '^') OR (up IS 'X') OR (up IS '+')) AND
+	    ((down IS 'v') OR (down IS 'X') OR (down IS '+'))) OR
+	   (((left IS '<') OR (left IS 'X') OR (left IS '+')) AND
+	    ((right IS '>') OR (right IS 'X') OR (right IS '+'))))
+    item SET_TO '+';
+  if (item ISNT 'X')
     {
-      IFF(ship_fits_col_row(col, row, size, &ys, &is_legal, world));
-      if (is_legal)
-	{
-	  if (NOT (world->locations[row][col]))
-	    min_starts[places++] SET_TO row;
-	  row SET_TO (row + size);
-	}
+      IFF(trail_square(row, col, world));
+      IFF(trail_number(&(world->rows[row].exes), world));
+      IFF(trail_number(&(world->cols[col].exes), world));
+      IFF(trail_number(&(world->exes), world));
+      IFF(set_square(row, col, item, world));
+      world->rows[row].exes--;
+      world->cols[col].exes--;
+      world->exes--;
+      world->progress SET_TO 1;
     }
-  CHK((places < assigned), "Puzzle has no answer");
   return OK;
 }
 
 /*************************************************************************/
 
-/* find_min_starts_row
+/* dex_squares
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. ship_fits_row_col returns ERROR.
-  2. The assigned ships do not fit in the row: "Puzzle has no answer".
+  1. dex_square returns ERROR.
+  2. dex_ends_row returns ERROR.
+  3. dex_ends_col returns ERROR.
+  4. record_line returns ERROR.
 
-Called By:  place_ships_row
+Called By:  run_rules
 
-Side Effects: The min_starts array is filled in with the column
-numbers of squares where successive ships of the given size and not
-already located can first be started.
+Side Effects: This changes all X's in the puzzle to known ship parts,
+if possible, and puts water next to any ship ends it makes from Xs, if
+water is not already there. See dex_square and the Notes here for
+details. If any squares are de-exed, this reports that fact.
 
 Notes:
 
-ys is used only because ship_fits_row_col requires it.
+There may be situations in which calling dex_squares twice in a row will
+produce changes both times. Have not yet found an example or disproved.
 
-Where col is set to (col + size), we really want it set to (col + size + 1)
-but col++ gets the 1 when the loop loops.
+For the purpose of reporting progress, this assumes world->progress is
+set to 0 before it starts.
+
+This checks if several ship parts next to each other along a strip
+make a ship. If so, it changes the ends and middles if necessary, and
+puts water next to the ends if water is not already there.
+
+A set of adjacent ship parts in a strip makes a ship if any of
+the following apply:
+1. there are four ship parts - must be a battleship.
+2. there are three ship parts and either:
+   a. a cruiser is assigned to the strip, and the aim for strip is
+      less than 7, or
+   b. no larger ship is available to go in the strip,
+   in both cases, there cannot be a larger ship covering the three ship parts.
+3. there are two ship parts and either:
+   a. a destroyer is assigned to the strip, and the aim for strip is
+      less than 5, or
+   b. no larger ship is available to go in the strip,
+   in both cases there cannot be a larger ship covering the two ship parts.
+
+There are other cases in which the adjacent squares must be a ship.
+The simple ones are picked up by other functions if the strip is full
+(try_full) or only one more ship part is needed in the strip
+(try_full_but_one).
+
+In the configurations: "X XXX" and "XX XX", the blank space in the
+middle will be made water by try_square_blank. Then dex_square will
+recognize that the Xs on either side of the blank square that are part
+of XXX or XX are ship ends.
+
+The two dex_ends_... functions just put water at the ends. Then dex_square
+changes the Xs.
 
 */
 
-int find_min_starts_row(   /* ARGUMENTS                                     */
- int row,                  /* row for which min_starts are being found      */
- int size,                 /* size of assigned ships                        */
- int assigned,             /* number of ships of given size assigned to row */
- int * min_starts,         /* array of minimum starting locations, set here */
- struct bap_world * world) /* puzzle model                                  */
+int dex_squares(           /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
 {
-  const char * name SET_TO "find_min_starts_row";
-  int col;
-  int stop;
-  int places;
-  int ys;
-  int is_legal;
+  const char * name SET_TO "dex_squares";
+  int row;       /* index of row being processed     */
+  int col;       /* index of column being processed  */
 
-  stop SET_TO (world->number_cols - (size - 1));
-  places SET_TO 0;
-  for (col SET_TO 0; ((col < stop) AND (places < assigned)); col++)
+  if (world->exes)
     {
-      IFF(ship_fits_row_col(row, col, size, &ys, &is_legal, world));
-      if (is_legal)
+      for (row SET_TO 0; row < world->number_rows; row++)
 	{
-	  if (NOT (world->locations[row][col]))
-	    min_starts[places++] SET_TO col;
-	  col SET_TO (col + size);
+	  if (world->rows[row].exes)
+	    IFF(dex_ends_row(row, world));
+	}
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  if (world->cols[col].exes)
+	    IFF(dex_ends_col(col, world));
+	}
+      for (row SET_TO 0; row < world->number_rows; row++)
+	{
+	  if (world->rows[row].exes)
+	    {
+	      for (col SET_TO 0; col < world->number_cols; col++)
+		{
+		  if (world->squares[row][col] IS 'X')
+		    IFF(dex_square(row, col, world));
+		}
+	    }
 	}
     }
-  CHK((places < assigned), "Puzzle has no answer");
+  if (world->progress)
+    {
+      IFF(record_line("identify ship parts:", world));
+    }
   return OK;
 }
 
 /*************************************************************************/
 
-/* init_solution
+/* dlx_answer
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. extend_ends returns ERROR.
-  2. pad_bap returns ERROR.
+  1. set_square, record_progress, print_bap, explain_bap, or
+     check_answer returns ERROR.
 
-Called By:  main
+Called By:  dlx_search
 
-Side Effects: Ship ends given in the puzzle statement are extended, and
-water is marked around any given ship parts.
+Side Effects: This puts the ships of the options chosen by dlx_search
+into the squares, fills the other blank squares with water, and prints
+the answer and its explanation (or, when solving a batch, checks it with
+check_answer). The explanation has one line for each ship placed. The
+squares and the explanation are then put back as they were read, so
+that the search can go on to the next answer. If world->find_all is 0,
+or world->count answers have been counted, the_dlx->stop is set so
+that the search stops.
 
 */
 
-int init_solution(         /* ARGUMENTS     */
- struct bap_world * world) /* puzzle model  */
+int dlx_answer(            /* ARGUMENTS                  */
+ struct dlx * the_dlx,     /* exact cover problem solved */
+ struct bap_world * world) /* puzzle model               */
 {
-  const char * name SET_TO "init_solution";
+  const char * name SET_TO "dlx_answer";
+  struct guess * ship; /* ship placed by an option chosen       */
+  char * action;       /* text describing ship placed           */
+  int logic_line;      /* value of world->logic_line on entry   */
+  int logic_strip;     /* value of world->logic_strip on entry  */
+  int row;
+  int col;
+  int n;
+  int k;
 
-  IFF(extend_ends(world));
-  IFF(pad_bap(world));
+  logic_line SET_TO world->logic_line;
+  logic_strip SET_TO world->logic_strip;
+  for (n SET_TO 0; n < the_dlx->number_chosen; n++)
+    {
+      ship SET_TO &(the_dlx->placements[the_dlx->chosen[n]]);
+      for (k SET_TO 0; k < ship->size; k++)
+	{
+	  row SET_TO (ship->in_row ? ship->row : (ship->row + k));
+	  col SET_TO (ship->in_row ? (ship->col + k) : ship->col);
+	  IFF(set_square(row, col, dlx_part(ship, k), world));
+	}
+      if (ship->size IS 1)
+	action SET_TO "submarine is at";
+      else if ((ship->size IS 2) AND ship->in_row)
+	action SET_TO "destroyer is in row at";
+      else if (ship->size IS 2)
+	action SET_TO "destroyer is in column at";
+      else if ((ship->size IS 3) AND ship->in_row)
+	action SET_TO "cruiser is in row at";
+      else if (ship->size IS 3)
+	action SET_TO "cruiser is in column at";
+      else if (ship->in_row)
+	action SET_TO "battleship is in row at";
+      else
+	action SET_TO "battleship is in column at";
+      world->rows_in[0] SET_TO ship->row;
+      world->number_in_rows SET_TO 1;
+      world->cols_in[0] SET_TO ship->col;
+      world->number_in_cols SET_TO 1;
+      world->progress SET_TO 1;
+      IFF(record_progress("exact cover", action, world));
+    }
+  for (row SET_TO 0; row < world->number_rows; row++)
+    {
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  if (world->squares[row][col] IS ' ')
+	    IFF(set_square(row, col, '.', world));
+	}
+    }
+  if (world->job)
+    {
+      IFF(check_answer(world));
+    }
+  else
+    {
+      IFF(print_bap(world));
+      IFF(explain_bap(world));
+    }
+  for (row SET_TO 0; row < world->number_rows; row++)
+    {
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  n SET_TO ((row * world->number_cols) + col);
+	  if (world->squares[row][col] ISNT the_dlx->given[n])
+	    IFF(set_square(row, col, the_dlx->given[n], world));
+	}
+    }
+  world->logic_line SET_TO logic_line;
+  world->logic_strip SET_TO logic_strip;
+  world->progress SET_TO 0;
+  the_dlx->answers++;
+  if ((world->find_all IS 0) OR
+      (world->count AND (the_dlx->answers >= world->count)))
+    the_dlx->stop SET_TO 1;
   return OK;
 }
 
 /*************************************************************************/
 
-/* init_world
+/* dlx_commit
 
 Returned Value: int (OK)
 
-Called By:  main
+Called By:  dlx_search
 
-Side Effects: This sets all ints and chars in the world model and
-its components to zero, except that the squares are set to blanks.
+Side Effects: This chooses the given option. The option is hidden, the
+need of each primary item in it is reduced by the weight of its node,
+and every option that no longer fits is hidden: (1) options whose
+weight in a primary item is more than what the item still needs (all
+of them, once it needs nothing), (2) all options that use a square the
+chosen option makes ship, and (3) options that make ship of a square
+the chosen option makes water. dlx_uncommit undoes all of this.
+
+Notes:
+
+Each option has at most one node in the list of any item, so hiding the
+option of one node in a list does not take out the next node of that
+list, which is saved before hiding.
 
 */
 
-int init_world(            /* ARGUMENTS                     */
- struct bap_world * world) /* puzzle model, filled in here  */
+int dlx_commit(            /* ARGUMENTS                  */
+ struct dlx * the_dlx,     /* exact cover problem        */
+ int option,               /* index of option chosen     */
+ struct bap_world * world) /* puzzle model               */
 {
-  const char * name SET_TO "init_world";
-  int row;
-  int col;
-  int n;
-  int m;
-
-  world->battleships_ass SET_TO 0;
-  world->battleships_left SET_TO 0;
-  for (col SET_TO 0; col < MAX_NUMBER_COLS; col++)
-    {
-      world->cols[col].aim SET_TO 0;
-      world->cols[col].battleships SET_TO 0;
-      world->cols[col].cruisers SET_TO 0;
-      world->cols[col].destroyers SET_TO 0;
-      world->cols[col].done SET_TO 0;
-      world->cols[col].dry SET_TO 0;
-      world->cols[col].exes SET_TO 0;
-      world->cols[col].got SET_TO 0;
-      world->cols[col].submarines SET_TO 0;
-      world->cols_in[col] SET_TO 0;
-    }
-  world->cruisers_ass SET_TO 0;
-  world->cruisers_left SET_TO 0;
-  world->destroyers_ass SET_TO 0;
-  world->destroyers_left SET_TO 0;
-  world->exes SET_TO 0;
-  world->find_all SET_TO 0;
-  for (n SET_TO 0; n < MAX_GUESSES; n++)
-    {
-      world->guesses_tried[n].row SET_TO 0;
-      world->guesses_tried[n].col SET_TO 0;
-      world->guesses_tried[n].size SET_TO 0;
-      world->guesses_tried[n].in_row SET_TO 0;
-    }
-  for (n SET_TO 0; n < TEXT_SIZE; n++)
+  const char * name SET_TO "dlx_commit";
+  int node;   /* node of chosen option          */
+  int item;   /* item of node                   */
+  int other;  /* node of another option in list */
+  int next;   /* node after other in list       */
+
+  IFF(dlx_hide(the_dlx, option));
+  for (node SET_TO the_dlx->option_first[option];
+       node < the_dlx->option_first[option + 1]; node++)
     {
-      for (m SET_TO 0; m < TEXT_SIZE; m++)
+      item SET_TO the_dlx->top[node];
+      if (the_dlx->color[node] IS 0)
+	the_dlx->need[item] SET_TO (the_dlx->need[item] - the_dlx->weight[node]);
+      for (other SET_TO the_dlx->dlink[item]; other ISNT item; other SET_TO next)
 	{
-	  world->logic[n][m] SET_TO 0;
+	  next SET_TO the_dlx->dlink[other];
+	  if (((the_dlx->color[node] IS 0) AND
+	       (the_dlx->weight[other] > the_dlx->need[item])) OR
+	      (the_dlx->color[node] IS DLX_SHIP) OR
+	      ((the_dlx->color[node] IS DLX_WATER) AND
+	       (the_dlx->color[other] IS DLX_SHIP)))
+	    IFF(dlx_hide(the_dlx, the_dlx->node_option[other]));
 	}
     }
-  world->logic_line SET_TO 0;
-  world->number_cols SET_TO 0;
-  world->number_in_cols SET_TO 0;
-  world->number_guesses_tried SET_TO 0;
-  world->number_rows SET_TO 0;
-  world->number_in_rows SET_TO 0;
-  world->print_all SET_TO 0;
-  world->progress SET_TO 0;
-  for (row SET_TO 0; row < MAX_NUMBER_ROWS; row++)
-    {
-      world->rows[row].aim SET_TO 0;
-      world->rows[row].battleships SET_TO 0;
-      world->rows[row].cruisers SET_TO 0;
-      world->rows[row].destroyers SET_TO 0;
-      world->rows[row].done SET_TO 0;
-      world->rows[row].dry SET_TO 0;
-      world->rows[row].exes SET_TO 0;
-      world->rows[row].got SET_TO 0;
-      world->rows[row].submarines SET_TO 0;
-      for (col SET_TO 0; col < MAX_NUMBER_COLS; col++)
-	{
-	  world->locations[row][col] SET_TO 0;
-	  world->squares[row][col] SET_TO ' ';
+  return OK;
+}
+
+/*************************************************************************/
+
+/* dlx_hide
+
+Returned Value: int (OK)
+
+Called By:
+  dlx_commit
+  dlx_make
+  dlx_search
+
+Side Effects: Unless the option is hidden already, this takes each
+node of the option out of the list of its item, lowers the len and room
+of the item, and pushes the option on the stack of hidden options.
+
+*/
+
+int dlx_hide(              /* ARGUMENTS              */
+ struct dlx * the_dlx,     /* exact cover problem    */
+ int option)               /* index of option to hide */
+{
+  const char * name SET_TO "dlx_hide";
+  int node;
+  int item;
+
+  if (NOT (the_dlx->hidden[option]))
+    {
+      for (node SET_TO the_dlx->option_first[option];
+	   node < the_dlx->option_first[option + 1]; node++)
+	{
+	  item SET_TO the_dlx->top[node];
+	  the_dlx->dlink[the_dlx->ulink[node]] SET_TO the_dlx->dlink[node];
+	  the_dlx->ulink[the_dlx->dlink[node]] SET_TO the_dlx->ulink[node];
+	  the_dlx->len[item]--;
+	  the_dlx->room[item] SET_TO (the_dlx->room[item] - the_dlx->weight[node]);
 	}
-      world->rows_in[row] SET_TO 0;
+      the_dlx->hidden[option] SET_TO 1;
+      the_dlx->stack[the_dlx->number_hidden++] SET_TO option;
     }
-  world->submarines_ass_col SET_TO 0;
-  world->submarines_ass_row SET_TO 0;
-  world->submarines_left_col SET_TO 0;
-  world->submarines_left_row SET_TO 0;
-  world->undone SET_TO 0;
-  world->verbose SET_TO 0;
   return OK;
 }
 
 /*************************************************************************/
 
-/* insert_guess_col
+/* dlx_make
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. A row or column is out of bounds: "Bug bad guess location".
-  2. The size of the guess is not 1, 2, 3, or 4:"Bug bad guess size".
-  3. No progress is made when the guess is inserted:
-     "Bug guess changed nothing".
-  4. record_progress returns ERROR.
-  5. insert_guess_square returns ERROR.
+  1. There is no memory for the problem: "Out of memory".
+  2. dlx_option returns ERROR.
 
-Called By:  try_guessing
+Called By:  solve_dlx
 
-Side Effects: This places a guess in a column of the puzzle.
+Side Effects: This mallocs an exact cover problem made from the puzzle
+as read and sets *the_dlx to it. free_dlx frees it.
 
-This checks that each character under the guess is either blank or is
-already what the guess says it should be.
+The primary items, each of which must get exactly its need, are:
+  1. the number of ships of each size (need: the number of that size),
+  2. each row and each column (need: its number of ship parts),
+  3. each ship part given in the puzzle (need: 1).
+The secondary items are the blank squares. Each option is one legal
+placement of one ship (see dlx_option).
+
+Notes:
+
+The options are counted by one pass of dlx_option before anything is
+malloc'ed and made by a second pass, so that every array is made only
+as long as it needs to be.
 
 */
 
-int insert_guess_col(      /* ARGUMENTS            */
- struct guess * the_guess, /* guess to be inserted */
- struct bap_world * world) /* puzzle model         */
+int dlx_make(              /* ARGUMENTS                     */
+ struct dlx ** the_dlx,    /* exact cover problem, set here */
+ struct bap_world * world) /* puzzle model, as read         */
 {
-  const char * name SET_TO "insert_guess_col";
+  const char * name SET_TO "dlx_make";
+  struct dlx * made;  /* problem being made                      */
+  int squares;        /* number of squares in puzzle             */
+  int pass;           /* 0 to count options and nodes, 1 to make */
+  int size;
+  int in_row;
   int row;
   int col;
-  char buffer[TEXT_SIZE];
-
-  row SET_TO the_guess->row;
-  col SET_TO the_guess->col;
-  CHB(((row < 0) OR
-       (row >= world->number_rows) OR
-       (col < 0) OR
-       (col >= world->number_cols)), "Bug bad guess location");
-  if (the_guess->size IS 1)
+  int n;
+  char given;   /* character of square as read                 */
+
+  made SET_TO (struct dlx *)malloc(sizeof(struct dlx));
+  CHB((made IS NULL), "Out of memory");
+  *the_dlx SET_TO made;
+  squares SET_TO (world->number_rows * world->number_cols);
+  made->answers SET_TO 0;
+  made->nodes SET_TO 0;
+  made->number_chosen SET_TO 0;
+  made->number_hidden SET_TO 0;
+  made->stop SET_TO 0;
+  made->top SET_TO NULL;
+  made->given SET_TO (char *)malloc(squares);
+  made->items SET_TO (int *)malloc(squares * sizeof(int));
+  CHB(((made->given IS NULL) OR (made->items IS NULL)), "Out of memory");
+  made->number_primary SET_TO (4 + world->number_rows + world->number_cols);
+  for (n SET_TO 0; n < squares; n++)
     {
-      strcpy(buffer, "submarine is at");
-      IFF(insert_guess_square(row, col, 'O', world));
+      given SET_TO
+	world->squares[n / world->number_cols][n % world->number_cols];
+      made->given[n] SET_TO given;
+      if ((given ISNT ' ') AND (given ISNT '.'))
+	made->items[n] SET_TO made->number_primary++;
+      else
+	made->items[n] SET_TO -1;
     }
-  else if (the_guess->size IS 2)
+  made->number_items SET_TO made->number_primary;
+  for (n SET_TO 0; n < squares; n++)
     {
-      strcpy(buffer, "destroyer is in column at");
-      IFF(insert_guess_square(row, col, '^', world));
-      IFF(insert_guess_square((row + 1), col, 'v', world));
+      if (made->given[n] IS ' ')
+	made->items[n] SET_TO made->number_items++;
     }
-  else if (the_guess->size IS 3)
+  for (pass SET_TO 0; pass < 2; pass++)
     {
-      strcpy(buffer, "cruiser is in column at");
-      IFF(insert_guess_square(row, col, '^', world));
-      IFF(insert_guess_square((row + 1), col, '+', world));
-      IFF(insert_guess_square((row + 2), col, 'v', world));
+      if (pass IS 1)
+	IFF(dlx_room(made, world));
+      made->number_options SET_TO 0;
+      made->number_nodes SET_TO made->number_items;
+      for (size SET_TO 1; size < 5; size++)
+	{
+	  for (in_row SET_TO 1; in_row > ((size IS 1) ? 0 : -1); in_row--)
+	    {
+	      for (row SET_TO 0; row < world->number_rows; row++)
+		{
+		  for (col SET_TO 0; col < world->number_cols; col++)
+		    IFF(dlx_option(made, row, col, size, in_row, world));
+		}
+	    }
+	}
     }
-  else if (the_guess->size IS 4)
+  made->option_first[made->number_options] SET_TO made->number_nodes;
+  made->need[0] SET_TO world->submarines_left_row;
+  made->need[1] SET_TO world->destroyers_left;
+  made->need[2] SET_TO world->cruisers_left;
+  made->need[3] SET_TO world->battleships_left;
+  for (row SET_TO 0; row < world->number_rows; row++)
+    made->need[4 + row] SET_TO world->rows[row].aim;
+  for (col SET_TO 0; col < world->number_cols; col++)
+    made->need[4 + world->number_rows + col] SET_TO world->cols[col].aim;
+  for (n SET_TO (4 + world->number_rows + world->number_cols);
+       n < made->number_primary; n++)
+    made->need[n] SET_TO 1;
+  for (n SET_TO 0; n < made->number_options; n++)
+    made->hidden[n] SET_TO 0;
+  for (n SET_TO 0; n < made->number_options; n++)
     {
-      strcpy(buffer, "battleship is in column at");
-      IFF(insert_guess_square(row, col, '^', world));
-      IFF(insert_guess_square((row + 1), col, '+', world));
-      IFF(insert_guess_square((row + 2), col, '+', world));
-      IFF(insert_guess_square((row + 3), col, 'v', world));
+      if (made->need[made->placements[n].size - 1] IS 0)
+	IFF(dlx_hide(made, n));
     }
-  else
-    CHB(1, "Bug bad guess size");
-  CHB((world->progress IS 0), "Bug guess changed nothing");
-  world->cols_in[0] SET_TO col;
-  world->number_in_cols SET_TO 1;
-  world->rows_in[0] SET_TO row;
-  world->number_in_rows SET_TO 1;
-  IFF(record_progress("guess", buffer, world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* insert_guess_row
+/* dlx_option
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. A row or column is out of bounds: "Bug bad guess location".
-  2. The size of the guess is not 1, 2, 3, or 4:"Bug bad guess size".
-  3. No progress is made when the guess is inserted:
-     "Bug guess changed nothing".
-  4. record_progress returns ERROR.
-  5. insert_guess_square returns ERROR.
-
-Called By:  try_guessing
-
-Side Effects: This places a guess in a row of the puzzle.
-
-This checks that each character under the guess is either blank or is
-already what the guess says it should be.
+  1. An option has too many nodes: "Bug option too big".
+
+Called By:  dlx_make
+
+Side Effects: If a ship of the given size may lie at the given row and
+column (in the row if in_row is 1, in the column if it is 0), this adds
+an option for it to the_dlx, or, if the arrays of the_dlx have not been
+made yet (on the first pass of dlx_make), only counts the option and
+its nodes.
+
+The ship may lie there if it is inside the grid, none of its squares is
+water or a ship part given as some other part, no square around it is
+a ship part, and it has no more parts in any row or column than that
+row or column needs. The option has nodes for:
+  1. the item for the size of ship, with weight 1,
+  2. the items for the rows and columns the ship is in, each with a
+     weight of the number of parts of the ship in it,
+  3. the item of each given ship part the ship covers, with weight 1,
+  4. each blank square of the ship, colored DLX_SHIP,
+  5. each blank square around the ship, colored DLX_WATER.
 
 */
 
-int insert_guess_row(      /* ARGUMENTS            */
- struct guess * the_guess, /* guess to be inserted */
- struct bap_world * world) /* puzzle model         */
+int dlx_option(            /* ARGUMENTS                                  */
+ struct dlx * the_dlx,     /* exact cover problem                        */
+ int row,                  /* row of left or top end of ship             */
+ int col,                  /* column of left or top end of ship          */
+ int size,                 /* size of ship                               */
+ int in_row,               /* 1 if ship lies in row, 0 if in column      */
+ struct bap_world * world) /* puzzle model, as read                      */
 {
-  const char * name SET_TO "insert_guess_row";
-  int row;
-  int col;
-  char buffer[TEXT_SIZE];
+  const char * name SET_TO "dlx_option";
+  int items[DLX_NODES];    /* item of each node of option     */
+  int weights[DLX_NODES];  /* weight of each node of option   */
+  int colors[DLX_NODES];   /* color of each node of option    */
+  struct guess ship;       /* ship placed by option           */
+  int number;              /* number of nodes of option       */
+  int legal;               /* set to 0 if ship may not lie here */
+  int last_row;            /* row of bottom end of ship       */
+  int last_col;            /* column of right end of ship     */
+  int r;
+  int c;
+  int n;
+  int node;
+  char item;
 
-  row SET_TO the_guess->row;
-  col SET_TO the_guess->col;
-  CHB(((row < 0) OR
-       (row >= world->number_rows) OR
-       (col < 0) OR
-       (col >= world->number_cols)), "Bug bad guess location");
-  if (the_guess->size IS 1)
+  ship.row SET_TO row;
+  ship.col SET_TO col;
+  ship.size SET_TO size;
+  ship.in_row SET_TO in_row;
+  last_row SET_TO (in_row ? row : (row + (size - 1)));
+  last_col SET_TO (in_row ? (col + (size - 1)) : col);
+  legal SET_TO ((last_row < world->number_rows) AND
+		(last_col < world->number_cols));
+  number SET_TO 0;
+  if (legal)
     {
-      strcpy(buffer, "submarine is at");
-      IFF(insert_guess_square(row, col, 'O', world));
+      items[number] SET_TO (size - 1);
+      weights[number] SET_TO 1;
+      colors[number++] SET_TO 0;
+      for (r SET_TO row; r <= last_row; r++)
+	{
+	  items[number] SET_TO (4 + r);
+	  weights[number] SET_TO ((last_col - col) + 1);
+	  colors[number++] SET_TO 0;
+	  legal SET_TO (legal AND (weights[number - 1] <= world->rows[r].aim));
+	}
+      for (c SET_TO col; c <= last_col; c++)
+	{
+	  items[number] SET_TO (4 + world->number_rows + c);
+	  weights[number] SET_TO ((last_row - row) + 1);
+	  colors[number++] SET_TO 0;
+	  legal SET_TO (legal AND (weights[number - 1] <= world->cols[c].aim));
+	}
     }
-  else if (the_guess->size IS 2)
+  for (r SET_TO (row - 1); (legal AND (r <= (last_row + 1))); r++)
     {
-      strcpy(buffer, "destroyer is in row at");
-      IFF(insert_guess_square(row, col, '<', world));
-      IFF(insert_guess_square(row, (col + 1), '>', world));
+      for (c SET_TO (col - 1); (legal AND (c <= (last_col + 1))); c++)
+	{
+	  item SET_TO square(r, c, world);
+	  n SET_TO ((r * world->number_cols) + c);
+	  if ((r < row) OR (r > last_row) OR (c < col) OR (c > last_col))
+	    {
+	      if (item IS ' ')
+		{
+		  items[number] SET_TO the_dlx->items[n];
+		  weights[number] SET_TO 0;
+		  colors[number++] SET_TO DLX_WATER;
+		}
+	      else
+		legal SET_TO (item IS '.');
+	    }
+	  else if (item IS ' ')
+	    {
+	      items[number] SET_TO the_dlx->items[n];
+	      weights[number] SET_TO 0;
+	      colors[number++] SET_TO DLX_SHIP;
+	    }
+	  else if ((item IS 'X') OR
+		   (item IS dlx_part(&ship, ((r - row) + (c - col)))))
+	    {
+	      items[number] SET_TO the_dlx->items[n];
+	      weights[number] SET_TO 1;
+	      colors[number++] SET_TO 0;
+	    }
+	  else
+	    legal SET_TO 0;
+	}
     }
-  else if (the_guess->size IS 3)
+  CHB((number > DLX_NODES), "Bug option too big");
+  if (legal AND (the_dlx->top ISNT NULL))
     {
-      strcpy(buffer, "cruiser is in row at");
-      IFF(insert_guess_square(row, col, '<', world));
-      IFF(insert_guess_square(row, (col + 1), '+', world));
-      IFF(insert_guess_square(row, (col + 2), '>', world));
+      the_dlx->option_first[the_dlx->number_options] SET_TO
+	the_dlx->number_nodes;
+      the_dlx->placements[the_dlx->number_options] SET_TO ship;
+      for (n SET_TO 0; n < number; n++)
+	{
+	  node SET_TO the_dlx->number_nodes++;
+	  the_dlx->top[node] SET_TO items[n];
+	  the_dlx->weight[node] SET_TO weights[n];
+	  the_dlx->color[node] SET_TO colors[n];
+	  the_dlx->node_option[node] SET_TO the_dlx->number_options;
+	  the_dlx->ulink[node] SET_TO the_dlx->ulink[items[n]];
+	  the_dlx->dlink[node] SET_TO items[n];
+	  the_dlx->dlink[the_dlx->ulink[items[n]]] SET_TO node;
+	  the_dlx->ulink[items[n]] SET_TO node;
+	  the_dlx->len[items[n]]++;
+	  the_dlx->room[items[n]] SET_TO (the_dlx->room[items[n]] + weights[n]);
+	}
+      the_dlx->number_options++;
     }
-  else if (the_guess->size IS 4)
+  else if (legal)
     {
-      strcpy(buffer, "battleship is in row at");
-      IFF(insert_guess_square(row, col, '<', world));
-      IFF(insert_guess_square(row, (col + 1), '+', world));
-      IFF(insert_guess_square(row, (col + 2), '+', world));
-      IFF(insert_guess_square(row, (col + 3), '>', world));
+      the_dlx->number_options++;
+      the_dlx->number_nodes SET_TO (the_dlx->number_nodes + number);
     }
-  else
-    CHB(1, "Bug bad guess size");
-  CHB((world->progress IS 0), "Bug guess changed nothing");
-  world->cols_in[0] SET_TO col;
-  world->number_in_cols SET_TO 1;
-  world->rows_in[0] SET_TO row;
-  world->number_in_rows SET_TO 1;
-  IFF(record_progress("guess", buffer, world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* insert_guess_square
+/* dlx_part
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. The square to be set is neither blank nor X:
-     "Bug bad character at guess location".
+Returned Value: char
+
+This returns the character of part k (counting from 0 at the left or
+top end) of the given ship.
 
 Called By:
-  insert_guess_col
-  insert_guess_row
+  dlx_answer
+  dlx_option
+  generate_ship
 
-Side Effects: 
+Side Effects: none
 
 */
 
-int insert_guess_square(   /* ARGUMENTS                     */
- int row,                  /* row index of square           */
- int col,                  /* column index of square        */
- char item1,               /* character to insert in square */
- struct bap_world * world) /* puzzle model                  */
+char dlx_part(             /* ARGUMENTS                      */
+ struct guess * ship,      /* ship                           */
+ int k)                    /* index of part, from left or top */
 {
-  const char * name SET_TO "insert_guess_square";
-  char item2;
+  const char * name SET_TO "dlx_part";
 
-  item2 SET_TO world->squares[row][col];
-  if (item2 IS item1);
-  else if ((item2 IS ' ') OR (item2 IS 'X'))
-    {
-      world->squares[row][col] SET_TO item1;
-      world->progress SET_TO 1;
-      if (item2 IS 'X')
-	{
-	  world->rows[row].exes--;
-	  world->cols[col].exes--;
-	  world->exes--;
-	}
-      else
-	{
-	  world->rows[row].got++;
-	  world->cols[col].got++;
-	}
-      IFF(make_water(row - 1, col - 1, world));
-      IFF(make_water(row - 1, col + 1, world));
-      IFF(make_water(row + 1, col - 1, world));
-      IFF(make_water(row + 1, col + 1, world));
-      if (item1 IS 'O')
-	{
-	  IFF(make_water(row + 1, col, world));
-	  IFF(make_water(row - 1, col, world));
-	  IFF(make_water(row, col + 1, world));
-	  IFF(make_water(row, col - 1, world));
-	}
-      else if (item1 IS '<')
-	IFF(make_water(row, col - 1, world));
-      else if (item1 IS '^')
-	IFF(make_water(row - 1, col, world));
-      else if (item1 IS '>')
-	IFF(make_water(row, col + 1, world));
-      else if (item1 IS 'v')
-	IFF(make_water(row + 1, col, world));
-      else
-	CHB((item1 ISNT '+'), "Bug bad character to insert");
-    }
-  else
-    CHB(1, "Bug bad character at guess location");
-  return OK;
+  return ((ship->size IS 1) ? 'O' :
+	  (k IS 0) ? (ship->in_row ? '<' : '^') :
+	  (k IS (ship->size - 1)) ? (ship->in_row ? '>' : 'v') : '+');
 }
 
 /*************************************************************************/
 
-/* legal_col
+/* dlx_room
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. legal_col_ships returns ERROR.
-  2. legal_col_across returns ERROR.
-  3. legal_col_beside returns ERROR.
+  1. There is no memory for the arrays: "Out of memory".
 
-Called By:
-  try_full_but_one_col
-  try_full_but_two_col
+Called By:  dlx_make
 
-Side Effects: *is_legal is set to 1 if the column is legal and to 0 if not.
+Side Effects: This mallocs the arrays of the_dlx for the numbers of
+items, options, and nodes counted by the first pass of dlx_make, and
+makes the list of each item empty.
 
-Notes:
+*/
 
-This checks whether the test column is legal and, if so, whether the
-test column can be inserted into the puzzle without creating an
-illegal condition in either the two columns on either side or any
-crossing row.
+int dlx_room(              /* ARGUMENTS           */
+ struct dlx * the_dlx,     /* exact cover problem */
+ struct bap_world * world) /* puzzle model        */
+{
+  const char * name SET_TO "dlx_room";
+  int nodes;    /* number of nodes, including headers of items */
+  int options;  /* number of options                           */
+  int items;    /* number of items                             */
+  int ships;    /* number of ships in puzzle                   */
+  int n;
 
-A column is illegal if any of the following occurs:
+  nodes SET_TO the_dlx->number_nodes;
+  options SET_TO the_dlx->number_options;
+  items SET_TO the_dlx->number_items;
+  ships SET_TO (world->battleships_left + world->cruisers_left +
+		world->destroyers_left + world->submarines_left_row);
+  the_dlx->top SET_TO (int *)malloc(nodes * sizeof(int));
+  the_dlx->ulink SET_TO (int *)malloc(nodes * sizeof(int));
+  the_dlx->dlink SET_TO (int *)malloc(nodes * sizeof(int));
+  the_dlx->weight SET_TO (int *)malloc(nodes * sizeof(int));
+  the_dlx->color SET_TO (int *)malloc(nodes * sizeof(int));
+  the_dlx->node_option SET_TO (int *)malloc(nodes * sizeof(int));
+  the_dlx->len SET_TO (int *)malloc(items * sizeof(int));
+  the_dlx->need SET_TO (int *)malloc(items * sizeof(int));
+  the_dlx->room SET_TO (int *)malloc(items * sizeof(int));
+  the_dlx->option_first SET_TO (int *)malloc((options + 1) * sizeof(int));
+  the_dlx->placements SET_TO
+    (struct guess *)malloc((options + 1) * sizeof(struct guess));
+  the_dlx->hidden SET_TO (char *)malloc(options + 1);
+  the_dlx->stack SET_TO (int *)malloc((options + 1) * sizeof(int));
+  the_dlx->chosen SET_TO (int *)malloc((ships + 1) * sizeof(int));
+  CHB(((the_dlx->top IS NULL) OR (the_dlx->ulink IS NULL) OR
+       (the_dlx->dlink IS NULL) OR (the_dlx->weight IS NULL) OR
+       (the_dlx->color IS NULL) OR (the_dlx->node_option IS NULL) OR
+       (the_dlx->len IS NULL) OR (the_dlx->need IS NULL) OR
+       (the_dlx->room IS NULL) OR (the_dlx->option_first IS NULL) OR
+       (the_dlx->placements IS NULL) OR (the_dlx->hidden IS NULL) OR
+       (the_dlx->stack IS NULL) OR (the_dlx->chosen IS NULL)),
+      "Out of memory");
+  for (n SET_TO 0; n < items; n++)
+    {
+      the_dlx->top[n] SET_TO n;
+      the_dlx->ulink[n] SET_TO n;
+      the_dlx->dlink[n] SET_TO n;
+      the_dlx->weight[n] SET_TO 0;
+      the_dlx->color[n] SET_TO 0;
+      the_dlx->node_option[n] SET_TO -1;
+      the_dlx->len[n] SET_TO 0;
+      the_dlx->need[n] SET_TO 0;
+      the_dlx->room[n] SET_TO 0;
+    }
+  return OK;
+}
 
-1. A ship is found that is longer than 4.
+/*************************************************************************/
 
-2. More ships of a given size are needed than are available.
+/* dlx_search
 
-3. The column on the right or left is left with fewer dry than its aim
-so that it cannot be filled.
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. dlx_answer or dlx_commit returns ERROR.
+  2. A ship is placed when every ship has been: "Bug too many ships".
 
-4. Any crossing row is left with fewer dry than its aim so that
-it cannot be filled.
+Called By:
+  dlx_search
+  solve_dlx
 
-5. A crossing row is overfilled. This could happen if try_full_but_one
-previously filled another column of the row.
+Side Effects: This finds the answers to the exact cover problem that
+use the options already chosen, calling dlx_answer for each one.
 
-6. A ship middle occurs with water on one side and ship part on the other.
+If every primary item has what it needs, the options chosen are an
+answer. If some primary item needs more than the options left in its
+list can give (its room), there is no answer here. Otherwise the
+primary item that still needs something and has the fewest options
+left for each unit of weight it needs is picked, and each of its
+options is chosen in turn (see dlx_commit) and followed up by a
+recursive call.
 
-The column being tested has been written in the test array, so that
-indexing is easy. It helps to imagine that the test array is written
-vertically, top down.
+Notes:
 
-Y is used to fill test columns so that the squares to be tested are not
-confused with squares previously set to X.
+After an option has been tried, it is hidden until all the options of
+the item have been tried, so that the same set of ships is never found
+twice by choosing them in another order. Each answer has a first
+option (in the order of the list) of those that put something in the
+item, and is found only when that option is tried.
 
-This assumes that all ship parts other than X's and Y's have been
-padded with water, so O^<> should not be encountered while
-reading_ship. The column should have no blanks in it, so a blank should
-never be encountered.
+The number of calls is counted in the_dlx->nodes (and in the job,
+when solving a batch), and each option tried counts as a guess.
 
 */
 
-int legal_col(             /* ARGUMENTS                        */
- char * test,              /* column being tested              */
- int col,                  /* index of the column being tested */
- int * is_legal,           /* set here, 1=line legal, 0=not    */
- struct bap_world * world) /* puzzle model                     */
+int dlx_search(            /* ARGUMENTS           */
+ struct dlx * the_dlx,     /* exact cover problem */
+ struct bap_world * world) /* puzzle model        */
 {
-  const char * name SET_TO "legal_col";
-
-  *is_legal SET_TO 1;
-  IFF(legal_col_ships(test, col, is_legal, world));
-  if (*is_legal)
-    IFF(legal_col_beside(test, col, is_legal, world));
-  if (*is_legal)
-    IFF(legal_col_across(test, col, is_legal, world));
+  const char * name SET_TO "dlx_search";
+  int best;    /* primary item picked, or -1 for none      */
+  int dead;    /* set to 1 if some item cannot be met      */
+  int item;
+  int mark;    /* number of options hidden on entry        */
+  int mark2;   /* number of options hidden before choosing */
+  int option;  /* option chosen                            */
+  int node;
+  int ships;   /* number of ships in puzzle                */
+
+  the_dlx->nodes++;
+  if (world->job)
+    world->job->nodes++;
+  best SET_TO -1;
+  dead SET_TO 0;
+  for (item SET_TO 0; item < the_dlx->number_primary; item++)
+    {
+      if (the_dlx->need[item] <= 0);
+      else if (the_dlx->room[item] < the_dlx->need[item])
+	dead SET_TO 1;
+      else if ((best IS -1) OR
+	       ((the_dlx->len[item] * the_dlx->need[best]) <
+		(the_dlx->len[best] * the_dlx->need[item])))
+	best SET_TO item;
+    }
+  if (dead);
+  else if (best IS -1)
+    IFF(dlx_answer(the_dlx, world));
+  else
+    {
+      ships SET_TO (world->battleships_left + world->cruisers_left +
+		    world->destroyers_left + world->submarines_left_row);
+      CHB((the_dlx->number_chosen IS ships), "Bug too many ships");
+      mark SET_TO the_dlx->number_hidden;
+      for (node SET_TO the_dlx->dlink[best];
+	   ((node ISNT best) AND (the_dlx->stop IS 0) AND
+	    (the_dlx->room[best] >= the_dlx->need[best]));
+	   node SET_TO the_dlx->dlink[best])
+	{
+	  option SET_TO the_dlx->node_option[node];
+	  if (world->job)
+	    world->job->guesses++;
+	  mark2 SET_TO the_dlx->number_hidden;
+	  IFF(dlx_commit(the_dlx, option, world));
+	  the_dlx->chosen[the_dlx->number_chosen++] SET_TO option;
+	  IFF(dlx_search(the_dlx, world));
+	  the_dlx->number_chosen--;
+	  IFF(dlx_uncommit(the_dlx, option, mark2));
+	  IFF(dlx_hide(the_dlx, option));
+	}
+      IFF(dlx_unhide(the_dlx, mark));
+    }
   return OK;
 }
 
 /*************************************************************************/
 
-/* legal_col_across
+/* dlx_uncommit
 
 Returned Value: int (OK)
 
-Called By:
-  legal_col
-  ship_fits_col_row
-
-Side Effects: This sets *is_legal to 0 if the column is not legal.
-
-Notes:
-
-Is_legal should be set to 1 when this is called.
+Called By:  dlx_search
 
-Y is used to fill test rows so that the squares to be tested are not
-confused with squares previously set to X.
+Side Effects: This undoes dlx_commit of the given option: the need of
+each primary item in the option is given back, and every option hidden
+since the stack of hidden options held mark of them is put back.
 
 */
 
-int legal_col_across(      /* ARGUMENTS                         */
- char * test,              /* column being tested               */
- int col,                  /* index of the column being tested  */
- int * is_legal,           /* set here to 0 if column not legal */
- struct bap_world * world) /* puzzle model                      */
+int dlx_uncommit(          /* ARGUMENTS                                */
+ struct dlx * the_dlx,     /* exact cover problem                      */
+ int option,               /* index of option chosen                   */
+ int mark)                 /* number of options hidden before choosing */
 {
-  const char * name SET_TO "legal_col_across";
-  int row;
-  int water;
+  const char * name SET_TO "dlx_uncommit";
+  int node;
+  int item;
 
-  for (row SET_TO 0; row < world->number_rows; row++)
+  for (node SET_TO the_dlx->option_first[option];
+       node < the_dlx->option_first[option + 1]; node++)
     {
-      if ((test[row] IS 'Y') AND
-	  (world->rows[row].aim < (world->rows[row].got + 1)))
-	{
-	  *is_legal SET_TO 0;
-	  break;
-	}
-      water SET_TO 0;
-      if ((square(row, (col - 1), world) IS ' ') AND
-	  ((test[row - 1] ISNT '.') OR (test[row + 1] ISNT '.')))
-	water++;
-      if ((square(row, (col + 1), world) IS ' ') AND
-	  ((test[row - 1] ISNT '.') OR (test[row + 1] ISNT '.')))
-	water++;
-      if ((world->rows[row].dry - water) < world->rows[row].aim)
-	{
-	  *is_legal SET_TO 0;
-	  break;
-	}
+      item SET_TO the_dlx->top[node];
+      if (the_dlx->color[node] IS 0)
+	the_dlx->need[item] SET_TO (the_dlx->need[item] + the_dlx->weight[node]);
     }
+  dlx_unhide(the_dlx, mark);
   return OK;
 }
 
 /*************************************************************************/
 
-/* legal_col_beside
+/* dlx_unhide
 
 Returned Value: int (OK)
 
 Called By:
-  legal_col
-  ship_fits_col_row
-
-Side Effects: See legal_row_beside. This is analogous.
-
-Notes:
+  dlx_search
+  dlx_uncommit
 
-*is_legal should be set to 1 when this is called.
+Side Effects: This pops options off the stack of hidden options until
+only mark of them are left, putting the nodes of each back in the lists
+of their items. Since options come off in the opposite order from the
+one they went on in, each node goes back between the same two nodes it
+was taken from between (the "dancing links").
 
 */
 
-int legal_col_beside(      /* ARGUMENTS                         */
- char * test,              /* column being tested               */
- int col,                  /* index of the column being tested  */
- int * is_legal,           /* set here to 0 if column not legal */
- struct bap_world * world) /* puzzle model                      */
+int dlx_unhide(            /* ARGUMENTS                          */
+ struct dlx * the_dlx,     /* exact cover problem                */
+ int mark)                 /* number of options to leave hidden  */
 {
-  const char * name SET_TO "legal_col_beside";
-  int row;
-  int water1;
-  int water2;
-  int no_ships;
+  const char * name SET_TO "dlx_unhide";
+  int option;
+  int node;
+  int item;
 
-  no_ships SET_TO
-    ((world->battleships_left IS 0) AND
-     (world->cruisers_left IS 0) AND
-     (world->destroyers_left IS 0));
-  water1 SET_TO 0;
-  water2 SET_TO 0;
-  for (row SET_TO 0; row < world->number_rows; row++)
+  for (; the_dlx->number_hidden > mark; )
     {
-      if ((square(row, (col - 1), world) IS ' ') AND
-	  ((test[row - 1] ISNT '.') OR
-	   (test[row + 1] ISNT '.') OR
-	   (no_ships AND
-	    (test[row] ISNT '.') AND
-	    (world->rows[row].battleships IS 0) AND
-	    (world->rows[row].cruisers IS 0) AND
-	    (world->rows[row].destroyers IS 0)) OR
-	   ((test[row] IS 'Y') AND
-	    (world->rows[row].aim IS (world->rows[row].got + 1)))))
-	water1++;
-      if ((square(row, (col + 1), world) IS ' ') AND
-	  ((test[row - 1] ISNT '.') OR
-	   (test[row + 1] ISNT '.') OR
-	   (no_ships AND
-	    (test[row] ISNT '.') AND
-	    (world->rows[row].battleships IS 0) AND
-	    (world->rows[row].cruisers IS 0) AND
-	    (world->rows[row].destroyers IS 0)) OR
-	   ((test[row] IS 'Y') AND
-	    (world->rows[row].aim IS (world->rows[row].got + 1)))))
-	water2++;
+      option SET_TO the_dlx->stack[--(the_dlx->number_hidden)];
+      for (node SET_TO (the_dlx->option_first[option + 1] - 1);
+	   node >= the_dlx->option_first[option]; node--)
+	{
+	  item SET_TO the_dlx->top[node];
+	  the_dlx->dlink[the_dlx->ulink[node]] SET_TO node;
+	  the_dlx->ulink[the_dlx->dlink[node]] SET_TO node;
+	  the_dlx->len[item]++;
+	  the_dlx->room[item] SET_TO (the_dlx->room[item] + the_dlx->weight[node]);
+	}
+      the_dlx->hidden[option] SET_TO 0;
     }
-  if ((col ISNT 0) AND
-      ((world->cols[col - 1].dry - water1) < world->cols[col - 1].aim))
-    *is_legal SET_TO 0;
-  if ((col ISNT (world->number_cols - 1)) AND
-      ((world->cols[col + 1].dry - water2) < world->cols[col + 1].aim))
-    *is_legal SET_TO 0;
   return OK;
 }
 
 /*************************************************************************/
 
-/* legal_col_ships
+/* enx_square
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. an illegal character is found while reading a ship:
-     "Puzzle has no answer bad ship".
-  2. an illegal character is found while not reading a ship:
-     "Bug_in_solving".
+  1. make_water returns ERROR.
+  2. trail_square or trail_number returns ERROR.
 
-Called By:  legal_col
+Called By:
+  extend_ends
+  extend_horizontal
+  extend_vertical
+  make_move
+  place_ships_col
+  place_ships_row
+  try_cross_col_fill_row
+  try_cross_row_fill_col
+  try_full
+  try_full_but_one_col
+  try_full_but_one_row
+  try_full_but_two_col
+  try_full_but_two_row
 
-Side Effects: This sets is_legal to 0 if any of the following occurs:
-1. A ship is found that is longer than 4.
-2. More ships of a given size are needed than are available.
-3. A ship middle occurs with water on one side and ship part on the other.
+Side Effects: This puts an X in the square world->squares[row][col],
+puts water in the squares adjacent to its corners, updates the
+row and column got for the square, updates the row and column exes
+for the square, updates the exes for the puzzle, and sets world->progress
+to 1.
 
-Notes:
+*/
 
-The column is known to be completely filled, so no spaces should occur.
+int enx_square(            /* ARGUMENTS                        */
+ int row,                  /* index of row being processed     */
+ int col,                  /* index of column being processed  */
+ struct bap_world * world) /* puzzle model                     */
+{
+  const char * name SET_TO "enx_square";
 
-Ship middle cannot occur on the top or bottom of the puzzle with a
-ship part in the same column of the row below or above it.
+  IFF(trail_square(row, col, world));
+  IFF(set_square(row, col, 'X', world));
+  IFF(trail_number(&(world->rows[row].exes), world));
+  world->rows[row].exes++;
+  IFF(trail_number(&(world->cols[col].exes), world));
+  world->cols[col].exes++;
+  IFF(trail_number(&(world->exes), world));
+  world->exes++;
+  IFF(trail_number(&(world->rows[row].got), world));
+  world->rows[row].got++;
+  IFF(trail_number(&(world->cols[col].got), world));
+  world->cols[col].got++;
+  IFF(make_water(row - 1, col - 1, world));
+  IFF(make_water(row - 1, col + 1, world));
+  IFF(make_water(row + 1, col - 1, world));
+  IFF(make_water(row + 1, col + 1, world));
+  world->progress SET_TO 1;
+  return OK;
+}
 
-is_legal should be set to 1 before this starts, since it only sets
-is_legal to zero for illegal configurations.
+/*************************************************************************/
 
-At the last "else" in this function (test[row] IS 'v') OR (test[row] IS ' ')
+/* explain_bap
 
-This is currently not testing submarines.
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. print_event returns ERROR.
+
+Called By:
+  dlx_answer
+  run_pool
+  solve_problem
+
+Side Effects: This prints the explanation of the steps in solving the
+puzzle, which has been accumulated in world->logic, one line for each
+event (see print_event). Nothing is printed if world->explain is 0.
 
 */
 
-int legal_col_ships(       /* ARGUMENTS                         */
- char * test,              /* column being tested               */
- int col,                  /* index of the column being tested  */
- int * is_legal,           /* set here to 0 if not legal        */
- struct bap_world * world) /* puzzle model                      */
+int explain_bap(           /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
 {
-  const char * name SET_TO "legal_col_ships";
-  int reading_ship; /* 1=have started reading a ship, 0=not */
-  int length;       /* length of ship being read            */
+  const char * name SET_TO "explain_bap";
+  int line;      /* index of logic line */
+
+  if (world->explain)
+    {
+      printf("\nEXPLANATION\n-----------\n");
+      for (line SET_TO 0; line < world->logic_line; line++)
+	IFF(print_event((world->logic + line), world));
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* extend_ends
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. enx_square returns ERROR.
+  2. record_line returns ERROR.
+
+Called By:  init_solution
+
+Side Effects: This looks at ship ends and extends them if
+possible. If any ship end is extended, this reports that fact.
+
+Notes:
+
+This needs to be called only once, since an end with a blank square
+by its open end can only occur in the original puzzle statement. The
+solution process does not create an end with a blank by its open end.
+
+*/
+
+int extend_ends(           /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "extend_ends";
   int row;
-  int battleships;
-  int cruisers;
-  int destroyers;
-  int submarines;
+  int col;
+  char item;
 
-  battleships SET_TO 0;
-  cruisers SET_TO 0;
-  destroyers SET_TO 0;
-  submarines SET_TO 0;
-  length SET_TO 0;
-  reading_ship SET_TO 0;
+  world->progress SET_TO 0;
   for (row SET_TO 0; row < world->number_rows; row++)
     {
-      if (reading_ship)
+      for (col SET_TO 0; col < world->number_cols; col++)
 	{
-	  if ((test[row] IS 'v') OR
-	      (test[row] IS '+') OR
-	      (test[row] IS 'X') OR
-	      (test[row] IS 'Y'))
-	    length++;
-	  else
-	    CHK(1, "Puzzle has no answer bad ship");
-	  if ((row IS (world->number_rows - 1)) OR (test[row + 1] IS '.'))
+	  item SET_TO world->squares[row][col];
+	  if (item IS '<')
 	    {
-	      if ((length > 4) OR (test[row] IS '+'))
-		{
-		  *is_legal SET_TO 0;
-		  break;
-		}
-	      else if (length IS 4)
-		{
-		  if (world->locations[row - 3][col]);
-		  else
-		    battleships++;
-		}
-	      else if (length IS 3)
-		{
-		  if (world->locations[row - 2][col]);
-		  else
-		    cruisers++;
-		}
-	      else if (length IS 2)
-		{
-		  if (world->locations[row - 1][col]);
-		  else
-		    destroyers++;
-		}
-	      reading_ship SET_TO 0;
-	      length SET_TO 0;
-	      row++;
+	      if (square(row, col + 1, world) IS ' ')
+		IFF(enx_square(row, col + 1, world));
 	    }
-	}
-      else
-	{
-	  if ((test[row] IS 'X') OR (test[row] IS 'Y'))
+	  else if (item IS '>')
 	    {
-	      if ((row IS (world->number_rows - 1)) OR (test[row + 1] IS '.'));
-	      else
-		{
-		  reading_ship SET_TO 1;
-		  length SET_TO 1;
-		}
+	      if (square(row, col - 1, world) IS ' ')
+		IFF(enx_square(row, col - 1, world));
 	    }
-	  else if (test[row] IS '^')
+	  else if (item IS 'v')
 	    {
-	      reading_ship SET_TO 1;
-	      length SET_TO 1;
+	      if (square(row - 1, col, world) IS ' ')
+		IFF(enx_square(row - 1, col, world));
 	    }
-	  else if (test[row] IS '+')
+	  else if (item IS '^')
 	    {
-	      if ((row IS (world->number_rows - 1)) OR (test[row + 1] IS '.'));
-	      else
-		{
-		  *is_legal SET_TO 0;
-		  break;
-		}
+	      if (square(row + 1, col, world) IS ' ')
+		IFF(enx_square(row + 1, col, world));
 	    }
-	  else if ((test[row] IS '<') OR
-		   (test[row] IS '>') OR
-		   (test[row] IS '.') OR
-		   (test[row] IS 'O'));
-	  else
-	    CHK(1, "Bug in solving");
 	}
     }
-  if (battleships > (world->battleships_left + world->cols[col].battleships))
-    *is_legal SET_TO 0;
-  if (cruisers > (world->cruisers_left + world->cols[col].cruisers))
-    *is_legal SET_TO 0;
-  if (destroyers > (world->destroyers_left + world->cols[col].destroyers))
-    *is_legal SET_TO 0;
-  if (submarines > (world->submarines_left_col + world->cols[col].submarines))
-    *is_legal SET_TO 0;
+  if (world->progress)
+    {
+      IFF(record_line("extend ship ends", world));
+    }
   return OK;
 }
 
 /*************************************************************************/
 
-/* legal_row
+/* extend_horizontal
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. legal_row_ships returns ERROR.
-  2. legal_row_across returns ERROR.
-  3. legal_row_beside returns ERROR.
-
-Called By:
-  try_full_but_one_row
-  try_full_but_two_row
-
-Side Effects: *is_legal is set to 1 if the row is legal and to 0 if not.
-
-This checks whether the test row is legal and, if so, whether it can
-be inserted into the puzzle without creating an illegal condition in
-either the two rows above and below or any crossing column.
+  1. make_water returns ERROR.
+  2. enx_square returns ERROR.
+  3. record_progress returns ERROR.
 
-A row is illegal if any of the following occurs:
+Called By:  extend_middle
 
-1. A ship is found that is longer than 4.
+Side Effects: This extends a ship middle horizontally. The squares
+above and below the ship middle are set to water if not already
+water. The squares right and left, if blank, are set to unknown ship
+part and are padded with water.
 
-2. More ships of a given size are needed than are available.
+*/
 
-3. The row above or below is left with fewer dry than its aim so that
-it cannot be filled.
+int extend_horizontal(     /* ARGUMENTS                                      */
+ int row,                  /* the row in which the ship middle is located    */
+ int col,                  /* the column in which the ship middle is located */
+ struct bap_world * world) /* puzzle model                                   */
+{
+  const char * name SET_TO "extend_horizontal";
 
-4. Any crossing column is left with fewer dry than its aim so that
-it cannot be filled.
+  CHK(((square(row, col + 1, world) IS '.') OR
+       (square(row, col - 1, world) IS '.')), "Puzzle has no answer");
+  IFF(make_water(row - 1, col, world));
+  IFF(make_water(row + 1, col, world));
+  if (square(row, col + 1, world) IS ' ')
+    IFF(enx_square(row, col + 1, world));
+  if (square(row, col - 1, world) IS ' ')
+    IFF(enx_square(row, col - 1, world));
+  if (world->progress)
+    {
+      world->number_in_rows SET_TO 1;
+      world->number_in_cols SET_TO 1;
+      world->rows_in[0] SET_TO row;
+      world->cols_in[0] SET_TO col;
+      IFF(record_progress("extend horizontally", "ship middle at", world));
+    }
+  return OK;
+}
 
-5. A crossing column is overfilled. This could happen if try_full_but_one
-previously filled another row of the column.
+/*************************************************************************/
 
-6. A ship middle occurs with water on one side and ship part on the other.
+/* extend_middle
 
-Notes:
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. extend_horizontal returns ERROR.
+  2. extend_vertical returns ERROR.
 
-Y is used to fill test rows so that the squares to be tested are not
-confused with squares previously set to X.
+Called By:  extend_middles
 
-This assumes that all ship parts other than X's and Y's have been
-padded with water, so Ov^< should not be encountered while
-reading_ship. The row should have no blanks in it, so a blank should
-never be encountered.
+Side Effects: This extends one middle if possible. If a ship middle is
+extended, this reports that fact.
 
 */
 
-int legal_row(             /* ARGUMENTS                     */
- char * test,              /* the row being tested          */
- int row,                  /* index of the row being tested */
- int * is_legal,           /* set here, 1=line legal, 0=not */
- struct bap_world * world) /* puzzle model                  */
+int extend_middle(         /* ARGUMENTS                 */
+ int row,                  /* index of row of middle    */
+ int col,                  /* index of column of middle */
+ struct bap_world * world) /* puzzle model              */
 {
-  const char * name SET_TO "legal_row";
+  const char * name SET_TO "extend_middle";
 
-  *is_legal SET_TO 1;
-  IFF(legal_row_ships(test, row, is_legal, world));
-  if (*is_legal)
-    IFF(legal_row_beside(test, row, is_legal, world));
-  if (*is_legal)
-    IFF(legal_row_across(test, row, is_legal, world));
+  if ((square(row - 1, col, world) IS '.') OR
+      (square(row + 1, col, world) IS '.'))
+    IFF(extend_horizontal(row, col, world));
+  else if ((square(row, col - 1, world) IS '.') OR
+	   (square(row, col + 1, world) IS '.'))
+    IFF(extend_vertical(row, col, world));
+  else if ((world->cols[col].aim - world->cols[col].got) < 2)
+    IFF(extend_horizontal(row, col, world));
+  else if ((world->rows[row].aim - world->rows[row].got) < 2)
+    IFF(extend_vertical(row, col, world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* legal_row_across
+/* extend_middles
 
-Returned Value: int (OK)
-
-Called By:
-  legal_row
-  ship_fits_row_col
-
-Side Effects: This sets *is_legal to 0 if the row is not legal.
-
-Notes:
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. extend_middle returns ERROR.
 
-Is_legal should be set to 1 when this is called.
+Called By:  run_rules
 
-Y is used to fill test rows so that the squares to be tested are not
-confused with squares previously set to X.
+Side Effects: This looks at ship middles and extends one middle if
+possible. If a ship middle is extended, this reports that fact.
 
 */
 
-int legal_row_across(      /* ARGUMENTS                     */
- char * test,              /* the row being tested          */
- int row,                  /* index of the row being tested */
- int * is_legal,           /* set here to 0 if not legal    */
- struct bap_world * world) /* puzzle model                  */
+int extend_middles(        /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
 {
-  const char * name SET_TO "legal_row_across";
+  const char * name SET_TO "extend_middles";
+  int row;
   int col;
-  int water;
 
-  for (col SET_TO 0; col < world->number_cols; col++)
+  for (row SET_TO 0; row < world->number_rows; row++)
     {
-      if ((test[col] IS 'Y') AND
-	  (world->cols[col].aim < (world->cols[col].got + 1)))
-	{
-	  *is_legal SET_TO 0;
-	  break;
-	}
-      water SET_TO 0;
-      if ((square((row - 1), col, world) IS ' ') AND
-	  ((test[col - 1] ISNT '.') OR (test[col + 1] ISNT '.')))
-	water++;
-      if ((square((row + 1), col, world) IS ' ') AND
-	  ((test[col - 1] ISNT '.') OR (test[col + 1] ISNT '.')))
-	water++;
-      if ((world->cols[col].dry - water) < world->cols[col].aim)
+      for (col SET_TO 0; col < world->number_cols; col++)
 	{
-	  *is_legal SET_TO 0;
-	  break;
+	  if (world->squares[row][col] IS '+')
+	    IFF(extend_middle(row, col, world));
+	  if (world->progress)
+	    break;
 	}
+      if (world->progress)
+	break;
     }
   return OK;
 }
 
 /*************************************************************************/
 
-/* legal_row_beside
-
-Returned Value: int (OK)
-
-Called By:
-  legal_row
-  ship_fits_row_col
-
-Side Effects:
-
-For the row above the given row, this counts the blank squares that would
-have water in them if the given row were as given. Then it checks that
-the number of now dry squares is less than the aim for the row. If so,
-it sets is_legal to 0. Then it does the same thing for the row below
-the given row.
-
-To see if a blank square in the row above would be water, this checks
-the diagonally adjacent squares in the given row. If either one is
-not water, the blank square being checked must be water. Also, if
-the only remaining ships are submarines, this looks at the square
-directly below the one being checked. If it is not water, the square
-being checked must be water.
-
-Notes:
+/* extend_vertical
 
-Is_legal should be set to 1 when this is called.
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. make_water returns ERROR.
+  2. enx_square returns ERROR.
+  3. record_progress returns ERROR.
 
-The test string does not have any spaces in it, so it is not necessary
-to check for them. The test string has extra water at both ends, so it
-is OK to index one space beyond the ends.
+Called By:  extend_middle
 
-This works for the top and bottom rows without any special checking.
+Side Effects: This extends a ship middle vertically. The squares to
+the right and left of the ship middle are set to water if not already
+water. The squares above and below, if blank, are set to unknown ship
+part and are padded with water.
 
 */
 
-int legal_row_beside(      /* ARGUMENTS                     */
- char * test,              /* the row being tested          */
- int row,                  /* index of the row being tested */
- int * is_legal,           /* set here to 0 if not legal    */
- struct bap_world * world) /* puzzle model                  */
+int extend_vertical(       /* ARGUMENTS                                      */
+ int row,                  /* the row in which the ship middle is located    */
+ int col,                  /* the column in which the ship middle is located */
+ struct bap_world * world) /* puzzle model                                   */
 {
-  const char * name SET_TO "legal_row_beside";
-  int col;
-  int water1;
-  int water2;
-  int no_ships;
+  const char * name SET_TO "extend_vertical";
 
-  no_ships SET_TO
-    ((world->battleships_left IS 0) AND
-     (world->cruisers_left IS 0) AND
-     (world->destroyers_left IS 0));
-  water1 SET_TO 0;
-  water2 SET_TO 0;
-  for (col SET_TO 0; col < world->number_cols; col++)
+  IFF(make_water(row, col - 1, world));
+  IFF(make_water(row, col + 1, world));
+  if (square(row - 1, col, world) IS ' ')
+    IFF(enx_square(row - 1, col, world));
+  if (square(row + 1, col, world) IS ' ')
+    IFF(enx_square(row + 1, col, world));
+  if (world->progress)
     {
-      if ((square((row - 1), col, world) IS ' ') AND
-	  ((test[col - 1] ISNT '.') OR
-	   (test[col + 1] ISNT '.') OR
-	   (no_ships AND
-	    (test[col] ISNT '.') AND
-	    (world->cols[col].battleships IS 0) AND
-	    (world->cols[col].cruisers IS 0) AND
-	    (world->cols[col].destroyers IS 0)) OR
-	   ((test[col] IS 'Y') AND
-	    (world->cols[col].aim IS (world->cols[col].got + 1)))))
-	water1++;
-      if ((square((row + 1), col, world) IS ' ') AND
-	  ((test[col - 1] ISNT '.') OR
-	   (test[col + 1] ISNT '.') OR
-	   (no_ships AND
-	    (test[col] ISNT '.') AND
-	    (world->cols[col].battleships IS 0) AND
-	    (world->cols[col].cruisers IS 0) AND
-	    (world->cols[col].destroyers IS 0)) OR
-	   ((test[col] IS 'Y') AND
-	    (world->cols[col].aim IS (world->cols[col].got + 1)))))
-	water2++;
+      world->number_in_rows SET_TO 1;
+      world->number_in_cols SET_TO 1;
+      world->rows_in[0] SET_TO row;
+      world->cols_in[0] SET_TO col;
+      IFF(record_progress("extend vertically", "ship middle at", world));
     }
-  if ((row ISNT 0) AND
-      ((world->rows[row - 1].dry - water1) < world->rows[row - 1].aim))
-    *is_legal SET_TO 0;
-  if ((row ISNT (world->number_rows - 1)) AND
-      ((world->rows[row + 1].dry - water2) < world->rows[row + 1].aim))
-    *is_legal SET_TO 0;
   return OK;
 }
 
 /*************************************************************************/
 
-/* legal_row_ships
+/* fill_bap
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. an illegal character is found while reading a ship:
-     "Puzzle has no answer bad ship".
-  2. an illegal character is found while not reading a ship:
-     "Bug in solving".
+  1. make_water returns ERROR.
+  2. record_progress returns ERROR.
 
-Called By:  legal_row
+Called By:  run_rules
 
-Side Effects: This sets *is_legal to 0 if any of the following occurs:
-1. A ship is found that is longer than 4.
-2. More ships of a given size are needed than are available.
-3. A ship middle occurs with water on one side and ship part on the other.
+Side Effects: If any strip (row or column) has (got = aim) but (dry >
+aim), this fills the empty squares of the strip with water. This also
+reports any strip that is filled.
 
 Notes:
 
-The row is known to be completely filled, so no spaces should occur.
-
-Ship middle cannot occur on the side of the puzzle with a ship part
-in the row next to it because, since it is on the side of the
-puzzle, the next square in the row will have been marked water
-when extend_middle ran.
-
-At the last "else" in this function (test[col] IS '>') OR (test[col] IS ' ')
-
-This is currently not testing submarines.
+For the purposes of reporting, this assumes world->progress is 0 before it
+starts.
 
 */
 
-int legal_row_ships(       /* ARGUMENTS                     */
- char * test,              /* the row being tested          */
- int row,                  /* index of the row being tested */
- int * is_legal,           /* set here to 0 if not legal    */
- struct bap_world * world) /* puzzle model                  */
+int fill_bap(              /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
 {
-  const char * name SET_TO "legal_row_ships";
-  int reading_ship; /* 1=have started reading a ship, 0=not */
-  int length;       /* length of ship being read */
+  const char * name SET_TO "fill_bap";
+  int row;
   int col;
-  int battleships;
-  int cruisers;
-  int destroyers;
-  int submarines;
 
-  battleships SET_TO 0;
-  cruisers SET_TO 0;
-  destroyers SET_TO 0;
-  submarines SET_TO 0;
-  length SET_TO 0;
-  reading_ship SET_TO 0;
-  for (col SET_TO 0; col < world->number_cols; col++)
+  world->number_in_rows SET_TO 0;
+  world->number_in_cols SET_TO 0;
+  for (row SET_TO 0; row < world->number_rows; row++)
     {
-      if (reading_ship)
+      if ((world->rows[row].aim IS world->rows[row].got) AND
+	  (world->rows[row].aim ISNT world->rows[row].dry))
 	{
-	  if ((test[col] IS '>') OR
-	      (test[col] IS '+') OR
-	      (test[col] IS 'X') OR
-	      (test[col] IS 'Y'))
-	    length++;
-	  else
-	    CHK(1, "Puzzle has no answer bad ship");
-	  if ((col IS (world->number_cols - 1)) OR (test[col + 1] IS '.'))
+	  for (col SET_TO 0; col < world->number_cols; col++)
 	    {
-	      if ((length > 4) OR (test[col] IS '+'))
-		{
-		  *is_legal SET_TO 0;
-		  break;
-		}
-	      else if (length IS 4)
-		{
-		  if (world->locations[row][col - 3]);
-		  else
-		    battleships++;
-		}
-	      else if (length IS 3)
-		{
-		  if (world->locations[row][col - 2]);
-		  else
-		    cruisers++;
-		}
-	      else if (length IS 2)
-		{
-		  if (world->locations[row][col - 1]);
-		  else
-		    destroyers++;
-		}
-	      reading_ship SET_TO 0;
-	      length SET_TO 0;
-	      col++;
+	      if (world->squares[row][col] IS ' ')
+		IFF(make_water(row, col, world));
 	    }
+	  world->rows_in[world->number_in_rows++] SET_TO row;
 	}
-      else
+    }
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      if ((world->cols[col].aim IS world->cols[col].got) AND
+	  (world->cols[col].aim ISNT world->cols[col].dry))
 	{
-	  if ((test[col] IS 'X') OR (test[col] IS 'Y'))
+	  for (row SET_TO 0; row < world->number_rows; row++)
 	    {
-	      if ((col IS (world->number_cols - 1)) OR (test[col + 1] IS '.'));
-	      else
-		{
-		  reading_ship SET_TO 1;
-		  length SET_TO 1;
-		}
-	    }
-	  else if (test[col] IS '<')
-	    {
-	      reading_ship SET_TO 1;
-	      length SET_TO 1;
-	    }
-	  else if (test[col] IS '+')
-	    {
-	      if ((col IS (world->number_cols - 1)) OR (test[col + 1] IS '.'));
-	      else
-		{
-		  *is_legal SET_TO 0;
-		  break;
-		}
+	      if (world->squares[row][col] IS ' ')
+		IFF(make_water(row, col, world));
 	    }
-	  else if ((test[col] IS 'v') OR
-		   (test[col] IS '^') OR
-		   (test[col] IS '.') OR
-		   (test[col] IS 'O'));
-	  else
-	    CHK(1, "Bug in solving");
+	  world->cols_in[world->number_in_cols++] SET_TO col;
 	}
     }
-  if (battleships > (world->battleships_left + world->rows[row].battleships))
-    *is_legal SET_TO 0;
-  if (cruisers > (world->cruisers_left + world->rows[row].cruisers))
-    *is_legal SET_TO 0;
-  if (destroyers > (world->destroyers_left + world->rows[row].destroyers))
-    *is_legal SET_TO 0;
-  if (submarines > (world->submarines_left_row + world->rows[row].submarines))
-    *is_legal SET_TO 0;
+  IFF(record_progress
+      ("all blanks must be water", "fill all blanks with water in", world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* locate_ships
+/* fill_request
+
+Returned Value: int (OK)
+
+Called By:
+  main
+  serve_bap
+
+Side Effects: This sets the request to solve puzzles as the arguments
+read by read_arguments say: the engine, strategy, order of branching,
+rules, trail, bits, worklist, and limit of the world. The text is left
+for the caller to set.
+
+*/
+
+int fill_request(               /* ARGUMENTS                       */
+ struct bap_request * request,  /* request, filled in here         */
+ struct bap_world * world)      /* puzzle model, holding arguments */
+{
+  const char * name SET_TO "fill_request";
+
+  bap_init_request(request);
+  request->bits SET_TO world->bits;
+  request->branch SET_TO world->branch;
+  request->engine SET_TO world->engine;
+  request->in_place SET_TO world->in_place;
+  request->limit SET_TO world->count;
+  request->rules SET_TO world->rules;
+  request->strategy SET_TO world->strategy;
+  request->worklist SET_TO world->worklist;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* find_hint
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. allocate_ship_col returns ERROR.
-  2. allocate_ship_row returns ERROR.
-  3. an illegal ship continuation is found: "Puzzle has no answer bad ship".
+  1. A rule returns ERROR with a message (not just because the puzzle
+     has no answer).
+  2. There is no memory for the explanation: "Out of memory".
+  3. undo_trail returns ERROR.
 
-Called By:  solve_problem
+Called By:
+  bap_next_hint
+  play_move
+  retract_move
+
+Side Effects: This runs the rules on the squares of the session (see
+run_rules) until one of them sets a square, and fills in the hint with
+what happened:
+  BAP_HINT - a rule set squares. The hint has its name, the lines of
+    explanation recorded since the rules were first run, the squares
+    set, and the squares as they would be once it fired.
+  BAP_SOLVED - every row and column is done, so there is nothing left
+    to hint at.
+  BAP_STUCK - no rule fires, so the next step would be a guess.
+  BAP_NO_ANSWER - a rule found that the squares have no answer. The
+    hint has the name of the rule.
+Everything the rules changed is then undone, so the squares are left
+as they were.
 
-Side Effects: This reads the rows and columns looking for whole ships
-with no X's. Each whole ship is allocated by allocate_ship_row or
-allocate_ship_col.
+Notes:
 
-Submarines are allocated from rows in this function but not from
-columns, since they should be allocated only once.
+verify_squares, locate_ships, and mark_dones only keep count, and the
+assign_ rules only assign ships to strips, so if the rules that make
+progress set no square, the rules are run again. A hint that set no
+square would leave the squares of the session as they are, so the
+caller would have no move to make and would be given the same hint
+again. What those rules did is kept in the explanation of the hint
+that follows. The rules look only at the strips touched since they
+were last run (see QUEUED), so that after a move the work done is
+about that of a few steps of solve_problem, not of solving the puzzle
+again.
+
+The lines of explanation are written out after the trail is undone and
+logic_line is set back, which is safe since nothing is recorded in
+between. Written out first, a failing realloc would leave the rule
+standing in the squares.
 
 */
 
-int locate_ships(          /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int find_hint(                 /* ARGUMENTS                  */
+ struct bap_session * session, /* session to give hint for   */
+ struct bap_hint * hint)       /* hint, filled in here       */
 {
-  const char * name SET_TO "locate_ships";
-  int row;
-  int col;
-  int reading_ship; /* 1=have started reading a ship, 0=not */
-  int length;       /* length of ship being read */
-  char switcher;
-
-  reading_ship SET_TO 0;
-  length SET_TO 0;
-  for (row SET_TO 0; row < world->number_rows; row++)
+  const char * name SET_TO "find_hint";
+  struct bap_world * world;
+  struct change * the_change; /* change on trail                       */
+  int end_line;      /* value of world->logic_line once rule fired     */
+  int failed;        /* set to ERROR if rule failed with a message     */
+  int fired;         /* rule that made progress or found no answer     */
+  int hinted;        /* set to 1 if a rule set squares                 */
+  int index;         /* index of square in squares of hint             */
+  int line;          /* index of line of explanation                   */
+  int logic_line;    /* value of world->logic_line on entry            */
+  int logic_strip;   /* value of world->logic_strip on entry           */
+  int mark;          /* number of changes on trail on entry            */
+  int n;             /* index of change on trail                       */
+  int needed;        /* number of characters explanation needs         */
+  int result;        /* value returned by run_rules                    */
+  int set;           /* set to 1 once a rule has set a square          */
+  int solved;        /* set to 1 if every strip done                   */
+  int stop;          /* set to 1 when rules need not be run again      */
+  char * text;       /* explanation, made longer                       */
+  char * where;      /* where to put next line of explanation          */
+
+  world SET_TO &(session->world);
+  logic_line SET_TO world->logic_line;
+  logic_strip SET_TO world->logic_strip;
+  mark SET_TO world->trail->number_changes;
+  result SET_TO OK;
+  fired SET_TO RULE_VERIFY_SQUARES;
+  set SET_TO 0;
+  n SET_TO mark;
+  world->progress SET_TO 0;
+  for (stop SET_TO (world->undone IS 0); stop IS 0; )
     {
-      if (world->rows[row].done)
-	continue;
-      for (col SET_TO 0; col < world->number_cols; col++)
+      world->number_in_cols SET_TO 0;
+      world->number_in_rows SET_TO 0;
+      world->progress SET_TO 0;
+      result SET_TO run_rules(&fired, world);
+      for (; n < world->trail->number_changes; n++)
 	{
-	  if (reading_ship)
-	    {
-	      switcher SET_TO square(row, col, world);
-	      if (switcher IS '>')
-		{
-		  IFF(allocate_ship_row
-		      (row, (col - length), length + 1, world));
-		  reading_ship SET_TO 0;
-		}
-	      else if (switcher IS '+')
-		length++;
-	      else if ((switcher IS 'X') OR (switcher IS ' '))
-		reading_ship SET_TO 0;
-	      else
-		CHK(1, "Puzzle has no answer bad ship");
-	    }
-	  else
-	    {
-	      if (square(row, col, world) IS '<')
-		{
-		  reading_ship SET_TO 1;
-		  length SET_TO 1;
-		}
-	      else if (square(row, col, world) IS 'O')
-		IFF(allocate_ship_row(row, col, 1, world));
-	    }
+	  if (world->trail->changes[n].number IS NULL)
+	    set SET_TO 1;
 	}
+      stop SET_TO ((result ISNT OK) OR (NOT (world->progress)) OR set OR
+		   (world->undone IS 0));
     }
-  reading_ship SET_TO 0;
-  length SET_TO 0;
-  for (col SET_TO 0; col < world->number_cols; col++)
+  hinted SET_TO ((result IS OK) AND (world->progress ISNT 0) AND set);
+  solved SET_TO (world->undone IS 0);
+  if (hinted)
     {
-      if (world->cols[col].done)
-	continue;
-      for (row SET_TO 0; row < world->number_rows; row++)
+      clear_hint(session, hint);
+      for (n SET_TO mark; n < world->trail->number_changes; n++)
 	{
-	  if (reading_ship)
-	    {
-	      switcher SET_TO square(row, col, world);
-	      if (switcher IS 'v')
-		{
-		  IFF(allocate_ship_col
-		      ((row - length), col, length + 1, world));
-		  reading_ship SET_TO 0;
-		}
-	      else if (switcher IS '+')
-		length++;
-	      else if ((switcher IS 'X') OR (switcher IS ' '))
-		reading_ship SET_TO 0;
-	      else
-		CHK(1, "Puzzle has no answer bad ship");
-	    }
-	  else
+	  the_change SET_TO (world->trail->changes + n);
+	  if (the_change->number ISNT NULL)
+	    continue;
+	  index SET_TO
+	    ((the_change->row * world->number_cols) + the_change->col);
+	  if (session->listed[index] IS 0)
 	    {
-	      if (square(row, col, world) IS '^')
-		{
-		  reading_ship SET_TO 1;
-		  length SET_TO 1;
-		}
+	      session->listed[index] SET_TO 1;
+	      session->changed[hint->number_changed++] SET_TO index;
 	    }
 	}
+      for (n SET_TO 0; n < hint->number_changed; n++)
+	session->listed[session->changed[n]] SET_TO 0;
+    }
+  end_line SET_TO world->logic_line;
+  IFF(undo_trail(mark, world));
+  world->logic_line SET_TO logic_line;
+  world->logic_strip SET_TO logic_strip;
+  failed SET_TO (((result ISNT OK) AND (world->message[0] ISNT 0)) ?
+		 ERROR : OK);
+  IFF(failed);
+  if (hinted)
+    {
+      needed SET_TO
+	(((end_line - logic_line) * world->logic_width) + TEXT_SIZE);
+      if (needed > session->text_size)
+	{
+	  text SET_TO (char *)realloc(session->text, needed);
+	  CHB((text IS NULL), "Out of memory");
+	  session->text SET_TO text;
+	  session->text_size SET_TO needed;
+	  hint->explanation SET_TO text;
+	}
+      strcpy(session->text, rule_names[fired]);
+      where SET_TO session->text;
+      for (line SET_TO logic_line; line < end_line; line++)
+	{
+	  if (line > logic_line)
+	    *(where++) SET_TO '\n';
+	  render_event((world->logic + line), where, world);
+	  for (where SET_TO (where + strlen(where));
+	       ((where > session->text) AND (where[-1] IS ' ')); where--);
+	  *where SET_TO 0;
+	}
+      hint->rule SET_TO rule_names[fired];
+      hint->status SET_TO BAP_HINT;
+    }
+  else
+    {
+      clear_hint(session, hint);
+      if (result ISNT OK)
+	{
+	  strcpy(session->text, "puzzle has no answer");
+	  hint->rule SET_TO rule_names[fired];
+	  hint->status SET_TO BAP_NO_ANSWER;
+	}
+      else if (solved)
+	hint->status SET_TO BAP_SOLVED;
+      else
+	hint->status SET_TO BAP_STUCK;
     }
   return OK;
 }
 
 /*************************************************************************/
 
-/* main
+/* find_max_starts_col
 
-Side Effects: This:
-1. calls read_arguments to read the arguments.
-2. calls init_world to initialize the world puzzle model.
-3. if needed, calls read_problem to read the problem.
-4. calls init_solution to initialize the solving process.
-5. calls solve_problem to solve the problem.
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. ship_fits_col_row returns ERROR.
+  2. The assigned ships do not fit in the column: "Puzzle has no answer".
 
-Notes:
+Called By:  place_ships_col
 
-This main follows the model for all mains for solving squares problems.
-The model always has the five steps listed immediately above.
+Side Effects:  The max_starts array is filled in with the row
+numbers of squares where successive ships of the given size and not
+already located can last be started.
 
-It is expected that solve_XXX may be called recursively for search,
-but that some initial steps in the solution will need to be done only
-once. The init_solution function takes these steps.
+Notes:
 
-The IFFs (which contain "return" statements) stop execution in case an
-error occurs (as intended) because in a "main" function, "return"
-stops execution.
+ys is used only because ship_fits_col_row requires it.
+
+Where row is set to (row - size), we really want it set to (row - size - 1)
+but row-- gets the 1 when the loop loops.
 
 */
 
-int main(      /* ARGUMENTS                             */
- int argc,     /* one more than the number of arguments */
- char ** argv) /* function name and arguments           */
+int find_max_starts_col(   /* ARGUMENTS                                     */
+ int col,                  /* column for which max_starts are being found   */
+ int size,                 /* size of assigned ships                        */
+ int assigned,             /* number of ships of given size assigned to col */
+ int * max_starts,         /* array of maximum starting locations, set here */
+ struct bap_world * world) /* puzzle model                                  */
 {
-  const char * name SET_TO "main";
-  struct bap_world world1;
-  struct bap_world * world;
+  const char * name SET_TO "find_max_starts_col";
+  int row;
+  int places;
+  int ys;
+  int is_legal;
 
-  world SET_TO &world1;
-  IFF(init_world(world));
-  IFF(read_arguments(argc, argv, world));
-  IFF(read_problem(argv[1], world));
-  IFF(init_solution(world));
-  CHB((solve_problem(world) ISNT OK), "Puzzle has no answer");
+  places SET_TO assigned;
+  for (row SET_TO (world->number_rows - size);
+       ((row > -1) AND (places ISNT 0));
+       row--)
+    {
+      IFF(ship_fits_col_row(col, row, size, &ys, &is_legal, world));
+      if (is_legal)
+	{
+	  if (NOT (world->locations[row][col]))
+	    {
+	      places--;
+	      max_starts[places] SET_TO row;
+	    }
+	  row SET_TO (row - size);
+	}
+    }
+  CHK((places ISNT 0), "Puzzle has no answer");
   return OK;
 }
 
 /*************************************************************************/
 
-/* make_guess_ship_col
+/* find_max_starts_row
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. size is less than 1 or greater than 4: "Bug bad size".
-  2. *number_guesses is too large: "Too many alternatives".
-  3. submarine_covers returns ERROR.
-  4. ship_fits_col_row returns ERROR.
-
-Called By:
-  make_guesses_battleships
-  make_guesses_cruisers
-  make_guesses_destroyers
-  make_guesses_submarines
+  1. ship_fits_row_col returns ERROR.
+  2. The assigned ships do not fit in the row: "Puzzle has no answer"
 
-Side Effects:
+Called By:  place_ships_row
 
-The current number of guesses is passed in and reset on the way out.
-This is so the function can add guesses to an existing set of guesses.
+Side Effects:  The max_starts array is filled in with the column
+numbers of squares where successive ships of the given size and not
+already located can last be started.
 
 Notes:
 
-This stops making guesses when *number_guesses equals limit.
+ys is used only because ship_fits_row_col requires it.
+
+Where col is set to (col - size), we really want it set to (col - size - 1)
+but col-- gets the 1 when the loop loops.
 
 */
 
-int make_guess_ship_col(   /* ARGUMENTS                                   */
- int size,                 /* size of ship to make guesses for            */
- int col,                  /* index of column to make guesses in          */
- int * number_guesses,     /* number of guesses in set, may be reset here */
- int limit,                /* the maximum number to put in a set          */
- struct guess * guesses,   /* the guesses, may be reset here              */
- struct bap_world * world) /* puzzle model                                */
+int find_max_starts_row(   /* ARGUMENTS                                     */
+ int row,                  /* row for which max_starts are being found      */
+ int size,                 /* size of assigned ships                        */
+ int assigned,             /* number of ships of given size assigned to row */
+ int * max_starts,         /* array of maximum starting locations, set here */
+ struct bap_world * world) /* puzzle model                                  */
 {
-  const char * name SET_TO "make_guess_ship_col";
-  int row;
-  int stop;
-  int ys;
+  const char * name SET_TO "find_max_starts_row";
+  int col;
+  int places;
+  int ys;
   int is_legal;
-  int n;
 
-  CHB(((size < 1) OR (size > 4)), "Bug bad size");
-  n SET_TO *number_guesses;
-  stop SET_TO (world->number_rows - (size - 1));
-  for (row SET_TO 0; ((n < limit) AND (row < stop)); row++)
+  places SET_TO assigned;
+  for (col SET_TO (world->number_cols - size);
+       ((col > -1) AND (places ISNT 0));
+       col--)
     {
-      if (size IS 1)
-	IFF(submarine_covers(row, col, &is_legal, world));
-      else
-	IFF(ship_fits_col_row(col, row, size, &ys, &is_legal, world));
-      if ((is_legal) AND (NOT (world->locations[row][col])))
+      IFF(ship_fits_row_col(row, col, size, &ys, &is_legal, world));
+      if (is_legal)
 	{
-	  IFF(already_tried(row, col, size, 0, &is_legal, world));
-	  if (is_legal)
+	  if (NOT (world->locations[row][col]))
 	    {
-	      CHB((n > (MAX_GUESSES - 2)), "Bug too many alternatives");
-	      guesses[n].size SET_TO size;
-	      guesses[n].row SET_TO row;
-	      guesses[n].col SET_TO col;
-	      guesses[n].in_row SET_TO 0;
-	      n++;
+	      places--;
+	      max_starts[places] SET_TO col;
 	    }
+	  col SET_TO (col - size);
 	}
     }
-  *number_guesses SET_TO n;
+  CHK((places ISNT 0), "Puzzle has no answer");
   return OK;
 }
 
 /*************************************************************************/
 
-/* make_guess_ship_row
+/* find_min_starts_col
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. size is less than 1 or greater than 4: "Bug bad size".
-  2. *number_guesses is too large: "Too many alternatives".
-  3. submarine_covers returns ERROR.
-  4. ship_fits_row_col returns ERROR.
-
-Called By:
-  make_guesses_battleships
-  make_guesses_cruisers
-  make_guesses_destroyers
-  make_guesses_submarines
+  1. ship_fits_col_row returns ERROR.
+  2. The assigned ships do not fit in the column: "Puzzle has no answer".
 
-Side Effects:
+Called By:  place_ships_col
 
-The current number of guesses is passed in and reset on the way out.
-This is so the function can add guesses to an existing set of guesses.
+Side Effects: The min_starts array is filled in with the row
+numbers of squares where successive ships of the given size and not
+already located can first be started.
 
 Notes:
 
-This stops making guesses when *number_guesses equals limit.
+ys is used only because ship_fits_col_row requires it.
+
+Where row is set to (row + size), we really want it set to (row + size + 1)
+but row++ gets the 1 when the loop loops.
 
 */
 
-int make_guess_ship_row(   /* ARGUMENTS                                   */
- int size,                 /* size of ship to make guesses for            */
- int row,                  /* index of row to make guesses in             */
- int * number_guesses,     /* number of guesses in set, may be reset here */
- int limit,                /* the maximum number to put in a set          */
- struct guess * guesses,   /* the guesses, may be reset here              */
- struct bap_world * world) /* puzzle model                                */
+int find_min_starts_col(   /* ARGUMENTS                                     */
+ int col,                  /* column for which min_starts are being found   */
+ int size,                 /* size of assigned ships                        */
+ int assigned,             /* number of ships of given size assigned to col */
+ int * min_starts,         /* array of minimum starting locations, set here */
+ struct bap_world * world) /* puzzle model                                  */
 {
-  const char * name SET_TO "make_guess_ship_row";
-  int col;
+  const char * name SET_TO "find_min_starts_col";
+  int row;
   int stop;
+  int places;
   int ys;
   int is_legal;
-  int n;
 
-  CHB(((size < 1) OR (size > 4)), "Bug bad size");
-  n SET_TO *number_guesses;
-  stop SET_TO (world->number_cols - (size - 1));
-  for (col SET_TO 0; ((n < limit) AND (col < stop)); col++)
+  stop SET_TO (world->number_rows - (size - 1));
+  places SET_TO 0;
+  for (row SET_TO 0; ((row < stop) AND (places < assigned)); row++)
     {
-      if (size IS 1)
-	IFF(submarine_covers(row, col, &is_legal, world));
-      else
-	IFF(ship_fits_row_col(row, col, size, &ys, &is_legal, world));
-      if ((is_legal) AND (NOT (world->locations[row][col])))
+      IFF(ship_fits_col_row(col, row, size, &ys, &is_legal, world));
+      if (is_legal)
 	{
-	  IFF(already_tried(row, col, size, 1, &is_legal, world));
-	  if (is_legal)
-	    {
-	      CHB((n > (MAX_GUESSES - 2)), "Bug too many alternatives");
-	      guesses[n].size SET_TO size;
-	      guesses[n].row SET_TO row;
-	      guesses[n].col SET_TO col;
-	      guesses[n].in_row SET_TO 1;
-	      n++;
-	    }
+	  if (NOT (world->locations[row][col]))
+	    min_starts[places++] SET_TO row;
+	  row SET_TO (row + size);
 	}
     }
-  *number_guesses SET_TO n;
+  CHK((places < assigned), "Puzzle has no answer");
   return OK;
 }
 
 /*************************************************************************/
 
-/* make_guesses_battleships
+/* find_min_starts_row
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. A battleship is assigned to a strip but no battleship fits in the
-     strip: "Cannot solve puzzle"
-  2. At least one battleship remains to be located but it is not possible
-     to put it anywhere in the puzzle: "Cannot solve puzzle"
-  3. make_guess_ship_row returns ERROR.
-  4. make_guess_ship_col returns ERROR.
-  5. copy_guesses returns ERROR.
-
-Called By:  try_guessing
+  1. ship_fits_row_col returns ERROR.
+  2. The assigned ships do not fit in the row: "Puzzle has no answer".
 
-Side Effects: If any battleship is assigned, this makes a set of
-guesses for each strip to which a battleship is assigned and saves the
-smallest set.  In the case of equally small sets, the first one found
-is saved.  If no battleship is assigned, this makes one set of guesses
-for the whole puzzle.
+Called By:  place_ships_row
 
-Each set of guesses is exhaustive (at least one must be correct), but
-the guesses are not mutually exclusive (which would be nice) unless
-only one battleship has not yet been located.
+Side Effects: The min_starts array is filled in with the column
+numbers of squares where successive ships of the given size and not
+already located can first be started.
 
 Notes:
 
-This assumes there may be more than one battleship.
+ys is used only because ship_fits_row_col requires it.
+
+Where col is set to (col + size), we really want it set to (col + size + 1)
+but col++ gets the 1 when the loop loops.
 
 */
 
-int make_guesses_battleships( /* ARGUMENTS                    */
- int * number_guesses,        /* number of guesses, set here  */
- struct guess * guesses,      /* a set of guesses, set here   */
- struct bap_world * world)    /* puzzle model                 */
+int find_min_starts_row(   /* ARGUMENTS                                     */
+ int row,                  /* row for which min_starts are being found      */
+ int size,                 /* size of assigned ships                        */
+ int assigned,             /* number of ships of given size assigned to row */
+ int * min_starts,         /* array of minimum starting locations, set here */
+ struct bap_world * world) /* puzzle model                                  */
 {
-  const char * name SET_TO "make_guesses_battleships";
-  int row;
+  const char * name SET_TO "find_min_starts_row";
   int col;
-  int n;
-  struct guess guesses2[MAX_GUESSES]; /* new set of guesses */
+  int stop;
+  int places;
+  int ys;
+  int is_legal;
 
-  if (world->battleships_ass)
-    {
-      *number_guesses SET_TO (MAX_GUESSES + 1);
-      for (row SET_TO 0; row < world->number_rows; row++)
-	{
-	  if (world->rows[row].battleships)
-	    {
-	      n SET_TO 0;
-	      IFF(make_guess_ship_row
-		  (4, row, &n, *number_guesses, guesses2, world));
-	      CHK((n IS 0), "Cannot solve puzzle");
-	      if (n < *number_guesses)
-		{
-		  IFF(copy_guesses(guesses, guesses2, n));
-		  *number_guesses SET_TO n;
-		}
-	    }
-	}
-      for (col SET_TO 0; col < world->number_cols; col++)
-	{
-	  if (world->cols[col].battleships)
-	    {
-	      n SET_TO 0;
-	      IFF(make_guess_ship_col
-		  (4, col, &n, *number_guesses, guesses2, world));
-	      CHK((n IS 0), "Cannot solve puzzle");
-	      if (n < *number_guesses)
-		{
-		  IFF(copy_guesses(guesses, guesses2, n));
-		  *number_guesses SET_TO n;
-		}
-	    }
-	}
-    }
-  else if (world->battleships_left)
+  stop SET_TO (world->number_cols - (size - 1));
+  places SET_TO 0;
+  for (col SET_TO 0; ((col < stop) AND (places < assigned)); col++)
     {
-      *number_guesses SET_TO 0;
-      for (row SET_TO 0; row < world->number_rows; row++)
-	{
-	  IFF(make_guess_ship_row
-	      (4, row, number_guesses, (MAX_GUESSES + 1), guesses, world));
-	}
-      for (col SET_TO 0; col < world->number_cols; col++)
+      IFF(ship_fits_row_col(row, col, size, &ys, &is_legal, world));
+      if (is_legal)
 	{
-	  IFF(make_guess_ship_col
-	      (4, col, number_guesses, (MAX_GUESSES + 1), guesses, world));
+	  if (NOT (world->locations[row][col]))
+	    min_starts[places++] SET_TO col;
+	  col SET_TO (col + size);
 	}
-      CHK((*number_guesses IS 0), "Cannot solve puzzle");
     }
-  else
-    CHB(1, "Bug make_guesses_battleships called when no battleships left");
+  CHK((places < assigned), "Puzzle has no answer");
   return OK;
 }
 
 /*************************************************************************/
 
-/* make_guesses_cruisers
+/* finish_pure
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. A cruiser is assigned to a strip but no cruiser fits in the
-     strip: "Cannot solve puzzle"
-  2. At least one cruiser remains to be located but it is not possible
-     to put it anywhere in the puzzle: "Cannot solve puzzle"
-  3. make_guess_ship_row returns ERROR.
-  4. make_guess_ship_col returns ERROR.
-  5. copy_guesses returns ERROR.
+  1. Some ship has not been located: "Puzzle has no answer".
+  2. trail_square, set_square, trail_number, or record_line returns
+     ERROR.
 
-Called By:  try_guessing
+Called By:  solve_problem
 
-Side Effects: See make_guesses_battleships
+Side Effects: This is called when every strip is done in a pure search
+(see mark_dones). It checks that every ship has been located, and then
+fills the remaining blank squares with water, so that the answer is
+printed (and checked in a batch) just as the other strategies print it.
+
+Notes:
+
+In a pure search a strip is done when it has all its ship parts, so
+every strip may be done while some parts (given in the puzzle, say)
+are not in any located ship. That is not an answer.
 
 */
 
-int make_guesses_cruisers( /* ARGUMENTS                    */
- int * number_guesses,     /* number of guesses, set here  */
- struct guess * guesses,   /* a set of guesses, set here   */
- struct bap_world * world) /* puzzle model                 */
+int finish_pure(           /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
 {
-  const char * name SET_TO "make_guesses_cruisers";
+  const char * name SET_TO "finish_pure";
   int row;
   int col;
-  int n;
-  struct guess guesses2[MAX_GUESSES]; /* new set of guesses */
-
-  if (world->cruisers_ass)
+  int filled;   /* set to 1 if any blank is filled */
+
+  CHK(((world->battleships_left ISNT 0) OR
+       (world->battleships_ass ISNT 0) OR
+       (world->cruisers_left ISNT 0) OR
+       (world->cruisers_ass ISNT 0) OR
+       (world->destroyers_left ISNT 0) OR
+       (world->destroyers_ass ISNT 0) OR
+       (world->submarines_left_row ISNT 0) OR
+       (world->submarines_ass_row ISNT 0)), "Puzzle has no answer");
+  filled SET_TO 0;
+  for (row SET_TO 0; row < world->number_rows; row++)
     {
-      *number_guesses SET_TO (MAX_GUESSES + 1);
-      for (row SET_TO 0; row < world->number_rows; row++)
-	{
-	  if (world->rows[row].cruisers)
-	    {
-	      n SET_TO 0;
-	      IFF(make_guess_ship_row
-		  (3, row, &n, *number_guesses, guesses2, world));
-	      CHK((n IS 0), "Cannot solve puzzle");
-	      if (n < *number_guesses)
-		{
-		  IFF(copy_guesses(guesses, guesses2, n));
-		  *number_guesses SET_TO n;
-		}
-	    }
-	}
       for (col SET_TO 0; col < world->number_cols; col++)
 	{
-	  if (world->cols[col].cruisers)
+	  if (world->squares[row][col] IS ' ')
 	    {
-	      n SET_TO 0;
-	      IFF(make_guess_ship_col
-		  (3, col, &n, *number_guesses, guesses2, world));
-	      CHK((n IS 0), "Cannot solve puzzle");
-	      if (n < *number_guesses)
-		{
-		  IFF(copy_guesses(guesses, guesses2, n));
-		  *number_guesses SET_TO n;
-		}
+	      IFF(trail_square(row, col, world));
+	      IFF(set_square(row, col, '.', world));
+	      IFF(trail_number(&(world->cols[col].dry), world));
+	      world->cols[col].dry--;
+	      IFF(trail_number(&(world->rows[row].dry), world));
+	      world->rows[row].dry--;
+	      filled SET_TO 1;
 	    }
 	}
     }
-  else if (world->cruisers_left)
+  if (filled)
+    IFF(record_line("fill remaining blanks with water", world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* finish_trace
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The trace file could not be written: "Could not write trace".
+  2. A guess of the replay differs from the trace, or the trace has
+     guesses that were not replayed: "Replay differs from trace".
+
+Called By:  main
+
+Side Effects: This closes the trace file and frees world->trace,
+setting it to NULL. When replaying, it first tries to read one more
+record, since a trace with a guess left over differs from the replay
+as much as one with a guess that differs, and then prints how many
+guesses were replayed or which was the first to differ.
+
+*/
+
+int finish_trace(          /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "finish_trace";
+  struct trace * trace;       /* trace being finished                  */
+  struct trace_record record; /* record after last one replayed        */
+  int failed;                 /* set to 1 if file could not be written */
+  long long differ;           /* number of first record that differs   */
+
+  trace SET_TO world->trace;
+  world->trace SET_TO NULL;
+  if (trace->replay AND (trace->differ IS 0) AND
+      (fread(&record, sizeof(struct trace_record), 1, trace->port) IS 1))
+    trace->differ SET_TO (trace->number_records + 1);
+  failed SET_TO ((fclose(trace->port) ISNT 0) AND (trace->replay IS 0));
+  if (trace->replay AND trace->differ)
+    printf("\nReplay: guess %lld differs from trace\n", trace->differ);
+  else if (trace->replay)
+    printf("\nReplay: %lld guesses, all as in trace\n",
+	   trace->number_records);
+  differ SET_TO trace->differ;
+  free(trace);
+  CHB(failed, "Could not write trace");
+  CHB(differ, "Replay differs from trace");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* free_arena
+
+Returned Value: int (OK)
+
+Called By:
+  bap_solve
+  run_pool
+  serve_bap
+  solve_job
+
+Side Effects: This frees every chunk of the arena and the arena itself.
+
+*/
+
+int free_arena(              /* ARGUMENTS        */
+ struct arena * the_arena)   /* arena to free    */
+{
+  const char * name SET_TO "free_arena";
+  struct chunk * the_chunk;  /* chunk to free      */
+  struct chunk * next;       /* chunk after it     */
+
+  for (the_chunk SET_TO the_arena->first;
+       the_chunk ISNT NULL;
+       the_chunk SET_TO next)
     {
-      *number_guesses SET_TO 0;
-      for (row SET_TO 0; row < world->number_rows; row++)
-	{
-	  IFF(make_guess_ship_row
-	      (3, row, number_guesses, (MAX_GUESSES + 1), guesses, world));
-	}
-      for (col SET_TO 0; col < world->number_cols; col++)
-	{
-	  IFF(make_guess_ship_col
-	      (3, col, number_guesses, (MAX_GUESSES + 1), guesses, world));
-	}
-      CHK((*number_guesses IS 0), "Cannot solve puzzle");
+      next SET_TO the_chunk->next;
+      free(the_chunk->memory);
+      free(the_chunk);
     }
-  else
-    CHB(1, "Bug make_guesses_cruisers called when no cruisers left");
+  free(the_arena);
   return OK;
 }
 
 /*************************************************************************/
 
-/* make_guesses_destroyers
+/* free_bap
+
+Returned Value: int (OK)
+
+Called By:
+  run_pool
+  save_answer
+
+Side Effects: This frees the block and the copies of the explanation,
+the list of guesses tried, and the path of a world made by clone_bap.
+The world itself is not freed.
+
+*/
+
+int free_bap(              /* ARGUMENTS                    */
+ struct bap_world * world) /* puzzle model made by clone_bap */
+{
+  const char * name SET_TO "free_bap";
+
+  free(world->block);
+  free(world->logic);
+  free(world->guesses_tried);
+  free(world->path);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* free_dlx
+
+Returned Value: int (OK)
+
+Called By:  solve_dlx
+
+Side Effects: This frees an exact cover problem made by dlx_make and
+everything it points to.
+
+*/
+
+int free_dlx(              /* ARGUMENTS                     */
+ struct dlx * the_dlx)     /* exact cover problem to free   */
+{
+  const char * name SET_TO "free_dlx";
+
+  free(the_dlx->chosen);
+  free(the_dlx->color);
+  free(the_dlx->dlink);
+  free(the_dlx->given);
+  free(the_dlx->hidden);
+  free(the_dlx->items);
+  free(the_dlx->len);
+  free(the_dlx->need);
+  free(the_dlx->node_option);
+  free(the_dlx->option_first);
+  free(the_dlx->placements);
+  free(the_dlx->room);
+  free(the_dlx->stack);
+  free(the_dlx->top);
+  free(the_dlx->ulink);
+  free(the_dlx->weight);
+  free(the_dlx);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* generate_bap
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. A destroyer is assigned to a strip but no destroyer fits in the
-     strip: "Cannot solve puzzle".
-  2. At least one destroyer remains to be located but it is not possible
-     to put it anywhere in the puzzle: "Cannot solve puzzle".
-  3. make_guess_ship_row returns ERROR.
-  4. make_guess_ship_col returns ERROR.
-  5. copy_guesses returns ERROR.
+  1. The directory name is too long: "Directory name too long".
+  2. FIXED_SIZE is not 0 and the size given is not FIXED_SIZE by
+     FIXED_SIZE: "Puzzle is not the size bap was compiled for".
+  3. There is no memory for the answer or the world checks are made on:
+     "Out of memory".
+  4. make_block, size_branch, make_branch, make_arena, make_trail,
+     size_block, attach_block, generate_fleet, generate_givens,
+     generate_count, or write_problem returns ERROR.
 
-Called By:  try_guessing
+Called By:  main
 
-Side Effects: See make_guesses_battleships
+Side Effects: This makes world->generate puzzles of the size and fleet
+given to read_arguments, each with exactly one answer, and writes each
+one as a problem file in the given directory, named genS_N.pro, where S
+is the seed and N counts from 1. One line is printed for each puzzle,
+giving the number of squares given in it and the number of times its
+answers were counted, and then a line of totals, for example:
+
+gen/gen1_1.pro givens=3 checks=7
+total puzzles=100 givens=352 checks=841 rejected=0 ms=312.420
+
+For each puzzle, generate_fleet places the ships at random, and
+generate_givens finds squares to give (see generate_count). Unless the
+checks were made with dlx, the answers of the puzzle made are then
+counted once more with dlx, and if it finds more than one, the puzzle
+is not written. A line giving the name it would have had and the
+number dlx found is printed instead, for example
+
+gen/gen7_423.pro rejected answers=2
+
+and another puzzle is made in its place, under the same name. rejected
+in the line of totals is the number of puzzles not written.
+
+Notes:
+
+The world passed in is the puzzle being made. Its block and branch are
+made once, here, and generate_clear sets it up for each new puzzle, as
+reading a problem file would. Each check copies it into the one other
+world made here (see generate_count), so nothing is read or malloc'ed
+for a check. The answers are counted with a limit of 2 in a job of
+this function, as with "count 2". The transposition table is not used,
+since states of one check would be found by the next.
+
+The count with dlx guards the promise of one answer against a rule
+that wrongly rules answers out, as ship_fits_row and ship_fits_col once
+did by counting too few ships (see K. of 9. in text/bap.txt). It is one
+more check for each puzzle, against a dozen or so made by
+generate_givens.
 
 */
 
-int make_guesses_destroyers( /* ARGUMENTS                    */
- int * number_guesses,       /* number of guesses, set here  */
- struct guess * guesses,     /* a set of guesses, set here   */
- struct bap_world * world)   /* puzzle model                 */
+int generate_bap(          /* ARGUMENTS                         */
+ char * directory,         /* directory to write problem files  */
+ struct bap_world * world) /* puzzle model, sized by arguments  */
 {
-  const char * name SET_TO "make_guesses_destroyers";
-  int row;
-  int col;
+  const char * name SET_TO "generate_bap";
+  struct bap_world work1;   /* world each check is made on           */
+  struct job the_job;       /* job counting answers of checks        */
+  char file_name[LINE_SIZE]; /* name of problem file written         */
+  char * solution;          /* answer of puzzle, row by row          */
+  int * order;              /* squares in the order they are tried   */
+  char * block;             /* block of work1                        */
+  long copied;              /* bytes of block copied by copy_bap     */
+  long bytes;               /* bytes of block altogether             */
+  unsigned long long seed;  /* seed given, for file names            */
+  struct timespec start;    /* time first puzzle started             */
+  struct timespec end;      /* time last puzzle finished             */
+  int squares;              /* number of squares in puzzle           */
+  int givens;               /* number of squares given in puzzle     */
+  int checks;               /* number of checks made for puzzle      */
+  int total_givens;         /* sum of givens                         */
+  long long total_checks;   /* sum of checks                         */
+  int answers;              /* number of answers dlx found           */
+  int rejected;             /* number of puzzles not written         */
+  int engine;               /* engine of checks                      */
   int n;
-  struct guess guesses2[MAX_GUESSES]; /* new set of guesses */
 
-  if (world->destroyers_ass)
-    {
-      *number_guesses SET_TO (MAX_GUESSES + 1);
-      for (row SET_TO 0; row < world->number_rows; row++)
-	{
-	  if (world->rows[row].destroyers)
-	    {
-	      n SET_TO 0;
-	      IFF(make_guess_ship_row
-		  (2, row, &n, *number_guesses, guesses2, world));
-	      CHK((n IS 0), "Cannot solve puzzle");
-	      if (n < *number_guesses)
-		{
-		  IFF(copy_guesses(guesses, guesses2, n));
-		  *number_guesses SET_TO n;
-		}
-	    }
-	}
-      for (col SET_TO 0; col < world->number_cols; col++)
-	{
-	  if (world->cols[col].destroyers)
-	    {
-	      n SET_TO 0;
-	      IFF(make_guess_ship_col
-		  (2, col, &n, *number_guesses, guesses2, world));
-	      CHK((n IS 0), "Cannot solve puzzle");
-	      if (n < *number_guesses)
-		{
-		  IFF(copy_guesses(guesses, guesses2, n));
-		  *number_guesses SET_TO n;
-		}
-	    }
-	}
-    }
-  else if (world->destroyers_left)
+  CHB((strlen(directory) > (LINE_SIZE - 64)), "Directory name too long");
+  CHB((FIXED_SIZE AND ((world->number_rows ISNT FIXED_SIZE) OR
+		       (world->number_cols ISNT FIXED_SIZE))),
+      "Puzzle is not the size bap was compiled for");
+  squares SET_TO (world->number_rows * world->number_cols);
+  seed SET_TO world->seed;
+  IFF(make_block(world->number_rows, world->number_cols, world));
+  IFF(size_branch(world));
+  IFF(make_branch(&(world->logic), &(world->logic_strips),
+		  &(world->guesses_tried), &(world->path), world));
+  IFF(make_arena(&(world->arena), world));
+  if (world->in_place)
+    IFF(make_trail(&(world->trail), world));
+  IFF(size_block(world->number_rows, world->number_cols, &copied, &bytes));
+  block SET_TO (char *)malloc(bytes);
+  solution SET_TO (char *)malloc(squares);
+  the_job.other SET_TO (char *)malloc(squares);
+  order SET_TO (int *)malloc(squares * sizeof(int));
+  CHB(((block IS NULL) OR (solution IS NULL) OR (the_job.other IS NULL) OR
+       (order IS NULL)), "Out of memory");
+  IFF(attach_block(block, world->number_rows, world->number_cols, &work1));
+  the_job.answer SET_TO solution;
+  the_job.file_name SET_TO file_name;
+  the_job.first SET_TO NULL;
+  the_job.request SET_TO NULL;
+  world->job SET_TO &the_job;
+  world->count SET_TO 2;
+  world->find_all SET_TO 1;
+  world->explain SET_TO 0;
+  total_givens SET_TO 0;
+  total_checks SET_TO 0;
+  rejected SET_TO 0;
+  engine SET_TO world->engine;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (n SET_TO 0; n < world->generate; n++)
     {
-      *number_guesses SET_TO 0;
-      for (row SET_TO 0; row < world->number_rows; row++)
+      IFF(generate_fleet(solution, world));
+      IFF(generate_givens(solution, order, &work1, &givens, &checks, world));
+      sprintf(file_name, "%s/gen%llu_%d.pro", directory, seed, (n + 1));
+      answers SET_TO 1;
+      if (engine ISNT ENGINE_DLX)
 	{
-	  IFF(make_guess_ship_row
-	      (2, row, number_guesses, (MAX_GUESSES + 1), guesses, world));
+	  world->engine SET_TO ENGINE_DLX;
+	  IFF(generate_count(&work1, &answers, world));
+	  world->engine SET_TO engine;
 	}
-      for (col SET_TO 0; col < world->number_cols; col++)
+      if (answers ISNT 1)
 	{
-	  IFF(make_guess_ship_col
-	      (2, col, number_guesses, (MAX_GUESSES + 1), guesses, world));
+	  printf("%s rejected answers=%d\n", file_name, answers);
+	  rejected++;
+	  n--;
+	  continue;
 	}
-      CHK((*number_guesses IS 0), "Cannot solve puzzle");
+      IFF(write_problem(file_name, world));
+      printf("%s givens=%d checks=%d\n", file_name, givens, checks);
+      total_givens SET_TO (total_givens + givens);
+      total_checks SET_TO (total_checks + checks);
     }
-  else
-    CHB(1, "Bug make_guesses_destroyers called when no destroyers left");
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  printf("total puzzles=%d givens=%d checks=%lld rejected=%d ms=%.3f\n",
+	 world->generate, total_givens, total_checks, rejected,
+	 ((1000.0 * (end.tv_sec - start.tv_sec)) +
+	  ((end.tv_nsec - start.tv_nsec) / 1000000.0)));
+  free(block);
+  free(solution);
+  free(the_job.other);
+  free(order);
+  world->job SET_TO NULL;
   return OK;
 }
 
 /*************************************************************************/
 
-/* make_guesses_submarines
+/* generate_clear
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. A submarine is assigned to a strip but no submarine fits in the
-     strip: "Cannot solve puzzle".
-  2. make_guess_ship_row returns ERROR.
-  3. make_guess_ship_col returns ERROR.
-  4. copy_guesses returns ERROR.
+  1. set_square returns ERROR.
 
-Called By:  try_guessing
+Called By:  generate_givens
 
-Side Effects: See make_guesses_battleships
+Side Effects: This sets up the world as if a problem file with the
+given answer and no squares given had just been read: all squares are
+blank, the total of each row and column is its number of ship parts in
+the answer, and all counts are as read_row and read_rows leave them.
 
 */
 
-int make_guesses_submarines( /* ARGUMENTS                    */
- int * number_guesses,       /* number of guesses, set here  */
- struct guess * guesses,     /* a set of guesses, set here   */
- struct bap_world * world)   /* puzzle model                 */
+int generate_clear(        /* ARGUMENTS                      */
+ char * solution,          /* answer of puzzle, row by row   */
+ struct bap_world * world) /* puzzle model, block made       */
 {
-  const char * name SET_TO "make_guesses_submarines";
+  const char * name SET_TO "generate_clear";
   int row;
   int col;
-  int n;
-  struct guess guesses2[MAX_GUESSES];
 
-  if (world->submarines_ass_row OR world->submarines_ass_col)
+  memset(world->block, 0, world->block_bytes);
+  for (row SET_TO 0; row < world->number_rows; row++)
     {
-      *number_guesses SET_TO (MAX_GUESSES + 1);
-      if (world->submarines_ass_row)
-	{
-	  for (row SET_TO 0; row < world->number_rows; row++)
-	    {
-	      if (world->rows[row].submarines)
-		{
-		  n SET_TO 0;
-		  IFF(make_guess_ship_row
-		      (1, row, &n, *number_guesses, guesses2, world));
-		  CHK((n IS 0), "Cannot solve puzzle");
-		  if (n < *number_guesses)
-		    {
-		      IFF(copy_guesses(guesses, guesses2, n));
-		      *number_guesses SET_TO n;
-		    }
-		}
-	    }
-	}
-      if (world->submarines_ass_col)
+      for (col SET_TO 0; col < world->number_cols; col++)
 	{
-	  for (col SET_TO 0; col < world->number_cols; col++)
+	  world->squares[row][col] SET_TO ' ';
+	  if (solution[(row * world->number_cols) + col] ISNT '.')
 	    {
-	      if (world->cols[col].submarines)
-		{
-		  n SET_TO 0;
-		  IFF(make_guess_ship_col
-		      (1, col, &n, *number_guesses, guesses2, world));
-		  CHK((n IS 0), "Cannot solve puzzle");
-		  if (n < *number_guesses)
-		    {
-		      IFF(copy_guesses(guesses, guesses2, n));
-		      *number_guesses SET_TO n;
-		    }
-		}
+	      world->rows[row].aim++;
+	      world->cols[col].aim++;
 	    }
 	}
+      world->rows[row].dry SET_TO world->number_cols;
     }
-  else if (world->submarines_left_row)
-    {
-      *number_guesses SET_TO 0;
-      for (row SET_TO 0; row < world->number_rows; row++)
-	{
-	  IFF(make_guess_ship_row
-	      (1, row, number_guesses, (MAX_GUESSES + 1), guesses, world));
-	}
-      CHK((*number_guesses IS 0), "Cannot solve puzzle");
-    }
-  else if (world->submarines_left_col)
-    {
-      *number_guesses SET_TO 0;
-      for (col SET_TO 0; col < world->number_cols; col++)
-	{
-	  IFF(make_guess_ship_col
-	      (1, col, number_guesses, (MAX_GUESSES + 1), guesses, world));
-	}
-      CHK((*number_guesses IS 0), "Cannot solve puzzle");
-    }
-  else
-    CHB(1, "Bug make_guesses_submarines called when no submarines left");
+  for (col SET_TO 0; col < world->number_cols; col++)
+    world->cols[col].dry SET_TO world->number_rows;
+  world->undone SET_TO (world->number_cols + world->number_rows);
   return OK;
 }
 
 /*************************************************************************/
 
-/* make_water
+/* generate_count
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. The square at the given row and column is neither blank nor
-     water: "Puzzle has no answer".
+  1. copy_bap or arena_release returns ERROR.
 
 Called By:
-  dex_ends_col
-  dex_ends_row
-  enx_square
-  extend_horizontal
-  extend_vertical
-  fill_bap
-  insert_guess_square
-  pad_square
-  place_ships_col_water
-  place_ships_row_water
-  try_cross_col_fill_col
-  try_cross_row_fill_row
-  try_full_but_two_col
-  try_full_but_two_row
-  try_square_blank
+  generate_bap
+  generate_givens
 
-Side Effects: If the square in given row and column is blank, this
-sets the square to water, updates dry in the given row and column, and
-sets world->progress to 1.
+Side Effects: This counts the answers of the puzzle in world, up to
+world->count, and sets *answers to the number. The puzzle is copied
+into work, which is solved as main would solve it with one thread
+(or by solve_dlx with --engine=dlx), so world is not changed. If an
+answer is not the one in world->job->answer, it is copied into
+world->job->other (see check_answer).
 
 Notes:
 
-This function may be called with row or col out of bounds. In this
-case, square(row, col, world) will be '.'. Thus the "if" serves to check
-that the square at row,col is both in bounds and blank before it is
-set to '.'.
+An error from init_solution, solve_problem, or solve_dlx means only
+that no answer was found, as in solve_job. The arena is emptied first
+in case a search that ended in an error left something in it.
 
 */
 
-int make_water(            /* ARGUMENTS                                  */
- int row,                  /* index of row of square being made water    */
- int col,                  /* index of column of square being made water */
- struct bap_world * world) /* puzzle model                               */
+int generate_count(        /* ARGUMENTS                        */
+ struct bap_world * work,  /* world to solve copy of puzzle on */
+ int * answers,            /* number of answers, set here      */
+ struct bap_world * world) /* puzzle model                     */
 {
-  const char * name SET_TO "make_water";
+  const char * name SET_TO "generate_count";
+  struct arena_mark empty;  /* mark of empty arena */
+  int result;
 
-  if (square(row, col, world) IS ' ')
+  empty.chunk SET_TO world->arena->first;
+  empty.used SET_TO 0;
+  IFF(arena_release(&empty, world));
+  if (world->trail)
+    world->trail->number_changes SET_TO 0;
+  world->job->number_answers SET_TO 0;
+  IFF(copy_bap(work, world));
+  if (world->engine IS ENGINE_DLX)
+    result SET_TO solve_dlx(work);
+  else
     {
-      world->squares[row][col] SET_TO '.';
-      world->cols[col].dry--;
-      world->rows[row].dry--;
-      world->progress SET_TO 1;
+      result SET_TO init_solution(work);
+      if (result IS OK)
+	result SET_TO solve_problem(work);
     }
-  else
-    CHK((square(row, col, world) ISNT '.'), "Puzzle has no answer");
+  *answers SET_TO world->job->number_answers;
   return OK;
 }
 
 /*************************************************************************/
 
-/* mark_dones
+/* generate_fits
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. A strip still has a ship assigned when done: "Bug in assigning ships".
-
-Called By:  solve_problem
+Returned Value: int (OK)
 
-Side Effects: For each strip not already marked done in which (1) aim,
-got, and dry are all equal and (2) exes is zero, the strip is marked
-done and world->undone is decreased by one.
+Called By:  generate_ship
 
-Notes: Locate_ships should normally be run before this so that no
-strip which has unlocated ships is marked done.
+Side Effects: This sets *fits to 1 if a ship of the given size may be
+placed in the answer with its left or top end at the given row and
+column (in the row if in_row is 1, in the column if it is 0), and to 0
+if not. It may be placed if it is inside the grid and no square of it
+or around it is already ship.
 
 */
 
-int mark_dones(            /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int generate_fits(         /* ARGUMENTS                                */
+ char * solution,          /* answer being made, row by row            */
+ int row,                  /* row of left or top end of ship           */
+ int col,                  /* column of left or top end of ship        */
+ int size,                 /* size of ship                             */
+ int in_row,               /* 1 if ship lies in row, 0 if in column    */
+ int * fits,               /* set here                                 */
+ struct bap_world * world) /* puzzle model                             */
 {
-  const char * name SET_TO "mark_dones";
-  int row;
-  int col;
-
-  for (row SET_TO 0; row < world->number_rows; row++)
-    {
-      if (world->rows[row].done);
-      else if ((world->rows[row].aim IS world->rows[row].got) AND
-	       (world->rows[row].aim IS world->rows[row].dry) AND
-	       (world->rows[row].exes IS 0))
-	{
-	  world->rows[row].done SET_TO 1;
-	  world->undone--;
-	  CHK(((world->rows[row].battleships) OR
-	       (world->rows[row].cruisers) OR
-	       (world->rows[row].destroyers) OR
-	       (world->rows[row].submarines)), "Bug in assigning ships");
-	}
-    }
-  for (col SET_TO 0; col < world->number_cols; col++)
+  const char * name SET_TO "generate_fits";
+  int last_row;  /* row of bottom end of ship    */
+  int last_col;  /* column of right end of ship  */
+  int r;
+  int c;
+
+  last_row SET_TO (in_row ? row : (row + (size - 1)));
+  last_col SET_TO (in_row ? (col + (size - 1)) : col);
+  *fits SET_TO ((last_row < world->number_rows) AND
+		(last_col < world->number_cols));
+  for (r SET_TO (row - 1); (*fits AND (r <= (last_row + 1))); r++)
     {
-      if (world->cols[col].done);
-      else if ((world->cols[col].aim IS world->cols[col].got) AND
-	       (world->cols[col].aim IS world->cols[col].dry) AND
-	       (world->cols[col].exes IS 0))
+      for (c SET_TO (col - 1); (*fits AND (c <= (last_col + 1))); c++)
 	{
-	  world->cols[col].done SET_TO 1;
-	  world->undone--;
-	  CHK(((world->cols[col].battleships) OR
-	       (world->cols[col].cruisers) OR
-	       (world->cols[col].destroyers) OR
-	       (world->cols[col].submarines)), "Bug in assigning ships");
+	  if ((r > -1) AND (r < world->number_rows) AND
+	      (c > -1) AND (c < world->number_cols) AND
+	      (solution[(r * world->number_cols) + c] ISNT '.'))
+	    *fits SET_TO 0;
 	}
     }
   return OK;
@@ -4154,2136 +5881,8877 @@ int mark_dones(            /* ARGUMENTS    */
 
 /*************************************************************************/
 
-/* pad_bap
+/* generate_fleet
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. pad_square returns ERROR.
+  1. The fleet cannot be placed after many tries: "Cannot place fleet".
+  2. generate_ship returns ERROR.
 
-Called By:  init_solution
+Called By:  generate_bap
 
-Side Effects: This adds any missing water at the adjacent squares sure
-to be water of each square of the puzzle that has a ship part in
-it. If any missing water is added, that fact is reported.
+Side Effects: This fills solution with a random answer: the ships of
+the fleet of the world, placed one at a time, largest first, each at a
+place picked at random from all the places it fits (see
+generate_ship), and water everywhere else. If some ship does not fit
+anywhere, the answer is started over.
 
 */
 
-int pad_bap(               /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int generate_fleet(        /* ARGUMENTS                         */
+ char * solution,          /* answer, row by row, made here     */
+ struct bap_world * world) /* puzzle model, holding the fleet   */
 {
-  const char * name SET_TO "pad_bap";
+  const char * name SET_TO "generate_fleet";
+  int numbers[5];  /* number of ships of each size      */
+  int placed;      /* set to 0 if a ship did not fit    */
+  int tries;       /* number of times answer started    */
+  int size;
   int n;
-  int k;
-  char item;
 
-  for (n SET_TO 0; n < world->number_rows; n++)
+  numbers[1] SET_TO world->submarines_left_row;
+  numbers[2] SET_TO world->destroyers_left;
+  numbers[3] SET_TO world->cruisers_left;
+  numbers[4] SET_TO world->battleships_left;
+  for (placed SET_TO 0, tries SET_TO 0; placed IS 0; tries++)
     {
-      for (k SET_TO 0; k < world->number_cols; k++)
-	{
-	  item SET_TO world->squares[n][k];
-	  if ((item ISNT ' ') AND (item ISNT '.'))
-	    IFF(pad_square(item, n, k, world));
-	}
-    }
-  if (world->progress)
-    {
-      strcpy
-	(world->logic[world->logic_line++], "pad given ship parts with water:");
-      if (world->print_all)
+      CHB((tries IS 1000), "Cannot place fleet");
+      memset(solution, '.', (world->number_rows * world->number_cols));
+      placed SET_TO 1;
+      for (size SET_TO 4; (placed AND (size > 0)); size--)
 	{
-	  print_bap(world);
-	  printf("%s\n\n", world->logic[world->logic_line - 1]);
+	  for (n SET_TO 0; (placed AND (n < numbers[size])); n++)
+	    IFF(generate_ship(solution, size, &placed, world));
 	}
-      world->progress SET_TO 0;
     }
   return OK;
 }
 
 /*************************************************************************/
 
-/* pad_square
+/* generate_give
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. make_water returns ERROR.
-
-Called By:  pad_bap
+  1. set_square returns ERROR.
 
-Side Effects:
+Called By:  generate_givens
 
-This adds any missing water at the adjacent squares sure to be water
-for one square of the puzzle that has a ship part (item) in it.
+Side Effects: This puts the given character (water, a ship part, or
+blank to take away what was given) in the square of the puzzle at the
+given row and column, and keeps the counts of dry squares and ship
+parts of its row and column as read_row would have set them.
 
 */
 
-int pad_square(            /* ARGUMENTS                 */
- char item,                /* ship part in square       */
- int row,                  /* index of row of square    */
- int col,                  /* index of column of square */
- struct bap_world * world) /* puzzle model              */
+int generate_give(         /* ARGUMENTS                          */
+ int row,                  /* row index of square                */
+ int col,                  /* column index of square             */
+ char item,                /* character to give, or blank        */
+ struct bap_world * world) /* puzzle model, set up for a puzzle  */
 {
-  const char * name SET_TO "pad_square";
+  const char * name SET_TO "generate_give";
+  char old;  /* character in square before */
 
-  IFF(make_water(row - 1, col - 1, world));
-  IFF(make_water(row - 1, col + 1, world));
-  IFF(make_water(row + 1, col - 1, world));
-  IFF(make_water(row + 1, col + 1, world));
-  if ((item IS '<') OR
-      (item IS '>') OR
-      (item IS 'v') OR
-      (item IS '^') OR
-      (item IS 'O'))
+  old SET_TO world->squares[row][col];
+  if (old IS '.')
     {
-      if (item ISNT 'v')
-	IFF(make_water(row - 1, col, world));
-      if (item ISNT '<')
-	IFF(make_water(row, col + 1, world));
-      if (item ISNT '^')
-	IFF(make_water(row + 1, col, world));
-      if (item ISNT '>')
-	IFF(make_water(row, col - 1, world));
+      world->rows[row].dry++;
+      world->cols[col].dry++;
+    }
+  else if (old ISNT ' ')
+    {
+      world->rows[row].got--;
+      world->cols[col].got--;
+    }
+  if (item IS '.')
+    {
+      world->rows[row].dry--;
+      world->cols[col].dry--;
     }
+  else if (item ISNT ' ')
+    {
+      world->rows[row].got++;
+      world->cols[col].got++;
+    }
+  IFF(set_square(row, col, item, world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* place_battleships
+/* generate_givens
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. place_ships_row returns ERROR.
-  2. place_ships_col returns ERROR.
-  3. record_progress returns ERROR.
+  1. No answer is found with every square that can tell the answers
+     apart given: "Bug generated puzzle has no answer".
+  2. generate_clear, generate_count, generate_give, or random_index
+     returns ERROR.
 
-Called By:  solve_problem
+Called By:  generate_bap
 
-Side Effects: Parts of battleships assigned to rows and columns are
-placed in the puzzle, to the extent the location can be determined.
+Side Effects: This finds squares of the answer to give in the puzzle,
+so that the puzzle has exactly that one answer, and sets them in the
+world. *givens is set to the number of squares given and *checks to the
+number of times the answers were counted.
+
+It starts with nothing given. While there is a second answer, a square
+in which it differs from the answer being made (there must be one) is
+picked at random and given. Then each given square is taken away in
+turn, in random order, and put back if the puzzle no longer has just
+one answer. So no square given can be taken away.
+
+Notes:
+
+Starting from the whole answer and taking squares away would take a
+check for every square of the grid. Giving only squares that tell two
+answers apart takes a few checks for most puzzles, and since all the
+squares given are tried again, the puzzle made is just as minimal.
 
 */
 
-int place_battleships(     /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int generate_givens(       /* ARGUMENTS                                 */
+ char * solution,          /* answer of puzzle, row by row              */
+ int * order,              /* room for the index of every square        */
+ struct bap_world * work,  /* world to solve copies of puzzle on        */
+ int * givens,             /* number of squares given, set here         */
+ int * checks,             /* number of checks made, set here           */
+ struct bap_world * world) /* puzzle model, set up for puzzle here      */
 {
-  const char * name SET_TO "place_battleships";
+  const char * name SET_TO "generate_givens";
+  int answers;   /* number of answers counted             */
+  int number;    /* number of squares in order            */
+  int squares;   /* number of squares in puzzle           */
+  int pick;      /* index in order of square picked       */
+  int swap;      /* square being moved in order           */
   int row;
   int col;
+  int n;
 
-  world->number_in_rows SET_TO 0;
-  for (row SET_TO 0; row < world->number_rows; row++)
+  squares SET_TO (world->number_rows * world->number_cols);
+  IFF(generate_clear(solution, world));
+  IFF(generate_count(work, &answers, world));
+  for (*checks SET_TO 1; answers > 1; (*checks)++)
     {
-      if (world->rows[row].battleships)
-	IFF(place_ships_row(row, 4, world->rows[row].battleships, world));
+      number SET_TO 0;
+      for (n SET_TO 0; n < squares; n++)
+	{
+	  if (world->job->other[n] ISNT solution[n])
+	    order[number++] SET_TO n;
+	}
+      CHB((number IS 0), "Bug second answer same as first");
+      IFF(random_index(number, &pick, world));
+      n SET_TO order[pick];
+      IFF(generate_give((n / world->number_cols), (n % world->number_cols),
+			solution[n], world));
+      IFF(generate_count(work, &answers, world));
     }
-  world->number_in_cols SET_TO 0;
-  for (col SET_TO 0; col < world->number_cols; col++)
+  CHB((answers IS 0), "Bug generated puzzle has no answer");
+  number SET_TO 0;
+  for (n SET_TO 0; n < squares; n++)
     {
-      if (world->cols[col].battleships)
-	IFF(place_ships_col(col, 4, world->cols[col].battleships, world));
+      if (world->squares[n / world->number_cols][n % world->number_cols] ISNT
+	  ' ')
+	order[number++] SET_TO n;
+    }
+  for (n SET_TO (number - 1); n > 0; n--)
+    {
+      IFF(random_index((n + 1), &pick, world));
+      swap SET_TO order[n];
+      order[n] SET_TO order[pick];
+      order[pick] SET_TO swap;
+    }
+  *givens SET_TO number;
+  for (n SET_TO 0; n < number; n++)
+    {
+      row SET_TO (order[n] / world->number_cols);
+      col SET_TO (order[n] % world->number_cols);
+      IFF(generate_give(row, col, ' ', world));
+      IFF(generate_count(work, &answers, world));
+      (*checks)++;
+      if (answers IS 1)
+	(*givens)--;
+      else
+	IFF(generate_give(row, col, solution[order[n]], world));
     }
-  IFF(record_progress
-      ("place battleships", "mark ship parts and/or water in", world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* place_cruisers
+/* generate_ship
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. place_ships_row returns ERROR.
-  2. place_ships_col returns ERROR.
-  3. record_progress returns ERROR.
-
-Called By:  solve_problem
+  1. generate_fits or random_index returns ERROR.
 
-Side Effects: Parts of cruisers assigned to rows and columns are
-placed in the puzzle, to the extent the location can be determined.
+Called By:  generate_fleet
 
+Side Effects: This counts the places a ship of the given size fits in
+the answer being made (see generate_fits), picks one of them at random,
+and puts the ship there. A submarine is counted once, not once lying
+in a row and once in a column. If the ship fits nowhere, *placed is set
+to 0 and nothing is changed.
 
 */
 
-int place_cruisers(        /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int generate_ship(         /* ARGUMENTS                          */
+ char * solution,          /* answer being made, row by row      */
+ int size,                 /* size of ship                       */
+ int * placed,             /* set to 0 if ship fits nowhere      */
+ struct bap_world * world) /* puzzle model                       */
 {
-  const char * name SET_TO "place_cruisers";
+  const char * name SET_TO "generate_ship";
+  struct guess ship;  /* place picked for ship             */
+  int number;         /* number of places ship fits        */
+  int pick;           /* index of place picked             */
+  int pass;           /* 0 to count places, 1 to pick one  */
+  int fits;
+  int in_row;
   int row;
   int col;
+  int k;
 
-  world->number_in_rows SET_TO 0;
-  for (row SET_TO 0; row < world->number_rows; row++)
+  ship.row SET_TO 0;
+  ship.col SET_TO 0;
+  ship.size SET_TO size;
+  ship.in_row SET_TO 1;
+  pick SET_TO -1;
+  for (pass SET_TO 0; pass < 2; pass++)
     {
-      if (world->rows[row].cruisers)
-	IFF(place_ships_row(row, 3, world->rows[row].cruisers, world));
+      number SET_TO 0;
+      for (in_row SET_TO 1; in_row > ((size IS 1) ? 0 : -1); in_row--)
+	{
+	  for (row SET_TO 0; row < world->number_rows; row++)
+	    {
+	      for (col SET_TO 0; col < world->number_cols; col++)
+		{
+		  IFF(generate_fits(solution, row, col, size, in_row, &fits,
+				    world));
+		  if (fits AND (number IS pick))
+		    {
+		      ship.row SET_TO row;
+		      ship.col SET_TO col;
+		      ship.in_row SET_TO in_row;
+		    }
+		  if (fits)
+		    number++;
+		}
+	    }
+	}
+      if ((pass IS 0) AND (number > 0))
+	IFF(random_index(number, &pick, world));
     }
-  world->number_in_cols SET_TO 0;
-  for (col SET_TO 0; col < world->number_cols; col++)
+  if (pick IS -1)
+    *placed SET_TO 0;
+  else
     {
-      if (world->cols[col].cruisers)
-	IFF(place_ships_col(col, 3, world->cols[col].cruisers, world));
+      for (k SET_TO 0; k < size; k++)
+	{
+	  row SET_TO (ship.in_row ? ship.row : (ship.row + k));
+	  col SET_TO (ship.in_row ? (ship.col + k) : ship.col);
+	  solution[(row * world->number_cols) + col] SET_TO
+	    dlx_part(&ship, k);
+	}
     }
-  IFF(record_progress
-      ("place cruisers", "mark ship parts and/or water in", world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* place_destroyers
+/* hash_squares
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. place_ships_row returns ERROR.
-  2. place_ships_col returns ERROR.
-  3. record_progress returns ERROR.
+Returned Value: int (OK)
 
-Called By:  solve_problem
+Called By:
+  main
+  solve_job
+  try_guessing
 
-Side Effects: Parts of destroyers assigned to rows and columns are
-placed in the puzzle, to the extent the location can be determined.
+Side Effects: This sets world->hash to the Zobrist hash of the squares,
+which is the exclusive or of the keys of the characters in all the
+squares (see zobrist_key). After this, set_square keeps world->hash up
+to date.
 
 */
 
-int place_destroyers(      /* ARGUMENTS    */
+int hash_squares(          /* ARGUMENTS    */
  struct bap_world * world) /* puzzle model */
 {
-  const char * name SET_TO "place_destroyers";
+  const char * name SET_TO "hash_squares";
   int row;
   int col;
+  unsigned long long key; /* key of character in one square */
 
-  world->number_in_rows SET_TO 0;
+  world->hash SET_TO 0;
   for (row SET_TO 0; row < world->number_rows; row++)
     {
-      if (world->rows[row].destroyers)
-	IFF(place_ships_row(row, 2, world->rows[row].destroyers, world));
-    }
-  world->number_in_cols SET_TO 0;
-  for (col SET_TO 0; col < world->number_cols; col++)
-    {
-      if (world->cols[col].destroyers)
-	IFF(place_ships_col(col, 2, world->cols[col].destroyers, world));
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  IFF(zobrist_key(row, col, world->squares[row][col], &key));
+	  world->hash SET_TO (world->hash ^ key);
+	}
     }
-  IFF(record_progress("place destroyers", "ship parts and/or water in", world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* place_ships_col
+/* init_solution
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. find_min_starts_col returns ERROR.
-  2. find_max_starts_col returns ERROR.
-  3. enx_square returns ERROR.
-  4. place_ships_col_water returns ERROR.
+  1. extend_ends returns ERROR.
+  2. pad_bap returns ERROR.
 
 Called By:
-  place_battleships
-  place_cruisers
-  place_destroyers
+  generate_count
+  main
+  solve_job
+  solve_request
+  start_session
 
-Side Effects: See discussion of place_ships_row.
+Side Effects: Ship ends given in the puzzle statement are extended, and
+water is marked around any given ship parts.
+
+Notes:
+
+Extending ends constructs ship, so it is done only by the constructive
+strategy. Padding with water is done by every strategy but pure search,
+which makes no water.
 
 */
 
-int place_ships_col(       /* ARGUMENTS                                     */
- int col,                  /* index of column being processed               */
- int size,                 /* size of ship                                  */
- int assigned,             /* number ships of given size assigned to column */
- struct bap_world * world) /* puzzle model                                  */
+int init_solution(         /* ARGUMENTS     */
+ struct bap_world * world) /* puzzle model  */
 {
-  const char * name SET_TO "place_ships_col";
-  int n;
-  int k;
-  int max_starts[MAX_NUMBER_ROWS]; /* array with minimum starting positions */
-  int min_starts[MAX_NUMBER_ROWS]; /* array with maximum starting positions */
-  int placed;
+  const char * name SET_TO "init_solution";
 
-  IFF(find_min_starts_col(col, size, assigned, min_starts, world));
-  IFF(find_max_starts_col(col, size, assigned, max_starts, world));
-  placed SET_TO 0;
-  for (n SET_TO 0; n < assigned; n++)
-    {
-      for (k SET_TO min_starts[n]; k < (min_starts[n] + size); k++)
-	{
-	  if ((k >= max_starts[n]) AND (square(k, col, world) IS ' '))
-	    {
-	      IFF(enx_square(k, col, world));
-	      placed SET_TO 1;
-	    }
-	}
-    }
-  IFF(place_ships_col_water
-      (col, size, assigned, min_starts, max_starts, &placed, world));
-  if (placed)
-    world->cols_in[world->number_in_cols++] SET_TO col;
+  if (world->strategy IS STRATEGY_CONSTRUCT)
+    IFF(extend_ends(world));
+  if (world->strategy ISNT STRATEGY_SEARCH_PURE)
+    IFF(pad_bap(world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* place_ships_col_water
+/* init_world
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. The assigned ships of the given length (along with other ship
-     parts in the row) do not fit in the column: "Puzzle has no answer".
-  2. make_water returns ERROR.
+Returned Value: int (OK)
 
-Called By:  place_ships_col
+Called By:
+  bap_open_session
+  bap_solve
+  main
+  serve_request
+  solve_job
 
-Side Effects: This counts the number of squares filled with ship parts
-that cannot be covered by the assigned ships of the given size in the
-given column and adds to it the number of squares that will be used by
-the assigned ships. If the total equals the aim number for the column,
-then the empty squares in the column that cannot be covered by the
-assigned ships must be water, so they are made water. Also, if min_start[n]
-is the same as max_start[n], then there is only one place that ship can
-go, so water is placed at both ends of the ship. If any square is
-made water, *placed is set to 1.
-
-Notes:
-
-placed may already be 1 before this is called. That is OK.
+Side Effects: This sets all ints in the world model to zero and all
+pointers to NULL. The arrays sized by the grid are made and cleared
+later, by make_block, once the size of the grid is known. The times at
+which the rules were last clean are set to -1, so that every rule looks
+at every strip the first time it is run.
 
 */
 
-int place_ships_col_water( /* ARGUMENTS                                     */
- int col,                  /* index of column being processed               */
- int size,                 /* size of ship                                  */
- int assigned,             /* number ships of given size assigned to column */
- int * min_starts,         /* array of minimum starting positions           */
- int * max_starts,         /* array of maximum starting positions           */
- int * placed,             /* set to one if any water placed                */
- struct bap_world * world) /* puzzle model                                  */
+int init_world(            /* ARGUMENTS                     */
+ struct bap_world * world) /* puzzle model, filled in here  */
 {
-  const char * name SET_TO "place_ships_col_water";
-  int row;
-  int n;     /* counter for assigned ships */
-  int total;
+  const char * name SET_TO "init_world";
+  int rule;
 
-  n SET_TO 0;
-  total SET_TO 0;
-  for (row SET_TO 0; row < world->number_rows; )
-    {
-      if ((row < min_starts[n]) OR (row > (max_starts[n] + size - 1)))
-	{
-	  if ((square(row, col, world) ISNT ' ') AND
-	      (square(row, col, world) ISNT '.'))
-	    total++;
-	  row++;
-	}
-      else
-	{
-	  row SET_TO (max_starts[n] + size);
-	  if (n < (assigned - 1))
-	    n++;
-	}
-    }
-  total SET_TO (total + (assigned * size));
-  CHK((total > world->cols[col].aim), "Puzzle has no answer");
-  n SET_TO 0;
-  if (total IS world->cols[col].aim)
-    {
-      for (row SET_TO 0; row < world->number_rows; )
-	{
-	  if ((row < min_starts[n]) OR (row > (max_starts[n] + size - 1)))
-	    {
-	      if (square(row, col, world) IS ' ')
-		{
-		  IFF(make_water(row, col, world));
-		  *placed SET_TO 1;
-		}
-	      row++;
-	    }
-	  else
-	    {
-	      row SET_TO (max_starts[n] + size);
-	      if (n < (assigned - 1))
-		n++;
-	    }
-	}
-    }
-  for (n SET_TO 0; n < assigned; n++)
-    {
-      if (min_starts[n] IS max_starts[n])
-	{
-	  if (square((min_starts[n] - 1), col, world) ISNT '.')
-	    {
-	      IFF(make_water((min_starts[n] - 1), col, world));
-	      *placed SET_TO 1;
-	    }
-	  if (square((min_starts[n] + size), col, world) ISNT '.')
-	    {
-	      IFF(make_water((min_starts[n] + size), col, world));
-	      *placed SET_TO 1;
-	    }
-	}
-    }
+  world->arena SET_TO NULL;
+  world->batch SET_TO 0;
+  world->battleships_ass SET_TO 0;
+  world->battleships_left SET_TO 0;
+  world->bits SET_TO 0;
+  world->block SET_TO NULL;
+  world->block_bytes SET_TO 0;
+  world->branch SET_TO BRANCH_LARGEST;
+  for (rule SET_TO 0; rule < NUMBER_RULES; rule++)
+    world->clean[rule] SET_TO -1;
+  world->clock SET_TO 0;
+  world->cols SET_TO NULL;
+  world->cols_in SET_TO NULL;
+  world->count SET_TO 0;
+  world->cruisers_ass SET_TO 0;
+  world->cruisers_left SET_TO 0;
+  world->depth SET_TO 0;
+  world->destroyers_ass SET_TO 0;
+  world->destroyers_left SET_TO 0;
+  world->engine SET_TO ENGINE_RULES;
+  world->exes SET_TO 0;
+  world->explain SET_TO 1;
+  world->find_all SET_TO 0;
+  world->generate SET_TO 0;
+  world->guesses_tried SET_TO NULL;
+  world->hash SET_TO 0;
+  world->in_place SET_TO 0;
+  world->job SET_TO NULL;
+  world->jobs SET_TO 1;
+  world->locations SET_TO NULL;
+  world->logic SET_TO NULL;
+  world->logic_line SET_TO 0;
+  world->logic_lines SET_TO 0;
+  world->logic_room SET_TO 0;
+  world->logic_strip SET_TO 0;
+  world->logic_strips SET_TO NULL;
+  world->logic_width SET_TO 0;
+  world->max_depth SET_TO 0;
+  world->max_guesses SET_TO 0;
+  world->max_tried SET_TO 0;
+  world->message SET_TO NULL;
+  world->number_cols SET_TO 0;
+  world->number_in_cols SET_TO 0;
+  world->number_guesses_tried SET_TO 0;
+  world->number_rows SET_TO 0;
+  world->number_in_rows SET_TO 0;
+  world->path SET_TO NULL;
+  world->pool SET_TO NULL;
+  world->print_all SET_TO 0;
+  world->profile SET_TO 0;
+  world->progress SET_TO 0;
+  world->replace SET_TO REPLACE_ALWAYS;
+  world->rows SET_TO NULL;
+  world->rows_in SET_TO NULL;
+  world->rules SET_TO ALL_RULES;
+  world->seed SET_TO 1;
+  world->serve SET_TO 0;
+  world->ship_cols SET_TO NULL;
+  world->ship_rows SET_TO NULL;
+  world->slack SET_TO -1;
+  world->squares SET_TO NULL;
+  world->stats SET_TO 0;
+  world->strategy SET_TO STRATEGY_CONSTRUCT;
+  world->submarines_ass_col SET_TO 0;
+  world->submarines_ass_row SET_TO 0;
+  world->submarines_left_col SET_TO 0;
+  world->submarines_left_row SET_TO 0;
+  world->table SET_TO NULL;
+  world->table_megabytes SET_TO 0;
+  world->trace SET_TO NULL;
+  world->trace_mode SET_TO 0;
+  world->trace_name SET_TO NULL;
+  world->trail SET_TO NULL;
+  world->undone SET_TO 0;
+  world->verbose SET_TO 0;
+  world->water_cols SET_TO NULL;
+  world->water_rows SET_TO NULL;
+  world->worker SET_TO 0;
+  world->worklist SET_TO 1;
   return OK;
 }
 
 /*************************************************************************/
 
-/* place_ships_row
+/* insert_guess_col
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. find_min_starts_row returns ERROR.
-  2. find_max_starts_row returns ERROR.
-  3. enx_square returns ERROR.
-  4. place_ships_row_water returns ERROR.
+  1. A row or column is out of bounds: "Bug bad guess location".
+  2. The size of the guess is not 1, 2, 3, or 4:"Bug bad guess size".
+  3. No progress is made when the guess is inserted:
+     "Bug guess changed nothing".
+  4. record_progress returns ERROR.
+  5. insert_guess_square returns ERROR.
 
 Called By:
-  place_battleships
-  place_cruisers
-  place_destroyers
-
-Side Effects: This makes two placements of the ships of the given size
-assigned to a row: as far left as possible, and as far right as
-possible. Blank squares that are covered by the same ship in both
-cases are marked with an X.  Both placements must be legal. In addition,
-this calls place_ships_row_water to mark water in the row.
-
-Notes:
-
-min_starts is an array of the starting positions of assigned (hence
-not located) ships pushed left. max_starts is an array of the starting
-positions of assigned (hence not located) ships pushed right. The
-length of both arrays equals the "assigned" argument.
+  run_task
+  try_guess_in_place
+  try_guessing
 
-max_starts[n] and min_starts[n] refer to the same ship.
+Side Effects: This places a guess in a column of the puzzle.
 
-To be complete, this would construct all possible fillings of the row
-that are legal and include all assigned ships. Then it would
-mark with an X all blank squares that are full in every case.
+This checks that each character under the guess is either blank or is
+already what the guess says it should be.
 
 */
 
-int place_ships_row(       /* ARGUMENTS                                     */
- int row,                  /* index of row being processed                  */
- int size,                 /* size of ship                                  */
- int assigned,             /* number of ships of given size assigned to row */
- struct bap_world * world) /* puzzle model                                  */
+int insert_guess_col(      /* ARGUMENTS            */
+ struct guess * the_guess, /* guess to be inserted */
+ struct bap_world * world) /* puzzle model         */
 {
-  const char * name SET_TO "place_ships_row";
-  int n;
-  int k;
-  int max_starts[MAX_NUMBER_COLS]; /* array with minimum starting positions */
-  int min_starts[MAX_NUMBER_COLS]; /* array with maximum starting positions */
-  int placed;
+  const char * name SET_TO "insert_guess_col";
+  int row;
+  int col;
+  char * action;
 
-  IFF(find_min_starts_row(row, size, assigned, min_starts, world));
-  IFF(find_max_starts_row(row, size, assigned, max_starts, world));
-  placed SET_TO 0;
-  for (n SET_TO 0; n < assigned; n++)
+  row SET_TO the_guess->row;
+  col SET_TO the_guess->col;
+  CHB(((row < 0) OR
+       (row >= world->number_rows) OR
+       (col < 0) OR
+       (col >= world->number_cols)), "Bug bad guess location");
+  if (the_guess->size IS 1)
     {
-      for (k SET_TO min_starts[n]; k < (min_starts[n] + size); k++)
-	{
-	  if ((k >= max_starts[n]) AND (square(row, k, world) IS ' '))
-	    {
-	      IFF(enx_square(row, k, world));
-	      placed SET_TO 1;
-	    }
-	}
+      action SET_TO "submarine is at";
+      IFF(insert_guess_square(row, col, 'O', world));
     }
-  IFF(place_ships_row_water
-      (row, size, assigned, min_starts, max_starts, &placed, world));
-  if (placed)
-    world->rows_in[world->number_in_rows++] SET_TO row;
+  else if (the_guess->size IS 2)
+    {
+      action SET_TO "destroyer is in column at";
+      IFF(insert_guess_square(row, col, '^', world));
+      IFF(insert_guess_square((row + 1), col, 'v', world));
+    }
+  else if (the_guess->size IS 3)
+    {
+      action SET_TO "cruiser is in column at";
+      IFF(insert_guess_square(row, col, '^', world));
+      IFF(insert_guess_square((row + 1), col, '+', world));
+      IFF(insert_guess_square((row + 2), col, 'v', world));
+    }
+  else if (the_guess->size IS 4)
+    {
+      action SET_TO "battleship is in column at";
+      IFF(insert_guess_square(row, col, '^', world));
+      IFF(insert_guess_square((row + 1), col, '+', world));
+      IFF(insert_guess_square((row + 2), col, '+', world));
+      IFF(insert_guess_square((row + 3), col, 'v', world));
+    }
+  else
+    CHB(1, "Bug bad guess size");
+  CHB((world->progress IS 0), "Bug guess changed nothing");
+  world->cols_in[0] SET_TO col;
+  world->number_in_cols SET_TO 1;
+  world->rows_in[0] SET_TO row;
+  world->number_in_rows SET_TO 1;
+  IFF(record_progress("guess", action, world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* place_ships_row_water
+/* insert_guess_row
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. The assigned ships of the given length (along with other ship
-     parts in the row) do not fit in the row: "Puzzle has no answer".
-  2. make_water returns ERROR.
-
-Called By:  place_ships_row
+  1. A row or column is out of bounds: "Bug bad guess location".
+  2. The size of the guess is not 1, 2, 3, or 4:"Bug bad guess size".
+  3. No progress is made when the guess is inserted:
+     "Bug guess changed nothing".
+  4. record_progress returns ERROR.
+  5. insert_guess_square returns ERROR.
 
-Side Effects: This counts the number of squares filled with ship parts
-that cannot be covered by the assigned ships of the given size in the
-given row and adds to it the number of squares that will be used by
-the assigned ships. If the total equals the aim number for the row,
-then the empty squares in the row that cannot be covered by the
-assigned ships must be water, so they are made water. If any square is
-made water, *placed is set to 1.
+Called By:
+  run_task
+  try_guess_in_place
+  try_guessing
 
-Notes:
+Side Effects: This places a guess in a row of the puzzle.
 
-placed may already be 1 before this is called. That is OK.
+This checks that each character under the guess is either blank or is
+already what the guess says it should be.
 
 */
 
-int place_ships_row_water( /* ARGUMENTS                                     */
- int row,                  /* index of row being processed                  */
- int size,                 /* size of ship                                  */
- int assigned,             /* number of ships of given size assigned to row */
- int * min_starts,         /* array of minimum starting positions           */
- int * max_starts,         /* array of maximum starting positions           */
- int * placed,             /* set to one if any water placed                */
- struct bap_world * world) /* puzzle model                                  */
+int insert_guess_row(      /* ARGUMENTS            */
+ struct guess * the_guess, /* guess to be inserted */
+ struct bap_world * world) /* puzzle model         */
 {
-  const char * name SET_TO "place_ships_row_water";
+  const char * name SET_TO "insert_guess_row";
+  int row;
   int col;
-  int n;     /* counter for assigned ships */
-  int total;
+  char * action;
 
-  n SET_TO 0;
-  total SET_TO 0;
-  for (col SET_TO 0; col < world->number_cols; )
+  row SET_TO the_guess->row;
+  col SET_TO the_guess->col;
+  CHB(((row < 0) OR
+       (row >= world->number_rows) OR
+       (col < 0) OR
+       (col >= world->number_cols)), "Bug bad guess location");
+  if (the_guess->size IS 1)
     {
-      if ((col < min_starts[n]) OR (col > (max_starts[n] + size - 1)))
-	{
-	  if ((square(row, col, world) ISNT ' ') AND
-	      (square(row, col, world) ISNT '.'))
-	    total++;
-	  col++;
-	}
-      else
-	{
-	  col SET_TO (max_starts[n] + size);
-	  if (n < (assigned - 1))
-	    n++;
-	}
+      action SET_TO "submarine is at";
+      IFF(insert_guess_square(row, col, 'O', world));
     }
-  total SET_TO (total + (assigned * size));
-  CHK((total > world->rows[row].aim), "Puzzle has no answer");
-  n SET_TO 0;
-  if (total IS world->rows[row].aim)
+  else if (the_guess->size IS 2)
     {
-      for (col SET_TO 0; col < world->number_cols; )
-	{
-	  if ((col < min_starts[n]) OR (col > (max_starts[n] + size - 1)))
-	    {
-	      if (square(row, col, world) IS ' ')
-		{
-		  IFF(make_water(row, col, world));
-		  *placed SET_TO 1;
-		}
-	      col++;
-	    }
-	  else
-	    {
-	      col SET_TO (max_starts[n] + size);
-	      if (n < (assigned - 1))
-		n++;
-	    }
-	}
+      action SET_TO "destroyer is in row at";
+      IFF(insert_guess_square(row, col, '<', world));
+      IFF(insert_guess_square(row, (col + 1), '>', world));
     }
-  for (n SET_TO 0; n < assigned; n++)
+  else if (the_guess->size IS 3)
     {
-      if (min_starts[n] IS max_starts[n])
-	{
-	  if (square(row, (min_starts[n] - 1), world) ISNT '.')
-	    {
-	      IFF(make_water(row, (min_starts[n] - 1), world));
-	      *placed SET_TO 1;
-	    }
-	  if (square(row, (min_starts[n] + size), world) ISNT '.')
-	    {
-	      IFF(make_water(row, (min_starts[n] + size), world));
-	      *placed SET_TO 1;
-	    }
-	}
+      action SET_TO "cruiser is in row at";
+      IFF(insert_guess_square(row, col, '<', world));
+      IFF(insert_guess_square(row, (col + 1), '+', world));
+      IFF(insert_guess_square(row, (col + 2), '>', world));
     }
+  else if (the_guess->size IS 4)
+    {
+      action SET_TO "battleship is in row at";
+      IFF(insert_guess_square(row, col, '<', world));
+      IFF(insert_guess_square(row, (col + 1), '+', world));
+      IFF(insert_guess_square(row, (col + 2), '+', world));
+      IFF(insert_guess_square(row, (col + 3), '>', world));
+    }
+  else
+    CHB(1, "Bug bad guess size");
+  CHB((world->progress IS 0), "Bug guess changed nothing");
+  world->cols_in[0] SET_TO col;
+  world->number_in_cols SET_TO 1;
+  world->rows_in[0] SET_TO row;
+  world->number_in_rows SET_TO 1;
+  IFF(record_progress("guess", action, world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* print_bap
+/* insert_guess_square
 
-Returned Value: int (OK)
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The square to be set is neither blank nor X:
+     "Bug bad character at guess location".
+  2. make_water returns ERROR.
+  3. trail_square or trail_number returns ERROR.
 
 Called By:
-  dex_squares
-  extend_ends
-  pad_bap
-  read_problem
-  record_progress
-  solve_problem
+  insert_guess_col
+  insert_guess_row
+  make_move
 
-Side Effects: This prints the puzzle from the bap_world. The puzzle
-is printed in the same format as required for reading in, except that
-the list of ships and end marker are omitted.
+Side Effects: 
 
 */
 
-int print_bap(             /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int insert_guess_square(   /* ARGUMENTS                     */
+ int row,                  /* row index of square           */
+ int col,                  /* column index of square        */
+ char item1,               /* character to insert in square */
+ struct bap_world * world) /* puzzle model                  */
 {
-  const char * name SET_TO "print_bap";
-  int row;
-  int col;
+  const char * name SET_TO "insert_guess_square";
+  char item2;
 
-  printf("\n ");
-  for (col SET_TO 0; col < world->number_cols; col++)
-    {
-      printf(" -");
-    }
-  printf("\n");
-  for (row SET_TO 0; row < world->number_rows; row++)
+  item2 SET_TO world->squares[row][col];
+  if (item2 IS item1);
+  else if ((item2 IS ' ') OR (item2 IS 'X'))
     {
-      printf(" |");
-      for (col SET_TO 0; col < world->number_cols; col++)
+      IFF(trail_square(row, col, world));
+      IFF(set_square(row, col, item1, world));
+      world->progress SET_TO 1;
+      if (item2 IS 'X')
 	{
-	  printf("%c", world->squares[row][col]);
-	  if (col < (world->number_cols - 1))
-	    printf(" ");
+	  IFF(trail_number(&(world->rows[row].exes), world));
+	  world->rows[row].exes--;
+	  IFF(trail_number(&(world->cols[col].exes), world));
+	  world->cols[col].exes--;
+	  IFF(trail_number(&(world->exes), world));
+	  world->exes--;
 	}
-      printf("|%d\n", world->rows[row].aim);
-    }
-  printf(" ");
-  for (col SET_TO 0; col < world->number_cols; col++)
-    {
-      printf(" -");
-    }
-  printf("\n  ");
-  for (col SET_TO 0; col < world->number_cols; col++)
-    {
-      printf("%d", world->cols[col].aim);
-      if (world->cols[col].aim < 10)
-	printf(" ");
+      else
+	{
+	  IFF(trail_number(&(world->rows[row].got), world));
+	  world->rows[row].got++;
+	  IFF(trail_number(&(world->cols[col].got), world));
+	  world->cols[col].got++;
+	}
+      IFF(make_water(row - 1, col - 1, world));
+      IFF(make_water(row - 1, col + 1, world));
+      IFF(make_water(row + 1, col - 1, world));
+      IFF(make_water(row + 1, col + 1, world));
+      if (item1 IS 'O')
+	{
+	  IFF(make_water(row + 1, col, world));
+	  IFF(make_water(row - 1, col, world));
+	  IFF(make_water(row, col + 1, world));
+	  IFF(make_water(row, col - 1, world));
+	}
+      else if (item1 IS '<')
+	IFF(make_water(row, col - 1, world));
+      else if (item1 IS '^')
+	IFF(make_water(row - 1, col, world));
+      else if (item1 IS '>')
+	IFF(make_water(row, col + 1, world));
+      else if (item1 IS 'v')
+	IFF(make_water(row + 1, col, world));
+      else
+	CHB((item1 ISNT '+'), "Bug bad character to insert");
     }
-  printf("\n");
+  else
+    CHB(1, "Bug bad character at guess location");
   return OK;
 }
 
 /*************************************************************************/
 
-/* read_arguments
+/* legal_col
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. argc is not 4 or 5.
-  2. argv[2] is not "all" or "one.
-  3. argv[3] is not "yes" or "no".
-  4. argc is 5 and argv[4] is not "v".
+  1. legal_col_ships returns ERROR.
+  2. legal_col_across returns ERROR.
+  3. legal_col_beside returns ERROR.
 
-Called By:  main
+Called By:
+  try_full_but_one_col
+  try_full_but_two_col
 
-Side Effects: The values of world->find_all, world->print_all,
-and world->verbose are set.
+Side Effects: *is_legal is set to 1 if the column is legal and to 0 if not.
 
-*/
+Notes:
 
-int read_arguments(        /* ARGUMENTS                             */
- int argc,                 /* one more than the number of arguments */
- char ** argv,             /* function name and arguments           */
- struct bap_world * world) /* puzzle model                          */
-{
-  const char * name SET_TO "read_arguments";
+This checks whether the test column is legal and, if so, whether the
+test column can be inserted into the puzzle without creating an
+illegal condition in either the two columns on either side or any
+crossing row.
 
-  if (((argc IS 4) OR ((argc IS 5) AND (strcmp(argv[4], "v") IS 0))) AND
-      ((strcmp(argv[2], "all") IS 0) OR (strcmp(argv[2], "one") IS 0)) AND
-      ((strcmp(argv[3], "no") IS 0) OR (strcmp(argv[3], "yes") IS 0)))
-    {
-      if (strcmp(argv[2], "all") IS 0)
-	world->find_all SET_TO 1;
-      else
-	world->find_all SET_TO 0;
-      if (strcmp(argv[3], "yes") IS 0)
-	world->print_all SET_TO 1;
-      else
-	world->print_all SET_TO 0;
-      if (argc IS 5)
-	world->verbose SET_TO 1;
-      else
-	world->verbose SET_TO 0;
-    }
-  else
-    {
-      printf("Usage: %s <file name> <all|one> <yes|no> [v]\n", argv[0]);
-      printf("all = find all solutions\n");
-      printf("one = find one solution\n");
-      printf("yes = print puzzle when done and when a rule makes progress\n");
-      printf("no = print puzzle only when done\n");
-      printf("v = verbose (prints more messages)\n");
-      CHB(1, " ");
-    }
-  return OK;
-}
+A column is illegal if any of the following occurs:
 
-/*************************************************************************/
+1. A ship is found that is longer than 4.
 
-/* read_column_numbers
+2. More ships of a given size are needed than are available.
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. The file ends before the line of column numbers:
-     "File ends before line of column numbers".
-  2. The line has bad format: "Bad line of column numbers".
-  3. A column number is greater than the number of places in a column:
-     "COLUMN COUNT TOO BIG.
-  4. The file ends before the blank line: "File ends before lines of ships".
-  5. The blank line is missing: "Blank line missing before ships".
+3. The column on the right or left is left with fewer dry than its aim
+so that it cannot be filled.
 
-Called By:  read_problem
+4. Any crossing row is left with fewer dry than its aim so that
+it cannot be filled.
 
-Side Effects: This reads the row of column numbers and records them in
-world->col_counts.  It also reads the blank line following that row. The
-column numbers line follows the bottom line of dashes.
+5. A crossing row is overfilled. This could happen if try_full_but_one
+previously filled another column of the row.
 
-*/
+6. A ship middle occurs with water on one side and ship part on the other.
 
-int read_column_numbers(   /* ARGUMENTS                 */
- FILE * in_port,           /* port to file to read from */
- char * buffer,            /* buffer to read into       */
- struct bap_world * world) /* puzzle model              */
-{
-  const char * name SET_TO "read_column_numbers";
-  int col;
-  int n;
+The column being tested has been written in the test array, so that
+indexing is easy. It helps to imagine that the test array is written
+vertically, top down.
 
-  CHB((fgets(buffer, TEXT_SIZE, in_port) IS NULL),
-      "File ends before line of column numbers");
-  CHB(((buffer[0] ISNT ' ') OR (buffer[1] ISNT ' ')),
-      "Bad line of column numbers");
-  for (col SET_TO 0; col < world->number_cols; col++)
-    {
-      n SET_TO
-	sscanf((buffer + (2 * col) + 2), "%2d", &(world->cols[col].aim));
-      CHB((n ISNT 1), "Bad line of column numbers");
-      CHB((world->cols[col].aim > world->number_rows), "Column count too big");
-    }
-  CHB((fgets(buffer, TEXT_SIZE, in_port) IS NULL),
-      "File ends before lines of ships");
-  CHB((buffer[0] ISNT '\n'), "Blank line missing before ships");
-  return OK;
-}
-
-/*************************************************************************/
-
-/* read_dashes
-
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. The file ends before the top row of dashes:
-     "File ends before first line of dashes".
-  2. The line of dashes has bad format: "Bad first line of dashes".
-  3. The line of dashes extends to the end of the buffer:
-     "Line of dashes too long".
-  4. There is not at least one dash:
-     "problem does not have at least one column".
-  5. There are more than MAX_NUMBER_COLS columns: "Too many columns".
-
-Called By:  read_problem
-
-Side Effects: This
-1. reads the top row of dashes and saves it in the "dashes" buffer.
-2. sets bap->number_cols and checks that it is at least 1.
-3. sets the row_length at two characters more than the length
-   of the row of dashes. read_rows uses row_length to tell when
-   it has read the bottom row of dashes.
+Y is used to fill test columns so that the squares to be tested are not
+confused with squares previously set to X.
 
-Each dash indicates a column.
+This assumes that all ship parts other than X's and Y's have been
+padded with water, so O^<> should not be encountered while
+reading_ship. The column should have no blanks in it, so a blank should
+never be encountered.
 
 */
 
-int read_dashes(           /* ARGUMENTS                       */
- FILE * in_port,           /* port to file to read from       */
- char * dashes,            /* array into which to copy dashes */
- int * row_length,         /* length of row, set here         */
- struct bap_world * world) /* puzzle model                    */
+int legal_col(             /* ARGUMENTS                        */
+ char * test,              /* column being tested              */
+ int col,                  /* index of the column being tested */
+ int * is_legal,           /* set here, 1=line legal, 0=not    */
+ struct bap_world * world) /* puzzle model                     */
 {
-  const char * name SET_TO "read_dashes";
-  int n;
+  const char * name SET_TO "legal_col";
 
-  CHB((fgets(dashes, TEXT_SIZE, in_port) IS NULL),
-      "File ends before first line of dashes");
-  CHB((dashes[0] ISNT ' '), "Bad first line of dashes");
-  for (n SET_TO 1; ; n SET_TO (n + 2))
-    {
-      CHB((n >= (TEXT_SIZE - 1)), "Line of dashes too long");
-      if (dashes[n] IS '\n')
-	break;
-      CHB(((dashes[n] ISNT ' ') OR (dashes[n + 1] ISNT '-')),
-	  "Bad first line of dashes");
-    }
-  *row_length SET_TO (n + 2);
-  world->number_cols SET_TO ((n - 1) / 2);
-  CHB((world->number_cols < 1), "Problem does not have at least one column");
-  CHB((world->number_cols > MAX_NUMBER_COLS), "Too many columns");
-  if (world->print_all)
-    printf("%d columns\n", world->number_cols);
+  *is_legal SET_TO 1;
+  IFF(legal_col_ships(test, col, is_legal, world));
+  if (*is_legal)
+    IFF(legal_col_beside(test, col, is_legal, world));
+  if (*is_legal)
+    IFF(legal_col_across(test, col, is_legal, world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* read_problem
+/* legal_col_across
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. The named file cannot be opened: "Could not open file".
-  2. The file ends before the first blank line:
-     "File ends before first blank line".
-  3. After read_rows returns, the next line is not a line of dashes identical
-     to the first line of dashes: "Bad row or second line of dashes".
-  4. Any of the following functions returns ERROR:
-     print_bap
-     read_column_numbers
-     read_dashes
-     read_rows
-     read_ships
+Returned Value: int (OK)
 
-Called By:  main
+Called By:
+  legal_col
+  ship_fits_col_row
 
-Side Effects: The puzzle in the file named file_name is read and stored.
+Side Effects: This sets *is_legal to 0 if the column is not legal.
 
 Notes:
 
-The executable compiled from this code is expected to be named bap.
-The executable should have one command argument, the name of a file
-containing the external representation of the problem. The file
-represents an M columns by N rows rectangle to be filled with an
-arbitrary collection of ships of lengths 4, 3, 2, and 1. The file must
-have all of the following in the order given:
-
-1. a blank line (above which everything is read and ignored).
-2. a row with one space followed by alternate spaces and dashes; each dash
-   indicates a column, so the number of dashes is the number of columns,
-   which must be between 1 and 99.
-3. 1 to 99 rows each consisting of two spaces followed by |stuff|, followed
-   by an integer between 0 and the number of columns. The stuff is a
-   mixture of blanks, ship parts and water, with appropriate spacing so
-   water and ship parts occur in the proper column. water is ., ship end
-   is one of v<^>, ship middle is +, submarine is O (capital letter O),
-   ship part of not fully determined type is X (which does not occur
-   in standard battleships).
-4. a row identical to the one described in item 2, above.
-5. a row with two spaces followed by numbers, each of which is either
-   a one-digit number between 0 and 9 followed by a blank or a two-digit
-   number between 10 and 99. The number gives the number of squares to be
-   be filled in the column above it.
-6. a blank line
-7. 1 to four rows of any length starting with two blanks and containing
-   ships. All the ships in a row are the same size. Larger ships are in
-   rows above smaller ships. Ships are length 4, 3, 2, or 1. Two blanks
-   separate ships in a row.
-8. The word "end" on a row by itself. Lines may occur below this but will
-   not be read.
-
-
-Here is a sample file between rows of stars.
-
-****************************************************
-This is a sample problem file.
-
-  - - - - - - - - - -
- |                   |1
- |                   |1
- |                   |2
- |                  O|1
- |                   |3
- |                   |3
- |                   |2
- |                   |6
- |                  O|1
- |                   |0
-  - - - - - - - - - -
-  2 0 2 4 1 3 2 2 0 4
-
-  <++>
-  <+>  <+>
-  <>  <>  <>
-  O  O  O  O
-end
-
-****************************************************
-
-The reading procedure is:
-1. Open the file and check that it opened.
-2. Look for a blank line. Read and ignore everything before the blank line.
-3. Read the first line of dashes. This gives the number of columns.
-4. Read the rows.
-5. Read the second line of dashes.
-6. Read the column numbers.
-7. Read the ships.
-8. Close the file.
+Is_legal should be set to 1 when this is called.
 
-Anything before the first blank line is a header which is intended to
-contain explanatory text, but could be anything.
+Y is used to fill test rows so that the squares to be tested are not
+confused with squares previously set to X.
 
 */
 
-int read_problem(          /* ARGUMENTS                    */
- char * file_name,         /* name of file to read         */
- struct bap_world * world) /* puzzle model, filled in here */
+int legal_col_across(      /* ARGUMENTS                         */
+ char * test,              /* column being tested               */
+ int col,                  /* index of the column being tested  */
+ int * is_legal,           /* set here to 0 if column not legal */
+ struct bap_world * world) /* puzzle model                      */
 {
-  const char * name SET_TO "read_problem";
-  FILE * in_port;
-  char dashes[TEXT_SIZE];
-  char buffer[TEXT_SIZE];
-  int row_length;
+  const char * name SET_TO "legal_col_across";
+  int row;
+  int water;
+  unsigned long long left;   /* blank squares in column to left  */
+  unsigned long long right;  /* blank squares in column to right */
 
-  in_port SET_TO fopen(file_name, "r");
-  CHB((in_port IS NULL), "Could not open file");
-  for (; ; )
+  left SET_TO 0;
+  right SET_TO 0;
+  if (world->bits)
     {
-      CHB((fgets(buffer, TEXT_SIZE, in_port) IS NULL),
-	  "File ends before first blank line");
-      if (buffer[0] IS '\n')
-	break;
+      IFF(blanks_col((col - 1), &left, world));
+      IFF(blanks_col((col + 1), &right, world));
     }
-  IFF(read_dashes(in_port, dashes, &row_length, world));
-  IFF(read_rows(in_port, buffer, row_length, world));
-  CHB((strcmp(dashes, buffer) ISNT 0), "Bad row or second line of dashes");
-  IFF(read_column_numbers(in_port, buffer, world));
-  IFF(read_ships(in_port, buffer, world));
-  world->undone SET_TO (world->number_cols + world->number_rows);
-  fclose(in_port);
-  strcpy(world->logic[world->logic_line++], "read problem");
-  if (world->print_all)
+  for (row SET_TO 0; row < ROWS; row++)
     {
-      IFF(print_bap(world));
-      printf("%s\n\n", world->logic[world->logic_line - 1]);
+      if ((test[row] IS 'Y') AND
+	  (world->rows[row].aim < (world->rows[row].got + 1)))
+	{
+	  *is_legal SET_TO 0;
+	  break;
+	}
+      water SET_TO 0;
+      if ((world->bits ? ((left >> row) & 1) :
+	   (square(row, (col - 1), world) IS ' ')) AND
+	  ((test[row - 1] ISNT '.') OR (test[row + 1] ISNT '.')))
+	water++;
+      if ((world->bits ? ((right >> row) & 1) :
+	   (square(row, (col + 1), world) IS ' ')) AND
+	  ((test[row - 1] ISNT '.') OR (test[row + 1] ISNT '.')))
+	water++;
+      if ((world->rows[row].dry - water) < world->rows[row].aim)
+	{
+	  *is_legal SET_TO 0;
+	  break;
+	}
     }
   return OK;
 }
 
 /*************************************************************************/
 
-/* read_row
+/* legal_col_beside
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. The row does not start with " |": "Bad problem row".
-  2. An illegal character is included in the row: "Bad character".
-  3. The number at the end of the row cannot be read: "Bad problem row".
-  4. The number at the end of the row is larger than the number of
-     places in the row: "Row count too big".
-  5. An X is used: "Cannot handle x yet".
-  6. The number of rows found is greater than MAX_NUMBER_ROWS:
-     "Too many rows".
+Returned Value: int (OK)
 
-Called By:  read_rows
+Called By:
+  legal_col
+  ship_fits_col_row
 
-Side Effects: This
-1. copies the row into world->squares
-2. sets the value of world->rows[row].aim
-3. adds one to world->number_rows.
+Side Effects: See legal_row_beside. This is analogous.
+
+Notes:
+
+*is_legal should be set to 1 when this is called.
 
 */
 
-int read_row(              /* ARGUMENTS                     */
- char * buffer,            /* buffer from which to read row */
- struct bap_world * world) /* puzzle model                  */
+int legal_col_beside(      /* ARGUMENTS                         */
+ char * test,              /* column being tested               */
+ int col,                  /* index of the column being tested  */
+ int * is_legal,           /* set here to 0 if column not legal */
+ struct bap_world * world) /* puzzle model                      */
 {
-  const char * name SET_TO "read_row";
-  int square_count;
-  int col;
-  int n;
-  char c;
+  const char * name SET_TO "legal_col_beside";
+  int row;
+  int water1;
+  int water2;
+  int no_ships;
+  unsigned long long left;   /* blank squares in column to left  */
+  unsigned long long right;  /* blank squares in column to right */
 
-  CHB((world->number_rows IS MAX_NUMBER_ROWS), "Too many rows");
-  world->rows[world->number_rows].dry SET_TO world->number_cols;
-  CHB(((buffer[0] ISNT ' ') OR (buffer[1] ISNT '|')), "Bad problem row");
-  for (col SET_TO 0; col < world->number_cols; col++)
+  left SET_TO 0;
+  right SET_TO 0;
+  if (world->bits)
     {
-      c SET_TO buffer[2 + (2 * col)];
-      CHB(((c ISNT '+') AND
-	   (c ISNT '<') AND
-	   (c ISNT 'v') AND
-	   (c ISNT 'O') AND
-	   (c ISNT '>') AND
-	   (c ISNT '^') AND
-	   (c ISNT '.') AND
-	   (c ISNT ' ') AND
-	   (c ISNT 'X')), "Bad character");
-      CHB((c IS 'X'), "Cannot handle x yet");
-      if (col < (world->number_cols - 1))
-	CHB((buffer[3 + (2 * col)] ISNT ' '), "Bad character");
-      else
-	CHB((buffer[3 + (2 * col)] ISNT '|'), "Bad character");
-      world->squares[world->number_rows][col] SET_TO c;
-      if (c IS '.')
-	{
-	  world->cols[col].dry--;
-	  world->rows[world->number_rows].dry--;
-	}
-      else if (c ISNT ' ')
-	{
-	  world->cols[col].got++;
-	  world->rows[world->number_rows].got++;
-	}
+      IFF(blanks_col((col - 1), &left, world));
+      IFF(blanks_col((col + 1), &right, world));
     }
-  n SET_TO sscanf((buffer + 2 + (2 * col)), "%d \n", &square_count);
-  CHB((n ISNT 1), "Bad problem row");
-  CHB((square_count > world->number_cols), "Row count too big");
-  world->rows[world->number_rows].aim SET_TO square_count;
-  world->number_rows++;
+  no_ships SET_TO
+    ((world->battleships_left IS 0) AND
+     (world->cruisers_left IS 0) AND
+     (world->destroyers_left IS 0));
+  water1 SET_TO 0;
+  water2 SET_TO 0;
+  for (row SET_TO 0; row < ROWS; row++)
+    {
+      if ((world->bits ? ((left >> row) & 1) :
+	   (square(row, (col - 1), world) IS ' ')) AND
+	  ((test[row - 1] ISNT '.') OR
+	   (test[row + 1] ISNT '.') OR
+	   (no_ships AND
+	    (test[row] ISNT '.') AND
+	    (world->rows[row].battleships IS 0) AND
+	    (world->rows[row].cruisers IS 0) AND
+	    (world->rows[row].destroyers IS 0)) OR
+	   ((test[row] IS 'Y') AND
+	    (world->rows[row].aim IS (world->rows[row].got + 1)))))
+	water1++;
+      if ((world->bits ? ((right >> row) & 1) :
+	   (square(row, (col + 1), world) IS ' ')) AND
+	  ((test[row - 1] ISNT '.') OR
+	   (test[row + 1] ISNT '.') OR
+	   (no_ships AND
+	    (test[row] ISNT '.') AND
+	    (world->rows[row].battleships IS 0) AND
+	    (world->rows[row].cruisers IS 0) AND
+	    (world->rows[row].destroyers IS 0)) OR
+	   ((test[row] IS 'Y') AND
+	    (world->rows[row].aim IS (world->rows[row].got + 1)))))
+	water2++;
+    }
+  if ((col ISNT 0) AND
+      ((world->cols[col - 1].dry - water1) < world->cols[col - 1].aim))
+    *is_legal SET_TO 0;
+  if ((col ISNT (COLS - 1)) AND
+      ((world->cols[col + 1].dry - water2) < world->cols[col + 1].aim))
+    *is_legal SET_TO 0;
   return OK;
 }
 
 /*************************************************************************/
 
-/* read_rows
+/* legal_col_ships
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. The file ends while rows are being read: "File ends while reading rows".
-  2. read_row returns ERROR.
+  1. an illegal character is found while reading a ship:
+     "Puzzle has no answer bad ship".
+  2. an illegal character is found while not reading a ship:
+     "Bug_in_solving".
 
-Called By:  read_problem
+Called By:  legal_col
 
-Side Effects: This reads the rows of the problem and builds parts of
-the _world model. In verbose mode, this prints the number of rows.
+Side Effects: This sets is_legal to 0 if any of the following occurs:
+1. A ship is found that is longer than 4.
+2. More ships of a given size are needed than are available.
+3. A ship middle occurs with water on one side and ship part on the other.
 
 Notes:
 
-The row_length is set by read_dashes. When the bottom row of dashes is
-read, the string length is less than row_length, so the "for" loop
-reading rows is exited.
+The column is known to be completely filled, so no spaces should occur.
+
+Ship middle cannot occur on the top or bottom of the puzzle with a
+ship part in the same column of the row below or above it.
+
+is_legal should be set to 1 before this starts, since it only sets
+is_legal to zero for illegal configurations.
+
+At the last "else" in this function (test[row] IS 'v') OR (test[row] IS ' ')
+
+This is currently not testing submarines.
 
 */
 
-int read_rows(             /* ARGUMENTS                 */
- FILE * in_port,           /* port to file to read from */
- char * buffer,            /* buffer to read rows into  */
- int row_length,           /* length of a row           */
- struct bap_world * world) /* puzzle model              */
+int legal_col_ships(       /* ARGUMENTS                         */
+ char * test,              /* column being tested               */
+ int col,                  /* index of the column being tested  */
+ int * is_legal,           /* set here to 0 if not legal        */
+ struct bap_world * world) /* puzzle model                      */
 {
-  const char * name SET_TO "read_rows";
-  int col;
+  const char * name SET_TO "legal_col_ships";
+  int reading_ship; /* 1=have started reading a ship, 0=not */
+  int length;       /* length of ship being read            */
+  int row;
+  int battleships;
+  int cruisers;
+  int destroyers;
+  int submarines;
 
-  for (; ; )
+  battleships SET_TO 0;
+  cruisers SET_TO 0;
+  destroyers SET_TO 0;
+  submarines SET_TO 0;
+  length SET_TO 0;
+  reading_ship SET_TO 0;
+  for (row SET_TO 0; row < ROWS; row++)
     {
-      CHB((fgets(buffer, TEXT_SIZE, in_port) IS NULL),
-	  "File ends while reading rows");
-      if (strlen(buffer) < row_length)
-	break;
-      IFF(read_row(buffer, world));
+      if (reading_ship)
+	{
+	  if ((test[row] IS 'v') OR
+	      (test[row] IS '+') OR
+	      (test[row] IS 'X') OR
+	      (test[row] IS 'Y'))
+	    length++;
+	  else
+	    CHK(1, "Puzzle has no answer bad ship");
+	  if ((row IS (ROWS - 1)) OR (test[row + 1] IS '.'))
+	    {
+	      if ((length > 4) OR (test[row] IS '+'))
+		{
+		  *is_legal SET_TO 0;
+		  break;
+		}
+	      else if (length IS 4)
+		{
+		  if (world->locations[row - 3][col]);
+		  else
+		    battleships++;
+		}
+	      else if (length IS 3)
+		{
+		  if (world->locations[row - 2][col]);
+		  else
+		    cruisers++;
+		}
+	      else if (length IS 2)
+		{
+		  if (world->locations[row - 1][col]);
+		  else
+		    destroyers++;
+		}
+	      reading_ship SET_TO 0;
+	      length SET_TO 0;
+	      row++;
+	    }
+	}
+      else
+	{
+	  if ((test[row] IS 'X') OR (test[row] IS 'Y'))
+	    {
+	      if ((row IS (ROWS - 1)) OR (test[row + 1] IS '.'));
+	      else
+		{
+		  reading_ship SET_TO 1;
+		  length SET_TO 1;
+		}
+	    }
+	  else if (test[row] IS '^')
+	    {
+	      reading_ship SET_TO 1;
+	      length SET_TO 1;
+	    }
+	  else if (test[row] IS '+')
+	    {
+	      if ((row IS (ROWS - 1)) OR (test[row + 1] IS '.'));
+	      else
+		{
+		  *is_legal SET_TO 0;
+		  break;
+		}
+	    }
+	  else if ((test[row] IS '<') OR
+		   (test[row] IS '>') OR
+		   (test[row] IS '.') OR
+		   (test[row] IS 'O'));
+	  else
+	    CHK(1, "Bug in solving");
+	}
     }
-  if (world->print_all)
-    printf("%d rows\n", world->number_rows);
-  for (col SET_TO 0; col < world->number_cols; col++)
-    world->cols[col].dry SET_TO (world->cols[col].dry + world->number_rows);
+  if (battleships > (world->battleships_left + world->cols[col].battleships))
+    *is_legal SET_TO 0;
+  if (cruisers > (world->cruisers_left + world->cols[col].cruisers))
+    *is_legal SET_TO 0;
+  if (destroyers > (world->destroyers_left + world->cols[col].destroyers))
+    *is_legal SET_TO 0;
+  if (submarines > (world->submarines_left_col + world->cols[col].submarines))
+    *is_legal SET_TO 0;
   return OK;
 }
 
 /*************************************************************************/
 
-/* read_ships
+/* legal_row
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. The file ends before the end line is read:
-     "File ends with no end marker".
-  2. The battleships line has bad format: "Bad battleships line".
-  3. The cruisers line has bad format: "Bad cruisers line".
-  4. The destroyers line has bad format: "Bad destroyers line".
-  5. The submarines line has bad format: "Bad submarines line".
-  6. The row count total is not the same as the number of ship parts:
-     "Bad row count total".
-  7. The column count total is not the same as the number of ship parts:
-     "Bad column count total".
+  1. legal_row_ships returns ERROR.
+  2. legal_row_across returns ERROR.
+  3. legal_row_beside returns ERROR.
 
-Called By:  read_problem
+Called By:
+  try_full_but_one_row
+  try_full_but_two_row
 
-Side Effects: This reads zero to four lines of ships, in order
-(battleships, cruisers, destroyers, submarines) and the "end" line. It
-also records the number of each type of ship.
+Side Effects: *is_legal is set to 1 if the row is legal and to 0 if not.
 
-Setting ship numbers to zero should not be necessary, since it is done
-in init_world, but it is done here just to be sure.
+This checks whether the test row is legal and, if so, whether it can
+be inserted into the puzzle without creating an illegal condition in
+either the two rows above and below or any crossing column.
 
-This will report an error if a ships line has bad format in any way,
-such as line spacing being incorrect (including extra spaces or tabs
-after the last ship on the line).
+A row is illegal if any of the following occurs:
 
-In verbose mode, this prints the number of each type of ship.
+1. A ship is found that is longer than 4.
 
-Notes:
+2. More ships of a given size are needed than are available.
 
-The first line after the column numbers must have nothing but a
-newline, and it has been read before this function is called.
-This starts reading on the second line after the column numbers
-and reads through lines representing ships in decreasing size order.
-Then it reads the line "end". There should be no blank lines before
-the "end" line. It does not matter what comes after the "end" line.
+3. The row above or below is left with fewer dry than its aim so that
+it cannot be filled.
 
-This does not signal an error if there are no ships.
+4. Any crossing column is left with fewer dry than its aim so that
+it cannot be filled.
 
-*/
+5. A crossing column is overfilled. This could happen if try_full_but_one
+previously filled another row of the column.
 
-int read_ships(            /* ARGUMENTS                 */
- FILE * in_port,           /* port to file to read from */
- char * buffer,            /* buffer to read ships into */
+6. A ship middle occurs with water on one side and ship part on the other.
+
+Notes:
+
+Y is used to fill test rows so that the squares to be tested are not
+confused with squares previously set to X.
+
+This assumes that all ship parts other than X's and Y's have been
+padded with water, so Ov^< should not be encountered while
+reading_ship. The row should have no blanks in it, so a blank should
+never be encountered.
+
+*/
+
+int legal_row(             /* ARGUMENTS                     */
+ char * test,              /* the row being tested          */
+ int row,                  /* index of the row being tested */
+ int * is_legal,           /* set here, 1=line legal, 0=not */
+ struct bap_world * world) /* puzzle model                  */
+{
+  const char * name SET_TO "legal_row";
+
+  *is_legal SET_TO 1;
+  IFF(legal_row_ships(test, row, is_legal, world));
+  if (*is_legal)
+    IFF(legal_row_beside(test, row, is_legal, world));
+  if (*is_legal)
+    IFF(legal_row_across(test, row, is_legal, world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* legal_row_across
+
+Returned Value: int (OK)
+
+Called By:
+  legal_row
+  ship_fits_row_col
+
+Side Effects: This sets *is_legal to 0 if the row is not legal.
+
+Notes:
+
+Is_legal should be set to 1 when this is called.
+
+Y is used to fill test rows so that the squares to be tested are not
+confused with squares previously set to X.
+
+*/
+
+int legal_row_across(      /* ARGUMENTS                     */
+ char * test,              /* the row being tested          */
+ int row,                  /* index of the row being tested */
+ int * is_legal,           /* set here to 0 if not legal    */
+ struct bap_world * world) /* puzzle model                  */
+{
+  const char * name SET_TO "legal_row_across";
+  int col;
+  int water;
+  unsigned long long above;  /* blank squares in row above */
+  unsigned long long below;  /* blank squares in row below */
+
+  above SET_TO 0;
+  below SET_TO 0;
+  if (world->bits)
+    {
+      IFF(blanks_row((row - 1), &above, world));
+      IFF(blanks_row((row + 1), &below, world));
+    }
+  for (col SET_TO 0; col < COLS; col++)
+    {
+      if ((test[col] IS 'Y') AND
+	  (world->cols[col].aim < (world->cols[col].got + 1)))
+	{
+	  *is_legal SET_TO 0;
+	  break;
+	}
+      water SET_TO 0;
+      if ((world->bits ? ((above >> col) & 1) :
+	   (square((row - 1), col, world) IS ' ')) AND
+	  ((test[col - 1] ISNT '.') OR (test[col + 1] ISNT '.')))
+	water++;
+      if ((world->bits ? ((below >> col) & 1) :
+	   (square((row + 1), col, world) IS ' ')) AND
+	  ((test[col - 1] ISNT '.') OR (test[col + 1] ISNT '.')))
+	water++;
+      if ((world->cols[col].dry - water) < world->cols[col].aim)
+	{
+	  *is_legal SET_TO 0;
+	  break;
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* legal_row_beside
+
+Returned Value: int (OK)
+
+Called By:
+  legal_row
+  ship_fits_row_col
+
+Side Effects:
+
+For the row above the given row, this counts the blank squares that would
+have water in them if the given row were as given. Then it checks that
+the number of now dry squares is less than the aim for the row. If so,
+it sets is_legal to 0. Then it does the same thing for the row below
+the given row.
+
+To see if a blank square in the row above would be water, this checks
+the diagonally adjacent squares in the given row. If either one is
+not water, the blank square being checked must be water. Also, if
+the only remaining ships are submarines, this looks at the square
+directly below the one being checked. If it is not water, the square
+being checked must be water.
+
+Notes:
+
+Is_legal should be set to 1 when this is called.
+
+The test string does not have any spaces in it, so it is not necessary
+to check for them. The test string has extra water at both ends, so it
+is OK to index one space beyond the ends.
+
+This works for the top and bottom rows without any special checking.
+
+*/
+
+int legal_row_beside(      /* ARGUMENTS                     */
+ char * test,              /* the row being tested          */
+ int row,                  /* index of the row being tested */
+ int * is_legal,           /* set here to 0 if not legal    */
+ struct bap_world * world) /* puzzle model                  */
+{
+  const char * name SET_TO "legal_row_beside";
+  int col;
+  int water1;
+  int water2;
+  int no_ships;
+  unsigned long long above;  /* blank squares in row above */
+  unsigned long long below;  /* blank squares in row below */
+
+  above SET_TO 0;
+  below SET_TO 0;
+  if (world->bits)
+    {
+      IFF(blanks_row((row - 1), &above, world));
+      IFF(blanks_row((row + 1), &below, world));
+    }
+  no_ships SET_TO
+    ((world->battleships_left IS 0) AND
+     (world->cruisers_left IS 0) AND
+     (world->destroyers_left IS 0));
+  water1 SET_TO 0;
+  water2 SET_TO 0;
+  for (col SET_TO 0; col < COLS; col++)
+    {
+      if ((world->bits ? ((above >> col) & 1) :
+	   (square((row - 1), col, world) IS ' ')) AND
+	  ((test[col - 1] ISNT '.') OR
+	   (test[col + 1] ISNT '.') OR
+	   (no_ships AND
+	    (test[col] ISNT '.') AND
+	    (world->cols[col].battleships IS 0) AND
+	    (world->cols[col].cruisers IS 0) AND
+	    (world->cols[col].destroyers IS 0)) OR
+	   ((test[col] IS 'Y') AND
+	    (world->cols[col].aim IS (world->cols[col].got + 1)))))
+	water1++;
+      if ((world->bits ? ((below >> col) & 1) :
+	   (square((row + 1), col, world) IS ' ')) AND
+	  ((test[col - 1] ISNT '.') OR
+	   (test[col + 1] ISNT '.') OR
+	   (no_ships AND
+	    (test[col] ISNT '.') AND
+	    (world->cols[col].battleships IS 0) AND
+	    (world->cols[col].cruisers IS 0) AND
+	    (world->cols[col].destroyers IS 0)) OR
+	   ((test[col] IS 'Y') AND
+	    (world->cols[col].aim IS (world->cols[col].got + 1)))))
+	water2++;
+    }
+  if ((row ISNT 0) AND
+      ((world->rows[row - 1].dry - water1) < world->rows[row - 1].aim))
+    *is_legal SET_TO 0;
+  if ((row ISNT (ROWS - 1)) AND
+      ((world->rows[row + 1].dry - water2) < world->rows[row + 1].aim))
+    *is_legal SET_TO 0;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* legal_row_ships
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. an illegal character is found while reading a ship:
+     "Puzzle has no answer bad ship".
+  2. an illegal character is found while not reading a ship:
+     "Bug in solving".
+
+Called By:  legal_row
+
+Side Effects: This sets *is_legal to 0 if any of the following occurs:
+1. A ship is found that is longer than 4.
+2. More ships of a given size are needed than are available.
+3. A ship middle occurs with water on one side and ship part on the other.
+
+Notes:
+
+The row is known to be completely filled, so no spaces should occur.
+
+Ship middle cannot occur on the side of the puzzle with a ship part
+in the row next to it because, since it is on the side of the
+puzzle, the next square in the row will have been marked water
+when extend_middle ran.
+
+At the last "else" in this function (test[col] IS '>') OR (test[col] IS ' ')
+
+This is currently not testing submarines.
+
+*/
+
+int legal_row_ships(       /* ARGUMENTS                     */
+ char * test,              /* the row being tested          */
+ int row,                  /* index of the row being tested */
+ int * is_legal,           /* set here to 0 if not legal    */
+ struct bap_world * world) /* puzzle model                  */
+{
+  const char * name SET_TO "legal_row_ships";
+  int reading_ship; /* 1=have started reading a ship, 0=not */
+  int length;       /* length of ship being read */
+  int col;
+  int battleships;
+  int cruisers;
+  int destroyers;
+  int submarines;
+
+  battleships SET_TO 0;
+  cruisers SET_TO 0;
+  destroyers SET_TO 0;
+  submarines SET_TO 0;
+  length SET_TO 0;
+  reading_ship SET_TO 0;
+  for (col SET_TO 0; col < COLS; col++)
+    {
+      if (reading_ship)
+	{
+	  if ((test[col] IS '>') OR
+	      (test[col] IS '+') OR
+	      (test[col] IS 'X') OR
+	      (test[col] IS 'Y'))
+	    length++;
+	  else
+	    CHK(1, "Puzzle has no answer bad ship");
+	  if ((col IS (COLS - 1)) OR (test[col + 1] IS '.'))
+	    {
+	      if ((length > 4) OR (test[col] IS '+'))
+		{
+		  *is_legal SET_TO 0;
+		  break;
+		}
+	      else if (length IS 4)
+		{
+		  if (world->locations[row][col - 3]);
+		  else
+		    battleships++;
+		}
+	      else if (length IS 3)
+		{
+		  if (world->locations[row][col - 2]);
+		  else
+		    cruisers++;
+		}
+	      else if (length IS 2)
+		{
+		  if (world->locations[row][col - 1]);
+		  else
+		    destroyers++;
+		}
+	      reading_ship SET_TO 0;
+	      length SET_TO 0;
+	      col++;
+	    }
+	}
+      else
+	{
+	  if ((test[col] IS 'X') OR (test[col] IS 'Y'))
+	    {
+	      if ((col IS (COLS - 1)) OR (test[col + 1] IS '.'));
+	      else
+		{
+		  reading_ship SET_TO 1;
+		  length SET_TO 1;
+		}
+	    }
+	  else if (test[col] IS '<')
+	    {
+	      reading_ship SET_TO 1;
+	      length SET_TO 1;
+	    }
+	  else if (test[col] IS '+')
+	    {
+	      if ((col IS (COLS - 1)) OR (test[col + 1] IS '.'));
+	      else
+		{
+		  *is_legal SET_TO 0;
+		  break;
+		}
+	    }
+	  else if ((test[col] IS 'v') OR
+		   (test[col] IS '^') OR
+		   (test[col] IS '.') OR
+		   (test[col] IS 'O'));
+	  else
+	    CHK(1, "Bug in solving");
+	}
+    }
+  if (battleships > (world->battleships_left + world->rows[row].battleships))
+    *is_legal SET_TO 0;
+  if (cruisers > (world->cruisers_left + world->rows[row].cruisers))
+    *is_legal SET_TO 0;
+  if (destroyers > (world->destroyers_left + world->rows[row].destroyers))
+    *is_legal SET_TO 0;
+  if (submarines > (world->submarines_left_row + world->rows[row].submarines))
+    *is_legal SET_TO 0;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* list_batch
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The list is not a directory and cannot be opened as a file:
+     "Could not open list".
+  2. The name of a problem file in a directory is too long:
+     "File name too long".
+  3. add_job returns ERROR.
+  4. No problem files are found: "No problem files in list".
+
+Called By:  run_batch
+
+Side Effects: This makes the list of jobs of the batch, one for each
+problem file. If list_name is a directory, there is a job for each file
+in it whose name ends in ".pro" and does not start with ".", and the
+jobs are put in order of file name (see sort_jobs). Otherwise, list_name is read as a file with the
+name of one problem file on each line, and the jobs are in the order of
+the lines. Blank lines are skipped.
+
+*/
+
+int list_batch(            /* ARGUMENTS                             */
+ char * list_name,         /* directory or file listing problems    */
+ struct batch * the_batch, /* batch of puzzles, jobs added here     */
+ struct bap_world * world) /* puzzle model, for messages            */
+{
+  const char * name SET_TO "list_batch";
+  DIR * directory;         /* directory of problem files, or NULL */
+  struct dirent * entry;   /* entry in directory                  */
+  FILE * in_port;          /* list of problem files               */
+  char buffer[LINE_SIZE];  /* name of problem file                */
+  int length;              /* length of name                      */
+
+  directory SET_TO opendir(list_name);
+  if (directory ISNT NULL)
+    {
+      for (entry SET_TO readdir(directory);
+	   entry ISNT NULL;
+	   entry SET_TO readdir(directory))
+	{
+	  length SET_TO strlen(entry->d_name);
+	  if ((entry->d_name[0] IS '.') OR (length < 5) OR
+	      (strcmp((entry->d_name + length - 4), ".pro") ISNT 0))
+	    continue;
+	  CHB(((strlen(list_name) + length + 2) > LINE_SIZE),
+	      "File name too long");
+	  sprintf(buffer, "%s/%s", list_name, entry->d_name);
+	  IFF(add_job(buffer, the_batch, world));
+	}
+      closedir(directory);
+      sort_jobs(the_batch);
+    }
+  else
+    {
+      in_port SET_TO fopen(list_name, "r");
+      CHB((in_port IS NULL), "Could not open list");
+      for (; fgets(buffer, LINE_SIZE, in_port) ISNT NULL; )
+	{
+	  for (length SET_TO strlen(buffer);
+	       ((length > 0) AND
+		((buffer[length - 1] IS '\n') OR (buffer[length - 1] IS '\r') OR
+		 (buffer[length - 1] IS ' ')));
+	       length--);
+	  buffer[length] SET_TO 0;
+	  if (length IS 0)
+	    continue;
+	  IFF(add_job(buffer, the_batch, world));
+	}
+      fclose(in_port);
+    }
+  CHB((the_batch->number_jobs IS 0), "No problem files in list");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* locate_ships
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. allocate_ship_col returns ERROR.
+  2. allocate_ship_row returns ERROR.
+  3. an illegal ship continuation is found: "Puzzle has no answer bad ship".
+
+Called By:  run_rules
+
+Side Effects: This reads the rows and columns looking for whole ships
+with no X's. Each whole ship is allocated by allocate_ship_row or
+allocate_ship_col.
+
+Submarines are allocated from rows in this function but not from
+columns, since they should be allocated only once.
+
+Only queued rows and columns are read (see QUEUED). A ship is whole
+only once its last square is set, which touches the row and column it
+lies in, so a strip not read has no whole ship that is not already
+allocated.
+
+*/
+
+int locate_ships(          /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "locate_ships";
+  int row;
+  int col;
+  int reading_ship; /* 1=have started reading a ship, 0=not */
+  int length;       /* length of ship being read */
+  char switcher;
+
+  reading_ship SET_TO 0;
+  length SET_TO 0;
+  for (row SET_TO 0; row < world->number_rows; row++)
+    {
+      if ((world->rows[row].done) OR
+	  (NOT (QUEUED(RULE_LOCATE_SHIPS, world->rows[row]))))
+	continue;
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  if (reading_ship)
+	    {
+	      switcher SET_TO square(row, col, world);
+	      if (switcher IS '>')
+		{
+		  IFF(allocate_ship_row
+		      (row, (col - length), length + 1, world));
+		  reading_ship SET_TO 0;
+		}
+	      else if (switcher IS '+')
+		length++;
+	      else if ((switcher IS 'X') OR (switcher IS ' '))
+		reading_ship SET_TO 0;
+	      else
+		CHK(1, "Puzzle has no answer bad ship");
+	    }
+	  else
+	    {
+	      if (square(row, col, world) IS '<')
+		{
+		  reading_ship SET_TO 1;
+		  length SET_TO 1;
+		}
+	      else if (square(row, col, world) IS 'O')
+		IFF(allocate_ship_row(row, col, 1, world));
+	    }
+	}
+    }
+  reading_ship SET_TO 0;
+  length SET_TO 0;
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      if ((world->cols[col].done) OR
+	  (NOT (QUEUED(RULE_LOCATE_SHIPS, world->cols[col]))))
+	continue;
+      for (row SET_TO 0; row < world->number_rows; row++)
+	{
+	  if (reading_ship)
+	    {
+	      switcher SET_TO square(row, col, world);
+	      if (switcher IS 'v')
+		{
+		  IFF(allocate_ship_col
+		      ((row - length), col, length + 1, world));
+		  reading_ship SET_TO 0;
+		}
+	      else if (switcher IS '+')
+		length++;
+	      else if ((switcher IS 'X') OR (switcher IS ' '))
+		reading_ship SET_TO 0;
+	      else
+		CHK(1, "Puzzle has no answer bad ship");
+	    }
+	  else
+	    {
+	      if (square(row, col, world) IS '^')
+		{
+		  reading_ship SET_TO 1;
+		  length SET_TO 1;
+		}
+	    }
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* main
+
+Side Effects: This:
+1. calls read_arguments to read the arguments.
+2. calls init_world to initialize the world puzzle model.
+3. if needed, calls read_problem to read the problem.
+4. calls init_solution to initialize the solving process.
+5. calls solve_problem to solve the problem.
+
+The arena the search takes its guesses and copies of the world from
+is made after init_solution. If searching in place was requested, the
+trail is made and attached to the world then too, so that the changes
+made before any guess is made are never recorded.
+
+If more than one thread was requested, run_pool is called instead of
+solve_problem. It gives each thread its own arena and trail.
+
+Unless it was turned off with --table=0, the transposition table is
+made and the hash of the squares is taken after init_solution. If
+--stats was given, the table statistics are printed at the end.
+
+If --batch was given, run_batch is called after read_arguments instead
+of steps 3 to 5. It takes those steps for each puzzle of the batch.
+
+If --profile was given, the counts made for each rule are printed at
+the end (see report_profile).
+
+If --engine=dlx was given, solve_dlx is called after read_problem
+instead of steps 4 and 5, and none of the above is made.
+
+If answers are being counted ("count" was given) with one thread, the
+problem file is read as text and solved by bap_solve, as a program
+using libbap would, instead of steps 3 to 5; the answers are counted
+by check_answer in the job bap_solve makes. With more threads,
+save_answer counts them in the pool. Nothing is printed but the count
+(see report_count), which is 0 if init_solution finds that there is
+no answer, or the message of bap_solve if solving fails. No table is
+made for bap_solve.
+
+If puzzles are being made ("generate" was given), generate_bap is
+called after read_arguments instead of all the other steps, and if
+puzzles are being served ("serve" was given), serve_bap is.
+
+If --trace was given, make_trace starts the trace after read_problem,
+and finish_trace ends it after solve_problem. If a trace is being
+replayed ("replay" was given), replay_trace reads the problem from the
+trace instead of read_problem, and finish_trace then says whether the
+search was the same. If a trace is being summarized ("summary" was
+given), summarize_trace is called instead of all the other steps.
+
+main is left out when bap is compiled with -DBAP_LIBRARY (for libbap).
+
+Notes:
+
+This main follows the model for all mains for solving squares problems.
+The model always has the five steps listed immediately above.
+
+It is expected that solve_XXX may be called recursively for search,
+but that some initial steps in the solution will need to be done only
+once. The init_solution function takes these steps.
+
+The IFFs (which contain "return" statements) stop execution in case an
+error occurs (as intended) because in a "main" function, "return"
+stops execution.
+
+*/
+
+#ifndef BAP_LIBRARY
+int main(      /* ARGUMENTS                             */
+ int argc,     /* one more than the number of arguments */
+ char ** argv) /* function name and arguments           */
+{
+  const char * name SET_TO "main";
+  int result;   /* value returned by solve_problem, solve_dlx, or bap_solve */
+  struct bap_request request; /* request to count answers, if counting  */
+  struct bap_result counted;  /* answers counted, if counting           */
+  char * text;                /* text of problem file, if counting      */
+  struct bap_world world1;
+  struct bap_world * world;
+
+  world SET_TO &world1;
+  IFF(init_world(world));
+  IFF(read_arguments(argc, argv, world));
+  if (world->generate)
+    IFF(generate_bap(argv[1], world));
+  else if (world->serve)
+    IFF(serve_bap(argv[1], world));
+  else if (world->trace_mode IS TRACE_SUMMARY)
+    IFF(summarize_trace(argv[1], atoi(argv[3]), world));
+  else if (world->batch)
+    {
+      IFF(run_batch(argv[1], world));
+      if (world->profile)
+	IFF(report_profile(world));
+    }
+  else if (world->count AND (world->jobs IS 1))
+    {
+      IFF(read_text(argv[1], &text, world));
+      IFF(fill_request(&request, world));
+      request.text SET_TO text;
+      result SET_TO bap_solve(&request, &counted);
+      bap_free_result(&counted);
+      free(text);
+      if (result ISNT OK)
+	printf("%s\n", counted.message);
+      else
+	IFF(report_count(counted.number_answers, world));
+      if (world->profile)
+	IFF(report_profile(world));
+      IFF(result);
+    }
+  else
+    {
+      if (world->trace_mode IS TRACE_REPLAY)
+	IFF(replay_trace(argv[1], world));
+      else
+	IFF(read_problem(argv[1], world));
+      if (world->trace_mode IS TRACE_WRITE)
+	IFF(make_trace(argv[1], world));
+      if (world->engine IS ENGINE_DLX)
+	result SET_TO solve_dlx(world);
+      else
+	result SET_TO init_solution(world);
+      if ((result ISNT OK) AND world->count)
+	IFF(report_count(0, world));
+      else if (world->engine IS ENGINE_DLX)
+	CHB((result ISNT OK), "Puzzle has no answer");
+      else
+	{
+	  IFF(result);
+	  if (world->table_megabytes > 0)
+	    {
+	      IFF(make_table(world));
+	      IFF(hash_squares(world));
+	    }
+	  if (world->jobs > 1)
+	    {
+	      IFF(run_pool(world));
+	      if (world->stats)
+		IFF(report_table(world));
+	      if (world->profile)
+		IFF(report_profile(world));
+	    }
+	  else
+	    {
+	      IFF(make_arena(&(world->arena), world));
+	      if (world->in_place)
+		IFF(make_trail(&(world->trail), world));
+	      result SET_TO solve_problem(world);
+	      if (world->trace)
+		IFF(finish_trace(world));
+	      if (world->stats)
+		IFF(report_table(world));
+	      if (world->profile)
+		IFF(report_profile(world));
+	      CHB((result ISNT OK), "Puzzle has no answer");
+	    }
+	}
+    }
+  return OK;
+}
+#endif
+
+/*************************************************************************/
+
+/* make_arena
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the arena: "Out of memory".
+
+Called By:
+  generate_bap
+  main
+  run_pool
+  solve_job
+  solve_request
+
+Side Effects: This makes an empty arena with one chunk of ARENA_CHUNK
+bytes and sets the_arena to point to it.
+
+*/
+
+int make_arena(               /* ARGUMENTS                */
+ struct arena ** the_arena,   /* arena made, set here     */
+ struct bap_world * world)    /* puzzle model             */
+{
+  const char * name SET_TO "make_arena";
+  struct arena * arena;  /* arena made here */
+
+  arena SET_TO (struct arena *)malloc(sizeof(struct arena));
+  CHB((arena IS NULL), "Out of memory");
+  arena->first SET_TO (struct chunk *)malloc(sizeof(struct chunk));
+  CHB((arena->first IS NULL), "Out of memory");
+  arena->first->memory SET_TO (char *)malloc(ARENA_CHUNK);
+  CHB((arena->first->memory IS NULL), "Out of memory");
+  arena->first->next SET_TO NULL;
+  arena->first->size SET_TO ARENA_CHUNK;
+  arena->first->used SET_TO 0;
+  arena->chunk SET_TO arena->first;
+  *the_arena SET_TO arena;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_block
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the block: "Out of memory".
+  2. size_block or attach_block returns ERROR.
+
+Called By:
+  generate_bap
+  read_rows
+
+Side Effects: This mallocs a block for the arrays of the world sized by
+a grid of the given size and lays them out in it (see attach_block).
+All strips, counts, masks, and locations are set to zero, and all
+squares are set to blank.
+
+*/
+
+int make_block(            /* ARGUMENTS                    */
+ int number_rows,          /* number of rows in puzzle     */
+ int number_cols,          /* number of columns in puzzle  */
+ struct bap_world * world) /* puzzle model                 */
+{
+  const char * name SET_TO "make_block";
+  long copied;       /* bytes of block copied by copy_bap */
+  long bytes;        /* bytes of block altogether         */
+  char * block;      /* block made here                   */
+  int row;
+  int col;
+
+  IFF(size_block(number_rows, number_cols, &copied, &bytes));
+  block SET_TO (char *)malloc(bytes);
+  CHB((block IS NULL), "Out of memory");
+  IFF(attach_block(block, number_rows, number_cols, world));
+  memset(block, 0, copied);
+  for (row SET_TO 0; row < number_rows; row++)
+    {
+      for (col SET_TO 0; col < number_cols; col++)
+	world->squares[row][col] SET_TO ' ';
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_branch
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the list of guesses tried or the path:
+     "Out of memory".
+  2. make_logic returns ERROR.
+
+Called By:
+  generate_bap
+  read_puzzle
+  run_pool
+
+Side Effects: This mallocs an explanation, a list of guesses tried, and
+a path long enough for any branch of the search (see size_branch), to
+be shared by all the worlds on a branch.
+
+*/
+
+int make_branch(           /* ARGUMENTS                            */
+ struct event ** logic,    /* explanation, set here                */
+ int ** strips,            /* rows and columns listed, set here    */
+ struct guess ** tried,    /* list of guesses tried, set here      */
+ int ** path,              /* path, set here                       */
+ struct bap_world * world) /* puzzle model, already sized          */
+{
+  const char * name SET_TO "make_branch";
+
+  IFF(make_logic(logic, strips, world->logic_lines, world->logic_room,
+		 world));
+  *tried SET_TO (struct guess *)
+    malloc((long)world->max_tried * sizeof(struct guess));
+  CHB((*tried IS NULL), "Out of memory");
+  *path SET_TO (int *)malloc(world->max_depth * sizeof(int));
+  CHB((*path IS NULL), "Out of memory");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_guess_ship_col
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. size is less than 1 or greater than 4: "Bug bad size".
+  2. *number_guesses is too large: "Too many alternatives".
+  3. submarine_covers returns ERROR.
+  4. ship_fits_col_row returns ERROR.
+
+Called By:
+  make_guesses_battleships
+  make_guesses_cruisers
+  make_guesses_destroyers
+  make_guesses_submarines
+
+Side Effects:
+
+The current number of guesses is passed in and reset on the way out.
+This is so the function can add guesses to an existing set of guesses.
+
+Notes:
+
+This stops making guesses when *number_guesses equals limit.
+
+*/
+
+int make_guess_ship_col(   /* ARGUMENTS                                   */
+ int size,                 /* size of ship to make guesses for            */
+ int col,                  /* index of column to make guesses in          */
+ int * number_guesses,     /* number of guesses in set, may be reset here */
+ int limit,                /* the maximum number to put in a set          */
+ struct guess * guesses,   /* the guesses, may be reset here              */
+ struct bap_world * world) /* puzzle model                                */
+{
+  const char * name SET_TO "make_guess_ship_col";
+  int row;
+  int stop;
+  int ys;
+  int is_legal;
+  int n;
+
+  CHB(((size < 1) OR (size > 4)), "Bug bad size");
+  n SET_TO *number_guesses;
+  stop SET_TO (world->number_rows - (size - 1));
+  for (row SET_TO 0; ((n < limit) AND (row < stop)); row++)
+    {
+      if (size IS 1)
+	IFF(submarine_covers(row, col, &is_legal, world));
+      else
+	IFF(ship_fits_col_row(col, row, size, &ys, &is_legal, world));
+      if ((is_legal) AND (NOT (world->locations[row][col])))
+	{
+	  IFF(already_tried(row, col, size, 0, &is_legal, world));
+	  if (is_legal)
+	    {
+	      CHB((n > (world->max_guesses - 2)), "Bug too many alternatives");
+	      guesses[n].size SET_TO size;
+	      guesses[n].row SET_TO row;
+	      guesses[n].col SET_TO col;
+	      guesses[n].in_row SET_TO 0;
+	      n++;
+	    }
+	}
+    }
+  *number_guesses SET_TO n;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_guess_ship_row
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. size is less than 1 or greater than 4: "Bug bad size".
+  2. *number_guesses is too large: "Too many alternatives".
+  3. submarine_covers returns ERROR.
+  4. ship_fits_row_col returns ERROR.
+
+Called By:
+  make_guesses_battleships
+  make_guesses_cruisers
+  make_guesses_destroyers
+  make_guesses_submarines
+
+Side Effects:
+
+The current number of guesses is passed in and reset on the way out.
+This is so the function can add guesses to an existing set of guesses.
+
+Notes:
+
+This stops making guesses when *number_guesses equals limit.
+
+*/
+
+int make_guess_ship_row(   /* ARGUMENTS                                   */
+ int size,                 /* size of ship to make guesses for            */
+ int row,                  /* index of row to make guesses in             */
+ int * number_guesses,     /* number of guesses in set, may be reset here */
+ int limit,                /* the maximum number to put in a set          */
+ struct guess * guesses,   /* the guesses, may be reset here              */
+ struct bap_world * world) /* puzzle model                                */
+{
+  const char * name SET_TO "make_guess_ship_row";
+  int col;
+  int stop;
+  int ys;
+  int is_legal;
+  int n;
+
+  CHB(((size < 1) OR (size > 4)), "Bug bad size");
+  n SET_TO *number_guesses;
+  stop SET_TO (world->number_cols - (size - 1));
+  for (col SET_TO 0; ((n < limit) AND (col < stop)); col++)
+    {
+      if (size IS 1)
+	IFF(submarine_covers(row, col, &is_legal, world));
+      else
+	IFF(ship_fits_row_col(row, col, size, &ys, &is_legal, world));
+      if ((is_legal) AND (NOT (world->locations[row][col])))
+	{
+	  IFF(already_tried(row, col, size, 1, &is_legal, world));
+	  if (is_legal)
+	    {
+	      CHB((n > (world->max_guesses - 2)), "Bug too many alternatives");
+	      guesses[n].size SET_TO size;
+	      guesses[n].row SET_TO row;
+	      guesses[n].col SET_TO col;
+	      guesses[n].in_row SET_TO 1;
+	      n++;
+	    }
+	}
+    }
+  *number_guesses SET_TO n;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_guesses_battleships
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. A battleship is assigned to a strip but no battleship fits in the
+     strip: "Cannot solve puzzle"
+  2. At least one battleship remains to be located but it is not possible
+     to put it anywhere in the puzzle: "Cannot solve puzzle"
+  3. make_guess_ship_row returns ERROR.
+  4. make_guess_ship_col returns ERROR.
+  5. copy_guesses returns ERROR.
+  6. arena_mark, arena_take, or arena_release returns ERROR.
+
+Called By:
+  make_guesses_fewest
+  try_guessing
+
+Side Effects: If any battleship is assigned, this makes a set of
+guesses for each strip to which a battleship is assigned and saves the
+smallest set.  In the case of equally small sets, the first one found
+is saved.  If no battleship is assigned, this makes one set of guesses
+for the whole puzzle. The scratch set of guesses for each strip is
+taken from world->arena and given back before this returns.
+
+Each set of guesses is exhaustive (at least one must be correct), but
+the guesses are not mutually exclusive (which would be nice) unless
+only one battleship has not yet been located.
+
+Notes:
+
+This assumes there may be more than one battleship.
+
+*/
+
+int make_guesses_battleships( /* ARGUMENTS                    */
+ int * number_guesses,        /* number of guesses, set here  */
+ struct guess * guesses,      /* a set of guesses, set here   */
+ struct bap_world * world)    /* puzzle model                 */
+{
+  const char * name SET_TO "make_guesses_battleships";
+  int row;
+  int col;
+  int n;
+  struct guess * guesses2;   /* new set of guesses, in the arena */
+  struct arena_mark mark;    /* arena before guesses2 taken      */
+  void * memory;
+
+  IFF(arena_mark(&mark, world));
+  IFF(arena_take(((long)world->max_guesses * sizeof(struct guess)),
+		 &memory, world));
+  guesses2 SET_TO (struct guess *)memory;
+  if (world->battleships_ass)
+    {
+      *number_guesses SET_TO (world->max_guesses + 1);
+      for (row SET_TO 0; row < world->number_rows; row++)
+	{
+	  if (world->rows[row].battleships)
+	    {
+	      n SET_TO 0;
+	      IFF(make_guess_ship_row
+		  (4, row, &n, *number_guesses, guesses2, world));
+	      CHK((n IS 0), "Cannot solve puzzle");
+	      if (n < *number_guesses)
+		{
+		  IFF(copy_guesses(guesses, guesses2, n));
+		  *number_guesses SET_TO n;
+		}
+	    }
+	}
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  if (world->cols[col].battleships)
+	    {
+	      n SET_TO 0;
+	      IFF(make_guess_ship_col
+		  (4, col, &n, *number_guesses, guesses2, world));
+	      CHK((n IS 0), "Cannot solve puzzle");
+	      if (n < *number_guesses)
+		{
+		  IFF(copy_guesses(guesses, guesses2, n));
+		  *number_guesses SET_TO n;
+		}
+	    }
+	}
+    }
+  else if (world->battleships_left)
+    {
+      *number_guesses SET_TO 0;
+      for (row SET_TO 0; row < world->number_rows; row++)
+	{
+	  IFF(make_guess_ship_row
+	      (4, row, number_guesses, (world->max_guesses + 1), guesses, world));
+	}
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  IFF(make_guess_ship_col
+	      (4, col, number_guesses, (world->max_guesses + 1), guesses, world));
+	}
+      CHK((*number_guesses IS 0), "Cannot solve puzzle");
+    }
+  else
+    CHB(1, "Bug make_guesses_battleships called when no battleships left");
+  IFF(arena_release(&mark, world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_guesses_cruisers
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. A cruiser is assigned to a strip but no cruiser fits in the
+     strip: "Cannot solve puzzle"
+  2. At least one cruiser remains to be located but it is not possible
+     to put it anywhere in the puzzle: "Cannot solve puzzle"
+  3. make_guess_ship_row returns ERROR.
+  4. make_guess_ship_col returns ERROR.
+  5. copy_guesses returns ERROR.
+  6. arena_mark, arena_take, or arena_release returns ERROR.
+
+Called By:
+  make_guesses_fewest
+  try_guessing
+
+Side Effects: See make_guesses_battleships
+
+*/
+
+int make_guesses_cruisers( /* ARGUMENTS                    */
+ int * number_guesses,     /* number of guesses, set here  */
+ struct guess * guesses,   /* a set of guesses, set here   */
+ struct bap_world * world) /* puzzle model                 */
+{
+  const char * name SET_TO "make_guesses_cruisers";
+  int row;
+  int col;
+  int n;
+  struct guess * guesses2;   /* new set of guesses, in the arena */
+  struct arena_mark mark;    /* arena before guesses2 taken      */
+  void * memory;
+
+  IFF(arena_mark(&mark, world));
+  IFF(arena_take(((long)world->max_guesses * sizeof(struct guess)),
+		 &memory, world));
+  guesses2 SET_TO (struct guess *)memory;
+  if (world->cruisers_ass)
+    {
+      *number_guesses SET_TO (world->max_guesses + 1);
+      for (row SET_TO 0; row < world->number_rows; row++)
+	{
+	  if (world->rows[row].cruisers)
+	    {
+	      n SET_TO 0;
+	      IFF(make_guess_ship_row
+		  (3, row, &n, *number_guesses, guesses2, world));
+	      CHK((n IS 0), "Cannot solve puzzle");
+	      if (n < *number_guesses)
+		{
+		  IFF(copy_guesses(guesses, guesses2, n));
+		  *number_guesses SET_TO n;
+		}
+	    }
+	}
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  if (world->cols[col].cruisers)
+	    {
+	      n SET_TO 0;
+	      IFF(make_guess_ship_col
+		  (3, col, &n, *number_guesses, guesses2, world));
+	      CHK((n IS 0), "Cannot solve puzzle");
+	      if (n < *number_guesses)
+		{
+		  IFF(copy_guesses(guesses, guesses2, n));
+		  *number_guesses SET_TO n;
+		}
+	    }
+	}
+    }
+  else if (world->cruisers_left)
+    {
+      *number_guesses SET_TO 0;
+      for (row SET_TO 0; row < world->number_rows; row++)
+	{
+	  IFF(make_guess_ship_row
+	      (3, row, number_guesses, (world->max_guesses + 1), guesses, world));
+	}
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  IFF(make_guess_ship_col
+	      (3, col, number_guesses, (world->max_guesses + 1), guesses, world));
+	}
+      CHK((*number_guesses IS 0), "Cannot solve puzzle");
+    }
+  else
+    CHB(1, "Bug make_guesses_cruisers called when no cruisers left");
+  IFF(arena_release(&mark, world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_guesses_destroyers
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. A destroyer is assigned to a strip but no destroyer fits in the
+     strip: "Cannot solve puzzle".
+  2. At least one destroyer remains to be located but it is not possible
+     to put it anywhere in the puzzle: "Cannot solve puzzle".
+  3. make_guess_ship_row returns ERROR.
+  4. make_guess_ship_col returns ERROR.
+  5. copy_guesses returns ERROR.
+  6. arena_mark, arena_take, or arena_release returns ERROR.
+
+Called By:
+  make_guesses_fewest
+  try_guessing
+
+Side Effects: See make_guesses_battleships
+
+*/
+
+int make_guesses_destroyers( /* ARGUMENTS                    */
+ int * number_guesses,       /* number of guesses, set here  */
+ struct guess * guesses,     /* a set of guesses, set here   */
+ struct bap_world * world)   /* puzzle model                 */
+{
+  const char * name SET_TO "make_guesses_destroyers";
+  int row;
+  int col;
+  int n;
+  struct guess * guesses2;   /* new set of guesses, in the arena */
+  struct arena_mark mark;    /* arena before guesses2 taken      */
+  void * memory;
+
+  IFF(arena_mark(&mark, world));
+  IFF(arena_take(((long)world->max_guesses * sizeof(struct guess)),
+		 &memory, world));
+  guesses2 SET_TO (struct guess *)memory;
+  if (world->destroyers_ass)
+    {
+      *number_guesses SET_TO (world->max_guesses + 1);
+      for (row SET_TO 0; row < world->number_rows; row++)
+	{
+	  if (world->rows[row].destroyers)
+	    {
+	      n SET_TO 0;
+	      IFF(make_guess_ship_row
+		  (2, row, &n, *number_guesses, guesses2, world));
+	      CHK((n IS 0), "Cannot solve puzzle");
+	      if (n < *number_guesses)
+		{
+		  IFF(copy_guesses(guesses, guesses2, n));
+		  *number_guesses SET_TO n;
+		}
+	    }
+	}
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  if (world->cols[col].destroyers)
+	    {
+	      n SET_TO 0;
+	      IFF(make_guess_ship_col
+		  (2, col, &n, *number_guesses, guesses2, world));
+	      CHK((n IS 0), "Cannot solve puzzle");
+	      if (n < *number_guesses)
+		{
+		  IFF(copy_guesses(guesses, guesses2, n));
+		  *number_guesses SET_TO n;
+		}
+	    }
+	}
+    }
+  else if (world->destroyers_left)
+    {
+      *number_guesses SET_TO 0;
+      for (row SET_TO 0; row < world->number_rows; row++)
+	{
+	  IFF(make_guess_ship_row
+	      (2, row, number_guesses, (world->max_guesses + 1), guesses, world));
+	}
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  IFF(make_guess_ship_col
+	      (2, col, number_guesses, (world->max_guesses + 1), guesses, world));
+	}
+      CHK((*number_guesses IS 0), "Cannot solve puzzle");
+    }
+  else
+    CHB(1, "Bug make_guesses_destroyers called when no destroyers left");
+  IFF(arena_release(&mark, world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_guesses_fewest
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. make_guesses_battleships, make_guesses_cruisers,
+     make_guesses_destroyers, or make_guesses_submarines returns ERROR
+     (which it does when some ship cannot be put anywhere).
+  2. copy_guesses returns ERROR.
+  3. arena_mark, arena_take, or arena_release returns ERROR.
+
+Called By:  try_guessing
+
+Side Effects: This makes the set of guesses for each type of ship that
+remains to be located and saves the smallest set. In the case of
+equally small sets, the set of the larger ship is saved, so that the
+order of world->branch IS BRANCH_LARGEST breaks ties. The scratch set
+of guesses is taken from world->arena and given back before this
+returns.
+
+Notes:
+
+Every set is exhaustive, since each ship that remains must be in one of
+the places of its set, so the smallest set is too. It is the branch
+point with the fewest ways to go, so a wrong guess near the top of the
+search, which costs the most, is less likely. Making the sets for every
+type of ship costs more than making one, but a type with no place left
+is found here, before any guess is tried.
+
+This stops looking once it has a set of one guess, since no set is
+smaller.
+
+*/
+
+int make_guesses_fewest(   /* ARGUMENTS                    */
+ int * number_guesses,     /* number of guesses, set here  */
+ struct guess * guesses,   /* a set of guesses, set here   */
+ struct bap_world * world) /* puzzle model                 */
+{
+  const char * name SET_TO "make_guesses_fewest";
+  int size;
+  int n;
+  struct guess * guesses2;   /* set of guesses for one size, in arena */
+  struct arena_mark mark;    /* arena before guesses2 taken           */
+  void * memory;
+
+  IFF(arena_mark(&mark, world));
+  IFF(arena_take(((long)world->max_guesses * sizeof(struct guess)),
+		 &memory, world));
+  guesses2 SET_TO (struct guess *)memory;
+  *number_guesses SET_TO (world->max_guesses + 1);
+  for (size SET_TO 4; ((size > 0) AND (*number_guesses > 1)); size--)
+    {
+      n SET_TO 0;
+      if ((size IS 4) AND (world->battleships_left OR world->battleships_ass))
+	IFF(make_guesses_battleships(&n, guesses2, world));
+      else if ((size IS 3) AND
+	       (world->cruisers_left OR world->cruisers_ass))
+	IFF(make_guesses_cruisers(&n, guesses2, world));
+      else if ((size IS 2) AND
+	       (world->destroyers_left OR world->destroyers_ass))
+	IFF(make_guesses_destroyers(&n, guesses2, world));
+      else if ((size IS 1) AND
+	       (world->submarines_left_row OR world->submarines_ass_row OR
+		world->submarines_left_col OR world->submarines_ass_col))
+	IFF(make_guesses_submarines(&n, guesses2, world));
+      else
+	continue;
+      if (n < *number_guesses)
+	{
+	  IFF(copy_guesses(guesses, guesses2, n));
+	  *number_guesses SET_TO n;
+	}
+    }
+  CHB((*number_guesses > world->max_guesses), "Bug in try_guessing");
+  IFF(arena_release(&mark, world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_guesses_submarines
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. A submarine is assigned to a strip but no submarine fits in the
+     strip: "Cannot solve puzzle".
+  2. make_guess_ship_row returns ERROR.
+  3. make_guess_ship_col returns ERROR.
+  4. copy_guesses returns ERROR.
+  5. arena_mark, arena_take, or arena_release returns ERROR.
+
+Called By:
+  make_guesses_fewest
+  try_guessing
+
+Side Effects: See make_guesses_battleships
+
+*/
+
+int make_guesses_submarines( /* ARGUMENTS                    */
+ int * number_guesses,       /* number of guesses, set here  */
+ struct guess * guesses,     /* a set of guesses, set here   */
+ struct bap_world * world)   /* puzzle model                 */
+{
+  const char * name SET_TO "make_guesses_submarines";
+  int row;
+  int col;
+  int n;
+  struct guess * guesses2;   /* new set of guesses, in the arena */
+  struct arena_mark mark;    /* arena before guesses2 taken      */
+  void * memory;
+
+  IFF(arena_mark(&mark, world));
+  IFF(arena_take(((long)world->max_guesses * sizeof(struct guess)),
+		 &memory, world));
+  guesses2 SET_TO (struct guess *)memory;
+  if (world->submarines_ass_row OR world->submarines_ass_col)
+    {
+      *number_guesses SET_TO (world->max_guesses + 1);
+      if (world->submarines_ass_row)
+	{
+	  for (row SET_TO 0; row < world->number_rows; row++)
+	    {
+	      if (world->rows[row].submarines)
+		{
+		  n SET_TO 0;
+		  IFF(make_guess_ship_row
+		      (1, row, &n, *number_guesses, guesses2, world));
+		  CHK((n IS 0), "Cannot solve puzzle");
+		  if (n < *number_guesses)
+		    {
+		      IFF(copy_guesses(guesses, guesses2, n));
+		      *number_guesses SET_TO n;
+		    }
+		}
+	    }
+	}
+      if (world->submarines_ass_col)
+	{
+	  for (col SET_TO 0; col < world->number_cols; col++)
+	    {
+	      if (world->cols[col].submarines)
+		{
+		  n SET_TO 0;
+		  IFF(make_guess_ship_col
+		      (1, col, &n, *number_guesses, guesses2, world));
+		  CHK((n IS 0), "Cannot solve puzzle");
+		  if (n < *number_guesses)
+		    {
+		      IFF(copy_guesses(guesses, guesses2, n));
+		      *number_guesses SET_TO n;
+		    }
+		}
+	    }
+	}
+    }
+  else if (world->submarines_left_row)
+    {
+      *number_guesses SET_TO 0;
+      for (row SET_TO 0; row < world->number_rows; row++)
+	{
+	  IFF(make_guess_ship_row
+	      (1, row, number_guesses, (world->max_guesses + 1), guesses, world));
+	}
+      CHK((*number_guesses IS 0), "Cannot solve puzzle");
+    }
+  else if (world->submarines_left_col)
+    {
+      *number_guesses SET_TO 0;
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  IFF(make_guess_ship_col
+	      (1, col, number_guesses, (world->max_guesses + 1), guesses, world));
+	}
+      CHK((*number_guesses IS 0), "Cannot solve puzzle");
+    }
+  else
+    CHB(1, "Bug make_guesses_submarines called when no submarines left");
+  IFF(arena_release(&mark, world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_logic
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the explanation: "Out of memory".
+
+Called By:
+  clone_bap
+  make_branch
+
+Side Effects: This mallocs an explanation with room for the given
+number of lines (events) and the given number of rows and columns
+listed by them. The rows and columns follow the events in one piece of
+memory, so freeing the events frees both.
+
+*/
+
+int make_logic(            /* ARGUMENTS                            */
+ struct event ** logic,    /* explanation, set here                */
+ int ** strips,            /* rows and columns listed, set here    */
+ int number_lines,         /* number of lines to make room for     */
+ int number_strips,        /* number of strips to make room for    */
+ struct bap_world * world) /* puzzle model, already sized          */
+{
+  const char * name SET_TO "make_logic";
+  struct event * events; /* memory holding events and strips */
+
+  events SET_TO (struct event *)
+    malloc(((long)number_lines * sizeof(struct event)) +
+	   ((long)number_strips * sizeof(int)));
+  CHB((events IS NULL), "Out of memory");
+  *logic SET_TO events;
+  *strips SET_TO (int *)(events + number_lines);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_move
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The row or column is out of bounds, or the character is not one
+     of ".<>^v+OX": "Bad move".
+  2. The square is already set (a ship part may be put only in a
+     blank or an X, and water or an X only in a blank):
+     "Square already set".
+  3. enx_square, insert_guess_square, or make_water returns ERROR (also
+     when the move leaves the puzzle with no answer).
+
+Called By:
+  play_move
+  retract_move
+
+Side Effects: This puts the given character in the square at the given
+row and column, as the solver would: water with make_water, an X with
+enx_square, and a ship part with insert_guess_square, so the counts of
+the strips, the water around the square, and the trail are kept up. A
+ship end with a blank by its open end is extended with an X, as
+extend_ends does.
+
+Notes:
+
+The rules take it that no ship end has a blank by its open end (see
+extend_ends). Without the X, try_full_but_one, for one, may find that
+a puzzle with an answer has none.
+
+*/
+
+int make_move(             /* ARGUMENTS                     */
+ int row,                  /* row index of square           */
+ int col,                  /* column index of square        */
+ char item,                /* character to put in square    */
+ struct bap_world * world) /* puzzle model                  */
+{
+  const char * name SET_TO "make_move";
+  char item2;              /* character in square now       */
+
+  CHB(((row < 0) OR (row >= world->number_rows) OR
+       (col < 0) OR (col >= world->number_cols) OR
+       (item IS 0) OR (strchr(".<>^v+OX", item) IS NULL)), "Bad move");
+  item2 SET_TO world->squares[row][col];
+  world->number_in_cols SET_TO 0;
+  world->number_in_rows SET_TO 0;
+  world->progress SET_TO 0;
+  if (item IS '.')
+    {
+      CHB((item2 ISNT ' '), "Square already set");
+      IFF(make_water(row, col, world));
+    }
+  else if (item IS 'X')
+    {
+      CHB((item2 ISNT ' '), "Square already set");
+      IFF(enx_square(row, col, world));
+    }
+  else
+    {
+      CHB(((item2 ISNT ' ') AND (item2 ISNT 'X')), "Square already set");
+      IFF(insert_guess_square(row, col, item, world));
+      if ((item IS '<') AND (square(row, col + 1, world) IS ' '))
+	IFF(enx_square(row, col + 1, world));
+      else if ((item IS '>') AND (square(row, col - 1, world) IS ' '))
+	IFF(enx_square(row, col - 1, world));
+      else if ((item IS 'v') AND (square(row - 1, col, world) IS ' '))
+	IFF(enx_square(row - 1, col, world));
+      else if ((item IS '^') AND (square(row + 1, col, world) IS ' '))
+	IFF(enx_square(row + 1, col, world));
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_table
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the table: "Out of memory".
+
+Called By:
+  main
+  run_batch
+
+Side Effects: This makes an empty transposition table with as many
+slots as will fit in world->table_megabytes, rounded down to a power of
+2, and sets world->table to point to it. The table is marked shared if
+more than one thread will use it, which is so whenever world->jobs is
+more than 1, both for the threads of one puzzle (see run_pool) and for
+the threads of a batch (see run_batch).
+
+*/
+
+int make_table(            /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "make_table";
+  long long bytes;        /* most memory the slots may use */
+  long long number;       /* number of slots               */
+  struct table * table;   /* table made here               */
+
+  bytes SET_TO ((long long)world->table_megabytes * 1048576);
+  for (number SET_TO 1;
+       ((2 * number * (long long)sizeof(struct entry)) <= bytes);
+       number SET_TO (2 * number));
+  table SET_TO (struct table *)malloc(sizeof(struct table));
+  CHB((table IS NULL), "Out of memory");
+  table->entries SET_TO
+    (struct entry *)calloc((size_t)number, sizeof(struct entry));
+  CHB((table->entries IS NULL), "Out of memory");
+  table->hits SET_TO 0;
+  pthread_mutex_init(&(table->lock), NULL);
+  table->mask SET_TO (unsigned long long)(number - 1);
+  table->number_entries SET_TO number;
+  table->probes SET_TO 0;
+  table->replace SET_TO world->replace;
+  table->replaced SET_TO 0;
+  table->shared SET_TO (world->jobs > 1);
+  table->stores SET_TO 0;
+  world->table SET_TO table;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_trace
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. read_text returns ERROR.
+  2. The trace file cannot be opened: "Could not open trace".
+  3. There is no memory for the trace: "Out of memory".
+  4. The head of the trace cannot be written: "Could not write trace".
+
+Called By:  main
+
+Side Effects: This makes world->trace and opens the file named by
+world->trace_name for it, and writes the head of the trace, giving the
+options of the world that decide the search, and then the text of the
+problem file, so that the trace alone is enough to replay the search
+(see replay_trace). trace_guess writes the records after them.
+
+*/
+
+int make_trace(            /* ARGUMENTS                   */
+ char * file_name,         /* name of problem file traced */
+ struct bap_world * world) /* puzzle model                */
+{
+  const char * name SET_TO "make_trace";
+  struct trace * trace;    /* trace made here                  */
+  FILE * port;             /* port to trace file               */
+  struct trace_head head;  /* head written                     */
+  char * text;             /* text of problem file             */
+  int written;             /* set to 1 if head and text written */
+
+  IFF(read_text(file_name, &text, world));
+  port SET_TO fopen(world->trace_name, "wb");
+  if (port IS NULL)
+    free(text);
+  CHB((port IS NULL), "Could not open trace");
+  trace SET_TO (struct trace *)malloc(sizeof(struct trace));
+  if (trace IS NULL)
+    {
+      free(text);
+      fclose(port);
+    }
+  CHB((trace IS NULL), "Out of memory");
+  trace->differ SET_TO 0;
+  trace->nodes SET_TO 0;
+  trace->number_records SET_TO 0;
+  trace->port SET_TO port;
+  trace->replay SET_TO 0;
+  world->trace SET_TO trace;
+  memcpy(head.magic, TRACE_MAGIC, sizeof(head.magic));
+  head.bits SET_TO world->bits;
+  head.branch SET_TO world->branch;
+  head.explain SET_TO world->explain;
+  head.find_all SET_TO world->find_all;
+  head.in_place SET_TO world->in_place;
+  head.replace SET_TO world->replace;
+  head.rules SET_TO world->rules;
+  head.strategy SET_TO world->strategy;
+  head.table_megabytes SET_TO world->table_megabytes;
+  head.text_length SET_TO (int)strlen(text);
+  head.worklist SET_TO world->worklist;
+  written SET_TO
+    ((fwrite(&head, sizeof(struct trace_head), 1, trace->port) IS 1) AND
+     (fwrite(text, 1, head.text_length, trace->port) IS
+      (size_t)head.text_length));
+  free(text);
+  CHB((written IS 0), "Could not write trace");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_trail
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the trail: "Out of memory".
+
+Called By:
+  generate_bap
+  main
+  run_pool
+  solve_job
+  solve_request
+  start_session
+
+Side Effects: This makes an empty trail long enough for any branch of
+the search and sets the_trail to point to it. If the_trail already
+points to a trail (one kept by a server from the last puzzle it
+solved), that trail is emptied and kept if it is long enough, and
+freed otherwise.
+
+Notes:
+
+A square changes at most twice on any branch (blank to X, X to a known
+part), and each change records at most six entries on the trail, with
+a few more for the counters of the ships. So 20 entries for each square
+is ample.
+
+*/
+
+int make_trail(            /* ARGUMENTS                */
+ struct trail ** the_trail, /* trail made, set here    */
+ struct bap_world * world) /* puzzle model             */
+{
+  const char * name SET_TO "make_trail";
+  struct trail * trail;    /* trail made or kept here          */
+  int size;                /* number of changes trail must hold */
+
+  size SET_TO ((20 * world->number_rows * world->number_cols) + 64);
+  trail SET_TO *the_trail;
+  if ((trail ISNT NULL) AND (trail->size < size))
+    {
+      free(trail->changes);
+      free(trail);
+      trail SET_TO NULL;
+      *the_trail SET_TO NULL;
+    }
+  if (trail IS NULL)
+    {
+      trail SET_TO (struct trail *)malloc(sizeof(struct trail));
+      CHB((trail IS NULL), "Out of memory");
+      trail->size SET_TO size;
+      trail->changes SET_TO (struct change *)
+	malloc((long)trail->size * sizeof(struct change));
+      CHB((trail->changes IS NULL), "Out of memory");
+    }
+  trail->number_changes SET_TO 0;
+  *the_trail SET_TO trail;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_water
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The square at the given row and column is neither blank nor
+     water: "Puzzle has no answer".
+  2. trail_square or trail_number returns ERROR.
+
+Called By:
+  dex_ends_col
+  dex_ends_row
+  enx_square
+  extend_horizontal
+  extend_vertical
+  fill_bap
+  insert_guess_square
+  make_move
+  pad_square
+  place_ships_col_water
+  place_ships_row_water
+  try_cross_col_fill_col
+  try_cross_row_fill_row
+  try_full_but_two_col
+  try_full_but_two_row
+  try_square_blank
+
+Side Effects: If the square in given row and column is blank, this
+sets the square to water, updates dry in the given row and column, and
+sets world->progress to 1.
+
+Notes:
+
+This function may be called with row or col out of bounds. In this
+case, square(row, col, world) will be '.'. Thus the "if" serves to check
+that the square at row,col is both in bounds and blank before it is
+set to '.'.
+
+In a pure search (world->strategy is STRATEGY_SEARCH_PURE), no water is
+made. A blank square is left blank, and only the check that the square
+is not a ship part is made.
+
+*/
+
+int make_water(            /* ARGUMENTS                                  */
+ int row,                  /* index of row of square being made water    */
+ int col,                  /* index of column of square being made water */
+ struct bap_world * world) /* puzzle model                               */
+{
+  const char * name SET_TO "make_water";
+
+  if ((square(row, col, world) IS ' ') AND
+      (world->strategy IS STRATEGY_SEARCH_PURE));
+  else if (square(row, col, world) IS ' ')
+    {
+      IFF(trail_square(row, col, world));
+      IFF(set_square(row, col, '.', world));
+      IFF(trail_number(&(world->cols[col].dry), world));
+      world->cols[col].dry--;
+      IFF(trail_number(&(world->rows[row].dry), world));
+      world->rows[row].dry--;
+      world->progress SET_TO 1;
+    }
+  else
+    CHK((square(row, col, world) ISNT '.'), "Puzzle has no answer");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* mark_dones
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. A strip still has a ship assigned when done: "Bug in assigning ships".
+  2. trail_number returns ERROR.
+
+Called By:  run_rules
+
+Side Effects: For each strip not already marked done in which (1) aim,
+got, and dry are all equal and (2) exes is zero, the strip is marked
+done and world->undone is decreased by one.
+
+Notes: Locate_ships should normally be run before this so that no
+strip which has unlocated ships is marked done.
+
+A pure search makes no water, so dry is not checked when
+world->strategy is STRATEGY_SEARCH_PURE. A strip is then done as soon
+as it has all its ship parts, and its blanks are left until the whole
+puzzle is done (see finish_pure).
+
+Only queued strips are looked at (see QUEUED), since the counts of a
+strip change only when one of its squares is set.
+
+*/
+
+int mark_dones(            /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "mark_dones";
+  int row;
+  int col;
+
+  for (row SET_TO 0; row < world->number_rows; row++)
+    {
+      if ((world->rows[row].done) OR
+	  (NOT (QUEUED(RULE_MARK_DONES, world->rows[row]))));
+      else if ((world->rows[row].aim IS world->rows[row].got) AND
+	       ((world->rows[row].aim IS world->rows[row].dry) OR
+		(world->strategy IS STRATEGY_SEARCH_PURE)) AND
+	       (world->rows[row].exes IS 0))
+	{
+	  IFF(trail_number(&(world->rows[row].done), world));
+	  world->rows[row].done SET_TO 1;
+	  IFF(trail_number(&(world->undone), world));
+	  world->undone--;
+	  CHK(((world->rows[row].battleships) OR
+	       (world->rows[row].cruisers) OR
+	       (world->rows[row].destroyers) OR
+	       (world->rows[row].submarines)), "Bug in assigning ships");
+	}
+    }
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      if ((world->cols[col].done) OR
+	  (NOT (QUEUED(RULE_MARK_DONES, world->cols[col]))));
+      else if ((world->cols[col].aim IS world->cols[col].got) AND
+	       ((world->cols[col].aim IS world->cols[col].dry) OR
+		(world->strategy IS STRATEGY_SEARCH_PURE)) AND
+	       (world->cols[col].exes IS 0))
+	{
+	  IFF(trail_number(&(world->cols[col].done), world));
+	  world->cols[col].done SET_TO 1;
+	  IFF(trail_number(&(world->undone), world));
+	  world->undone--;
+	  CHK(((world->cols[col].battleships) OR
+	       (world->cols[col].cruisers) OR
+	       (world->cols[col].destroyers) OR
+	       (world->cols[col].submarines)), "Bug in assigning ships");
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* measure_slack
+
+Returned Value: int (OK)
+
+Called By:  slack_strips
+
+Side Effects: This sets *slack to a number that is the same for two
+states of the strip if and only if a ship or water placed across the
+strip is legal in both or neither. That depends only on:
+1. how many more ship parts the strip needs (aim - got), counting
+   0 or less, 1, and 2 or more apart,
+2. how many more water squares the strip can take (dry - aim),
+   counting less than 0, 0, 1, and 2 or more apart (at most two water
+   squares are put in a strip by a ship across it), and
+3. whether any battleships, cruisers, or destroyers are assigned to
+   the strip.
+
+*/
+
+int measure_slack(         /* ARGUMENTS        */
+ struct strip * the_strip, /* strip to measure */
+ int * slack)              /* set here         */
+{
+  const char * name SET_TO "measure_slack";
+  int parts;  /* ship parts needed, 0 to 2 */
+  int water;  /* water squares spare, -1 to 2 */
+
+  parts SET_TO (the_strip->aim - the_strip->got);
+  if (parts < 0)
+    parts SET_TO 0;
+  else if (parts > 2)
+    parts SET_TO 2;
+  water SET_TO (the_strip->dry - the_strip->aim);
+  if (water < -1)
+    water SET_TO -1;
+  else if (water > 2)
+    water SET_TO 2;
+  *slack SET_TO
+    ((((parts * 4) + (water + 1)) * 2) +
+     ((the_strip->battleships OR the_strip->cruisers OR
+       the_strip->destroyers) ? 1 : 0));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* pad_bap
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. pad_square returns ERROR.
+  2. record_line returns ERROR.
+
+Called By:  init_solution
+
+Side Effects: This adds any missing water at the adjacent squares sure
+to be water of each square of the puzzle that has a ship part in
+it. If any missing water is added, that fact is reported.
+
+*/
+
+int pad_bap(               /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "pad_bap";
+  int n;
+  int k;
+  char item;
+
+  for (n SET_TO 0; n < world->number_rows; n++)
+    {
+      for (k SET_TO 0; k < world->number_cols; k++)
+	{
+	  item SET_TO world->squares[n][k];
+	  if ((item ISNT ' ') AND (item ISNT '.'))
+	    IFF(pad_square(item, n, k, world));
+	}
+    }
+  if (world->progress)
+    {
+      IFF(record_line("pad given ship parts with water:", world));
+      world->progress SET_TO 0;
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* pad_square
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. make_water returns ERROR.
+
+Called By:  pad_bap
+
+Side Effects:
+
+This adds any missing water at the adjacent squares sure to be water
+for one square of the puzzle that has a ship part (item) in it.
+
+*/
+
+int pad_square(            /* ARGUMENTS                 */
+ char item,                /* ship part in square       */
+ int row,                  /* index of row of square    */
+ int col,                  /* index of column of square */
+ struct bap_world * world) /* puzzle model              */
+{
+  const char * name SET_TO "pad_square";
+
+  IFF(make_water(row - 1, col - 1, world));
+  IFF(make_water(row - 1, col + 1, world));
+  IFF(make_water(row + 1, col - 1, world));
+  IFF(make_water(row + 1, col + 1, world));
+  if ((item IS '<') OR
+      (item IS '>') OR
+      (item IS 'v') OR
+      (item IS '^') OR
+      (item IS 'O'))
+    {
+      if (item ISNT 'v')
+	IFF(make_water(row - 1, col, world));
+      if (item ISNT '<')
+	IFF(make_water(row, col + 1, world));
+      if (item ISNT '^')
+	IFF(make_water(row + 1, col, world));
+      if (item ISNT '>')
+	IFF(make_water(row, col - 1, world));
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* path_before
+
+Returned Value: int (OK)
+
+Called By:  sort_answers
+
+Side Effects: This sets *before to 1 if the path of guesses that led to
+world1 comes before the path that led to world2 in the order a single
+thread would have tried them. Otherwise, it sets *before to 0.
+
+Notes:
+
+Paths are compared index by index. If one path is the start of the
+other, the shorter comes first. This cannot happen for two answers,
+since an answer is found only at the end of a path.
+
+*/
+
+int path_before(            /* ARGUMENTS                        */
+ struct bap_world * world1, /* puzzle model holding one answer  */
+ struct bap_world * world2, /* puzzle model holding other answer */
+ int * before)              /* set here to 1 or 0               */
+{
+  const char * name SET_TO "path_before";
+  int n;
+
+  *before SET_TO (world1->depth < world2->depth);
+  for (n SET_TO 0; ((n < world1->depth) AND (n < world2->depth)); n++)
+    {
+      if (world1->path[n] ISNT world2->path[n])
+	{
+	  *before SET_TO (world1->path[n] < world2->path[n]);
+	  break;
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* place_battleships
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. place_ships_row returns ERROR.
+  2. place_ships_col returns ERROR.
+  3. record_progress returns ERROR.
+
+Called By:  run_rules
+
+Side Effects: Parts of battleships assigned to rows and columns are
+placed in the puzzle, to the extent the location can be determined.
+
+*/
+
+int place_battleships(     /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "place_battleships";
+  int row;
+  int col;
+
+  world->number_in_rows SET_TO 0;
+  for (row SET_TO 0; row < world->number_rows; row++)
+    {
+      if (world->rows[row].battleships)
+	IFF(place_ships_row(row, 4, world->rows[row].battleships, world));
+    }
+  world->number_in_cols SET_TO 0;
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      if (world->cols[col].battleships)
+	IFF(place_ships_col(col, 4, world->cols[col].battleships, world));
+    }
+  IFF(record_progress
+      ("place battleships", "mark ship parts and/or water in", world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* place_cruisers
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. place_ships_row returns ERROR.
+  2. place_ships_col returns ERROR.
+  3. record_progress returns ERROR.
+
+Called By:  run_rules
+
+Side Effects: Parts of cruisers assigned to rows and columns are
+placed in the puzzle, to the extent the location can be determined.
+
+
+*/
+
+int place_cruisers(        /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "place_cruisers";
+  int row;
+  int col;
+
+  world->number_in_rows SET_TO 0;
+  for (row SET_TO 0; row < world->number_rows; row++)
+    {
+      if (world->rows[row].cruisers)
+	IFF(place_ships_row(row, 3, world->rows[row].cruisers, world));
+    }
+  world->number_in_cols SET_TO 0;
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      if (world->cols[col].cruisers)
+	IFF(place_ships_col(col, 3, world->cols[col].cruisers, world));
+    }
+  IFF(record_progress
+      ("place cruisers", "mark ship parts and/or water in", world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* place_destroyers
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. place_ships_row returns ERROR.
+  2. place_ships_col returns ERROR.
+  3. record_progress returns ERROR.
+
+Called By:  run_rules
+
+Side Effects: Parts of destroyers assigned to rows and columns are
+placed in the puzzle, to the extent the location can be determined.
+
+*/
+
+int place_destroyers(      /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "place_destroyers";
+  int row;
+  int col;
+
+  world->number_in_rows SET_TO 0;
+  for (row SET_TO 0; row < world->number_rows; row++)
+    {
+      if (world->rows[row].destroyers)
+	IFF(place_ships_row(row, 2, world->rows[row].destroyers, world));
+    }
+  world->number_in_cols SET_TO 0;
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      if (world->cols[col].destroyers)
+	IFF(place_ships_col(col, 2, world->cols[col].destroyers, world));
+    }
+  IFF(record_progress("place destroyers", "ship parts and/or water in", world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* place_ships_col
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. find_min_starts_col returns ERROR.
+  2. find_max_starts_col returns ERROR.
+  3. enx_square returns ERROR.
+  4. place_ships_col_water returns ERROR.
+
+Called By:
+  place_battleships
+  place_cruisers
+  place_destroyers
+
+Side Effects: See discussion of place_ships_row.
+
+*/
+
+int place_ships_col(       /* ARGUMENTS                                     */
+ int col,                  /* index of column being processed               */
+ int size,                 /* size of ship                                  */
+ int assigned,             /* number ships of given size assigned to column */
+ struct bap_world * world) /* puzzle model                                  */
+{
+  const char * name SET_TO "place_ships_col";
+  int n;
+  int k;
+  int max_starts[MAX_NUMBER_ROWS]; /* array with minimum starting positions */
+  int min_starts[MAX_NUMBER_ROWS]; /* array with maximum starting positions */
+  int placed;
+
+  IFF(find_min_starts_col(col, size, assigned, min_starts, world));
+  IFF(find_max_starts_col(col, size, assigned, max_starts, world));
+  placed SET_TO 0;
+  for (n SET_TO 0; n < assigned; n++)
+    {
+      for (k SET_TO min_starts[n]; k < (min_starts[n] + size); k++)
+	{
+	  if ((k >= max_starts[n]) AND (square(k, col, world) IS ' '))
+	    {
+	      IFF(enx_square(k, col, world));
+	      placed SET_TO 1;
+	    }
+	}
+    }
+  IFF(place_ships_col_water
+      (col, size, assigned, min_starts, max_starts, &placed, world));
+  if (placed)
+    world->cols_in[world->number_in_cols++] SET_TO col;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* place_ships_col_water
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The assigned ships of the given length (along with other ship
+     parts in the row) do not fit in the column: "Puzzle has no answer".
+  2. make_water returns ERROR.
+
+Called By:  place_ships_col
+
+Side Effects: This counts the number of squares filled with ship parts
+that cannot be covered by the assigned ships of the given size in the
+given column and adds to it the number of squares that will be used by
+the assigned ships. If the total equals the aim number for the column,
+then the empty squares in the column that cannot be covered by the
+assigned ships must be water, so they are made water. Also, if min_start[n]
+is the same as max_start[n], then there is only one place that ship can
+go, so water is placed at both ends of the ship. If any square is
+made water, *placed is set to 1.
+
+Notes:
+
+placed may already be 1 before this is called. That is OK.
+
+*/
+
+int place_ships_col_water( /* ARGUMENTS                                     */
+ int col,                  /* index of column being processed               */
+ int size,                 /* size of ship                                  */
+ int assigned,             /* number ships of given size assigned to column */
+ int * min_starts,         /* array of minimum starting positions           */
+ int * max_starts,         /* array of maximum starting positions           */
+ int * placed,             /* set to one if any water placed                */
+ struct bap_world * world) /* puzzle model                                  */
+{
+  const char * name SET_TO "place_ships_col_water";
+  int row;
+  int n;     /* counter for assigned ships */
+  int total;
+
+  n SET_TO 0;
+  total SET_TO 0;
+  for (row SET_TO 0; row < world->number_rows; )
+    {
+      if ((row < min_starts[n]) OR (row > (max_starts[n] + size - 1)))
+	{
+	  if ((square(row, col, world) ISNT ' ') AND
+	      (square(row, col, world) ISNT '.'))
+	    total++;
+	  row++;
+	}
+      else
+	{
+	  row SET_TO (max_starts[n] + size);
+	  if (n < (assigned - 1))
+	    n++;
+	}
+    }
+  total SET_TO (total + (assigned * size));
+  CHK((total > world->cols[col].aim), "Puzzle has no answer");
+  n SET_TO 0;
+  if (total IS world->cols[col].aim)
+    {
+      for (row SET_TO 0; row < world->number_rows; )
+	{
+	  if ((row < min_starts[n]) OR (row > (max_starts[n] + size - 1)))
+	    {
+	      if (square(row, col, world) IS ' ')
+		{
+		  IFF(make_water(row, col, world));
+		  *placed SET_TO 1;
+		}
+	      row++;
+	    }
+	  else
+	    {
+	      row SET_TO (max_starts[n] + size);
+	      if (n < (assigned - 1))
+		n++;
+	    }
+	}
+    }
+  for (n SET_TO 0; n < assigned; n++)
+    {
+      if (min_starts[n] IS max_starts[n])
+	{
+	  if (square((min_starts[n] - 1), col, world) ISNT '.')
+	    {
+	      IFF(make_water((min_starts[n] - 1), col, world));
+	      *placed SET_TO 1;
+	    }
+	  if (square((min_starts[n] + size), col, world) ISNT '.')
+	    {
+	      IFF(make_water((min_starts[n] + size), col, world));
+	      *placed SET_TO 1;
+	    }
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* place_ships_row
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. find_min_starts_row returns ERROR.
+  2. find_max_starts_row returns ERROR.
+  3. enx_square returns ERROR.
+  4. place_ships_row_water returns ERROR.
+
+Called By:
+  place_battleships
+  place_cruisers
+  place_destroyers
+
+Side Effects: This makes two placements of the ships of the given size
+assigned to a row: as far left as possible, and as far right as
+possible. Blank squares that are covered by the same ship in both
+cases are marked with an X.  Both placements must be legal. In addition,
+this calls place_ships_row_water to mark water in the row.
+
+Notes:
+
+min_starts is an array of the starting positions of assigned (hence
+not located) ships pushed left. max_starts is an array of the starting
+positions of assigned (hence not located) ships pushed right. The
+length of both arrays equals the "assigned" argument.
+
+max_starts[n] and min_starts[n] refer to the same ship.
+
+To be complete, this would construct all possible fillings of the row
+that are legal and include all assigned ships. Then it would
+mark with an X all blank squares that are full in every case.
+
+*/
+
+int place_ships_row(       /* ARGUMENTS                                     */
+ int row,                  /* index of row being processed                  */
+ int size,                 /* size of ship                                  */
+ int assigned,             /* number of ships of given size assigned to row */
+ struct bap_world * world) /* puzzle model                                  */
+{
+  const char * name SET_TO "place_ships_row";
+  int n;
+  int k;
+  int max_starts[MAX_NUMBER_COLS]; /* array with minimum starting positions */
+  int min_starts[MAX_NUMBER_COLS]; /* array with maximum starting positions */
+  int placed;
+
+  IFF(find_min_starts_row(row, size, assigned, min_starts, world));
+  IFF(find_max_starts_row(row, size, assigned, max_starts, world));
+  placed SET_TO 0;
+  for (n SET_TO 0; n < assigned; n++)
+    {
+      for (k SET_TO min_starts[n]; k < (min_starts[n] + size); k++)
+	{
+	  if ((k >= max_starts[n]) AND (square(row, k, world) IS ' '))
+	    {
+	      IFF(enx_square(row, k, world));
+	      placed SET_TO 1;
+	    }
+	}
+    }
+  IFF(place_ships_row_water
+      (row, size, assigned, min_starts, max_starts, &placed, world));
+  if (placed)
+    world->rows_in[world->number_in_rows++] SET_TO row;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* place_ships_row_water
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The assigned ships of the given length (along with other ship
+     parts in the row) do not fit in the row: "Puzzle has no answer".
+  2. make_water returns ERROR.
+
+Called By:  place_ships_row
+
+Side Effects: This counts the number of squares filled with ship parts
+that cannot be covered by the assigned ships of the given size in the
+given row and adds to it the number of squares that will be used by
+the assigned ships. If the total equals the aim number for the row,
+then the empty squares in the row that cannot be covered by the
+assigned ships must be water, so they are made water. If any square is
+made water, *placed is set to 1.
+
+Notes:
+
+placed may already be 1 before this is called. That is OK.
+
+*/
+
+int place_ships_row_water( /* ARGUMENTS                                     */
+ int row,                  /* index of row being processed                  */
+ int size,                 /* size of ship                                  */
+ int assigned,             /* number of ships of given size assigned to row */
+ int * min_starts,         /* array of minimum starting positions           */
+ int * max_starts,         /* array of maximum starting positions           */
+ int * placed,             /* set to one if any water placed                */
+ struct bap_world * world) /* puzzle model                                  */
+{
+  const char * name SET_TO "place_ships_row_water";
+  int col;
+  int n;     /* counter for assigned ships */
+  int total;
+
+  n SET_TO 0;
+  total SET_TO 0;
+  for (col SET_TO 0; col < world->number_cols; )
+    {
+      if ((col < min_starts[n]) OR (col > (max_starts[n] + size - 1)))
+	{
+	  if ((square(row, col, world) ISNT ' ') AND
+	      (square(row, col, world) ISNT '.'))
+	    total++;
+	  col++;
+	}
+      else
+	{
+	  col SET_TO (max_starts[n] + size);
+	  if (n < (assigned - 1))
+	    n++;
+	}
+    }
+  total SET_TO (total + (assigned * size));
+  CHK((total > world->rows[row].aim), "Puzzle has no answer");
+  n SET_TO 0;
+  if (total IS world->rows[row].aim)
+    {
+      for (col SET_TO 0; col < world->number_cols; )
+	{
+	  if ((col < min_starts[n]) OR (col > (max_starts[n] + size - 1)))
+	    {
+	      if (square(row, col, world) IS ' ')
+		{
+		  IFF(make_water(row, col, world));
+		  *placed SET_TO 1;
+		}
+	      col++;
+	    }
+	  else
+	    {
+	      col SET_TO (max_starts[n] + size);
+	      if (n < (assigned - 1))
+		n++;
+	    }
+	}
+    }
+  for (n SET_TO 0; n < assigned; n++)
+    {
+      if (min_starts[n] IS max_starts[n])
+	{
+	  if (square(row, (min_starts[n] - 1), world) ISNT '.')
+	    {
+	      IFF(make_water(row, (min_starts[n] - 1), world));
+	      *placed SET_TO 1;
+	    }
+	  if (square(row, (min_starts[n] + size), world) ISNT '.')
+	    {
+	      IFF(make_water(row, (min_starts[n] + size), world));
+	      *placed SET_TO 1;
+	    }
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* play_move
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no room for another move: "Bug too many moves".
+  2. make_move returns ERROR with a message.
+  3. find_hint or undo_trail returns ERROR.
+
+Called By:  bap_set_square
+
+Side Effects: This puts the given character in the square at the given
+row and column (see make_move), pushes the move on the moves of the
+session with the length the trail had before it, and fills in the hint
+with the next rule that sets squares (see find_hint).
+
+If the move leaves the puzzle with no answer (water around a ship part
+runs into another ship part), it is undone and not pushed, and the
+status of the hint is BAP_NO_ANSWER with no rule.
+
+Notes:
+
+A move sets a blank, or an X to a known part, so there can be no more
+moves than twice the number of squares.
+
+*/
+
+int play_move(                 /* ARGUMENTS                    */
+ int row,                      /* row index of square          */
+ int col,                      /* column index of square       */
+ char item,                    /* character to put in square   */
+ struct bap_session * session, /* session to make move in      */
+ struct bap_hint * hint)       /* hint, filled in here         */
+{
+  const char * name SET_TO "play_move";
+  struct bap_world * world;
+  struct move * the_move; /* move pushed                              */
+  int failed;             /* set to ERROR if move failed with message */
+  int mark;               /* number of changes on trail before move   */
+  int result;             /* value returned by make_move              */
+
+  world SET_TO &(session->world);
+  CHB((session->number_moves IS
+       (2 * world->number_rows * world->number_cols)),
+      "Bug too many moves");
+  mark SET_TO world->trail->number_changes;
+  result SET_TO make_move(row, col, item, world);
+  if (result IS OK)
+    {
+      the_move SET_TO (session->moves + session->number_moves++);
+      the_move->item SET_TO item;
+      the_move->mark SET_TO mark;
+      the_move->row SET_TO row;
+      the_move->col SET_TO col;
+      IFF(find_hint(session, hint));
+    }
+  else
+    {
+      IFF(undo_trail(mark, world));
+      failed SET_TO ((world->message[0] ISNT 0) ? ERROR : OK);
+      IFF(failed);
+      clear_hint(session, hint);
+      strcpy(session->text, "move leaves puzzle with no answer");
+      hint->status SET_TO BAP_NO_ANSWER;
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* print_bap
+
+Returned Value: int (OK)
+
+Called By:
+  dlx_answer
+  record_line
+  record_progress
+  run_pool
+  solve_problem
+
+Side Effects: This prints the puzzle from the bap_world. The puzzle
+is printed in the same format as required for reading in, except that
+the list of ships and end marker are omitted.
+
+*/
+
+int print_bap(             /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "print_bap";
+  int row;
+  int col;
+
+  printf("\n ");
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      printf(" -");
+    }
+  printf("\n");
+  for (row SET_TO 0; row < world->number_rows; row++)
+    {
+      printf(" |");
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  printf("%c", world->squares[row][col]);
+	  if (col < (world->number_cols - 1))
+	    printf(" ");
+	}
+      printf("|%d\n", world->rows[row].aim);
+    }
+  printf(" ");
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      printf(" -");
+    }
+  printf("\n  ");
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      printf("%d", world->cols[col].aim);
+      if (world->cols[col].aim < 10)
+	printf(" ");
+    }
+  printf("\n");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* print_event
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the text: "Out of memory".
+
+Called By:
+  explain_bap
+  record_line
+  record_progress
+
+Side Effects: This prints one line of explanation, written out as text
+by render_event.
+
+*/
+
+int print_event(           /* ARGUMENTS                    */
+ struct event * the_event, /* line of explanation to print */
+ struct bap_world * world) /* puzzle model                 */
+{
+  const char * name SET_TO "print_event";
+  char * text;  /* text of line */
+
+  text SET_TO (char *)malloc(world->logic_width);
+  CHB((text IS NULL), "Out of memory");
+  render_event(the_event, text, world);
+  printf("%s\n", text);
+  free(text);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* probe_table
+
+Returned Value: int (OK)
+
+Called By:  try_guessing
+
+Side Effects: This sets *found to 1 if the key is in the transposition
+table, and to 0 if not. The counts of probes and hits are updated.
+
+Notes:
+
+The one slot the key can be in is given by the low bits of the key.
+The lock is taken only if the table is shared by threads (see
+make_table). A world of a batch has no pool, so whether threads are
+searching cannot be told from the world.
+
+*/
+
+int probe_table(           /* ARGUMENTS                        */
+ unsigned long long key,   /* key of state to look up          */
+ int * found,              /* set here to 1 if found, 0 if not */
+ struct bap_world * world) /* puzzle model                     */
+{
+  const char * name SET_TO "probe_table";
+  struct table * table; /* transposition table */
+
+  table SET_TO world->table;
+  if (table->shared)
+    pthread_mutex_lock(&(table->lock));
+  *found SET_TO (table->entries[key & table->mask].key IS key);
+  table->probes++;
+  if (*found)
+    table->hits++;
+  if (table->shared)
+    pthread_mutex_unlock(&(table->lock));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* profile_clock
+
+Returned Value: int (OK)
+
+Called By:
+  profile_rule
+  run_rules (by way of RUN_RULE)
+  trace_guess
+  try_guessing
+
+Side Effects: This sets *now to the time in nanoseconds from the
+monotonic clock.
+
+*/
+
+int profile_clock(         /* ARGUMENTS                */
+ long long * now)          /* set here to current time */
+{
+  const char * name SET_TO "profile_clock";
+  struct timespec time_now;
+
+  clock_gettime(CLOCK_MONOTONIC, &time_now);
+  *now SET_TO (((long long)time_now.tv_sec * 1000000000) + time_now.tv_nsec);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* profile_rule
+
+Returned Value: int (OK)
+
+Called By:  run_rules (by way of RUN_RULE, only if PROFILING is 1)
+
+Side Effects: This adds one call of the rule, and the time since start,
+to the counts of the rule for the depth of guessing of the world. If
+the rule made progress (world->progress was 0 before the rule was
+called and is not now), one firing is added too.
+
+Notes:
+
+The counts are added with atomic adds, since threads searching the same
+puzzle or solving different puzzles of a batch share them. The atomic
+adds are not cheap, but they are made only when profiling.
+
+*/
+
+int profile_rule(          /* ARGUMENTS                              */
+ int rule,                 /* RULE_XXX number of rule called         */
+ long long start,          /* time rule was called, from profile_clock */
+ int progress,             /* world->progress before rule called     */
+ struct bap_world * world) /* puzzle model                           */
+{
+  const char * name SET_TO "profile_rule";
+  struct rule_count * count; /* counts for rule at depth */
+  long long now;             /* time rule returned       */
+  int depth;                 /* depth counts are kept for */
+
+  profile_clock(&now);
+  depth SET_TO ((world->depth < PROFILE_DEPTHS) ? world->depth :
+		(PROFILE_DEPTHS - 1));
+  count SET_TO &(rule_counts[rule][depth]);
+  __sync_fetch_and_add(&(count->calls), 1);
+  if ((progress IS 0) AND world->progress)
+    __sync_fetch_and_add(&(count->fires), 1);
+  __sync_fetch_and_add(&(count->nanoseconds), (now - start));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* queue_guess
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the task: "Out of memory".
+  2. clone_bap returns ERROR.
+  3. copy_guess returns ERROR.
+
+Called By:  try_guessing
+
+Side Effects: This makes a task holding a copy of the world and the
+guess, and puts it on the queue of the thread working on the world.
+*queued is set to 1 if the task was put on the queue. If the queue is
+full, no task is made and *queued is set to 0, so that the
+caller will try the guess itself.
+
+Notes:
+
+The index of the guess among its siblings is recorded as the last step
+of the path of the copy, so that the answers found can be put in order
+later (see sort_answers).
+
+Only the thread that owns a queue adds tasks to it, so if there is
+room when the lock is released, there is still room after the task has
+been made.
+
+*/
+
+int queue_guess(           /* ARGUMENTS                              */
+ struct guess * the_guess, /* guess to be tried                      */
+ int index,                /* index of guess in set of guesses       */
+ int * queued,             /* set here to 1 if queued, 0 if not      */
+ struct bap_world * world) /* puzzle model                           */
+{
+  const char * name SET_TO "queue_guess";
+  struct queue * the_queue; /* queue of thread working on world */
+  struct task * the_task;   /* task made here                   */
+  int room;                 /* set to 1 if queue is not full    */
+
+  the_queue SET_TO &(world->pool->queues[world->worker]);
+  pthread_mutex_lock(&(world->pool->lock));
+  room SET_TO (the_queue->number_tasks < MAX_TASKS);
+  pthread_mutex_unlock(&(world->pool->lock));
+  *queued SET_TO 0;
+  if (room)
+    {
+      the_task SET_TO (struct task *)malloc(sizeof(struct task));
+      CHB((the_task IS NULL), "Out of memory");
+      IFF(clone_bap(&(the_task->world), world));
+      IFF(copy_guess(&(the_task->the_guess), the_guess));
+      the_task->world.path[the_task->world.depth++] SET_TO index;
+      the_task->has_guess SET_TO 1;
+      pthread_mutex_lock(&(world->pool->lock));
+      the_queue->tasks[(the_queue->first + the_queue->number_tasks) %
+		       MAX_TASKS] SET_TO the_task;
+      the_queue->number_tasks++;
+      world->pool->pending++;
+      pthread_cond_signal(&(world->pool->wake));
+      pthread_mutex_unlock(&(world->pool->lock));
+      *queued SET_TO 1;
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* random_index
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. scramble_key returns ERROR.
+
+Called By:
+  generate_givens
+  generate_ship
+
+Side Effects: This sets *index to a number picked at random from 0 to
+limit - 1, and moves world->seed on to the next number, so that the
+same seed always gives the same numbers.
+
+Notes:
+
+The numbers are those of the splitmix64 generator: the seed goes up by
+a fixed odd number each time, and is scrambled (see scramble_key).
+
+*/
+
+int random_index(          /* ARGUMENTS                             */
+ int limit,                /* one more than largest index to pick   */
+ int * index,              /* index picked, set here                */
+ struct bap_world * world) /* puzzle model, holding seed            */
+{
+  const char * name SET_TO "random_index";
+  unsigned long long number; /* seed, scrambled */
+
+  world->seed SET_TO (world->seed + 0x9E3779B97F4A7C15ULL);
+  number SET_TO world->seed;
+  IFF(scramble_key(&number));
+  *index SET_TO (int)(number % (unsigned long long)limit);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_answer
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the answer: "Out of memory".
+
+Called By:  solve_job
+
+Side Effects: If the name of the problem file of the job ends in ".pro"
+and there is a file with the same name ending in ".ans" instead, this
+reads the squares of the answer in that file into the_job->answer, row
+by row. Otherwise, the_job->answer is left NULL.
+
+A row of the answer is a line starting with " |", as in a problem file.
+Anything else in the file (a header, the lines of dashes, and the
+explanation) is skipped. Squares missing from the file are set to '?',
+so that no answer found matches them.
+
+*/
+
+int read_answer(           /* ARGUMENTS                            */
+ struct job * the_job,     /* job for puzzle, answer read into it  */
+ struct bap_world * world) /* puzzle model, read from problem file */
+{
+  const char * name SET_TO "read_answer";
+  FILE * in_port;           /* answer file, or NULL             */
+  char buffer[LINE_SIZE];   /* line of answer file              */
+  char file_name[LINE_SIZE]; /* name of answer file             */
+  int length;               /* length of name of problem file  */
+  int row;
+  int col;
+
+  in_port SET_TO NULL;
+  length SET_TO strlen(the_job->file_name);
+  if ((length >= 4) AND (length < LINE_SIZE) AND
+      (strcmp((the_job->file_name + length - 4), ".pro") IS 0))
+    {
+      strcpy(file_name, the_job->file_name);
+      strcpy((file_name + length - 4), ".ans");
+      in_port SET_TO fopen(file_name, "r");
+    }
+  if (in_port ISNT NULL)
+    {
+      the_job->answer SET_TO
+	(char *)malloc(world->number_rows * world->number_cols);
+      if (the_job->answer IS NULL)
+	fclose(in_port);
+      CHB((the_job->answer IS NULL), "Out of memory");
+      memset(the_job->answer, '?', (world->number_rows * world->number_cols));
+      for (row SET_TO 0;
+	   ((row < world->number_rows) AND
+	    (fgets(buffer, LINE_SIZE, in_port) ISNT NULL)); )
+	{
+	  if ((buffer[0] ISNT ' ') OR (buffer[1] ISNT '|'))
+	    continue;
+	  length SET_TO strlen(buffer);
+	  for (col SET_TO 0;
+	       ((col < world->number_cols) AND ((2 + (2 * col)) < length));
+	       col++)
+	    {
+	      the_job->answer[(row * world->number_cols) + col] SET_TO
+		buffer[2 + (2 * col)];
+	    }
+	  row++;
+	}
+      fclose(in_port);
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_arguments
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. argc is less than 4.
+  2. argv[2] is not "all", "one", "count", "generate", "serve",
+     "replay", or "summary".
+  3. argv[3] is not "yes" or "no", or, after "count", "generate",
+     "serve", or "summary", is not a number greater than 0.
+  4. An argument after argv[3] is not "v", "--trail", "--no-bits",
+     "--no-worklist", "--no-explain", "--stats", "--batch", "--profile",
+     "--profile=json", "--table=N" with N from 0 to 4096,
+     "--replace=always", "--replace=shallow", "--strategy=construct",
+     "--strategy=search-water", "--strategy=search-pure", "--rules=N"
+     with N a mask of rules other than 0, "--branch=largest",
+     "--branch=fewest", "--engine=rules", "--engine=dlx", "--size=RxC"
+     with R and C from 1 to 99, "--fleet=B,C,D,S" with numbers of ships
+     not less than 0 and not all 0, "--seed=N", "--trace=FILE", or "-j"
+     followed by a number of threads from 1 to MAX_THREADS.
+  5. More than one thread, a batch, no explanation, or the dlx engine
+     is requested and argv[3] is "yes".
+  6. More than one thread and the dlx engine are requested without a
+     batch.
+  7. argv[2] is "generate" or "serve" and more than one thread or a
+     batch is requested, or it is not "generate" and --size, --fleet,
+     or --seed is given.
+  8. A trace is written, replayed, or summarized and more than one
+     thread, a batch, or the dlx engine is requested, or --trace is
+     given and argv[2] is not "all" or "one".
+
+Called By:  main
+
+Side Effects: The values of world->find_all, world->print_all,
+world->verbose, world->in_place, world->bits, world->worklist,
+world->explain, world->jobs, world->table_megabytes, world->replace,
+world->stats, world->batch, world->profile, world->strategy,
+world->rules, world->branch, world->engine, world->count,
+world->generate, world->serve, world->trace_mode, and world->trace_name
+are set. When generating, the size
+and fleet (world->number_rows, world->number_cols, and the numbers of
+ships left) and world->seed are set too.
+
+Notes:
+
+Partial solutions cannot be printed when searching with more than one
+thread, since the threads would print them mixed together, or when
+solving a batch, which prints only one line for each puzzle. They are
+not printed without an explanation either, since the lines printed with
+them are lines of the explanation.
+
+The rules run are those of the strategy (all of them for construct,
+SEARCH_WATER_RULES or SEARCH_PURE_RULES for the searches) unless
+--rules gives a mask of them, bit n for rule n in the order of
+rule_names, as in --rules=0x800f to add try_square_blank to the rules of
+search-water. The mask replaces the rules of the strategy, but the
+strategy still decides whether water is made.
+
+--branch picks what try_guessing branches on: the largest type of ship
+left (largest, the default) or the type with the fewest places left
+(fewest). It changes only the order of the search, so the answers found
+are the same, though with "one" the first answer found may differ.
+
+With "count", argv[3] is the most answers to count (world->count)
+instead of "yes" or "no". All answers are looked for until that many
+are found, nothing is printed or explained but the count (see
+report_count), and it may be used with -j and with --batch. A limit of
+2 is enough to tell whether a puzzle has exactly one answer.
+
+With "generate", argv[1] is a directory and argv[3] is the number of
+puzzles to make in it (see generate_bap). They are 10 by 10 with the
+standard fleet of 1 battleship, 2 cruisers, 3 destroyers, and 4
+submarines unless --size or --fleet says otherwise, and --seed picks
+the random numbers (1 if not given). Sizes are at most 99 so that the
+totals written fit in two digits.
+
+With "serve", argv[1] is the name of a Unix socket to make, or "-" for
+standard input and output, and argv[3] is the most answers to look for
+in each puzzle served (world->count), as with "count", so 1 finds one
+answer and 2 tells whether it is the only one (see serve_bap).
+
+With --trace=FILE, the search is recorded in FILE (see trace_guess).
+With "replay", argv[1] is a trace, and the puzzle in it is solved again
+with the options it records, printing as "all" or "one" would with
+argv[3], and checking that every guess comes out as recorded (see
+replay_trace and finish_trace). With "summary", argv[1] is a trace,
+which is summarized, listing the argv[3] largest subtrees in which no
+answer was found (see summarize_trace). Traces are made with one
+thread, so that the order of the guesses is fixed.
+
+The dlx engine searches with one thread. With --batch, -j still says
+how many puzzles are solved at once. Partial solutions cannot be
+printed with it, since it has none; the explanation of each answer
+lists where each ship was placed.
+
+*/
+
+int read_arguments(        /* ARGUMENTS                             */
+ int argc,                 /* one more than the number of arguments */
+ char ** argv,             /* function name and arguments           */
+ struct bap_world * world) /* puzzle model                          */
+{
+  const char * name SET_TO "read_arguments";
+  int bad;       /* set to 1 if an argument is not recognized     */
+  int rules;     /* mask given with --rules, or 0 for none        */
+  int sizes[2];  /* rows and columns given with --size            */
+  int fleet[4];  /* numbers of ships given with --fleet           */
+  int making;    /* set to 1 if an option for generating is given */
+  int tracing;   /* set to 1 if a trace is written or read        */
+  int n;
+
+  bad SET_TO 0;
+  rules SET_TO 0;
+  sizes[0] SET_TO 10;
+  sizes[1] SET_TO 10;
+  fleet[0] SET_TO 1;
+  fleet[1] SET_TO 2;
+  fleet[2] SET_TO 3;
+  fleet[3] SET_TO 4;
+  making SET_TO 0;
+  world->verbose SET_TO 0;
+  world->in_place SET_TO 0;
+  world->bits SET_TO 1;
+  world->worklist SET_TO 1;
+  world->explain SET_TO 1;
+  world->jobs SET_TO 1;
+  world->table_megabytes SET_TO TABLE_MEGABYTES;
+  world->replace SET_TO REPLACE_ALWAYS;
+  world->stats SET_TO 0;
+  world->batch SET_TO 0;
+  world->profile SET_TO 0;
+  world->strategy SET_TO STRATEGY_CONSTRUCT;
+  world->engine SET_TO ENGINE_RULES;
+  world->branch SET_TO BRANCH_LARGEST;
+  world->count SET_TO 0;
+  world->generate SET_TO 0;
+  world->serve SET_TO 0;
+  world->seed SET_TO 1;
+  world->trace_mode SET_TO 0;
+  world->trace_name SET_TO NULL;
+  for (n SET_TO 4; n < argc; n++)
+    {
+      if ((strcmp(argv[n], "-j") IS 0) AND ((n + 1) < argc))
+	{
+	  world->jobs SET_TO atoi(argv[++n]);
+	  if ((world->jobs < 1) OR (world->jobs > MAX_THREADS))
+	    bad SET_TO 1;
+	}
+      else if (strcmp(argv[n], "v") IS 0)
+	world->verbose SET_TO 1;
+      else if (strcmp(argv[n], "--trail") IS 0)
+	world->in_place SET_TO 1;
+      else if (strcmp(argv[n], "--no-bits") IS 0)
+	world->bits SET_TO 0;
+      else if (strcmp(argv[n], "--no-worklist") IS 0)
+	world->worklist SET_TO 0;
+      else if (strcmp(argv[n], "--no-explain") IS 0)
+	world->explain SET_TO 0;
+      else if (strcmp(argv[n], "--stats") IS 0)
+	world->stats SET_TO 1;
+      else if (strcmp(argv[n], "--batch") IS 0)
+	world->batch SET_TO 1;
+      else if (strcmp(argv[n], "--profile") IS 0)
+	world->profile SET_TO PROFILE_TEXT;
+      else if (strcmp(argv[n], "--profile=json") IS 0)
+	world->profile SET_TO PROFILE_JSON;
+      else if (strncmp(argv[n], "--table=", 8) IS 0)
+	{
+	  world->table_megabytes SET_TO atoi(argv[n] + 8);
+	  if ((world->table_megabytes < 0) OR (world->table_megabytes > 4096))
+	    bad SET_TO 1;
+	}
+      else if (strcmp(argv[n], "--replace=always") IS 0)
+	world->replace SET_TO REPLACE_ALWAYS;
+      else if (strcmp(argv[n], "--replace=shallow") IS 0)
+	world->replace SET_TO REPLACE_SHALLOW;
+      else if (strcmp(argv[n], "--strategy=construct") IS 0)
+	world->strategy SET_TO STRATEGY_CONSTRUCT;
+      else if (strcmp(argv[n], "--strategy=search-water") IS 0)
+	world->strategy SET_TO STRATEGY_SEARCH_WATER;
+      else if (strcmp(argv[n], "--strategy=search-pure") IS 0)
+	world->strategy SET_TO STRATEGY_SEARCH_PURE;
+      else if (strcmp(argv[n], "--branch=largest") IS 0)
+	world->branch SET_TO BRANCH_LARGEST;
+      else if (strcmp(argv[n], "--branch=fewest") IS 0)
+	world->branch SET_TO BRANCH_FEWEST;
+      else if (strcmp(argv[n], "--engine=rules") IS 0)
+	world->engine SET_TO ENGINE_RULES;
+      else if (strcmp(argv[n], "--engine=dlx") IS 0)
+	world->engine SET_TO ENGINE_DLX;
+      else if (strncmp(argv[n], "--rules=", 8) IS 0)
+	{
+	  rules SET_TO (int)strtol((argv[n] + 8), NULL, 0);
+	  if ((rules <= 0) OR (rules > ALL_RULES))
+	    bad SET_TO 1;
+	}
+      else if (strncmp(argv[n], "--size=", 7) IS 0)
+	{
+	  making SET_TO 1;
+	  if ((sscanf((argv[n] + 7), "%dx%d", &(sizes[0]), &(sizes[1])) ISNT 2)
+	      OR (sizes[0] < 1) OR (sizes[0] > 99) OR
+	      (sizes[1] < 1) OR (sizes[1] > 99))
+	    bad SET_TO 1;
+	}
+      else if (strncmp(argv[n], "--fleet=", 8) IS 0)
+	{
+	  making SET_TO 1;
+	  if ((sscanf((argv[n] + 8), "%d,%d,%d,%d", &(fleet[0]), &(fleet[1]),
+		      &(fleet[2]), &(fleet[3])) ISNT 4) OR
+	      (fleet[0] < 0) OR (fleet[1] < 0) OR (fleet[2] < 0) OR
+	      (fleet[3] < 0) OR
+	      ((fleet[0] + fleet[1] + fleet[2] + fleet[3]) IS 0))
+	    bad SET_TO 1;
+	}
+      else if (strncmp(argv[n], "--seed=", 7) IS 0)
+	{
+	  making SET_TO 1;
+	  world->seed SET_TO strtoull((argv[n] + 7), NULL, 0);
+	}
+      else if ((strncmp(argv[n], "--trace=", 8) IS 0) AND argv[n][8])
+	world->trace_name SET_TO (argv[n] + 8);
+      else
+	bad SET_TO 1;
+    }
+  if (rules ISNT 0)
+    world->rules SET_TO rules;
+  else if (world->strategy IS STRATEGY_SEARCH_WATER)
+    world->rules SET_TO SEARCH_WATER_RULES;
+  else if (world->strategy IS STRATEGY_SEARCH_PURE)
+    world->rules SET_TO SEARCH_PURE_RULES;
+  else
+    world->rules SET_TO ALL_RULES;
+  if ((world->engine IS ENGINE_DLX) AND (world->jobs > 1) AND
+      (world->batch IS 0))
+    bad SET_TO 1;
+  if ((argc < 4) OR (strcmp(argv[2], "generate") ISNT 0))
+    bad SET_TO (bad OR making);
+  if ((argc >= 4) AND ((strcmp(argv[2], "generate") IS 0) OR
+		       (strcmp(argv[2], "serve") IS 0)))
+    bad SET_TO (bad OR (world->jobs > 1) OR world->batch);
+  tracing SET_TO ((world->trace_name ISNT NULL) OR
+		  ((argc >= 4) AND ((strcmp(argv[2], "replay") IS 0) OR
+				    (strcmp(argv[2], "summary") IS 0))));
+  if (tracing AND ((world->jobs > 1) OR world->batch OR
+		   (world->engine IS ENGINE_DLX)))
+    bad SET_TO 1;
+  if (world->trace_name AND
+      ((argc < 4) OR ((strcmp(argv[2], "all") ISNT 0) AND
+		      (strcmp(argv[2], "one") ISNT 0))))
+    bad SET_TO 1;
+  if ((argc >= 4) AND (bad IS 0) AND (strcmp(argv[2], "count") IS 0) AND
+      (atoi(argv[3]) > 0))
+    {
+      world->count SET_TO atoi(argv[3]);
+      world->find_all SET_TO 1;
+      world->print_all SET_TO 0;
+      world->explain SET_TO 0;
+    }
+  else if ((argc >= 4) AND (bad IS 0) AND
+	   (strcmp(argv[2], "generate") IS 0) AND (atoi(argv[3]) > 0))
+    {
+      world->generate SET_TO atoi(argv[3]);
+      world->number_rows SET_TO sizes[0];
+      world->number_cols SET_TO sizes[1];
+      if ((sizes[0] > 64) OR (sizes[1] > 64))
+	world->bits SET_TO 0;
+      world->battleships_left SET_TO fleet[0];
+      world->cruisers_left SET_TO fleet[1];
+      world->destroyers_left SET_TO fleet[2];
+      world->submarines_left_col SET_TO fleet[3];
+      world->submarines_left_row SET_TO fleet[3];
+      world->print_all SET_TO 0;
+    }
+  else if ((argc >= 4) AND (bad IS 0) AND
+	   (strcmp(argv[2], "serve") IS 0) AND (atoi(argv[3]) > 0))
+    {
+      world->serve SET_TO 1;
+      world->count SET_TO atoi(argv[3]);
+      world->find_all SET_TO 1;
+      world->print_all SET_TO 0;
+      world->explain SET_TO 0;
+    }
+  else if ((argc >= 4) AND (bad IS 0) AND
+	   (strcmp(argv[2], "summary") IS 0) AND (atoi(argv[3]) > 0))
+    {
+      world->trace_mode SET_TO TRACE_SUMMARY;
+      world->print_all SET_TO 0;
+    }
+  else if ((argc >= 4) AND (bad IS 0) AND
+	   (strcmp(argv[2], "replay") IS 0) AND
+	   ((strcmp(argv[3], "yes") IS 0) OR (strcmp(argv[3], "no") IS 0)))
+    {
+      world->trace_mode SET_TO TRACE_REPLAY;
+      world->print_all SET_TO (strcmp(argv[3], "yes") IS 0);
+    }
+  else if ((argc >= 4) AND (bad IS 0) AND
+	   ((strcmp(argv[2], "all") IS 0) OR (strcmp(argv[2], "one") IS 0)) AND
+	   ((strcmp(argv[3], "no") IS 0) OR
+	    ((strcmp(argv[3], "yes") IS 0) AND (world->jobs IS 1) AND
+	     (world->batch IS 0) AND world->explain AND
+	     (world->engine IS ENGINE_RULES))))
+    {
+      if (strcmp(argv[2], "all") IS 0)
+	world->find_all SET_TO 1;
+      else
+	world->find_all SET_TO 0;
+      if (strcmp(argv[3], "yes") IS 0)
+	world->print_all SET_TO 1;
+      else
+	world->print_all SET_TO 0;
+      if (world->trace_name)
+	world->trace_mode SET_TO TRACE_WRITE;
+    }
+  else
+    {
+      printf("Usage: %s <file name> <all|one> <yes|no> [v] [--trail] "
+	     "[--no-bits] [--no-worklist]\n       [--no-explain] [-j <threads>] "
+	     "[--table=<megabytes>] [--replace=always|shallow]\n       "
+	     "[--stats] [--batch] [--profile[=json]]\n       "
+	     "[--strategy=construct|search-water|search-pure] "
+	     "[--rules=<mask>]\n       [--branch=largest|fewest] "
+	     "[--engine=rules|dlx]\n       [--trace=<trace file>]\n",
+	     argv[0]);
+      printf("   or: %s <file name> count <limit> [the same options]\n",
+	     argv[0]);
+      printf("   or: %s <directory> generate <number> [--size=<rows>x<cols>] "
+	     "\n       [--fleet=<b>,<c>,<d>,<s>] [--seed=<n>] [the same "
+	     "options]\n", argv[0]);
+      printf("   or: %s <socket|-> serve <limit> [the same options]\n",
+	     argv[0]);
+      printf("   or: %s <trace file> replay <yes|no> [v]\n", argv[0]);
+      printf("   or: %s <trace file> summary <number>\n", argv[0]);
+      printf("all = find all solutions\n");
+      printf("one = find one solution\n");
+      printf("yes = print puzzle when done and when a rule makes progress\n");
+      printf("no = print puzzle only when done\n");
+      printf("count = count answers, stopping at the limit, and print only "
+	     "\"answers=<count>\n  limit=<limit>\"\n");
+      printf("generate = make the number of puzzles with one answer each "
+	     "as problem files\n  in the directory (default 10x10, fleet "
+	     "1,2,3,4, seed 1)\n");
+      printf("serve = solve each puzzle sent as a line giving its length "
+	     "and then its text,\n  stopping at the limit, and print a line "
+	     "for each (- for standard input)\n");
+      printf("replay = solve the puzzle of a trace again as traced, and "
+	     "check each guess\n");
+      printf("summary = summarize a trace, listing the number of largest "
+	     "subtrees with no\n  answer\n");
+      printf("v = verbose (prints more messages)\n");
+      printf("--trail = search in place, undoing changes after each guess\n");
+      printf("--no-bits = check squares one at a time, not with bit masks\n");
+      printf("--no-worklist = run every rule on every strip, not only on "
+	     "strips changed\n  since the rule last found nothing\n");
+      printf("--no-explain = do not record or print the explanation "
+	     "(not with yes)\n");
+      printf("-j = search with the given number of threads (not with yes)\n");
+      printf("--table = size of table of failed states, 0 for none "
+	     "(default %d)\n", TABLE_MEGABYTES);
+      printf("--replace = reuse a full table slot always (default), or only "
+	     "for a state\n  as near the first guess\n");
+      printf("--stats = print table statistics when done\n");
+      printf("--batch = file name is a directory of problem files or a "
+	     "file listing them,\n  all solved with one line printed for "
+	     "each; -j = puzzles solved at once\n");
+      printf("--profile = print calls, firings, and time of each rule "
+	     "(if compiled with\n  -DBAP_PROFILE), as JSON with =json\n");
+      printf("--strategy = construct then guess (default), search making "
+	     "only water, or\n  pure search making no water\n");
+      printf("--rules = mask of rules to run, bit n for rule n, in place "
+	     "of those of the\n  strategy\n");
+      printf("--branch = guess where the largest ship left goes (default), "
+	     "or the ship with\n  the fewest places left\n");
+      printf("--engine = solve by rules and guessing (default), or by "
+	     "exact cover with\n  dancing links (not with yes, nor -j "
+	     "without --batch)\n");
+      printf("--trace = record each guess tried in the trace file (with "
+	     "all or one, not with\n  -j, --batch, or --engine=dlx)\n");
+      CHB(1, " ");
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_column_numbers
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The file ends before the line of column numbers:
+     "File ends before line of column numbers".
+  2. The line has bad format: "Bad line of column numbers".
+  3. A column number is greater than the number of places in a column:
+     "COLUMN COUNT TOO BIG.
+  4. The file ends before the blank line: "File ends before lines of ships".
+  5. The blank line is missing: "Blank line missing before ships".
+
+Called By:  read_puzzle
+
+Side Effects: This reads the row of column numbers and records them in
+world->col_counts.  It also reads the blank line following that row. The
+column numbers line follows the bottom line of dashes.
+
+*/
+
+int read_column_numbers(   /* ARGUMENTS                 */
+ FILE * in_port,           /* port to file to read from */
+ char * buffer,            /* buffer to read into       */
+ struct bap_world * world) /* puzzle model              */
+{
+  const char * name SET_TO "read_column_numbers";
+  int col;
+  int n;
+
+  CHB((fgets(buffer, LINE_SIZE, in_port) IS NULL),
+      "File ends before line of column numbers");
+  CHB(((buffer[0] ISNT ' ') OR (buffer[1] ISNT ' ')),
+      "Bad line of column numbers");
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      n SET_TO
+	sscanf((buffer + (2 * col) + 2), "%2d", &(world->cols[col].aim));
+      CHB((n ISNT 1), "Bad line of column numbers");
+      CHB((world->cols[col].aim > world->number_rows), "Column count too big");
+    }
+  CHB((fgets(buffer, LINE_SIZE, in_port) IS NULL),
+      "File ends before lines of ships");
+  CHB((buffer[0] ISNT '\n'), "Blank line missing before ships");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_dashes
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The file ends before the top row of dashes:
+     "File ends before first line of dashes".
+  2. The line of dashes has bad format: "Bad first line of dashes".
+  3. The line of dashes extends to the end of the buffer:
+     "Line of dashes too long".
+  4. There is not at least one dash:
+     "problem does not have at least one column".
+  5. There are more than MAX_NUMBER_COLS columns: "Too many columns".
+
+Called By:  read_puzzle
+
+Side Effects: This
+1. reads the top row of dashes and saves it in the "dashes" buffer.
+2. sets bap->number_cols and checks that it is at least 1.
+3. sets the row_length at two characters more than the length
+   of the row of dashes. read_rows uses row_length to tell when
+   it has read the bottom row of dashes.
+
+Each dash indicates a column.
+
+*/
+
+int read_dashes(           /* ARGUMENTS                       */
+ FILE * in_port,           /* port to file to read from       */
+ char * dashes,            /* array into which to copy dashes */
+ int * row_length,         /* length of row, set here         */
+ struct bap_world * world) /* puzzle model                    */
+{
+  const char * name SET_TO "read_dashes";
+  int n;
+
+  CHB((fgets(dashes, LINE_SIZE, in_port) IS NULL),
+      "File ends before first line of dashes");
+  CHB((dashes[0] ISNT ' '), "Bad first line of dashes");
+  for (n SET_TO 1; ; n SET_TO (n + 2))
+    {
+      CHB((n >= (LINE_SIZE - 1)), "Line of dashes too long");
+      if (dashes[n] IS '\n')
+	break;
+      CHB(((dashes[n] ISNT ' ') OR (dashes[n + 1] ISNT '-')),
+	  "Bad first line of dashes");
+    }
+  *row_length SET_TO (n + 2);
+  world->number_cols SET_TO ((n - 1) / 2);
+  CHB((world->number_cols < 1), "Problem does not have at least one column");
+  CHB((world->number_cols > MAX_NUMBER_COLS), "Too many columns");
+  if (world->print_all)
+    printf("%d columns\n", world->number_cols);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_problem
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The named file cannot be opened: "Could not open file".
+  2. read_puzzle returns ERROR.
+
+Called By:
+  main
+  solve_job
+
+Side Effects: The puzzle in the file named file_name is read and stored
+by read_puzzle. The file is closed whether or not the puzzle in it can
+be read.
+
+Notes:
+
+The executable compiled from this code is expected to be named bap.
+The executable should have one command argument, the name of a file
+containing the external representation of the problem. The file
+represents an M columns by N rows rectangle to be filled with an
+arbitrary collection of ships of lengths 4, 3, 2, and 1. The file must
+have all of the following in the order given:
+
+1. a blank line (above which everything is read and ignored).
+2. a row with one space followed by alternate spaces and dashes; each dash
+   indicates a column, so the number of dashes is the number of columns,
+   which must be between 1 and MAX_NUMBER_COLS.
+3. 1 to MAX_NUMBER_ROWS rows each consisting of two spaces followed by
+   |stuff|, followed by an integer between 0 and the number of columns.
+   The stuff is a mixture of blanks, ship parts and water, with
+   appropriate spacing so water and ship parts occur in the proper column. water is ., ship end
+   is one of v<^>, ship middle is +, submarine is O (capital letter O),
+   ship part of not fully determined type is X (which does not occur
+   in standard battleships).
+4. a row identical to the one described in item 2, above.
+5. a row with two spaces followed by numbers, each of which is either
+   a one-digit number between 0 and 9 followed by a blank or a two-digit
+   number between 10 and 99. The number gives the number of squares to be
+   be filled in the column above it.
+6. a blank line
+7. 1 to four rows of any length starting with two blanks and containing
+   ships. All the ships in a row are the same size. Larger ships are in
+   rows above smaller ships. Ships are length 4, 3, 2, or 1. Two blanks
+   separate ships in a row.
+8. The word "end" on a row by itself. Lines may occur below this but will
+   not be read.
+
+
+Here is a sample file between rows of stars.
+
+****************************************************
+This is a sample problem file.
+
+  - - - - - - - - - -
+ |                   |1
+ |                   |1
+ |                   |2
+ |                  O|1
+ |                   |3
+ |                   |3
+ |                   |2
+ |                   |6
+ |                  O|1
+ |                   |0
+  - - - - - - - - - -
+  2 0 2 4 1 3 2 2 0 4
+
+  <++>
+  <+>  <+>
+  <>  <>  <>
+  O  O  O  O
+end
+
+****************************************************
+
+The reading procedure is:
+1. Open the file and check that it opened.
+2. Look for a blank line. Read and ignore everything before the blank line.
+3. Read the first line of dashes. This gives the number of columns.
+4. Read the rows.
+5. Read the second line of dashes.
+6. Read the column numbers.
+7. Read the ships.
+8. Close the file.
+Steps 2 through 7 are taken by read_puzzle, which bap_solve also calls
+to read a puzzle given as text.
+
+Anything before the first blank line is a header which is intended to
+contain explanatory text, but could be anything.
+
+*/
+
+int read_problem(          /* ARGUMENTS                    */
+ char * file_name,         /* name of file to read         */
+ struct bap_world * world) /* puzzle model, filled in here */
+{
+  const char * name SET_TO "read_problem";
+  FILE * in_port;
+  int result;   /* value returned by read_puzzle */
+
+  in_port SET_TO fopen(file_name, "r");
+  CHB((in_port IS NULL), "Could not open file");
+  result SET_TO read_puzzle(in_port, world);
+  fclose(in_port);
+  IFF(result);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_puzzle
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The port ends before the first blank line:
+     "File ends before first blank line".
+  2. After read_rows returns, the next line is not a line of dashes identical
+     to the first line of dashes: "Bad row or second line of dashes".
+  3. FIXED_SIZE is not 0 and the puzzle is not FIXED_SIZE by FIXED_SIZE:
+     "Puzzle is not the size bap was compiled for".
+  4. Any of the following functions returns ERROR:
+     make_branch
+     read_column_numbers
+     read_dashes
+     read_rows
+     read_ships
+     record_line
+     size_branch
+
+Called By:
+  read_problem
+  replay_trace
+  solve_request
+  start_session
+
+Side Effects: The puzzle in the format of a problem file (see
+read_problem) is read from in_port and stored. Once the size of the
+grid and the number of ships are known, the explanation, the list of
+guesses tried, and the path are made for them (see size_branch). The
+port is left open.
+
+*/
+
+int read_puzzle(           /* ARGUMENTS                    */
+ FILE * in_port,           /* port to read puzzle from     */
+ struct bap_world * world) /* puzzle model, filled in here */
+{
+  const char * name SET_TO "read_puzzle";
+  char dashes[LINE_SIZE];
+  char buffer[LINE_SIZE];
+  int row_length;
+
+  for (; ; )
+    {
+      CHB((fgets(buffer, LINE_SIZE, in_port) IS NULL),
+	  "File ends before first blank line");
+      if (buffer[0] IS '\n')
+	break;
+    }
+  IFF(read_dashes(in_port, dashes, &row_length, world));
+  IFF(read_rows(in_port, buffer, row_length, world));
+  CHB((strcmp(dashes, buffer) ISNT 0), "Bad row or second line of dashes");
+  CHB((FIXED_SIZE AND ((world->number_rows ISNT FIXED_SIZE) OR
+		       (world->number_cols ISNT FIXED_SIZE))),
+      "Puzzle is not the size bap was compiled for");
+  IFF(read_column_numbers(in_port, buffer, world));
+  IFF(read_ships(in_port, buffer, world));
+  world->undone SET_TO (world->number_cols + world->number_rows);
+  IFF(size_branch(world));
+  IFF(make_branch(&(world->logic), &(world->logic_strips),
+		  &(world->guesses_tried), &(world->path), world));
+  IFF(record_line("read problem", world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_row
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The row does not start with " |": "Bad problem row".
+  2. An illegal character is included in the row: "Bad character".
+  3. The number at the end of the row cannot be read: "Bad problem row".
+  4. The number at the end of the row is larger than the number of
+     places in the row: "Row count too big".
+  5. An X is used: "Cannot handle x yet".
+
+Called By:  read_rows
+
+Side Effects: This
+1. copies the row into world->squares
+2. sets the value of world->rows[row].aim
+3. adds one to world->number_rows.
+
+*/
+
+int read_row(              /* ARGUMENTS                     */
+ char * buffer,            /* buffer from which to read row */
+ struct bap_world * world) /* puzzle model                  */
+{
+  const char * name SET_TO "read_row";
+  int square_count;
+  int col;
+  int n;
+  char c;
+
+  world->rows[world->number_rows].dry SET_TO world->number_cols;
+  CHB(((buffer[0] ISNT ' ') OR (buffer[1] ISNT '|')), "Bad problem row");
+  for (col SET_TO 0; col < world->number_cols; col++)
+    {
+      c SET_TO buffer[2 + (2 * col)];
+      CHB(((c ISNT '+') AND
+	   (c ISNT '<') AND
+	   (c ISNT 'v') AND
+	   (c ISNT 'O') AND
+	   (c ISNT '>') AND
+	   (c ISNT '^') AND
+	   (c ISNT '.') AND
+	   (c ISNT ' ') AND
+	   (c ISNT 'X')), "Bad character");
+      CHB((c IS 'X'), "Cannot handle x yet");
+      if (col < (world->number_cols - 1))
+	CHB((buffer[3 + (2 * col)] ISNT ' '), "Bad character");
+      else
+	CHB((buffer[3 + (2 * col)] ISNT '|'), "Bad character");
+      IFF(set_square(world->number_rows, col, c, world));
+      if (c IS '.')
+	{
+	  world->cols[col].dry--;
+	  world->rows[world->number_rows].dry--;
+	}
+      else if (c ISNT ' ')
+	{
+	  world->cols[col].got++;
+	  world->rows[world->number_rows].got++;
+	}
+    }
+  n SET_TO sscanf((buffer + 2 + (2 * col)), "%d \n", &square_count);
+  CHB((n ISNT 1), "Bad problem row");
+  CHB((square_count > world->number_cols), "Row count too big");
+  world->rows[world->number_rows].aim SET_TO square_count;
+  world->number_rows++;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_rows
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The file ends while rows are being read: "File ends while reading rows".
+  2. The number of rows found is greater than MAX_NUMBER_ROWS:
+     "Too many rows".
+  3. make_block returns ERROR.
+  4. read_row returns ERROR.
+
+Called By:  read_puzzle
+
+Side Effects: This reads the rows of the problem and builds parts of
+the _world model. In verbose mode, this prints the number of rows.
+The line after the rows (the bottom row of dashes) is left in buffer.
+
+Notes:
+
+The row_length is set by read_dashes. When the bottom row of dashes is
+read, the string length is less than row_length, so the "for" loop
+reading rows is exited.
+
+The rows are read twice. The first time, they are only counted, so that
+the arrays of the world can be made for the size of the grid (see
+make_block) before any row is stored. If the grid is too big for the
+bit masks, world->bits is set to 0 here, before any square is set.
+
+*/
+
+int read_rows(             /* ARGUMENTS                 */
+ FILE * in_port,           /* port to file to read from */
+ char * buffer,            /* buffer to read rows into  */
+ int row_length,           /* length of a row           */
+ struct bap_world * world) /* puzzle model              */
+{
+  const char * name SET_TO "read_rows";
+  long start;              /* place in file of first row */
+  int number_rows;         /* number of rows in file     */
+  int row;
+  int col;
+
+  start SET_TO ftell(in_port);
+  for (number_rows SET_TO 0; ; number_rows++)
+    {
+      CHB((fgets(buffer, LINE_SIZE, in_port) IS NULL),
+	  "File ends while reading rows");
+      if (strlen(buffer) < row_length)
+	break;
+      CHB((number_rows IS MAX_NUMBER_ROWS), "Too many rows");
+    }
+  if ((number_rows > 64) OR (world->number_cols > 64))
+    world->bits SET_TO 0;
+  IFF(make_block(number_rows, world->number_cols, world));
+  fseek(in_port, start, SEEK_SET);
+  for (row SET_TO 0; row < number_rows; row++)
+    {
+      fgets(buffer, LINE_SIZE, in_port);
+      IFF(read_row(buffer, world));
+    }
+  fgets(buffer, LINE_SIZE, in_port);
+  if (world->print_all)
+    printf("%d rows\n", world->number_rows);
+  for (col SET_TO 0; col < world->number_cols; col++)
+    world->cols[col].dry SET_TO (world->cols[col].dry + world->number_rows);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_ships
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The file ends before the end line is read:
+     "File ends with no end marker".
+  2. The battleships line has bad format: "Bad battleships line".
+  3. The cruisers line has bad format: "Bad cruisers line".
+  4. The destroyers line has bad format: "Bad destroyers line".
+  5. The submarines line has bad format: "Bad submarines line".
+  6. The row count total is not the same as the number of ship parts:
+     "Bad row count total".
+  7. The column count total is not the same as the number of ship parts:
+     "Bad column count total".
+
+Called By:  read_puzzle
+
+Side Effects: This reads zero to four lines of ships, in order
+(battleships, cruisers, destroyers, submarines) and the "end" line. It
+also records the number of each type of ship.
+
+Setting ship numbers to zero should not be necessary, since it is done
+in init_world, but it is done here just to be sure.
+
+This will report an error if a ships line has bad format in any way,
+such as line spacing being incorrect (including extra spaces or tabs
+after the last ship on the line).
+
+In verbose mode, this prints the number of each type of ship.
+
+Notes:
+
+The first line after the column numbers must have nothing but a
+newline, and it has been read before this function is called.
+This starts reading on the second line after the column numbers
+and reads through lines representing ships in decreasing size order.
+Then it reads the line "end". There should be no blank lines before
+the "end" line. It does not matter what comes after the "end" line.
+
+This does not signal an error if there are no ships.
+
+*/
+
+int read_ships(            /* ARGUMENTS                 */
+ FILE * in_port,           /* port to file to read from */
+ char * buffer,            /* buffer to read ships into */
+ struct bap_world * world) /* puzzle model              */
+{
+  const char * name SET_TO "read_ships";
+  int n;
+  int sum_aim;
+  int sum_ship;
+
+  world->battleships_left SET_TO 0;
+  world->cruisers_left SET_TO 0;
+  world->destroyers_left SET_TO 0;
+  world->submarines_left_col SET_TO 0;
+  world->submarines_left_row SET_TO 0;
+  CHB((fgets(buffer, LINE_SIZE, in_port) IS NULL),
+      "File ends with no end marker");
+  for (n SET_TO 0; ; n SET_TO (n + 6))
+    {
+      if (strncmp((buffer + n), "  <++>", 6) IS 0)
+	world->battleships_left++;
+      else
+	break;
+    }
+  CHB(((n ISNT 0) AND (buffer[n] ISNT '\n')), "Bad battleships line");
+  if (world->print_all)
+    printf("%d battleships\n", world->battleships_left);
+  if (world->battleships_left ISNT 0)
+    {
+      CHB((fgets(buffer, LINE_SIZE, in_port) IS NULL),
+	  "File ends with no end marker");
+    }
+  for (n SET_TO 0; ; n SET_TO (n + 5))
+    {
+      if (strncmp((buffer + n), "  <+>", 5) IS 0)
+	world->cruisers_left++;
+      else
+	break;
+    }
+  CHB(((n ISNT 0) AND (buffer[n] ISNT '\n')), "Bad cruisers line");
+  if (world->print_all)
+    printf("%d cruisers\n", world->cruisers_left);
+  if (world->cruisers_left ISNT 0)
+    {
+      CHB((fgets(buffer, LINE_SIZE, in_port) IS NULL),
+	  "File ends with no end marker");
+    }
+  for (n SET_TO 0; ; n SET_TO (n + 4))
+    {
+      if (strncmp((buffer + n), "  <>", 4) IS 0)
+	world->destroyers_left++;
+      else
+	break;
+    }
+  CHB(((n ISNT 0) AND (buffer[n] ISNT '\n')), "Bad destroyers line");
+  if (world->print_all)
+    printf("%d destroyers\n", world->destroyers_left);
+  if (world->destroyers_left ISNT 0)
+    {
+      CHB((fgets(buffer, LINE_SIZE, in_port) IS NULL),
+	  "File ends with no end marker");
+    }
+  for (n SET_TO 0; ; n SET_TO (n + 3))
+    {
+      if (strncmp((buffer + n), "  O", 3) IS 0)
+	{
+	  world->submarines_left_col++;
+	  world->submarines_left_row++;
+	}
+      else
+	break;
+    }
+  CHB(((n ISNT 0) AND (buffer[n] ISNT '\n')), "Bad submarines line");
+  if (world->print_all)
+    printf("%d submarines\n", world->submarines_left_col);
+  if (world->submarines_left_col ISNT 0)
+    {
+      CHB((fgets(buffer, LINE_SIZE, in_port) IS NULL),
+	  "File ends with no end marker");
+    }
+  CHB((strncmp(buffer, "end", 3) ISNT 0), "File ends with no end marker");
+  sum_ship SET_TO
+    ((4 * world->battleships_left) +
+     (3 * world->cruisers_left) +
+     (2 * world->destroyers_left) +
+     (world->submarines_left_row));
+  sum_aim SET_TO 0;
+  for (n SET_TO 0; n < world->number_rows; n++)
+    sum_aim SET_TO (sum_aim + world->rows[n].aim);
+  CHB((sum_aim ISNT sum_ship), "Bad row count total");
+  sum_aim SET_TO 0;
+  for (n SET_TO 0; n < world->number_cols; n++)
+    sum_aim SET_TO (sum_aim + world->cols[n].aim);
+  CHB((sum_aim ISNT sum_ship), "Bad column count total");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_text
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The named file cannot be opened: "Could not open file".
+  2. There is no memory for the text: "Out of memory".
+
+Called By:
+  main
+  make_trace
+
+Side Effects: This mallocs a string holding the whole of the file named
+file_name and sets text to point to it. The caller frees it.
+
+*/
+
+int read_text(             /* ARGUMENTS                        */
+ char * file_name,         /* name of file to read             */
+ char ** text,             /* text of file, set here           */
+ struct bap_world * world) /* puzzle model, for messages       */
+{
+  const char * name SET_TO "read_text";
+  FILE * in_port;
+  long size;    /* number of characters in file */
+
+  in_port SET_TO fopen(file_name, "r");
+  CHB((in_port IS NULL), "Could not open file");
+  fseek(in_port, 0, SEEK_END);
+  size SET_TO ftell(in_port);
+  fseek(in_port, 0, SEEK_SET);
+  *text SET_TO (char *)malloc(size + 1);
+  if (*text ISNT NULL)
+    (*text)[fread(*text, 1, size, in_port)] SET_TO 0;
+  fclose(in_port);
+  CHB((*text IS NULL), "Out of memory");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_trace
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The port does not begin with the head of a trace, or ends before
+     the text of the puzzle does: "Not a trace".
+  2. There is no memory for the text: "Out of memory".
+
+Called By:
+  replay_trace
+  summarize_trace
+
+Side Effects: This reads the head of a trace (see make_trace) from
+in_port into head, and mallocs a string holding the text of the puzzle
+that follows it and sets text to point to it. The caller frees it. The
+port is left at the first record.
+
+*/
+
+int read_trace(            /* ARGUMENTS                         */
+ FILE * in_port,           /* port to trace file                */
+ struct trace_head * head, /* head of trace, read here          */
+ char ** text,             /* text of puzzle traced, set here   */
+ struct bap_world * world) /* puzzle model, for messages        */
+{
+  const char * name SET_TO "read_trace";
+  int got;      /* number of characters of text read */
+
+  *text SET_TO NULL;
+  CHB(((fread(head, sizeof(struct trace_head), 1, in_port) ISNT 1) OR
+       (memcmp(head->magic, TRACE_MAGIC, sizeof(head->magic)) ISNT 0) OR
+       (head->text_length < 0)), "Not a trace");
+  *text SET_TO (char *)malloc(head->text_length + 1);
+  CHB((*text IS NULL), "Out of memory");
+  got SET_TO (int)fread(*text, 1, head->text_length, in_port);
+  (*text)[got] SET_TO 0;
+  CHB((got ISNT head->text_length), "Not a trace");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* record_line
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no room for another line of explanation:
+     "Bug explanation too long".
+  2. print_bap or print_event returns ERROR.
+
+Called By:
+  dex_squares
+  extend_ends
+  finish_pure
+  pad_bap
+  read_puzzle
+
+Side Effects: If world->explain is set, a line of explanation with the
+given text and no rows or columns is recorded (see record_progress),
+and if world->print_all is set, the puzzle and the line are printed.
+
+*/
+
+int record_line(           /* ARGUMENTS                     */
+ char * text,              /* text of line, never changed   */
+ struct bap_world * world) /* puzzle model                  */
+{
+  const char * name SET_TO "record_line";
+  struct event * the_event; /* line of explanation being recorded */
+
+  if (world->explain)
+    {
+      CHB((world->logic_line IS world->logic_lines),
+	  "Bug explanation too long");
+      the_event SET_TO (world->logic + world->logic_line);
+      the_event->reason SET_TO text;
+      the_event->action SET_TO NULL;
+      the_event->first_strip SET_TO world->logic_strip;
+      the_event->number_rows SET_TO 0;
+      the_event->number_cols SET_TO 0;
+      if (world->print_all)
+	{
+	  IFF(print_bap(world));
+	  IFF(print_event(the_event, world));
+	  printf("\n");
+	}
+      world->logic_line++;
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* record_progress
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no room for another line of explanation:
+     "Bug explanation too long".
+  2. print_event returns ERROR.
+
+Called By:
+  assign_battleships
+  assign_cruisers
+  assign_destroyers
+  assign_submarines
+  dlx_answer
+  extend_horizontal
+  extend_vertical
+  fill_bap
+  insert_guess_col
+  insert_guess_row
+  place_battleships
+  place_cruisers
+  place_destroyers
+  try_cross_col_one
+  try_cross_row_one
+  try_full
+  try_full_but_one
+  try_full_but_two
+  try_square_blank
+
+Side Effects: If progress has been made and world->explain is set, a
+line of explanation is recorded, and if world->print_all is set, the
+puzzle and the line are printed.
+
+Notes:
+
+The line is not written out as text. An event pointing at the reason
+and action (which are never changed, so they are not copied) is put in
+world->logic, and the rows and columns in rows_in and cols_in are put
+in world->logic_strips. render_event makes the text when it is printed.
+
+*/
+
+int record_progress(       /* ARGUMENTS                     */
+ char * reason,            /* text giving reason for action */
+ char * action,            /* text describing action taken  */
+ struct bap_world * world) /* puzzle model                  */
+{
+  const char * name SET_TO "record_progress";
+  struct event * the_event; /* line of explanation being recorded */
+  int n;                    /* counter for rows_in and columns_in */
+
+  if ((world->progress ISNT 0) AND world->explain)
+    {
+      CHB(((world->logic_line IS world->logic_lines) OR
+	   ((world->logic_strip + world->number_in_rows +
+	     world->number_in_cols) > world->logic_room)),
+	  "Bug explanation too long");
+      the_event SET_TO (world->logic + world->logic_line);
+      the_event->reason SET_TO reason;
+      the_event->action SET_TO action;
+      the_event->first_strip SET_TO world->logic_strip;
+      the_event->number_rows SET_TO world->number_in_rows;
+      the_event->number_cols SET_TO world->number_in_cols;
+      for (n SET_TO 0; n < world->number_in_rows; n++)
+	world->logic_strips[world->logic_strip++] SET_TO world->rows_in[n];
+      for (n SET_TO 0; n < world->number_in_cols; n++)
+	world->logic_strips[world->logic_strip++] SET_TO world->cols_in[n];
+      if (world->print_all)
+	{
+	  print_bap(world);
+	  IFF(print_event(the_event, world));
+	  printf("\n");
+	}
+      world->logic_line++;
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* render_event
+
+Returned Value: int (OK)
+
+Called By:
+  find_hint
+  print_event
+
+Side Effects: This writes the text of a line of explanation into text,
+which must be world->logic_width characters long. The reason and the
+action are followed by the rows and then the columns listed, counting
+from 1, as in "blank cannot be ship: fill blank with water at crossing
+of row 3 and column 5 ". A line with no action is just the reason.
+
+*/
+
+int render_event(          /* ARGUMENTS                          */
+ struct event * the_event, /* line of explanation to write       */
+ char * text,              /* text of line, written here         */
+ struct bap_world * world) /* puzzle model                       */
+{
+  const char * name SET_TO "render_event";
+  int numb;     /* number of characters printed       */
+  int n;        /* counter for rows and columns       */
+  int * strips; /* rows and then columns listed       */
+  char * where; /* where to put next characters       */
+
+  strips SET_TO (world->logic_strips + the_event->first_strip);
+  where SET_TO text;
+  if (the_event->action IS NULL)
+    strcpy(where, the_event->reason);
+  else
+    {
+      numb SET_TO
+	sprintf(where, "%s: %s ", the_event->reason, the_event->action);
+      where SET_TO (where + numb);
+      if (the_event->number_rows > 0)
+	{
+	  sprintf(where, "row");
+	  where SET_TO (where + 3);
+	  numb SET_TO
+	    sprintf(where, ((the_event->number_rows > 1) ? "s " : " "));
+	  where SET_TO (where + numb);
+	  for (n SET_TO 0; n < the_event->number_rows; n++)
+	    {
+	      numb SET_TO sprintf(where, "%d ", (1 + strips[n]));
+	      where SET_TO (where + numb);
+	    }
+	}
+      if (the_event->number_cols > 0)
+	{
+	  if (the_event->number_rows > 0)
+	    {
+	      sprintf(where, "and ");
+	      where SET_TO (where + 4);
+	    }
+	  sprintf(where, "column");
+	  where SET_TO (where + 6);
+	  numb SET_TO
+	    sprintf(where, ((the_event->number_cols > 1) ? "s " : " "));
+	  where SET_TO (where + numb);
+	  for (n SET_TO 0; n < the_event->number_cols; n++)
+	    {
+	      numb SET_TO
+		sprintf(where, "%d ", (1 + strips[the_event->number_rows + n]));
+	      where SET_TO (where + numb);
+	    }
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* replay_trace
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The trace file cannot be opened: "Could not open trace".
+  2. read_trace returns ERROR.
+  3. Partial solutions are to be printed but the trace was made with
+     no explanation: "Trace has no explanation".
+  4. There is no memory for the trace: "Out of memory".
+  5. The text cannot be read as a port: "Could not read text".
+  6. read_puzzle returns ERROR.
+
+Called By:  main
+
+Side Effects: This opens the trace file named file_name, sets the
+options of the world that decide the search from the head of the trace
+(see make_trace), and reads the puzzle from the text in the trace, as
+read_problem reads a problem file. world->trace is made for replaying,
+so that as the puzzle is solved, trace_guess reads each record from the
+file and compares it with the guess tried, instead of writing it.
+
+Notes:
+
+The search is the same as the one traced as long as bap.c has not been
+changed in a way that changes the order of the guesses or what is
+found between them, so a replay checks that a change leaves the search
+alone. Only the times may differ.
+
+*/
+
+int replay_trace(          /* ARGUMENTS                  */
+ char * file_name,         /* name of trace file         */
+ struct bap_world * world) /* puzzle model, filled in here */
+{
+  const char * name SET_TO "replay_trace";
+  struct trace * trace;    /* trace made here                  */
+  struct trace_head head;  /* head of trace                    */
+  FILE * port;             /* port to trace file               */
+  FILE * in_port;          /* port reading text of puzzle      */
+  char * text;             /* text of puzzle                   */
+  int result;              /* value returned by read_trace or  */
+                           /* read_puzzle                      */
+
+  port SET_TO fopen(file_name, "rb");
+  CHB((port IS NULL), "Could not open trace");
+  result SET_TO read_trace(port, &head, &text, world);
+  if ((result ISNT OK) OR (world->print_all AND (head.explain IS 0)))
+    {
+      free(text);
+      fclose(port);
+    }
+  IFF(result);
+  CHB((world->print_all AND (head.explain IS 0)), "Trace has no explanation");
+  trace SET_TO (struct trace *)malloc(sizeof(struct trace));
+  if (trace IS NULL)
+    {
+      free(text);
+      fclose(port);
+    }
+  CHB((trace IS NULL), "Out of memory");
+  trace->differ SET_TO 0;
+  trace->nodes SET_TO 0;
+  trace->number_records SET_TO 0;
+  trace->port SET_TO port;
+  trace->replay SET_TO 1;
+  world->trace SET_TO trace;
+  world->bits SET_TO head.bits;
+  world->branch SET_TO head.branch;
+  world->explain SET_TO head.explain;
+  world->find_all SET_TO head.find_all;
+  world->in_place SET_TO head.in_place;
+  world->replace SET_TO head.replace;
+  world->rules SET_TO head.rules;
+  world->strategy SET_TO head.strategy;
+  world->table_megabytes SET_TO head.table_megabytes;
+  world->worklist SET_TO head.worklist;
+  in_port SET_TO fmemopen((void *)text, head.text_length, "r");
+  if (in_port IS NULL)
+    free(text);
+  CHB((in_port IS NULL), "Could not read text");
+  result SET_TO read_puzzle(in_port, world);
+  fclose(in_port);
+  free(text);
+  IFF(result);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* report_count
+
+Returned Value: int (OK)
+
+Called By:
+  main
+  run_pool
+
+Side Effects: This prints the number of answers counted (see the count
+argument of read_arguments) as one line that a program can read, for
+example:
+
+answers=1 limit=2
+
+The count is never more than the limit, since the search stops when it
+gets there. So with a limit of 2, "answers=1" means the puzzle has
+exactly one answer, "answers=2" that it has more than one, and
+"answers=0" that it has none.
+
+*/
+
+int report_count(          /* ARGUMENTS                  */
+ int answers,              /* number of answers counted  */
+ struct bap_world * world) /* puzzle model               */
+{
+  const char * name SET_TO "report_count";
+
+  printf("answers=%d limit=%d\n", answers, world->count);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* report_profile
+
+Returned Value: int (OK)
+
+Called By:  main
+
+Side Effects: If PROFILING is 1, this prints the counts made by
+profile_rule: for each rule, the number of calls, the number of calls
+that made progress (fires), and the total time in milliseconds, first
+over all depths of guessing and then for each depth at which the rule
+was called. If world->profile is PROFILE_JSON, the same counts are
+printed as one JSON object, with a "depths" list for each rule.
+Otherwise, they are printed as a table. If PROFILING is 0, this says
+that there are no counts.
+
+Notes:
+
+The last depth (PROFILE_DEPTHS - 1) includes all deeper ones.
+
+*/
+
+int report_profile(        /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "report_profile";
+  struct rule_count total;  /* counts for rule over all depths */
+  struct rule_count * count; /* counts for rule at one depth   */
+  int rule;
+  int depth;
+  int any;                  /* set to 1 once a depth is printed */
+
+  if (PROFILING IS 0)
+    printf("\nProfile: none (compile with -DBAP_PROFILE)\n");
+  else if (world->profile IS PROFILE_JSON)
+    printf("\n{\"rules\": [");
+  else
+    printf("\nProfile:\n%-20s %5s %12s %12s %12s\n",
+	   "rule", "depth", "calls", "fires", "ms");
+  for (rule SET_TO 0; ((PROFILING ISNT 0) AND (rule < NUMBER_RULES)); rule++)
+    {
+      total.calls SET_TO 0;
+      total.fires SET_TO 0;
+      total.nanoseconds SET_TO 0;
+      for (depth SET_TO 0; depth < PROFILE_DEPTHS; depth++)
+	{
+	  total.calls SET_TO (total.calls + rule_counts[rule][depth].calls);
+	  total.fires SET_TO (total.fires + rule_counts[rule][depth].fires);
+	  total.nanoseconds SET_TO (total.nanoseconds +
+				    rule_counts[rule][depth].nanoseconds);
+	}
+      if (world->profile IS PROFILE_JSON)
+	printf("%s\n  {\"rule\": \"%s\", \"calls\": %lld, \"fires\": %lld, "
+	       "\"ms\": %.3f, \"depths\": [",
+	       ((rule IS 0) ? "" : ","), rule_names[rule], total.calls,
+	       total.fires, (total.nanoseconds / 1e6));
+      else
+	printf("%-20s %5s %12lld %12lld %12.3f\n", rule_names[rule], "all",
+	       total.calls, total.fires, (total.nanoseconds / 1e6));
+      any SET_TO 0;
+      for (depth SET_TO 0; depth < PROFILE_DEPTHS; depth++)
+	{
+	  count SET_TO &(rule_counts[rule][depth]);
+	  if (count->calls IS 0)
+	    continue;
+	  if (world->profile IS PROFILE_JSON)
+	    printf("%s\n    {\"depth\": %d, \"calls\": %lld, \"fires\": %lld, "
+		   "\"ms\": %.3f}",
+		   (any ? "," : ""), depth, count->calls, count->fires,
+		   (count->nanoseconds / 1e6));
+	  else
+	    printf("%-20s %5d %12lld %12lld %12.3f\n", "", depth,
+		   count->calls, count->fires, (count->nanoseconds / 1e6));
+	  any SET_TO 1;
+	}
+      if (world->profile IS PROFILE_JSON)
+	printf("]}");
+    }
+  if ((PROFILING ISNT 0) AND (world->profile IS PROFILE_JSON))
+    printf("\n]}\n");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* report_table
+
+Returned Value: int (OK)
+
+Called By:  main
+
+Side Effects: This prints the size of the transposition table and the
+numbers of probes, hits, stores, and stores that pushed out another
+key, or says there is no table.
+
+*/
+
+int report_table(          /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "report_table";
+  struct table * table; /* transposition table */
+
+  table SET_TO world->table;
+  if (table IS NULL)
+    printf("\nTable: none\n");
+  else
+    {
+      printf("\nTable: %lld slots, %lld probes, %lld hits (%.1f%%), "
+	     "%lld stores, %lld replaced\n",
+	     table->number_entries, table->probes, table->hits,
+	     ((table->probes IS 0) ? 0.0 :
+	      ((100.0 * table->hits) / table->probes)),
+	     table->stores, table->replaced);
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* retract_move
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. No move has been made in the square: "No move in square".
+  2. A later move cannot be made again: "Bug move could not be made
+     again".
+  3. find_hint or undo_trail returns ERROR.
+
+Called By:  bap_retract_square
+
+Side Effects: This takes back the last move made in the square at the
+given row and column and fills in the hint with the next rule that
+sets squares (see find_hint). The trail is undone to the length it had before
+the move, which takes back the moves made after it too, and those are
+then made again in order, so the moves of the session are the same
+less the one taken back.
+
+Notes:
+
+Taking back a move only turns squares back to blank (or to X), so a
+later move, which was made on a square that was blank or X, can always
+be made again.
+
+*/
+
+int retract_move(              /* ARGUMENTS                      */
+ int row,                      /* row index of square            */
+ int col,                      /* column index of square         */
+ struct bap_session * session, /* session to take move back in   */
+ struct bap_hint * hint)       /* hint, filled in here           */
+{
+  const char * name SET_TO "retract_move";
+  struct bap_world * world;
+  struct move * the_move; /* move made again                 */
+  int last;               /* index of move taken back, or -1 */
+  int n;                  /* index of move made again        */
+
+  world SET_TO &(session->world);
+  for (last SET_TO (session->number_moves - 1); last >= 0; last--)
+    {
+      if ((session->moves[last].row IS row) AND
+	  (session->moves[last].col IS col))
+	break;
+    }
+  CHB((last < 0), "No move in square");
+  IFF(undo_trail(session->moves[last].mark, world));
+  for (n SET_TO (last + 1); n < session->number_moves; n++)
+    {
+      the_move SET_TO (session->moves + (n - 1));
+      *the_move SET_TO session->moves[n];
+      the_move->mark SET_TO world->trail->number_changes;
+      CHB((make_move(the_move->row, the_move->col, the_move->item,
+		     world) ISNT OK), "Bug move could not be made again");
+    }
+  session->number_moves--;
+  IFF(find_hint(session, hint));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* run_batch
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. list_batch returns ERROR.
+  2. make_table returns ERROR.
+  3. A thread cannot be started: "Cannot start thread".
+
+Called By:  main
+
+Side Effects: This solves every puzzle in the list named by list_name
+(see list_batch) in this one process, with world->jobs threads each
+solving one whole puzzle at a time (see work_batch). When all are done,
+this prints one line for each puzzle, in the order of the list, and
+then a line of totals, for example:
+
+pro/ftex2.pro solved answers=1 check=match ms=0.412 nodes=9 guesses=2
+total puzzles=109 solved=101 none=0 error=8 match=44 differ=1 ...
+
+The word after the file name is "solved", "none" if the puzzle has no
+answer, or "error" if the problem file could not be read. check is
+"match" if an answer found is the same as the one in the answer file of
+the puzzle (see read_answer), "differ" if none is, and "none" if there
+is no answer file. ms is the time in milliseconds taken to solve the
+puzzle, not counting reading its files. nodes is the number of times
+solve_problem was called and guesses is the number of guesses tried.
+The line of totals also gives the sum of the times (ms), the time from
+the first puzzle being started to the last being finished (wall_ms),
+and the number of threads.
+
+Notes:
+
+Unless it was turned off with --table=0, one transposition table is
+made and shared by all the puzzles, and by all the threads, which lock
+it since make_table marks it shared when there is more than one. Each
+puzzle starts its hash from a
+different number (see solve_job), so that states of different puzzles
+are not taken for one another.
+
+*/
+
+int run_batch(             /* ARGUMENTS                          */
+ char * list_name,         /* directory or file listing problems */
+ struct bap_world * world) /* puzzle model, holding the options  */
+{
+  const char * name SET_TO "run_batch";
+  struct batch the_batch;  /* batch of puzzles                     */
+  struct job * the_job;    /* job for one puzzle                   */
+  pthread_t threads[MAX_THREADS]; /* threads other than this one    */
+  struct timespec start;   /* time first puzzle started            */
+  struct timespec end;     /* time last puzzle finished            */
+  double total;            /* sum of solving times, in seconds     */
+  int counts[5];           /* solved, none, error, match, differ   */
+  int n;
+
+  the_batch.jobs SET_TO NULL;
+  the_batch.next SET_TO 0;
+  the_batch.number_jobs SET_TO 0;
+  the_batch.size_jobs SET_TO 0;
+  the_batch.world SET_TO world;
+  pthread_mutex_init(&(the_batch.lock), NULL);
+  IFF(list_batch(list_name, &the_batch, world));
+  if (world->table_megabytes > 0)
+    IFF(make_table(world));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (n SET_TO 1; n < world->jobs; n++)
+    {
+      CHB((pthread_create(&(threads[n]), NULL, run_batch_thread,
+			  &the_batch) ISNT 0),
+	  "Cannot start thread");
+    }
+  work_batch(&the_batch);
+  for (n SET_TO 1; n < world->jobs; n++)
+    {
+      pthread_join(threads[n], NULL);
+    }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  total SET_TO 0.0;
+  for (n SET_TO 0; n < 5; n++)
+    counts[n] SET_TO 0;
+  for (n SET_TO 0; n < the_batch.number_jobs; n++)
+    {
+      the_job SET_TO &(the_batch.jobs[n]);
+      printf("%s %s answers=%d check=%s ms=%.3f nodes=%lld guesses=%lld\n",
+	     the_job->file_name,
+	     ((the_job->status IS JOB_SOLVED) ? "solved" :
+	      (the_job->status IS JOB_NO_ANSWER) ? "none" : "error"),
+	     the_job->number_answers,
+	     ((the_job->answer IS NULL) ? "none" :
+	      the_job->matched ? "match" : "differ"),
+	     (1000.0 * the_job->seconds), the_job->nodes, the_job->guesses);
+      total SET_TO (total + the_job->seconds);
+      counts[the_job->status]++;
+      if (the_job->answer AND the_job->matched)
+	counts[3]++;
+      else if (the_job->answer)
+	counts[4]++;
+      free(the_job->file_name);
+      free(the_job->answer);
+    }
+  printf("total puzzles=%d solved=%d none=%d error=%d match=%d differ=%d "
+	 "ms=%.3f wall_ms=%.3f threads=%d\n",
+	 the_batch.number_jobs, counts[JOB_SOLVED], counts[JOB_NO_ANSWER],
+	 counts[JOB_ERROR], counts[3], counts[4], (1000.0 * total),
+	 ((1000.0 * (end.tv_sec - start.tv_sec)) +
+	  ((end.tv_nsec - start.tv_nsec) / 1000000.0)),
+	 world->jobs);
+  if (world->stats)
+    IFF(report_table(world));
+  free(the_batch.jobs);
+  pthread_mutex_destroy(&(the_batch.lock));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* run_batch_thread
+
+Returned Value: void * (NULL)
+
+Called By:  run_batch (by way of pthread_create)
+
+Side Effects: This is where each thread but the main thread starts when
+solving a batch of puzzles. It calls work_batch on the batch it is
+given.
+
+Notes:
+
+Like run_queue, this does not return int, because pthread_create
+requires a function that takes and returns void *.
+
+*/
+
+void * run_batch_thread( /* ARGUMENTS                      */
+ void * batch_pointer)   /* batch of puzzles, as a void *  */
+{
+  work_batch((struct batch *)batch_pointer);
+  return NULL;
+}
+
+/*************************************************************************/
+
+/* run_pool
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the pool or the first task: "Out of memory".
+  2. make_arena, make_branch, make_trail, or clone_bap returns ERROR.
+  3. A thread cannot be started: "Cannot start thread".
+  4. work_queue returns ERROR.
+  5. No answer is found, and answers are not being counted:
+     "Puzzle has no answer".
+  6. sort_answers returns ERROR.
+  7. print_bap returns ERROR.
+  8. explain_bap returns ERROR.
+  9. report_count returns ERROR.
+
+Called By:  main
+
+Side Effects: This solves the puzzle with world->jobs threads. A pool
+with one queue of tasks per thread is made, and a task holding a copy
+of the world is put on the first queue. The main thread works on the
+first queue and the other threads work on the others until every task
+is finished (see work_queue). Then the answers are printed.
+
+If all answers are wanted, they are printed in the order a single
+thread would have found them. Otherwise, the first answer found is
+printed, which need not be the answer a single thread would have found
+if the puzzle has more than one. If answers are being counted, only the
+count is printed (see report_count).
+
+Notes:
+
+Each thread is given its own arena and its own explanation, list of
+guesses tried, and path, which the task it is running uses as its
+branch (see run_task). If searching in place was requested, each
+thread is also given its own trail, since the trail is used by one
+world at a time.
+
+*/
+
+int run_pool(              /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "run_pool";
+  struct pool * the_pool; /* pool of threads made here  */
+  struct task * the_task; /* first task                 */
+  int n;
+
+  the_pool SET_TO (struct pool *)malloc(sizeof(struct pool));
+  CHB((the_pool IS NULL), "Out of memory");
+  pthread_mutex_init(&(the_pool->lock), NULL);
+  pthread_cond_init(&(the_pool->wake), NULL);
+  the_pool->answers SET_TO NULL;
+  the_pool->cancel SET_TO 0;
+  the_pool->find_all SET_TO world->find_all;
+  the_pool->number_answers SET_TO 0;
+  the_pool->number_threads SET_TO world->jobs;
+  the_pool->pending SET_TO 0;
+  the_pool->size_answers SET_TO 0;
+  for (n SET_TO 0; n < the_pool->number_threads; n++)
+    {
+      the_pool->queues[n].first SET_TO 0;
+      the_pool->queues[n].number_tasks SET_TO 0;
+      the_pool->queues[n].pool SET_TO the_pool;
+      the_pool->queues[n].trail SET_TO NULL;
+      the_pool->queues[n].worker SET_TO n;
+      IFF(make_arena(&(the_pool->queues[n].arena), world));
+      IFF(make_branch(&(the_pool->queues[n].logic),
+		      &(the_pool->queues[n].logic_strips),
+		      &(the_pool->queues[n].guesses_tried),
+		      &(the_pool->queues[n].path), world));
+      if (world->in_place)
+	IFF(make_trail(&(the_pool->queues[n].trail), world));
+    }
+  world->pool SET_TO the_pool;
+  the_task SET_TO (struct task *)malloc(sizeof(struct task));
+  CHB((the_task IS NULL), "Out of memory");
+  IFF(clone_bap(&(the_task->world), world));
+  the_task->has_guess SET_TO 0;
+  the_pool->queues[0].tasks[0] SET_TO the_task;
+  the_pool->queues[0].number_tasks SET_TO 1;
+  the_pool->pending SET_TO 1;
+  for (n SET_TO 1; n < the_pool->number_threads; n++)
+    {
+      CHB((pthread_create(&(the_pool->queues[n].thread), NULL, run_queue,
+			  &(the_pool->queues[n])) ISNT 0),
+	  "Cannot start thread");
+    }
+  IFF(work_queue(&(the_pool->queues[0])));
+  for (n SET_TO 1; n < the_pool->number_threads; n++)
+    {
+      pthread_join(the_pool->queues[n].thread, NULL);
+    }
+  if (world->count)
+    IFF(report_count(the_pool->number_answers, world));
+  else
+    {
+      CHB((the_pool->number_answers IS 0), "Puzzle has no answer");
+      if (the_pool->find_all)
+	IFF(sort_answers(the_pool));
+      for (n SET_TO 0; n < the_pool->number_answers; n++)
+	{
+	  IFF(print_bap(the_pool->answers[n]));
+	  IFF(explain_bap(the_pool->answers[n]));
+	  free_bap(the_pool->answers[n]);
+	  free(the_pool->answers[n]);
+	}
+    }
+  for (n SET_TO 0; n < the_pool->number_threads; n++)
+    {
+      free_arena(the_pool->queues[n].arena);
+      free(the_pool->queues[n].logic);
+      free(the_pool->queues[n].guesses_tried);
+      free(the_pool->queues[n].path);
+      if (the_pool->queues[n].trail)
+	free(the_pool->queues[n].trail->changes);
+      free(the_pool->queues[n].trail);
+    }
+  free(the_pool->answers);
+  pthread_cond_destroy(&(the_pool->wake));
+  pthread_mutex_destroy(&(the_pool->lock));
+  free(the_pool);
+  world->pool SET_TO NULL;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* run_queue
+
+Returned Value: void * (NULL)
+
+Called By:  run_pool (by way of pthread_create)
+
+Side Effects: This is where each thread but the main thread starts. It
+calls work_queue on the queue it is given.
+
+Notes:
+
+This is the one function that does not return int, because
+pthread_create requires a function that takes and returns void *.
+
+*/
+
+void * run_queue(       /* ARGUMENTS                     */
+ void * queue_pointer)  /* queue of thread, as a void *  */
+{
+  work_queue((struct queue *)queue_pointer);
+  return NULL;
+}
+
+/*************************************************************************/
+
+/* run_rules
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. One of the following functions returns ERROR:
+     assign_battleships, assign_cruisers, assign_destroyers,
+     assign_submarines, dex_squares, extend_middles, fill_bap,
+     locate_ships, mark_dones, place_battleships, place_cruisers,
+     place_destroyers, try_cross, try_full, try_full_but_one,
+     try_full_but_two, try_square_blank, verify_squares.
+
+Called By:
+  find_hint
+  solve_problem
+
+Side Effects: This goes down the list of things to try once (see
+solve_problem), stopping at the first rule that makes progress, and
+sets *fired to that rule. If no rule makes progress, world->progress is
+left 0 and *fired is the last rule run. If a rule returns ERROR, *fired
+is that rule.
+
+Notes:
+
+verify_squares, locate_ships, and mark_dones are always run together,
+and if any of them makes progress, *fired is RULE_MARK_DONES.
+
+*/
+
+int run_rules(             /* ARGUMENTS                          */
+ int * fired,              /* rule that made progress, set here  */
+ struct bap_world * world) /* puzzle model                       */
+{
+  const char * name SET_TO "run_rules";
+
+  *fired SET_TO RULE_VERIFY_SQUARES;
+  RUN_RULE(RULE_VERIFY_SQUARES, verify_squares(world));
+  *fired SET_TO RULE_LOCATE_SHIPS;
+  RUN_RULE(RULE_LOCATE_SHIPS, locate_ships(world));
+  *fired SET_TO RULE_MARK_DONES;
+  RUN_RULE(RULE_MARK_DONES, mark_dones(world));
+  if (world->progress)
+    return OK;
+  *fired SET_TO RULE_FILL_BAP;
+  RUN_RULE(RULE_FILL_BAP, fill_bap(world));
+  if (world->progress)
+    return OK;
+  *fired SET_TO RULE_EXTEND_MIDDLES;
+  RUN_RULE(RULE_EXTEND_MIDDLES, extend_middles(world));
+  if (world->progress)
+    return OK;
+  *fired SET_TO RULE_DEX_SQUARES;
+  RUN_RULE(RULE_DEX_SQUARES, dex_squares(world));
+  if (world->progress)
+    return OK;
+  *fired SET_TO RULE_TRY_FULL;
+  RUN_RULE(RULE_TRY_FULL, try_full(world));
+  if (world->progress)
+    return OK;
+  *fired SET_TO RULE_TRY_FULL_BUT_ONE;
+  RUN_RULE(RULE_TRY_FULL_BUT_ONE, try_full_but_one(world));
+  if (world->progress)
+    return OK;
+  if (world->battleships_left)
+    {
+      *fired SET_TO RULE_ASSIGN_BATTLESHIPS;
+      RUN_RULE(RULE_ASSIGN_BATTLESHIPS, assign_battleships(world));
+      if (world->progress)
+	return OK;
+    }
+  if (world->battleships_ass)
+    {
+      *fired SET_TO RULE_PLACE_BATTLESHIPS;
+      RUN_RULE(RULE_PLACE_BATTLESHIPS, place_battleships(world));
+      if (world->progress)
+	return OK;
+    }
+  if (world->cruisers_left)
+    {
+      *fired SET_TO RULE_ASSIGN_CRUISERS;
+      RUN_RULE(RULE_ASSIGN_CRUISERS, assign_cruisers(world));
+      if (world->progress)
+	return OK;
+    }
+  if (world->cruisers_ass)
+    {
+      *fired SET_TO RULE_PLACE_CRUISERS;
+      RUN_RULE(RULE_PLACE_CRUISERS, place_cruisers(world));
+      if (world->progress)
+	return OK;
+    }
+  if (world->destroyers_left)
+    {
+      *fired SET_TO RULE_ASSIGN_DESTROYERS;
+      RUN_RULE(RULE_ASSIGN_DESTROYERS, assign_destroyers(world));
+      if (world->progress)
+	return OK;
+    }
+  if (world->destroyers_ass)
+    {
+      *fired SET_TO RULE_PLACE_DESTROYERS;
+      RUN_RULE(RULE_PLACE_DESTROYERS, place_destroyers(world));
+      if (world->progress)
+	return OK;
+    }
+  *fired SET_TO RULE_ASSIGN_SUBMARINES;
+  RUN_RULE(RULE_ASSIGN_SUBMARINES, assign_submarines(world));
+  if (world->progress)
+    return OK;
+  *fired SET_TO RULE_TRY_SQUARE_BLANK;
+  RUN_RULE(RULE_TRY_SQUARE_BLANK, try_square_blank(world));
+  if (world->progress)
+    return OK;
+  *fired SET_TO RULE_TRY_FULL_BUT_TWO;
+  RUN_RULE(RULE_TRY_FULL_BUT_TWO, try_full_but_two(world));
+  if (world->progress)
+    return OK;
+  *fired SET_TO RULE_TRY_CROSS;
+  RUN_RULE(RULE_TRY_CROSS, try_cross(world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* run_task
+
+Returned Value: int (OK)
+
+Called By:  work_queue
+
+Side Effects: This inserts the guess of the task (if it has one) into
+the world of the task and calls solve_problem on that world. The task
+is freed before returning.
+
+The explanation, list of guesses tried, and path of the task are
+copied into those of the thread, and the world of the task is pointed
+at them, so that the branch below the task has room to grow. The world
+is also given the arena and trail of the thread, both emptied first.
+
+Notes:
+
+Any answers are saved by solve_problem (see save_answer), so ERROR from
+solve_problem means only that this branch of the search found none, and
+it is not passed on. Inserting a guess fails only if there is a bug,
+which insert_guess_row or insert_guess_col will already have reported.
+
+*/
+
+int run_task(                /* ARGUMENTS              */
+ struct queue * the_queue,   /* queue of thread        */
+ struct task * the_task)     /* task to run            */
+{
+  const char * name SET_TO "run_task";
+  struct bap_world * world; /* world of task */
+  struct arena_mark empty;  /* mark of empty arena */
+  int result;
+  int n;
+
+  world SET_TO &(the_task->world);
+  memcpy(the_queue->logic, world->logic,
+	 (world->logic_line * sizeof(struct event)));
+  memcpy(the_queue->logic_strips, world->logic_strips,
+	 (world->logic_strip * sizeof(int)));
+  copy_guesses(the_queue->guesses_tried, world->guesses_tried,
+	       world->number_guesses_tried);
+  for (n SET_TO 0; n < world->depth; n++)
+    the_queue->path[n] SET_TO world->path[n];
+  free(world->logic);
+  free(world->guesses_tried);
+  free(world->path);
+  world->logic SET_TO the_queue->logic;
+  world->logic_strips SET_TO the_queue->logic_strips;
+  world->guesses_tried SET_TO the_queue->guesses_tried;
+  world->path SET_TO the_queue->path;
+  world->arena SET_TO the_queue->arena;
+  empty.chunk SET_TO world->arena->first;
+  empty.used SET_TO 0;
+  arena_release(&empty, world);
+  world->worker SET_TO the_queue->worker;
+  world->trail SET_TO the_queue->trail;
+  if (world->trail)
+    world->trail->number_changes SET_TO 0;
+  result SET_TO OK;
+  if (the_task->has_guess AND the_task->the_guess.in_row)
+    result SET_TO insert_guess_row(&(the_task->the_guess), world);
+  else if (the_task->has_guess)
+    result SET_TO insert_guess_col(&(the_task->the_guess), world);
+  if (result IS OK)
+    solve_problem(world);
+  free(world->block);
+  free(the_task);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* save_answer
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the answer or for a longer list of answers:
+     "Out of memory".
+  2. clone_bap returns ERROR.
+
+Called By:  solve_problem
+
+Side Effects: This saves a copy of the solved world in the list of
+answers of the pool, making the list longer if it is full. If only one
+answer is wanted, the search is cancelled, and answers found by other
+threads before they notice are not saved.
+
+When counting answers (world->count is not 0), nothing is saved. The
+answer is only counted, and once world->count have been, the search is
+cancelled and no more are counted.
+
+*/
+
+int save_answer(           /* ARGUMENTS                 */
+ struct bap_world * world) /* puzzle model, solved      */
+{
+  const char * name SET_TO "save_answer";
+  struct bap_world * answer;   /* copy of world to save        */
+  struct bap_world ** answers; /* longer list of answers       */
+  struct pool * the_pool;      /* pool of threads              */
+  int result;                  /* set to ERROR if list not made longer */
+
+  the_pool SET_TO world->pool;
+  answer SET_TO NULL;
+  if (world->count IS 0)
+    {
+      answer SET_TO (struct bap_world *)malloc(sizeof(struct bap_world));
+      CHB((answer IS NULL), "Out of memory");
+      IFF(clone_bap(answer, world));
+    }
+  result SET_TO OK;
+  pthread_mutex_lock(&(the_pool->lock));
+  if (world->count)
+    {
+      if (the_pool->number_answers < world->count)
+	the_pool->number_answers++;
+      if (the_pool->number_answers IS world->count)
+	__atomic_store_n(&(the_pool->cancel), 1, __ATOMIC_RELEASE);
+    }
+  else if (the_pool->number_answers IS the_pool->size_answers)
+    {
+      answers SET_TO (struct bap_world **)
+	realloc(the_pool->answers,
+		((2 * the_pool->size_answers) + 16) *
+		sizeof(struct bap_world *));
+      if (answers IS NULL)
+	result SET_TO ERROR;
+      else
+	{
+	  the_pool->answers SET_TO answers;
+	  the_pool->size_answers SET_TO ((2 * the_pool->size_answers) + 16);
+	}
+    }
+  if ((result IS OK) AND answer AND
+      (the_pool->find_all OR (the_pool->number_answers IS 0)))
+    {
+      the_pool->answers[the_pool->number_answers++] SET_TO answer;
+      answer SET_TO NULL;
+    }
+  if (the_pool->find_all IS 0)
+    __atomic_store_n(&(the_pool->cancel), 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&(the_pool->lock));
+  if (answer)
+    {
+      free_bap(answer);
+      free(answer);
+    }
+  CHB((result ISNT OK), "Out of memory");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* scramble_key
+
+Returned Value: int (OK)
+
+Called By:
+  random_index
+  solve_job
+  table_key
+  zobrist_key
+
+Side Effects: This replaces *key with a number that looks random but is
+always the same for the same *key. Numbers that differ in one bit give
+numbers that differ in about half their bits.
+
+Notes:
+
+This is the finishing step of the splitmix64 generator.
+
+*/
+
+int scramble_key(          /* ARGUMENTS              */
+ unsigned long long * key) /* number to scramble     */
+{
+  const char * name SET_TO "scramble_key";
+  unsigned long long z;
+
+  z SET_TO (*key + 0x9E3779B97F4A7C15ULL);
+  z SET_TO ((z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL);
+  z SET_TO ((z ^ (z >> 27)) * 0x94D049BB133111EBULL);
+  *key SET_TO (z ^ (z >> 31));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* serve_bap
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The name of the socket is too long: "Socket name too long".
+  2. The socket cannot be made, bound to the name, or listened on:
+     "Could not make socket".
+  3. A connection cannot be accepted or opened as ports:
+     "Could not accept connection".
+  4. fill_request returns ERROR.
+  5. Serving standard input, serve_port returns ERROR.
+
+Called By:  main
+
+Side Effects: This serves puzzles, solving each one sent to it and
+writing one line saying how it came out (see serve_port and
+serve_request), with the options given to read_arguments. If place is
+"-", the puzzles are read from standard input and the lines written to
+standard output until standard input ends or a request of length 0 is
+read. Otherwise, place is the name of a Unix socket made here, and
+the connections made to it are served one at a time until a request
+of length 0 is read. The socket is removed before this returns.
+
+Notes:
+
+A socket left behind by a server that did not finish is removed before
+the new one is made, but no other kind of file is. An error in a
+connection (such as a bad length) ends only that connection, so one
+client sending something wrong does not stop the server. SIGPIPE is
+ignored so that a client that goes away before reading its lines does
+not either.
+
+*/
+
+int serve_bap(             /* ARGUMENTS                          */
+ char * place,             /* name of socket, or "-" for stdin   */
+ struct bap_world * world) /* puzzle model, holding arguments    */
+{
+  const char * name SET_TO "serve_bap";
+  struct server server1;
+  struct server * the_server;
+  struct sockaddr_un address; /* address of socket                 */
+  struct stat status;         /* status of file named place        */
+  int listener;               /* socket connections are made to    */
+  int connection;             /* socket of one connection          */
+  FILE * in_port;             /* port reading connection           */
+  FILE * out_port;            /* port writing connection           */
+  int stop;                   /* set to 1 when request of 0 read   */
+  int result;                 /* value returned by serve_port      */
+
+  the_server SET_TO &server1;
+  the_server->arena SET_TO NULL;
+  the_server->number_served SET_TO 0;
+  the_server->room SET_TO 0;
+  the_server->text SET_TO NULL;
+  the_server->trail SET_TO NULL;
+  IFF(fill_request(&(the_server->request), world));
+  if (strcmp(place, "-") IS 0)
+    result SET_TO serve_port(stdin, stdout, the_server, &stop, world);
+  else
+    {
+      CHB((strlen(place) >= sizeof(address.sun_path)),
+	  "Socket name too long");
+      if ((stat(place, &status) IS 0) AND S_ISSOCK(status.st_mode))
+	unlink(place);
+      listener SET_TO socket(AF_UNIX, SOCK_STREAM, 0);
+      CHB((listener < 0), "Could not make socket");
+      memset(&address, 0, sizeof(address));
+      address.sun_family SET_TO AF_UNIX;
+      strcpy(address.sun_path, place);
+      CHB(((bind(listener, (struct sockaddr *)&address,
+		 sizeof(address)) ISNT 0) OR
+	   (listen(listener, 8) ISNT 0)), "Could not make socket");
+      signal(SIGPIPE, SIG_IGN);
+      for (stop SET_TO 0; NOT stop; )
+	{
+	  connection SET_TO accept(listener, NULL, NULL);
+	  CHB((connection < 0), "Could not accept connection");
+	  in_port SET_TO fdopen(connection, "r");
+	  out_port SET_TO fdopen(dup(connection), "w");
+	  CHB(((in_port IS NULL) OR (out_port IS NULL)),
+	      "Could not accept connection");
+	  serve_port(in_port, out_port, the_server, &stop, world);
+	  fclose(in_port);
+	  fclose(out_port);
+	}
+      close(listener);
+      unlink(place);
+      result SET_TO OK;
+    }
+  free(the_server->text);
+  if (the_server->arena)
+    free_arena(the_server->arena);
+  if (the_server->trail)
+    free(the_server->trail->changes);
+  free(the_server->trail);
+  IFF(result);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* serve_port
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. A line giving the length of a request is not a number from 0 to
+     the largest a puzzle may need: "Bad length of request".
+  2. There is no memory for the text: "Out of memory".
+  3. The port ends before the text of a request does:
+     "Request ends early".
+  4. serve_request returns ERROR.
+
+Called By:  serve_bap
+
+Side Effects: This reads requests from in_port until it ends or a
+request of length 0 is read, and writes one line to out_port for each
+(see serve_request), flushing it at once so that a client waiting for
+it gets it. *stop is set to 1 if a request of length 0 is read, and to
+0 otherwise.
+
+A request is a line giving the length in bytes of the text of a puzzle
+followed by exactly that many bytes of text, in the format of a problem
+file, for example:
+
+449
+Standard Battleships
+...
+end
+
+The text of the server is made longer as needed and kept for the next
+request.
+
+*/
+
+int serve_port(              /* ARGUMENTS                         */
+ FILE * in_port,             /* port to read requests from        */
+ FILE * out_port,            /* port to write lines to            */
+ struct server * the_server, /* server, kept between requests     */
+ int * stop,                 /* set here to 1 if server to stop   */
+ struct bap_world * world)   /* puzzle model, for messages        */
+{
+  const char * name SET_TO "serve_port";
+  char header[TEXT_SIZE]; /* line giving length of request */
+  long length;            /* length of text of request     */
+  char * text;            /* longer text                   */
+
+  *stop SET_TO 0;
+  for (; ; )
+    {
+      if (fgets(header, TEXT_SIZE, in_port) IS NULL)
+	break;
+      CHB(((sscanf(header, "%ld", &length) ISNT 1) OR (length < 0) OR
+	   (length > ((long)LINE_SIZE * (MAX_NUMBER_ROWS + 8)))),
+	  "Bad length of request");
+      if (length IS 0)
+	{
+	  *stop SET_TO 1;
+	  break;
+	}
+      if (length >= the_server->room)
+	{
+	  text SET_TO (char *)realloc(the_server->text, length + 1);
+	  CHB((text IS NULL), "Out of memory");
+	  the_server->text SET_TO text;
+	  the_server->room SET_TO (length + 1);
+	}
+      CHB((fread(the_server->text, 1, length, in_port) ISNT (size_t)length),
+	  "Request ends early");
+      the_server->text[length] SET_TO 0;
+      IFF(serve_request(the_server, out_port, world));
+      fflush(out_port);
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* serve_request
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. arena_release returns ERROR.
+
+Called By:  serve_port
+
+Side Effects: This solves the puzzle in the text of the server, as the
+request of the server says (see solve_result), and writes one line to
+out_port saying how it came out, for example:
+
+1 solved answers=1 us=41.2 nodes=3 guesses=2 rows=6 cols=6 answer=...
+
+The number first counts the requests served. The word after it is
+"solved", "none" if the puzzle has no answer, or "error" if it could
+not be read or solved, in which case the line ends with the message
+instead of the answer. us is the time taken to solve the puzzle in
+microseconds. The answer is the squares of the first answer found, row
+by row, with no breaks between rows.
+
+Notes:
+
+The world the puzzle is solved in is set up here by init_world, and is
+given the arena and the trail of the world of the last puzzle, so that
+they are not made again. The arena is emptied first in case a search
+that ended in an error left something in it (as in generate_count).
+A puzzle that fails to be solved is reported in its line, so this does
+not return ERROR for it.
+
+*/
+
+int serve_request(           /* ARGUMENTS                         */
+ struct server * the_server, /* server, with text of puzzle       */
+ FILE * out_port,            /* port to write line to             */
+ struct bap_world * world)   /* puzzle model, for messages        */
+{
+  const char * name SET_TO "serve_request";
+  struct bap_world work1;    /* world puzzle is solved in         */
+  struct bap_result result;  /* how solving came out              */
+  struct arena_mark empty;   /* mark of empty arena               */
+  struct timespec start;     /* time solving started              */
+  struct timespec end;       /* time solving finished             */
+  int n;
+
+  init_world(&work1);
+  work1.arena SET_TO the_server->arena;
+  work1.trail SET_TO the_server->trail;
+  if (work1.arena ISNT NULL)
+    {
+      empty.chunk SET_TO work1.arena->first;
+      empty.used SET_TO 0;
+      IFF(arena_release(&empty, &work1));
+    }
+  the_server->request.text SET_TO the_server->text;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  solve_result(&(the_server->request), &result, &work1);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  the_server->arena SET_TO work1.arena;
+  the_server->trail SET_TO work1.trail;
+  the_server->number_served++;
+  fprintf(out_port, "%d %s answers=%d us=%.1f nodes=%lld guesses=%lld",
+	  the_server->number_served,
+	  ((result.status IS BAP_SOLVED) ? "solved" :
+	   (result.status IS BAP_NO_ANSWER) ? "none" : "error"),
+	  result.number_answers,
+	  ((1000000.0 * (end.tv_sec - start.tv_sec)) +
+	   ((end.tv_nsec - start.tv_nsec) / 1000.0)),
+	  result.nodes, result.guesses);
+  if (result.status IS BAP_SOLVED)
+    {
+      fprintf(out_port, " rows=%d cols=%d answer=", result.number_rows,
+	      result.number_cols);
+      for (n SET_TO 0; n < (result.number_rows * result.number_cols); n++)
+	fputc(result.answer[n], out_port);
+    }
+  else if (result.status IS BAP_ERROR)
+    fprintf(out_port, " message=%s", result.message);
+  fputc('\n', out_port);
+  bap_free_result(&result);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* set_square
+
+Returned Value: int (OK)
+
+Called By:
+  dex_square
+  dlx_answer
+  enx_square
+  finish_pure
+  generate_give
+  insert_guess_square
+  make_water
+  read_row
+  undo_trail
+
+Side Effects: This puts the given character in the square at the given
+row and column and, if world->bits is 1, updates the bit masks for the
+row and column to match. If there is a transposition table, the hash of the squares is
+updated too, by taking out the key of the old character and putting in
+the key of the new one. The rows and columns through the square and
+beside it are touched (see touch_strips), since the rules looking at
+them read the square.
+
+Notes:
+
+Every change to a square after init_world must be made by calling
+this, or the bit masks, the hash, and the worklist will be wrong.
+
+*/
+
+int set_square(            /* ARGUMENTS                     */
+ int row,                  /* row index of square           */
+ int col,                  /* column index of square        */
+ char item,                /* character to put in square    */
+ struct bap_world * world) /* puzzle model                  */
+{
+  const char * name SET_TO "set_square";
+  unsigned long long row_bit; /* bit for col in masks for row */
+  unsigned long long col_bit; /* bit for row in masks for col */
+  unsigned long long key;     /* Zobrist key of old or new item */
+
+  if (world->table)
+    {
+      IFF(zobrist_key(row, col, world->squares[row][col], &key));
+      world->hash SET_TO (world->hash ^ key);
+      IFF(zobrist_key(row, col, item, &key));
+      world->hash SET_TO (world->hash ^ key);
+    }
+  world->squares[row][col] SET_TO item;
+  IFF(touch_strips((row - 1), (row + 1), (col - 1), (col + 1), world));
+  if (world->bits)
+    {
+      row_bit SET_TO (1ULL << col);
+      col_bit SET_TO (1ULL << row);
+      world->ship_rows[row] SET_TO (world->ship_rows[row] & ~row_bit);
+      world->water_rows[row] SET_TO (world->water_rows[row] & ~row_bit);
+      world->ship_cols[col] SET_TO (world->ship_cols[col] & ~col_bit);
+      world->water_cols[col] SET_TO (world->water_cols[col] & ~col_bit);
+      if (item IS '.')
+	{
+	  world->water_rows[row] SET_TO (world->water_rows[row] | row_bit);
+	  world->water_cols[col] SET_TO (world->water_cols[col] | col_bit);
+	}
+      else if (item ISNT ' ')
+	{
+	  world->ship_rows[row] SET_TO (world->ship_rows[row] | row_bit);
+	  world->ship_cols[col] SET_TO (world->ship_cols[col] | col_bit);
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* ship_covers_col
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. ship_fits_col_row returns ERROR.
+
+Called By:  try_square_blank
+
+Side Effects: This tries to fit a ship of the given size into the given
+column, covering the square in the given row, without creating any
+illegal conditions. If it succeeds, it sets *cover to 1. Otherwise,
+it sets *cover to 0.
+
+*/
+
+int ship_covers_col(       /* ARGUMENTS                 */
+ int row,                  /* index of row of square    */
+ int col,                  /* index of column of square */
+ int size,                 /* size of ship              */
+ int * cover,              /* set here                  */
+ struct bap_world * world) /* puzzle model              */
+{
+  const char * name SET_TO "ship_covers_col";
+  int start;
+  int stop;
+  int n;
+  int ys;
+
+  start SET_TO (row - (size - 1));
+  if (start < 0)
+    start SET_TO 0;
+  stop SET_TO (row + 1);
+  if (stop > (world->number_rows - (size - 1)))
+    stop SET_TO (world->number_rows - (size - 1));
+  for (n SET_TO start; n < stop; n++)
+    {
+      IFF(ship_fits_col_row(col, n, size, &ys, cover, world));
+      if (ys + world->cols[col].got > world->cols[col].aim)
+	*cover SET_TO 0;
+      if (*cover)
+	break;
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* ship_covers_row
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. ship_fits_row_col returns ERROR.
+
+Called By:  try_square_blank
+
+Side Effects: This tries to fit a ship of the given size into the given
+row, covering the square in the given column, without creating any
+illegal conditions. If it succeeds, it sets *cover to 1. Otherwise,
+it sets *cover to 0.
+
+Notes:
+
+If there are not enough columns for a ship of the given size to fit,
+this fails. Might add a check when reading that there are at least
+four rows and four columns.
+
+*/
+
+int ship_covers_row(       /* ARGUMENTS                 */
+ int row,                  /* index of row of square    */
+ int col,                  /* index of column of square */
+ int size,                 /* size of ship              */
+ int * cover,              /* set here                  */
  struct bap_world * world) /* puzzle model              */
 {
-  const char * name SET_TO "read_ships";
-  int n;
-  int sum_aim;
-  int sum_ship;
+  const char * name SET_TO "ship_covers_row";
+  int start;
+  int stop;
+  int k;
+  int ys;
+
+  start SET_TO (col - (size - 1));
+  if (start < 0)
+    start SET_TO 0;
+  stop SET_TO (col + 1);
+  if (stop > (world->number_cols - (size - 1)))
+    stop SET_TO (world->number_cols - (size - 1));
+  for (k SET_TO start; k < stop; k++)
+    {
+      IFF(ship_fits_row_col(row, k, size, &ys, cover, world));
+      if (ys + world->rows[row].got > world->rows[row].aim)
+	*cover SET_TO 0;
+      if (*cover)
+	break;
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* ship_fits_col
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. ship_fits_col_row returns ERROR.
+
+Called By:
+  assign_battleships
+  assign_cruisers
+  assign_destroyers
+  assign_submarines_cols
+
+Side Effects: This sets *fits to the number of ships of a given size
+that can fit in a column in addition to the ones of that size already
+located there.
+
+Notes:
+
+See ship_fits_row. This is analogous.
+
+*/
+
+int ship_fits_col(         /* ARGUMENTS                         */
+ int col,                  /* index of column being checked     */
+ int size,                 /* size of ship                      */
+ int * fits,               /* set here to number that fit newly */
+ struct bap_world * world) /* puzzle model                      */
+{
+  const char * name SET_TO "ship_fits_col";
+  int row;
+  int rows;
+  int is_legal;
+  int ys;       /* number of additional ship parts in column from one ship  */
+  int spare;    /* number of ship parts column may still get                */
+  int b;        /* number of ship parts that may be added, in most          */
+  int most[MAX_TEST][MAX_NUMBER_ROWS + 1]; /* most that fit from row on     */
+
+  *fits SET_TO 0;
+  rows SET_TO ROWS;
+  spare SET_TO (world->cols[col].aim - world->cols[col].got);
+  if (spare < 0)
+    return OK;
+  for (row SET_TO (rows - (size - 1)); row <= (rows + 1); row++)
+    {
+      for (b SET_TO 0; b <= spare; b++)
+	most[row][b] SET_TO 0;
+    }
+  for (row SET_TO (rows - size); row >= 0; row--)
+    {
+      IFF(ship_fits_col_row(col, row, size, &ys, &is_legal, world));
+      for (b SET_TO 0; b <= spare; b++)
+	{
+	  most[row][b] SET_TO most[row + 1][b];
+	  if (is_legal AND (ys <= b) AND
+	      ((most[row + size + 1][b - ys] +
+		(world->locations[row][col] ? 0 : 1)) > most[row][b]))
+	    most[row][b] SET_TO
+	      (most[row + size + 1][b - ys] +
+	       (world->locations[row][col] ? 0 : 1));
+	}
+    }
+  *fits SET_TO most[0][spare];
+  return OK;
+}
+
+/*************************************************************************/
+
+/* ship_fits_col_row
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. Size is less than one or greater than four: "Bug bad size".
+  2. legal_col_across returns ERROR.
+  3. legal_col_beside returns ERROR.
+
+Called By:
+  find_max_starts_col
+  find_min_starts_col
+  make_guess_ship_col
+  ship_covers_col
+  ship_fits_col
+  submarine_covers
+
+Side Effects: This checks if a ship of the given size fits in the
+given column, starting in the given row. It also checks if that is a
+legal placement. If world->bits is 1, the squares around the ship are
+checked by bits_fit_col_row rather than one at a time. If the placement is legal, *is_legal is set to 1;
+otherwise, *is_legal is set to 0.
+
+ys is set to the number of empty squares that need to be filled
+so the ship has no blanks in it.
+
+Notes:
+
+size must be 1, 2, 3, or 4
+
+This does not check if a ship is already located in the column
+starting at the given row.
+
+This builds a test column used by legal_col_across and
+legal_col_beside.  The ship to be tested is inserted in the test
+column starting at the given row. Squares of the ship that were
+previously blank are marked with Y. Blank squares in the test column
+outside the ship are marked as water. This is only for the convenience
+of legal_col_across and legal_col_beside, not because they are all
+necessarily water (although the two at the ends of the ship are
+necessarily water).
+
+*/
+
+int ship_fits_col_row(     /* ARGUMENTS                                 */
+ int col,                  /* index of column being checked             */
+ int row,                  /* index of row being checked                */
+ int size,                 /* size of ship                              */
+ int * ys,                 /* number of additional ship parts, set here */
+ int * is_legal,           /* set here to 0 or 1                        */
+ struct bap_world * world) /* puzzle model                              */
+{
+  const char * name SET_TO "ship_fits_col_row";
+  int rows;
+  char item1;
+  char item2;
+  char item3;
+  char item4;
+  char test[MAX_TEST];
+  int n;
+  int total;
+
+  CHB(((size < 1) OR (size > 4)), "Bug bad size");
+  *ys SET_TO 0;
+  *is_legal SET_TO 1;
+  item1 SET_TO world->squares[row][col];
+  item2 SET_TO ' ';
+  item3 SET_TO ' ';
+  item4 SET_TO ' ';
+  if (world->bits)
+    IFF(bits_fit_col_row(col, row, size, is_legal, world));
+  else if (((square(row - 1, col - 1, world) ISNT '.') AND
+	    (square(row - 1, col - 1, world) ISNT ' ')) OR
+	   ((square(row - 1, col, world) ISNT '.') AND
+	    (square(row - 1, col, world) ISNT ' ')) OR
+	   ((square(row - 1, col + 1, world) ISNT '.') AND
+	    (square(row - 1, col + 1, world) ISNT ' ')) OR
+	   ((square(row, col - 1, world) ISNT '.') AND
+	    (square(row, col - 1, world) ISNT ' ')) OR
+	   ((square(row, col + 1, world) ISNT '.') AND
+	    (square(row, col + 1, world) ISNT ' ')) OR
+	   ((square(row + 1, col - 1, world) ISNT '.') AND
+	    (square(row + 1, col - 1, world) ISNT ' ')) OR
+	   ((square(row + 1, col + 1, world) ISNT '.') AND
+	    (square(row + 1, col + 1, world) ISNT ' ')))
+    *is_legal SET_TO 0;
+  if (*is_legal AND (size > 1))
+    {
+      item2 SET_TO world->squares[row + 1][col];
+      if ((world->bits IS 0) AND
+	  (((square(row + 2, col - 1, world) ISNT '.') AND
+	    (square(row + 2, col - 1, world) ISNT ' ')) OR
+	   ((square(row + 2, col + 1, world) ISNT '.') AND
+	    (square(row + 2, col + 1, world) ISNT ' '))))
+	*is_legal SET_TO 0;
+    }
+  if (*is_legal AND (size > 2))
+    {
+      item3 SET_TO world->squares[row + 2][col];
+      if ((world->bits IS 0) AND
+	  (((square(row + 3, col - 1, world) ISNT '.') AND
+	    (square(row + 3, col - 1, world) ISNT ' ')) OR
+	   ((square(row + 3, col + 1, world) ISNT '.') AND
+	    (square(row + 3, col + 1, world) ISNT ' '))))
+	*is_legal SET_TO 0;
+    }
+  if (*is_legal AND (size > 3))
+    {
+      item4 SET_TO world->squares[row + 3][col];
+      if ((world->bits IS 0) AND
+	  (((square(row + 4, col - 1, world) ISNT '.') AND
+	    (square(row + 4, col - 1, world) ISNT ' ')) OR
+	   ((square(row + 4, col + 1, world) ISNT '.') AND
+	    (square(row + 4, col + 1, world) ISNT ' '))))
+	*is_legal SET_TO 0;
+    }
+  if (*is_legal)
+    {
+      if (size IS 1)
+	{
+	  if (((item1 ISNT 'O') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
+	      ((square(row + 1, col, world) ISNT '.') AND
+	       (square(row + 1, col, world) ISNT ' ')))
+	    *is_legal SET_TO 0;
+	}
+      else if (size IS 2)
+	{
+	  if (((item1 ISNT '^') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
+	      ((item2 ISNT 'v') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
+	      ((square(row + 2, col, world) ISNT '.') AND
+	       (square(row + 2, col, world) ISNT ' ')))
+	    *is_legal SET_TO 0;
+	}
+      else if (size IS 3)
+	{
+	  if (((item1 ISNT '^') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
+	      ((item2 ISNT '+') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
+	      ((item3 ISNT 'v') AND (item3 ISNT 'X') AND (item3 ISNT ' ')) OR
+	      ((square(row + 3, col, world) ISNT '.') AND
+	       (square(row + 3, col, world) ISNT ' ')))
+	    *is_legal SET_TO 0;
+	}
+      else if (size IS 4)
+	{
+	  if (((item1 ISNT '^') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
+	      ((item2 ISNT '+') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
+	      ((item3 ISNT '+') AND (item3 ISNT 'X') AND (item3 ISNT ' ')) OR
+	      ((item4 ISNT 'v') AND (item4 ISNT 'X') AND (item4 ISNT ' ')) OR
+	      ((square(row + 4, col, world) ISNT '.') AND
+	       (square(row + 4, col, world) ISNT ' ')))
+	    *is_legal SET_TO 0;
+	}
+    }
+  if (*is_legal)
+    {
+      rows SET_TO ROWS;
+      test[0] SET_TO '.';
+      test[rows + 1] SET_TO '.';
+      total SET_TO 0;
+      for (n SET_TO 0; n < rows; n++)
+	{
+	  if ((n < row) OR (n > (row + (size - 1))))
+	    {
+	      if ((square(n, col, world) IS ' ') OR
+		  (square(n, col, world) IS '.'))
+		test[n + 1] SET_TO '.';
+	      else
+		{
+		  test[n + 1] SET_TO square(n, col, world);
+		  total++;
+		}
+	    }
+	  else
+	    {
+	      total++;
+	      if (square(n, col, world) IS ' ')
+		{
+		  test[n + 1] SET_TO 'Y';
+		  *ys SET_TO (*ys + 1);
+		}
+	      else
+		test[n + 1] SET_TO square(n, col, world);
+	    }
+	}
+      if (total > world->cols[col].aim)
+	*is_legal SET_TO 0;
+      if (*is_legal)
+	IFF(legal_col_across(test + 1, col, is_legal, world));
+      if (*is_legal)
+	IFF(legal_col_beside(test + 1, col, is_legal, world));
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* ship_fits_row
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. ship_fits_row_col returns ERROR.
+
+Called By:
+  assign_battleships
+  assign_cruisers
+  assign_destroyers
+  assign_submarines_rows
+
+Side Effects: This sets *fits to the number of the given size that can
+fit in a row in addition to the ones already located there.
+
+Notes:
+
+The number is the most ships that can be put in the row at once, at
+legal places (see ship_fits_row_col) with a square between each two,
+without the blank squares they fill (ys) taking the row past its aim.
+The assign_ functions assign to a strip the ships that do not fit in
+the others, so counting too few here would assign ships wrongly and
+lose answers. The most is found by working back from the end of the
+row: most[col][b] is the most that fit starting at col or after,
+filling at most b blank squares. Placing ships first-fit from the
+start of the row, as was done before, may count too few. A ship placed
+first may fill blanks that leave no room under the aim for the rest,
+where one placed a little later, over squares already set to X, would
+fill none. A ship already located at a place counts nothing but may
+still be placed, since its squares are counted in got.
+
+*/
+
+int ship_fits_row(         /* ARGUMENTS                         */
+ int row,                  /* index of row being checked        */
+ int size,                 /* size of ship                      */
+ int * fits,               /* set here to number that fit newly */
+ struct bap_world * world) /* puzzle model                      */
+{
+  const char * name SET_TO "ship_fits_row";
+  int col;
+  int cols;
+  int is_legal;
+  int ys;       /* number of additional ship parts in row from one ship     */
+  int spare;    /* number of ship parts row may still get                   */
+  int b;        /* number of ship parts that may be added, in most          */
+  int most[MAX_TEST][MAX_NUMBER_COLS + 1]; /* most that fit from col on     */
 
-  world->battleships_left SET_TO 0;
-  world->cruisers_left SET_TO 0;
-  world->destroyers_left SET_TO 0;
-  world->submarines_left_col SET_TO 0;
-  world->submarines_left_row SET_TO 0;
-  CHB((fgets(buffer, TEXT_SIZE, in_port) IS NULL),
-      "File ends with no end marker");
-  for (n SET_TO 0; ; n SET_TO (n + 6))
-    {
-      if (strncmp((buffer + n), "  <++>", 6) IS 0)
-	world->battleships_left++;
-      else
-	break;
-    }
-  CHB(((n ISNT 0) AND (buffer[n] ISNT '\n')), "Bad battleships line");
-  if (world->print_all)
-    printf("%d battleships\n", world->battleships_left);
-  if (world->battleships_left ISNT 0)
+  *fits SET_TO 0;
+  cols SET_TO COLS;
+  spare SET_TO (world->rows[row].aim - world->rows[row].got);
+  if (spare < 0)
+    return OK;
+  for (col SET_TO (cols - (size - 1)); col <= (cols + 1); col++)
     {
-      CHB((fgets(buffer, TEXT_SIZE, in_port) IS NULL),
-	  "File ends with no end marker");
+      for (b SET_TO 0; b <= spare; b++)
+	most[col][b] SET_TO 0;
     }
-  for (n SET_TO 0; ; n SET_TO (n + 5))
+  for (col SET_TO (cols - size); col >= 0; col--)
     {
-      if (strncmp((buffer + n), "  <+>", 5) IS 0)
-	world->cruisers_left++;
-      else
-	break;
+      IFF(ship_fits_row_col(row, col, size, &ys, &is_legal, world));
+      for (b SET_TO 0; b <= spare; b++)
+	{
+	  most[col][b] SET_TO most[col + 1][b];
+	  if (is_legal AND (ys <= b) AND
+	      ((most[col + size + 1][b - ys] +
+		(world->locations[row][col] ? 0 : 1)) > most[col][b]))
+	    most[col][b] SET_TO
+	      (most[col + size + 1][b - ys] +
+	       (world->locations[row][col] ? 0 : 1));
+	}
     }
-  CHB(((n ISNT 0) AND (buffer[n] ISNT '\n')), "Bad cruisers line");
-  if (world->print_all)
-    printf("%d cruisers\n", world->cruisers_left);
-  if (world->cruisers_left ISNT 0)
+  *fits SET_TO most[0][spare];
+  return OK;
+}
+
+/*************************************************************************/
+
+/* ship_fits_row_col
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. Size is less than one or greater than four: "Bug bad size".
+  2. legal_row_across returns ERROR.
+  3. legal_row_beside returns ERROR.
+
+Called By:
+  find_max_starts_row
+  find_min_starts_row
+  make_guess_ship_row
+  ship_covers_row
+  ship_fits_row
+  submarine_covers
+
+Side Effects: This checks if a ship of the given size fits in the
+given row, starting in the given column. It also checks if that is a
+legal placement. If world->bits is 1, the squares around the ship are
+checked by bits_fit_row_col rather than one at a time. If the placement is legal, *is_legal is set to 1;
+otherwise, *is_legal is set to 0.
+
+ys is set to the number of empty squares that need to be filled so the
+ship has no blanks in it.
+
+Notes:
+
+size must be 1, 2, 3, or 4
+
+This does not check if a ship is already located in the given row
+starting at the given column.
+
+This builds a test row used by legal_row_across and
+legal_row_beside.  The ship to be tested is inserted in the test
+row starting at the given col. Squares of the ship that were
+previously blank are marked with Y. Blank squares in the test row
+outside the ship are marked as water. This is only for the convenience
+of legal_row_across and legal_row_beside, not because they are all
+necessarily water (although the two at the ends of the ship are
+necessarily water).
+
+*/
+
+int ship_fits_row_col(     /* ARGUMENTS                                 */
+ int row,                  /* index of row being checked                */
+ int col,                  /* index of column being checked             */
+ int size,                 /* size of ship                              */
+ int * ys,                 /* number of additional ship parts, set here */
+ int * is_legal,           /* set here to 0 or 1                        */
+ struct bap_world * world) /* puzzle model                              */
+{
+  const char * name SET_TO "ship_fits_row_col";
+  int cols;
+  char item1;
+  char item2;
+  char item3;
+  char item4;
+  char test[MAX_TEST];
+  int n;
+  int total;
+
+  CHB(((size < 1) OR (size > 4)), "Bug bad size");
+  *ys SET_TO 0;
+  *is_legal SET_TO 1;
+  item1 SET_TO world->squares[row][col];
+  item2 SET_TO ' ';
+  item3 SET_TO ' ';
+  item4 SET_TO ' ';
+  if (world->bits)
+    IFF(bits_fit_row_col(row, col, size, is_legal, world));
+  else if (((square(row - 1, col - 1, world) ISNT '.') AND
+	    (square(row - 1, col - 1, world) ISNT ' ')) OR
+	   ((square(row, col - 1, world) ISNT '.') AND
+	    (square(row, col - 1, world) ISNT ' ')) OR
+	   ((square(row + 1, col - 1, world) ISNT '.') AND
+	    (square(row + 1, col - 1, world) ISNT ' ')) OR
+	   ((square(row - 1, col, world) ISNT '.') AND
+	    (square(row - 1, col, world) ISNT ' ')) OR
+	   ((square(row + 1, col, world) ISNT '.') AND
+	    (square(row + 1, col, world) ISNT ' ')) OR
+	   ((square(row - 1, col + 1, world) ISNT '.') AND
+	    (square(row - 1, col + 1, world) ISNT ' ')) OR
+	   ((square(row + 1, col + 1, world) ISNT '.') AND
+	    (square(row + 1, col + 1, world) ISNT ' ')))
+    *is_legal SET_TO 0;
+  if (*is_legal AND (size > 1))
     {
-      CHB((fgets(buffer, TEXT_SIZE, in_port) IS NULL),
-	  "File ends with no end marker");
+      item2 SET_TO world->squares[row][col + 1];
+      if ((world->bits IS 0) AND
+	  (((square(row - 1, col + 2, world) ISNT '.') AND
+	    (square(row - 1, col + 2, world) ISNT ' ')) OR
+	   ((square(row + 1, col + 2, world) ISNT '.') AND
+	    (square(row + 1, col + 2, world) ISNT ' '))))
+	*is_legal SET_TO 0;
     }
-  for (n SET_TO 0; ; n SET_TO (n + 4))
+  if (*is_legal AND (size > 2))
     {
-      if (strncmp((buffer + n), "  <>", 4) IS 0)
-	world->destroyers_left++;
-      else
-	break;
+      item3 SET_TO world->squares[row][col + 2];
+      if ((world->bits IS 0) AND
+	  (((square(row - 1, col + 3, world) ISNT '.') AND
+	    (square(row - 1, col + 3, world) ISNT ' ')) OR
+	   ((square(row + 1, col + 3, world) ISNT '.') AND
+	    (square(row + 1, col + 3, world) ISNT ' '))))
+	*is_legal SET_TO 0;
     }
-  CHB(((n ISNT 0) AND (buffer[n] ISNT '\n')), "Bad destroyers line");
-  if (world->print_all)
-    printf("%d destroyers\n", world->destroyers_left);
-  if (world->destroyers_left ISNT 0)
+  if (*is_legal AND (size > 3))
     {
-      CHB((fgets(buffer, TEXT_SIZE, in_port) IS NULL),
-	  "File ends with no end marker");
+      item4 SET_TO world->squares[row][col + 3];
+      if ((world->bits IS 0) AND
+	  (((square(row - 1, col + 4, world) ISNT '.') AND
+	    (square(row - 1, col + 4, world) ISNT ' ')) OR
+	   ((square(row + 1, col + 4, world) ISNT '.') AND
+	    (square(row + 1, col + 4, world) ISNT ' '))))
+	*is_legal SET_TO 0;
     }
-  for (n SET_TO 0; ; n SET_TO (n + 3))
+  if (*is_legal)
     {
-      if (strncmp((buffer + n), "  O", 3) IS 0)
+      if (size IS 1)
 	{
-	  world->submarines_left_col++;
-	  world->submarines_left_row++;
+	  if (((item1 ISNT 'O') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
+	      ((square(row, col + 1, world) ISNT '.') AND
+	       (square(row, col + 1, world) ISNT ' ')))
+	    *is_legal SET_TO 0;
+	}
+      else if (size IS 2)
+	{
+	  if (((item1 ISNT '<') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
+	      ((item2 ISNT '>') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
+	      ((square(row, col + 2, world) ISNT '.') AND
+	       (square(row, col + 2, world) ISNT ' ')))
+	    *is_legal SET_TO 0;
+	}
+      else if (size IS 3)
+	{
+	  if (((item1 ISNT '<') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
+	      ((item2 ISNT '+') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
+	      ((item3 ISNT '>') AND (item3 ISNT 'X') AND (item3 ISNT ' ')) OR
+	      ((square(row, col + 3, world) ISNT '.') AND
+	       (square(row, col + 3, world) ISNT ' ')))
+	    *is_legal SET_TO 0;
+	}
+      else if (size IS 4)
+	{
+	  if (((item1 ISNT '<') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
+	      ((item2 ISNT '+') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
+	      ((item3 ISNT '+') AND (item3 ISNT 'X') AND (item3 ISNT ' ')) OR
+	      ((item4 ISNT '>') AND (item4 ISNT 'X') AND (item4 ISNT ' ')) OR
+	      ((square(row, col + 4, world) ISNT '.') AND
+	       (square(row, col + 4, world) ISNT ' ')))
+	    *is_legal SET_TO 0;
 	}
-      else
-	break;
     }
-  CHB(((n ISNT 0) AND (buffer[n] ISNT '\n')), "Bad submarines line");
-  if (world->print_all)
-    printf("%d submarines\n", world->submarines_left_col);
-  if (world->submarines_left_col ISNT 0)
+  if (*is_legal)
     {
-      CHB((fgets(buffer, TEXT_SIZE, in_port) IS NULL),
-	  "File ends with no end marker");
+      cols SET_TO COLS;
+      test[0] SET_TO '.';
+      test[cols + 1] SET_TO '.';
+      total SET_TO 0;
+      for (n SET_TO 0; n < cols; n++)
+	{
+	  if ((n < col) OR (n > (col + (size - 1))))
+	    {
+	      if ((square(row, n, world) IS ' ') OR
+		  (square(row, n, world) IS '.'))
+		test[n + 1] SET_TO '.';
+	      else
+		{
+		  test[n + 1] SET_TO square(row, n, world);
+		  total++;
+		}
+	    }
+	  else
+	    {
+	      total++;
+	      if (square(row, n, world) IS ' ')
+		{
+		  test[n + 1] SET_TO 'Y';
+		  *ys SET_TO (*ys + 1);
+		}
+	      else
+		test[n + 1] SET_TO square(row, n, world);
+	    }
+	}
+      if (total > world->rows[row].aim)
+	*is_legal SET_TO 0;
+      if (*is_legal)
+	IFF(legal_row_across(test + 1, row, is_legal, world));
+      if (*is_legal)
+	IFF(legal_row_beside(test + 1, row, is_legal, world));
     }
-  CHB((strncmp(buffer, "end", 3) ISNT 0), "File ends with no end marker");
-  sum_ship SET_TO
-    ((4 * world->battleships_left) +
-     (3 * world->cruisers_left) +
-     (2 * world->destroyers_left) +
-     (world->submarines_left_row));
-  sum_aim SET_TO 0;
-  for (n SET_TO 0; n < world->number_rows; n++)
-    sum_aim SET_TO (sum_aim + world->rows[n].aim);
-  CHB((sum_aim ISNT sum_ship), "Bad row count total");
-  sum_aim SET_TO 0;
-  for (n SET_TO 0; n < world->number_cols; n++)
-    sum_aim SET_TO (sum_aim + world->cols[n].aim);
-  CHB((sum_aim ISNT sum_ship), "Bad column count total");
   return OK;
 }
 
 /*************************************************************************/
 
-/* record_progress
+/* size_block
+
+Returned Value: int (OK)
+
+Called By:
+  attach_block
+  clone_bap
+  generate_bap
+  make_block
+  try_guessing
+
+Side Effects: This sets copied to the number of bytes of a block for a
+grid of the given size that are copied by copy_bap, and bytes to the
+number of bytes in the block altogether (see attach_block).
+
+*/
+
+int size_block(        /* ARGUMENTS                              */
+ int number_rows,      /* number of rows in puzzle               */
+ int number_cols,      /* number of columns in puzzle            */
+ long * copied,        /* bytes copied by copy_bap, set here     */
+ long * bytes)         /* bytes of block altogether, set here    */
+{
+  const char * name SET_TO "size_block";
+
+  *copied SET_TO
+    ((2 * (number_rows + number_cols) * sizeof(unsigned long long)) +
+     ((number_rows + number_cols) * sizeof(struct strip)) +
+     ((number_rows + number_cols) * sizeof(int)) +
+     ((long)number_rows * number_cols * sizeof(int)) +
+     ((long)number_rows * number_cols));
+  *bytes SET_TO
+    (((*copied + 7) & ~7L) +
+     (number_rows * (sizeof(int *) + sizeof(char *))));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* size_branch
 
 Returned Value: int (OK)
 
 Called By:
-  assign_battleships
-  assign_cruisers
-  assign_destroyers
-  assign_submarines
-  extend_horizontal
-  extend_vertical
-  fill_bap
-  insert_guess_col
-  insert_guess_row
-  place_battleships
-  place_cruisers
-  place_destroyers
-  try_cross_col_one
-  try_cross_row_one
-  try_full
-  try_full_but_one
-  try_full_but_two
-  try_square_blank
+  generate_bap
+  read_puzzle
+
+Side Effects: This sets the sizes of the explanation (and the rows and
+columns it lists), the list of guesses tried, and the path that
+make_branch makes, from the size of the grid and the number of ships.
+
+Notes:
 
-Side Effects: If progress has been made, a line of explanation is
-recorded, and in verbose mode, the puzzle is printed.
+A set of guesses has at most one guess for each way a ship can lie on
+each square, so it has at most 2 times the number of squares. Each
+guess locates one ship, so no branch has more guesses on it than there
+are ships, and each of those can add a whole set of guesses to the list
+of guesses tried. Each line of explanation records some progress, and
+progress changes a square or a count of ships, so there cannot be many
+more lines than twice the number of squares plus the ships. A line
+lists at most every row and column, in at most four characters each.
+
+A row or column is listed only when something in it changed. A square
+changes at most three times and is in one row and one column, and a
+count of ships assigned to a row or column goes up at most once for
+each ship, so six times the number of squares plus the number of rows
+and columns times the ships bounds the rows and columns listed.
 
 */
 
-int record_progress(       /* ARGUMENTS                     */
- char * reason,            /* text giving reason for action */
- char * action,            /* text describing action taken  */
- struct bap_world * world) /* puzzle model                  */
+int size_branch(           /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
 {
-  const char * name SET_TO "record_progress";
-  int numb;     /* number of characters printed       */
-  int n;        /* counter for rows_in and columns_in */
-  char * where; /* where to put next characters       */
+  const char * name SET_TO "size_branch";
+  int squares;  /* number of squares in puzzle */
+  int ships;    /* number of ships in puzzle   */
+
+  squares SET_TO (world->number_rows * world->number_cols);
+  ships SET_TO
+    (world->battleships_left + world->cruisers_left +
+     world->destroyers_left + world->submarines_left_row);
+  world->logic_lines SET_TO ((2 * squares) + (4 * ships) + 16);
+  world->logic_room SET_TO
+    ((6 * squares) + ((world->number_rows + world->number_cols) * ships) + 16);
+  world->logic_width SET_TO
+    (TEXT_SIZE + (4 * (world->number_rows + world->number_cols)));
+  world->max_depth SET_TO (ships + 1);
+  world->max_guesses SET_TO ((2 * squares) + 2);
+  world->max_tried SET_TO (world->max_depth * world->max_guesses);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* slack_strips
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. measure_slack returns ERROR.
+  2. touch_strips returns ERROR.
+
+Called By:  run_rules (by way of RUN_RULE)
+
+Side Effects: If world->worklist is set, this touches the strips whose
+rules may come out differently because a strip across them or the
+kinds of ship left have changed, since no counter of their own has.
+
+When looking at a row, the counts of a column are read only to see if
+the column has room for one more ship part or a little more water (see
+legal_row_across and legal_row_beside), and that is all the slack of
+the column tells (see measure_slack). So when the slack of a column
+changes, the rows that may read it are touched. Those are the rows
+with a blank in the column and the rows beside them. Rows are the same.
+
+The kinds of ship left (whether any of each kind is left) are read
+everywhere, so if they change, every strip is touched.
+
+*/
+
+int slack_strips(          /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
+{
+  const char * name SET_TO "slack_strips";
+  int row;
+  int col;
+  int slack;
+  int kinds;    /* one bit for each kind of ship of which some are left */
 
-  if (world->progress ISNT 0)
+  if (world->worklist)
     {
-      where SET_TO world->logic[world->logic_line];
-      numb SET_TO sprintf(where, "%s: %s ", reason, action);
-      where SET_TO (where + numb);
-      if (world->number_in_rows > 0)
+      kinds SET_TO
+	((world->battleships_left ? 1 : 0) |
+	 (world->cruisers_left ? 2 : 0) |
+	 (world->destroyers_left ? 4 : 0) |
+	 (world->submarines_left_row ? 8 : 0) |
+	 (world->submarines_left_col ? 16 : 0));
+      if (kinds ISNT world->slack)
 	{
-	  sprintf(where, "row");
-	  where SET_TO (where + 3);
-	  numb SET_TO
-	    sprintf(where, ((world->number_in_rows > 1) ? "s " : " "));
-	  where SET_TO (where + numb);
-	  for (n SET_TO 0; n < world->number_in_rows; n++)
-	    {
-	      numb SET_TO sprintf(where, "%d ", (1 + world->rows_in[n]));
-	      where SET_TO (where + numb);
-	    }
+	  world->slack SET_TO kinds;
+	  IFF(touch_strips(0, (world->number_rows - 1),
+			   0, (world->number_cols - 1), world));
 	}
-      if (world->number_in_cols > 0)
+      for (row SET_TO 0; row < world->number_rows; row++)
 	{
-	  if (world->number_in_rows > 0)
+	  IFF(measure_slack(&(world->rows[row]), &slack));
+	  if (slack ISNT world->rows[row].slack)
 	    {
-	      sprintf(where, "and ");
-	      where SET_TO (where + 4);
+	      world->rows[row].slack SET_TO slack;
+	      for (col SET_TO 0; col < world->number_cols; col++)
+		{
+		  if (world->squares[row][col] IS ' ')
+		    IFF(touch_strips(0, -1, (col - 1), (col + 1), world));
+		}
 	    }
-	  sprintf(where, "column");
-	  where SET_TO (where + 6);
-	  numb SET_TO
-	    sprintf(where, ((world->number_in_cols > 1) ? "s " : " "));
-	  where SET_TO (where + numb);
-	  for (n SET_TO 0; n < world->number_in_cols; n++)
+	}
+      for (col SET_TO 0; col < world->number_cols; col++)
+	{
+	  IFF(measure_slack(&(world->cols[col]), &slack));
+	  if (slack ISNT world->cols[col].slack)
 	    {
-	      numb SET_TO sprintf(where, "%d ", (1 + world->cols_in[n]));
-	      where SET_TO (where + numb);
+	      world->cols[col].slack SET_TO slack;
+	      for (row SET_TO 0; row < world->number_rows; row++)
+		{
+		  if (world->squares[row][col] IS ' ')
+		    IFF(touch_strips((row - 1), (row + 1), 0, -1, world));
+		}
 	    }
 	}
-      if (world->print_all)
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* solve_dlx
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. dlx_make or dlx_search returns ERROR.
+  2. No answer is found: "Puzzle has no answer".
+
+Called By:
+  generate_count
+  main
+  solve_job
+  solve_request
+
+Side Effects: This solves the puzzle as read by the exact cover engine
+(--engine=dlx), printing each answer found (or, when solving a batch,
+checking it with check_answer). The problem is made by dlx_make,
+searched by dlx_search, and freed here. None of the rules of
+solve_problem are run.
+
+*/
+
+int solve_dlx(             /* ARGUMENTS             */
+ struct bap_world * world) /* puzzle model, as read */
+{
+  const char * name SET_TO "solve_dlx";
+  struct dlx * the_dlx;  /* exact cover problem made from puzzle */
+  int result;            /* value returned by dlx_search         */
+  int answers;           /* number of answers found              */
+
+  the_dlx SET_TO NULL;
+  result SET_TO dlx_make(&the_dlx, world);
+  if (result IS OK)
+    result SET_TO dlx_search(the_dlx, world);
+  answers SET_TO (the_dlx ? the_dlx->answers : 0);
+  if (the_dlx AND the_dlx->top)
+    free_dlx(the_dlx);
+  IFF(result);
+  CHK((answers IS 0), "Puzzle has no answer");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* solve_job
+
+Returned Value: int (OK)
+
+Called By:  work_batch
+
+Side Effects: This reads and solves the puzzle of the job on a world of
+its own, made with the options of the batch, and records in the job
+what happened and how long solving took (see run_batch). No
+explanation is recorded, since a batch prints none. Everything made for
+the puzzle is freed before this returns.
+
+Notes:
+
+ERROR from any of the functions called here is recorded in the status
+of the job rather than passed on, so that one bad problem file or one
+puzzle with no answer does not stop the batch. The messages of CHB are
+still printed, mixed in with those of other threads.
+
+The hash of the squares is started from a number made from the index of
+the job, so that the keys of one puzzle in the shared transposition
+table are not found by another. The number is shifted up past the bits
+that zobrist_key scrambles, so it cannot be the key of any square.
+
+*/
+
+int solve_job(             /* ARGUMENTS                   */
+ struct job * the_job,     /* job for puzzle to solve     */
+ struct batch * the_batch) /* batch the job belongs to    */
+{
+  const char * name SET_TO "solve_job";
+  struct bap_world world1;
+  struct bap_world * world;
+  struct timespec start;    /* time solving started            */
+  struct timespec end;      /* time solving finished           */
+  unsigned long long salt;  /* number hash of squares starts at */
+  int result;
+
+  world SET_TO &world1;
+  init_world(world);
+  world->bits SET_TO the_batch->world->bits;
+  world->branch SET_TO the_batch->world->branch;
+  world->count SET_TO the_batch->world->count;
+  world->engine SET_TO the_batch->world->engine;
+  world->explain SET_TO 0;
+  world->find_all SET_TO the_batch->world->find_all;
+  world->in_place SET_TO the_batch->world->in_place;
+  world->job SET_TO the_job;
+  world->rules SET_TO the_batch->world->rules;
+  world->strategy SET_TO the_batch->world->strategy;
+  world->table SET_TO the_batch->world->table;
+  world->verbose SET_TO the_batch->world->verbose;
+  world->worklist SET_TO the_batch->world->worklist;
+  result SET_TO read_problem(the_job->file_name, world);
+  if (result IS OK)
+    result SET_TO read_answer(the_job, world);
+  if (result IS OK)
+    {
+      the_job->status SET_TO JOB_NO_ANSWER;
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      if (world->engine IS ENGINE_DLX)
+	result SET_TO solve_dlx(world);
+      else
 	{
-	  print_bap(world);
-	  printf("%s\n\n", world->logic[world->logic_line]);
+	  result SET_TO init_solution(world);
+	  if ((result IS OK) AND world->table)
+	    {
+	      hash_squares(world);
+	      salt SET_TO
+		((unsigned long long)((the_job - the_batch->jobs) + 1) << 40);
+	      scramble_key(&salt);
+	      world->hash SET_TO (world->hash ^ salt);
+	    }
+	  if (result IS OK)
+	    result SET_TO make_arena(&(world->arena), world);
+	  if ((result IS OK) AND world->in_place)
+	    result SET_TO make_trail(&(world->trail), world);
+	  if (result IS OK)
+	    result SET_TO solve_problem(world);
 	}
-      world->logic_line++;
+      if (result IS OK)
+	the_job->status SET_TO JOB_SOLVED;
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      the_job->seconds SET_TO ((end.tv_sec - start.tv_sec) +
+			       ((end.tv_nsec - start.tv_nsec) / 1e9));
     }
+  free(world->block);
+  free(world->logic);
+  free(world->guesses_tried);
+  free(world->path);
+  if (world->arena)
+    free_arena(world->arena);
+  if (world->trail)
+    free(world->trail->changes);
+  free(world->trail);
   return OK;
 }
 
 /*************************************************************************/
 
-/* ship_covers_col
+/* solve_problem
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. ship_fits_col_row returns ERROR.
+  1. One of the following functions returns ERROR:
+     check_answer, explain_bap, finish_pure, print_bap, run_rules,
+     save_answer, try_guessing.
+  2. The search has been cancelled: "Search cancelled".
 
-Called By:  try_square_blank
+Called By:
+  generate_count
+  main
+  run_task
+  solve_job
+  solve_request
+  try_guess_in_place
+  try_guessing
 
-Side Effects: This tries to fit a ship of the given size into the given
-column, covering the square in the given row, without creating any
-illegal conditions. If it succeeds, it sets *cover to 1. Otherwise,
-it sets *cover to 0.
+Side Effects: The puzzle gets filled in, if possible. While this is
+happening, the bap_world gets changed continually.
+
+Notes:
+
+This has a hard-coded list of things to try for solving
+the puzzle arranged in order from easy to hard:
+
+1.  Check the current state of the puzzle for being legal (verify_squares).
+2.  Locate previously unlocated identifiable ships. A ship is not
+    identifiable until it has no Xs in it and has all parts (ends
+    and middle, if any) in place (locate_ships).
+3.  Mark the rows and columns that are done (mark dones).
+4.  Fill with water the blanks of any strip that has all the ship parts
+    it needs but still has some blanks (fill_bap).
+5.  Extend with X's (unknown ship parts) any ship middles that
+    can be extended (extend_middles).
+6.  Change to a known ship part any unknown ship part whose identify
+    can be determined (dex_squares).
+7.  Fill with ship parts any unfilled strip that has only as many dry
+    squares as the number of ship parts it needs (try_full).
+8.  Fill with ship parts any squares of [any strip that has only one
+    fewer dry squares than the number of ship parts it needs] which must
+    be filled no matter where the one additional water square is
+    (legally) placed (try_full_but_one)
+9.  Assign battleships to strips, if possible (assign_battleships).
+10. Place battleship parts in strips where battleships are assigned,
+    if possible (place_battleships).
+11. Assign cruisers to strips, if possible (assign_cruisers).
+12. Place cruiser parts in strips where cruisers are assigned,
+    if possible (place_cruisers).
+13. Assign destroyers to strips, if possible (assign_destroyers).
+14. Place destroyer parts in strips where destroyers are assigned,
+    if possible (place_destroyers).
+15. Assign submarines to strips, if possible (assign_submarines).
+16. Look at each blank square, one at a time, and determine if it can
+    be covered by any available ship. If not, mark it water
+    (try_square_blank).
+17. Look for the situation described in documentation of try_cross
+    and mark ship parts (and water) if possible.
+18. If done, print the puzzle and the explanation of how it was solved
+    (or, when searching with a pool of threads, save it with
+    save_answer, or when solving a batch, check it with check_answer).
+    If not, return whatever try_guessing returns.
+
+The function goes down the list of things to try. verify_squares and
+locate_ships are always run. They do not fill in any squares. After
+that, as soon as one of the functions succeeds in filling in even one
+square, solve_problem goes back to the top of the list (skipping the
+remaining, harder, things to try) and goes down it again. The easier
+things to try (even the same thing that worked last time) may now work
+because more of the puzzle is filled in. Each trip down the list
+(items 1 to 17) is made by run_rules.
+
+If all the things to try do not solve the puzzle, call try_guessing,
+which calls solve_problem recursively. As a result of the recursive
+call, multiple solutions can be found.
+
+Only the rules whose bits are on in world->rules are run (see
+RUN_RULE), so the search strategies skip the ones that construct. When
+a pure search has every strip done, finish_pure checks that the ships
+are all located and fills in the water before the answer is printed.
 
 */
 
-int ship_covers_col(       /* ARGUMENTS                 */
- int row,                  /* index of row of square    */
- int col,                  /* index of column of square */
- int size,                 /* size of ship              */
- int * cover,              /* set here                  */
- struct bap_world * world) /* puzzle model              */
+int solve_problem(         /* ARGUMENTS    */
+ struct bap_world * world) /* puzzle model */
 {
-  const char * name SET_TO "ship_covers_col";
-  int start;
-  int stop;
-  int n;
-  int ys;
+  const char * name SET_TO "solve_problem";
+  int fired;  /* rule that made progress (see run_rules), not used */
+
+  CHK((world->pool AND
+       __atomic_load_n(&(world->pool->cancel), __ATOMIC_ACQUIRE)),
+      "Search cancelled");
+  if (world->job)
+    world->job->nodes++;
+  if (world->trace)
+    world->trace->nodes++;
+  for (world->progress SET_TO 0; world->undone ISNT 0; world->progress SET_TO 0)
+    {
+      IFF(run_rules(&fired, world));
+      if (NOT (world->progress))
+	break;
+    }
+  if ((world->undone IS 0) AND (world->strategy IS STRATEGY_SEARCH_PURE))
+    IFF(finish_pure(world));
+  if ((world->undone IS 0) AND world->pool)
+    {
+      IFF(save_answer(world));
+    }
+  else if ((world->undone IS 0) AND world->job)
+    {
+      IFF(check_answer(world));
+    }
+  else if (world->undone IS 0)
+    {
+      IFF(print_bap(world));
+      IFF(explain_bap(world));
+    }
+  else
+    {
+      IFF(try_guessing(world));
+    }
+  return OK;
+}
 
-  start SET_TO (row - (size - 1));
-  if (start < 0)
-    start SET_TO 0;
-  stop SET_TO (row + 1);
-  if (stop > (world->number_rows - (size - 1)))
-    stop SET_TO (world->number_rows - (size - 1));
-  for (n SET_TO start; n < stop; n++)
+/*************************************************************************/
+
+/* solve_request
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The request has no text, or has an engine, strategy, order of
+     branching, rules, or limit that there is not: "Bad request".
+  2. The text cannot be read as a port: "Could not read text".
+  3. There is no memory for the first answer: "Out of memory".
+  4. Any of the following functions returns ERROR:
+     init_solution (also when the puzzle has no answer)
+     make_arena
+     make_trail
+     read_puzzle
+     solve_dlx (also when the puzzle has no answer)
+     solve_problem (also when the puzzle has no answer)
+
+Called By:  solve_result
+
+Side Effects: This sets the options of the world from the request,
+reads the puzzle from the text of the request, and solves it, counting
+the answers in the job of the world (see check_answer). The first
+answer is kept in the job. Everything made is left in the world and
+the job for solve_result to free, whether or not this returns OK. If
+the world already has an arena or a trail (given to it by
+serve_request), it is used instead of a new one.
+
+Notes:
+
+The text is read through a port made on it with fmemopen, so that
+read_puzzle reads it just as read_problem reads a problem file.
+
+*/
+
+int solve_request(              /* ARGUMENTS                         */
+ struct bap_request * request,  /* puzzle to solve, and how          */
+ struct bap_world * world)      /* puzzle model, with job of request */
+{
+  const char * name SET_TO "solve_request";
+  FILE * in_port;  /* port reading text of request  */
+  int result;      /* value returned by read_puzzle */
+
+  CHB(((request->text IS NULL) OR (request->limit < 0) OR
+       ((request->engine ISNT ENGINE_RULES) AND
+	(request->engine ISNT ENGINE_DLX)) OR
+       ((request->strategy ISNT STRATEGY_CONSTRUCT) AND
+	(request->strategy ISNT STRATEGY_SEARCH_WATER) AND
+	(request->strategy ISNT STRATEGY_SEARCH_PURE)) OR
+       ((request->branch ISNT BRANCH_LARGEST) AND
+	(request->branch ISNT BRANCH_FEWEST)) OR
+       (request->rules < 0) OR (request->rules > ALL_RULES)),
+      "Bad request");
+  world->bits SET_TO request->bits;
+  world->branch SET_TO request->branch;
+  world->count SET_TO request->limit;
+  world->engine SET_TO request->engine;
+  world->explain SET_TO 0;
+  world->find_all SET_TO (request->find_all OR (request->limit > 0));
+  world->in_place SET_TO request->in_place;
+  if (request->rules ISNT 0)
+    world->rules SET_TO request->rules;
+  else if (request->strategy IS STRATEGY_SEARCH_WATER)
+    world->rules SET_TO SEARCH_WATER_RULES;
+  else if (request->strategy IS STRATEGY_SEARCH_PURE)
+    world->rules SET_TO SEARCH_PURE_RULES;
+  else
+    world->rules SET_TO ALL_RULES;
+  world->strategy SET_TO request->strategy;
+  world->worklist SET_TO request->worklist;
+  in_port SET_TO fmemopen((void *)request->text, strlen(request->text), "r");
+  CHB((in_port IS NULL), "Could not read text");
+  result SET_TO read_puzzle(in_port, world);
+  fclose(in_port);
+  IFF(result);
+  world->job->first SET_TO
+    (char *)malloc(world->number_rows * world->number_cols);
+  CHB((world->job->first IS NULL), "Out of memory");
+  if (world->engine IS ENGINE_DLX)
+    IFF(solve_dlx(world));
+  else
     {
-      IFF(ship_fits_col_row(col, n, size, &ys, cover, world));
-      if (ys + world->cols[col].got > world->cols[col].aim)
-	*cover SET_TO 0;
-      if (*cover)
-	break;
+      IFF(init_solution(world));
+      if (world->arena IS NULL)
+	IFF(make_arena(&(world->arena), world));
+      if (world->in_place)
+	IFF(make_trail(&(world->trail), world));
+      IFF(solve_problem(world));
     }
   return OK;
 }
 
 /*************************************************************************/
 
-/* ship_covers_row
+/* solve_result
 
 Returned Value: int
-  If any of the following errors occur, this returns ERROR.
+  If the status of the result is BAP_ERROR, this returns ERROR.
   Otherwise, it returns OK.
-  1. ship_fits_row_col returns ERROR.
-
-Called By:  try_square_blank
 
-Side Effects: This tries to fit a ship of the given size into the given
-row, covering the square in the given column, without creating any
-illegal conditions. If it succeeds, it sets *cover to 1. Otherwise,
-it sets *cover to 0.
+Called By:
+  bap_solve
+  serve_request
+
+Side Effects: This solves the puzzle given as text in the request, as
+the request says (see solve_request), in the world, which init_world
+has just set up, and fills in the result: the status, the number of
+answers, the size of the grid, the first answer, and the numbers of
+nodes and guesses. The first answer is made here and freed by
+bap_free_result. Everything else made for the puzzle is freed before
+this returns, except the arena and the trail, which are left in the
+world for the caller to free or to give to the next world.
+
+The status is BAP_ERROR if any CHB failed while reading or solving,
+with the message it gave in the result, BAP_SOLVED if there is an
+answer, and BAP_NO_ANSWER otherwise.
 
 Notes:
 
-If there are not enough columns for a ship of the given size to fit,
-this fails. Might add a check when reading that there are at least
-four rows and four columns.
+The job is on the stack, and the world has the message of the result,
+so that CHB keeps its message there instead of printing it. ERROR from
+solve_request with no message means that the puzzle was found to have
+no answer, which is not an error of the call.
 
 */
 
-int ship_covers_row(       /* ARGUMENTS                 */
- int row,                  /* index of row of square    */
- int col,                  /* index of column of square */
- int size,                 /* size of ship              */
- int * cover,              /* set here                  */
- struct bap_world * world) /* puzzle model              */
+int solve_result(               /* ARGUMENTS                    */
+ struct bap_request * request,  /* puzzle to solve, and how     */
+ struct bap_result * result,    /* how solving came out         */
+ struct bap_world * world)      /* puzzle model, just set up    */
 {
-  const char * name SET_TO "ship_covers_row";
-  int start;
-  int stop;
-  int k;
-  int ys;
-
-  start SET_TO (col - (size - 1));
-  if (start < 0)
-    start SET_TO 0;
-  stop SET_TO (col + 1);
-  if (stop > (world->number_cols - (size - 1)))
-    stop SET_TO (world->number_cols - (size - 1));
-  for (k SET_TO start; k < stop; k++)
+  const char * name SET_TO "solve_result";
+  struct job the_job;  /* job counting answers of puzzle */
+  int failed;          /* set to ERROR if status is BAP_ERROR */
+
+  result->message[0] SET_TO 0;
+  world->message SET_TO result->message;
+  the_job.answer SET_TO NULL;
+  the_job.file_name SET_TO NULL;
+  the_job.first SET_TO NULL;
+  the_job.guesses SET_TO 0;
+  the_job.matched SET_TO 0;
+  the_job.nodes SET_TO 0;
+  the_job.number_answers SET_TO 0;
+  the_job.other SET_TO NULL;
+  the_job.request SET_TO request;
+  the_job.seconds SET_TO 0.0;
+  the_job.status SET_TO JOB_ERROR;
+  world->job SET_TO &the_job;
+  solve_request(request, world);
+  if (result->message[0] ISNT 0)
+    result->status SET_TO BAP_ERROR;
+  else if (the_job.number_answers > 0)
+    result->status SET_TO BAP_SOLVED;
+  else
+    result->status SET_TO BAP_NO_ANSWER;
+  if (result->status IS BAP_SOLVED)
+    result->answer SET_TO the_job.first;
+  else
     {
-      IFF(ship_fits_row_col(row, k, size, &ys, cover, world));
-      if (ys + world->rows[row].got > world->rows[row].aim)
-	*cover SET_TO 0;
-      if (*cover)
-	break;
+      free(the_job.first);
+      result->answer SET_TO NULL;
     }
+  result->guesses SET_TO the_job.guesses;
+  result->nodes SET_TO the_job.nodes;
+  result->number_answers SET_TO the_job.number_answers;
+  result->number_cols SET_TO world->number_cols;
+  result->number_rows SET_TO world->number_rows;
+  free(world->block);
+  free(world->logic);
+  free(world->guesses_tried);
+  free(world->path);
+  world->job SET_TO NULL;
+  world->message SET_TO NULL;
+  failed SET_TO ((result->status IS BAP_ERROR) ? ERROR : OK);
+  IFF(failed);
   return OK;
 }
 
 /*************************************************************************/
 
-/* ship_fits_col
+/* sort_answers
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. ship_fits_col_row returns ERROR.
+Returned Value: int (OK)
 
-Called By:
-  assign_battleships
-  assign_cruisers
-  assign_destroyers
-  assign_submarines_cols
+Called By:  run_pool
 
-Side Effects: This sets *fits to the number of ships of a given size
-that can fit in a column in addition to the ones of that size already
-located there.
+Side Effects: This sorts the answers in the pool into the order in
+which a single thread would have found them, by comparing the paths of
+guesses that led to them (see path_before).
+
+Notes:
+
+This is an insertion sort. The answers are usually nearly in order
+already, and there are seldom many of them.
 
 */
 
-int ship_fits_col(         /* ARGUMENTS                         */
- int col,                  /* index of column being checked     */
- int size,                 /* size of ship                      */
- int * fits,               /* set here to number that fit newly */
- struct bap_world * world) /* puzzle model                      */
+int sort_answers(          /* ARGUMENTS          */
+ struct pool * the_pool)   /* pool of threads    */
 {
-  const char * name SET_TO "ship_fits_col";
-  int row;
-  int rows;
-  int is_legal;
-  int ys;       /* number of additional ship parts in column from one ship  */
-  int all_ys;   /* number of additional ship parts in column from all ships */
+  const char * name SET_TO "sort_answers";
+  struct bap_world * answer; /* answer being inserted              */
+  int before;                /* 1 if answer goes before other one  */
+  int m;
+  int n;
 
-  *fits SET_TO 0;
-  all_ys SET_TO 0;
-  rows SET_TO world->number_rows;
-  for (row SET_TO 0; row < (rows - (size - 1)); row++)
+  for (n SET_TO 1; n < the_pool->number_answers; n++)
     {
-      IFF(ship_fits_col_row(col, row, size, &ys, &is_legal, world));
-      if (is_legal)
-	{
-	  if ((world->cols[col].got + ys + all_ys) > world->cols[col].aim)
-	    is_legal SET_TO 0;
-	}
-      if (is_legal)
+      answer SET_TO the_pool->answers[n];
+      for (m SET_TO n; m > 0; m--)
 	{
-	  if (NOT (world->locations[row][col]))
-	    *fits SET_TO (*fits + 1);
-	  row SET_TO (row + size);
-	  all_ys SET_TO (all_ys + ys);
+	  path_before(answer, the_pool->answers[m - 1], &before);
+	  if (before IS 0)
+	    break;
+	  the_pool->answers[m] SET_TO the_pool->answers[m - 1];
 	}
+      the_pool->answers[m] SET_TO answer;
     }
   return OK;
 }
 
 /*************************************************************************/
 
-/* ship_fits_col_row
-
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. Size is less than one or greater than four: "Bug bad size".
-  2. legal_col_across returns ERROR.
-  3. legal_col_beside returns ERROR.
+/* sort_jobs
 
-Called By:
-  find_max_starts_col
-  find_min_starts_col
-  make_guess_ship_col
-  ship_covers_col
-  ship_fits_col
-  submarine_covers
+Returned Value: int (OK)
 
-Side Effects: This checks if a ship of the given size fits in the
-given column, starting in the given row. It also checks if that is a
-legal placement. If the placement is legal, *is_legal is set to 1;
-otherwise, *is_legal is set to 0.
+Called By:  list_batch
 
-ys is set to the number of empty squares that need to be filled
-so the ship has no blanks in it.
+Side Effects: This sorts the jobs of the batch into order of the names
+of their problem files, since the files of a directory are listed in
+no particular order.
 
 Notes:
 
-size must be 1, 2, 3, or 4
-
-This does not check if a ship is already located in the column
-starting at the given row.
-
-This builds a test column used by legal_col_across and
-legal_col_beside.  The ship to be tested is inserted in the test
-column starting at the given row. Squares of the ship that were
-previously blank are marked with Y. Blank squares in the test column
-outside the ship are marked as water. This is only for the convenience
-of legal_col_across and legal_col_beside, not because they are all
-necessarily water (although the two at the ends of the ship are
-necessarily water).
+Like sort_answers, this is an insertion sort.
 
 */
 
-int ship_fits_col_row(     /* ARGUMENTS                                 */
- int col,                  /* index of column being checked             */
- int row,                  /* index of row being checked                */
- int size,                 /* size of ship                              */
- int * ys,                 /* number of additional ship parts, set here */
- int * is_legal,           /* set here to 0 or 1                        */
- struct bap_world * world) /* puzzle model                              */
+int sort_jobs(             /* ARGUMENTS          */
+ struct batch * the_batch) /* batch of puzzles   */
 {
-  const char * name SET_TO "ship_fits_col_row";
-  int rows;
-  char item1;
-  char item2;
-  char item3;
-  char item4;
-  char test[MAX_TEST];
+  const char * name SET_TO "sort_jobs";
+  struct job the_job;      /* job being inserted */
+  int m;
   int n;
-  int total;
 
-  CHB(((size < 1) OR (size > 4)), "Bug bad size");
-  *ys SET_TO 0;
-  *is_legal SET_TO 1;
-  item1 SET_TO world->squares[row][col];
-  if (((square(row - 1, col - 1, world) ISNT '.') AND
-       (square(row - 1, col - 1, world) ISNT ' ')) OR
-      ((square(row - 1, col, world) ISNT '.') AND
-       (square(row - 1, col, world) ISNT ' ')) OR
-      ((square(row - 1, col + 1, world) ISNT '.') AND
-       (square(row - 1, col + 1, world) ISNT ' ')) OR
-      ((square(row, col - 1, world) ISNT '.') AND
-       (square(row, col - 1, world) ISNT ' ')) OR
-      ((square(row, col + 1, world) ISNT '.') AND
-       (square(row, col + 1, world) ISNT ' ')) OR
-      ((square(row + 1, col - 1, world) ISNT '.') AND
-       (square(row + 1, col - 1, world) ISNT ' ')) OR
-      ((square(row + 1, col + 1, world) ISNT '.') AND
-       (square(row + 1, col + 1, world) ISNT ' ')))
-    *is_legal SET_TO 0;
-  if (*is_legal AND (size > 1))
-    {
-      item2 SET_TO world->squares[row + 1][col];
-      if (((square(row + 2, col - 1, world) ISNT '.') AND
-	   (square(row + 2, col - 1, world) ISNT ' ')) OR
-	  ((square(row + 2, col + 1, world) ISNT '.') AND
-	   (square(row + 2, col + 1, world) ISNT ' ')))
-	*is_legal SET_TO 0;
-    }
-  if (*is_legal AND (size > 2))
+  for (n SET_TO 1; n < the_batch->number_jobs; n++)
     {
-      item3 SET_TO world->squares[row + 2][col];
-      if (((square(row + 3, col - 1, world) ISNT '.') AND
-	   (square(row + 3, col - 1, world) ISNT ' ')) OR
-	  ((square(row + 3, col + 1, world) ISNT '.') AND
-	   (square(row + 3, col + 1, world) ISNT ' ')))
-	*is_legal SET_TO 0;
-    }
-  if (*is_legal AND (size > 3))
-    {
-      item4 SET_TO world->squares[row + 3][col];
-      if (((square(row + 4, col - 1, world) ISNT '.') AND
-	   (square(row + 4, col - 1, world) ISNT ' ')) OR
-	  ((square(row + 4, col + 1, world) ISNT '.') AND
-	   (square(row + 4, col + 1, world) ISNT ' ')))
-	*is_legal SET_TO 0;
-    }
-  if (*is_legal)
-    {
-      if (size IS 1)
-	{
-	  if (((item1 ISNT 'O') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
-	      ((square(row + 1, col, world) ISNT '.') AND
-	       (square(row + 1, col, world) ISNT ' ')))
-	    *is_legal SET_TO 0;
-	}
-      else if (size IS 2)
-	{
-	  if (((item1 ISNT '^') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
-	      ((item2 ISNT 'v') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
-	      ((square(row + 2, col, world) ISNT '.') AND
-	       (square(row + 2, col, world) ISNT ' ')))
-	    *is_legal SET_TO 0;
-	}
-      else if (size IS 3)
-	{
-	  if (((item1 ISNT '^') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
-	      ((item2 ISNT '+') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
-	      ((item3 ISNT 'v') AND (item3 ISNT 'X') AND (item3 ISNT ' ')) OR
-	      ((square(row + 3, col, world) ISNT '.') AND
-	       (square(row + 3, col, world) ISNT ' ')))
-	    *is_legal SET_TO 0;
-	}
-      else if (size IS 4)
+      the_job SET_TO the_batch->jobs[n];
+      for (m SET_TO n; m > 0; m--)
 	{
-	  if (((item1 ISNT '^') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
-	      ((item2 ISNT '+') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
-	      ((item3 ISNT '+') AND (item3 ISNT 'X') AND (item3 ISNT ' ')) OR
-	      ((item4 ISNT 'v') AND (item4 ISNT 'X') AND (item4 ISNT ' ')) OR
-	      ((square(row + 4, col, world) ISNT '.') AND
-	       (square(row + 4, col, world) ISNT ' ')))
-	    *is_legal SET_TO 0;
+	  if (strcmp(the_job.file_name,
+		     the_batch->jobs[m - 1].file_name) >= 0)
+	    break;
+	  the_batch->jobs[m] SET_TO the_batch->jobs[m - 1];
 	}
+      the_batch->jobs[m] SET_TO the_job;
     }
-  if (*is_legal)
+  return OK;
+}
+
+/*************************************************************************/
+
+/* square
+
+Returned Value: char
+
+This returns the actual character of world->squares in the row, col
+position if the square is inside the defined area, and returns water
+('.') otherwise.
+
+Called By:
+  assign_submarines_cols
+  assign_submarines_rows
+  dex_ends_col
+  dex_ends_row
+  dex_square
+  dlx_option
+  extend_ends
+  extend_horizontal
+  extend_middle
+  extend_vertical
+  legal_col_across
+  legal_col_beside
+  legal_row_across
+  legal_row_beside
+  locate_ships
+  make_move
+  make_water
+  place_ships_col
+  place_ships_col_water
+  place_ships_row
+  place_ships_row_water
+  ship_fits_col_row
+  ship_fits_row_col
+  try_cross_col_fill_col
+  try_cross_col_fill_row
+  try_cross_row_fill_col
+  try_cross_row_fill_row
+  try_full
+  try_full_but_one_col
+  try_full_but_one_row
+  try_full_but_two_col
+  try_full_but_two_row
+  try_square_blank
+  verify_square
+
+Side Effects: none
+
+Notes:
+
+This is an array referencer for world->squares that pads the occupied
+squares with a virtually infinite amount of virtual water. Doing this
+allows the functions that use it to pretend the array consists of
+all inside squares (none along the edges), which simplifies things
+greatly.
+
+Virtual water is better than actual water because there is as much of
+it as necessary, and it is not necessary to fiddle with the world->squares
+array itself.
+
+*/
+
+char square(               /* ARGUMENTS              */
+ int row,                  /* row index of square    */
+ int col,                  /* column index of square */
+ struct bap_world * world) /* puzzle model           */
+{
+  const char * name SET_TO "square";
+  char return_value;
+
+  if ((row > -1) AND
+      (row < ROWS) AND
+      (col > -1) AND
+      (col < COLS))
+    return_value SET_TO world->squares[row][col];
+  else
+    return_value SET_TO '.';
+  return return_value;
+}
+
+/*************************************************************************/
+
+/* start_session
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The request has no text, or has an engine, strategy, or rules
+     that a session cannot use: "Bad request".
+  2. The text cannot be read as a port: "Could not read text".
+  3. The puzzle as given has no answer: "Puzzle has no answer".
+  4. There is no memory for the hints and moves: "Out of memory".
+  5. make_trail or read_puzzle returns ERROR.
+
+Called By:  bap_open_session
+
+Side Effects: This sets the options of the world of the session from
+the request, as solve_request does, reads the puzzle from the text of
+the request, fills in what init_solution fills in, and makes the trail
+and the room the session keeps for moves and hints. Everything made is
+left in the session for bap_close_session to free, whether or not this
+returns OK.
+
+Notes:
+
+The explanation, the trail, and the worklist are always used, whatever
+the request says: hints are explained, moves and hints are undone with
+the trail, and the rules look only at the strips a move touched. The
+order of branching, the limit, and the function taking answers are not
+used, since a session makes no guesses.
+
+The DLX engine has no rules to give as hints, and a pure search makes
+no water, so neither may be used.
+
+*/
+
+int start_session(             /* ARGUMENTS                    */
+ struct bap_request * request, /* puzzle to play, and how      */
+ struct bap_session * session) /* session, just set up         */
+{
+  const char * name SET_TO "start_session";
+  struct bap_world * world;
+  FILE * in_port;  /* port reading text of request  */
+  int result;      /* value returned by read_puzzle */
+  int squares;     /* number of squares in puzzle   */
+
+  world SET_TO &(session->world);
+  CHB(((request->text IS NULL) OR (request->engine ISNT ENGINE_RULES) OR
+       ((request->strategy ISNT STRATEGY_CONSTRUCT) AND
+	(request->strategy ISNT STRATEGY_SEARCH_WATER)) OR
+       (request->rules < 0) OR (request->rules > ALL_RULES)),
+      "Bad request");
+  world->bits SET_TO request->bits;
+  world->explain SET_TO 1;
+  world->in_place SET_TO 1;
+  if (request->rules ISNT 0)
+    world->rules SET_TO request->rules;
+  else if (request->strategy IS STRATEGY_SEARCH_WATER)
+    world->rules SET_TO SEARCH_WATER_RULES;
+  else
+    world->rules SET_TO ALL_RULES;
+  world->strategy SET_TO request->strategy;
+  world->worklist SET_TO 1;
+  in_port SET_TO fmemopen((void *)request->text, strlen(request->text), "r");
+  CHB((in_port IS NULL), "Could not read text");
+  result SET_TO read_puzzle(in_port, world);
+  fclose(in_port);
+  IFF(result);
+  CHB((init_solution(world) ISNT OK), "Puzzle has no answer");
+  IFF(make_trail(&(world->trail), world));
+  squares SET_TO (world->number_rows * world->number_cols);
+  session->changed SET_TO (int *)malloc(squares * sizeof(int));
+  session->listed SET_TO (char *)calloc(squares, 1);
+  session->moves SET_TO
+    (struct move *)malloc(2 * squares * sizeof(struct move));
+  session->squares SET_TO (char *)malloc(squares);
+  session->text_size SET_TO (4 * world->logic_width);
+  session->text SET_TO (char *)malloc(session->text_size);
+  CHB(((session->changed IS NULL) OR (session->listed IS NULL) OR
+       (session->moves IS NULL) OR (session->squares IS NULL) OR
+       (session->text IS NULL)), "Out of memory");
+  session->text[0] SET_TO 0;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* store_table
+
+Returned Value: int (OK)
+
+Called By:  try_guessing
+
+Side Effects: This stores the key in its slot of the transposition
+table, with world->depth, unless the replacement policy says to keep
+the key already there.
+
+Notes:
+
+With REPLACE_ALWAYS, the newest key always goes in. With
+REPLACE_SHALLOW, a key already in the slot is pushed out only by a key
+stored at the same or a smaller depth. A state found after fewer
+guesses usually heads a larger part of the search tree, so it is more
+worth keeping. An empty slot or the same key is always written.
+The lock is taken only if the table is shared (see probe_table).
+
+*/
+
+int store_table(           /* ARGUMENTS                */
+ unsigned long long key,   /* key of state that failed */
+ struct bap_world * world) /* puzzle model             */
+{
+  const char * name SET_TO "store_table";
+  struct entry * entry; /* slot for key         */
+  struct table * table; /* transposition table  */
+
+  table SET_TO world->table;
+  if (table->shared)
+    pthread_mutex_lock(&(table->lock));
+  entry SET_TO &(table->entries[key & table->mask]);
+  if ((entry->key IS 0) OR (entry->key IS key) OR
+      (table->replace IS REPLACE_ALWAYS) OR (world->depth <= entry->depth))
     {
-      rows SET_TO world->number_rows;
-      test[0] SET_TO '.';
-      test[rows + 1] SET_TO '.';
-      total SET_TO 0;
-      for (n SET_TO 0; n < rows; n++)
-	{
-	  if ((n < row) OR (n > (row + (size - 1))))
-	    {
-	      if ((square(n, col, world) IS ' ') OR
-		  (square(n, col, world) IS '.'))
-		test[n + 1] SET_TO '.';
-	      else
-		{
-		  test[n + 1] SET_TO square(n, col, world);
-		  total++;
-		}
-	    }
-	  else
-	    {
-	      total++;
-	      if (square(n, col, world) IS ' ')
-		{
-		  test[n + 1] SET_TO 'Y';
-		  *ys SET_TO (*ys + 1);
-		}
-	      else
-		test[n + 1] SET_TO square(n, col, world);
-	    }
-	}
-      if (total > world->cols[col].aim)
-	*is_legal SET_TO 0;
-      if (*is_legal)
-	IFF(legal_col_across(test + 1, col, is_legal, world));
-      if (*is_legal)
-	IFF(legal_col_beside(test + 1, col, is_legal, world));
+      if ((entry->key ISNT 0) AND (entry->key ISNT key))
+	table->replaced++;
+      entry->key SET_TO key;
+      entry->depth SET_TO world->depth;
+      table->stores++;
     }
+  if (table->shared)
+    pthread_mutex_unlock(&(table->lock));
   return OK;
 }
 
 /*************************************************************************/
 
-/* ship_fits_row
+/* submarine_covers
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
   1. ship_fits_row_col returns ERROR.
+  2. ship_fits_col_row returns ERROR.
 
 Called By:
-  assign_battleships
-  assign_cruisers
-  assign_destroyers
-  assign_submarines_rows
+  make_guess_ship_col
+  make_guess_ship_row
+  try_square_blank
 
-Side Effects: This sets *fits to the number of the given size that can
-fit in a row in addition to the ones already located there.
+Side Effects: This checks that it is OK for a submarine to be at the
+given row and column. It sets *cover to 1 if OK and to 0 if not.
+
+Notes:
+
+This calls both ship_fits_row_col and ship_fits_col_row so that both
+strips containing the submarine are checked and all four strips
+next to those two strips are also checked.
 
 */
 
-int ship_fits_row(         /* ARGUMENTS                         */
- int row,                  /* index of row being checked        */
- int size,                 /* size of ship                      */
- int * fits,               /* set here to number that fit newly */
- struct bap_world * world) /* puzzle model                      */
+int submarine_covers(      /* ARGUMENTS              */
+ int row,                  /* row index of square    */
+ int col,                  /* column index of square */
+ int * cover,              /* set here to 0  or 1    */
+ struct bap_world * world) /* puzzle model           */
 {
-  const char * name SET_TO "ship_fits_row";
-  int col;
-  int cols;
-  int is_legal;
+  const char * name SET_TO "submarine_covers";
   int ys;
-  int all_ys;
 
-  *fits SET_TO 0;
-  all_ys SET_TO 0;
-  cols SET_TO world->number_cols;
-  for (col SET_TO 0; col < (cols - (size - 1)); col++)
-    {
-      IFF(ship_fits_row_col(row, col, size, &ys, &is_legal, world));
-      if (is_legal)
-	{
-	  if ((world->rows[row].got + ys + all_ys) > world->rows[row].aim)
-	    is_legal SET_TO 0;
-	}
-      if (is_legal)
-	{
-	  if (NOT (world->locations[row][col]))
-	    *fits SET_TO (*fits + 1);
-	  col SET_TO (col + size);
-	  all_ys SET_TO (all_ys + ys);
-	}
-    }
+  IFF(ship_fits_row_col(row, col, 1, &ys, cover, world));
+  if (*cover IS 1)
+    IFF(ship_fits_col_row(col, row, 1, &ys, cover, world));
   return OK;
 }
 
 /*************************************************************************/
 
-/* ship_fits_row_col
+/* summarize_trace
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. Size is less than one or greater than four: "Bug bad size".
-  2. legal_row_across returns ERROR.
-  3. legal_row_beside returns ERROR.
-
-Called By:
-  find_max_starts_row
-  find_min_starts_row
-  make_guess_ship_row
-  ship_covers_row
-  ship_fits_row
-  submarine_covers
+  1. The trace file cannot be opened: "Could not open trace".
+  2. read_trace returns ERROR.
+  3. There is no memory for the records or the counts: "Out of memory".
+  4. The records cannot be read: "Could not read trace".
 
-Side Effects: This checks if a ship of the given size fits in the
-given row, starting in the given column. It also checks if that is a
-legal placement. If the placement is legal, *is_legal is set to 1;
-otherwise, *is_legal is set to 0.
+Called By:  main
 
-ys is set to the number of empty squares that need to be filled so the
-ship has no blanks in it.
+Side Effects: This reads the trace in the file named file_name (see
+make_trace) and prints:
+a. for each depth of guessing, the number of sets of guesses made
+   there, the number of guesses in them, the number tried, the
+   branching factor (guesses tried for each set), the number of
+   guesses tried under which no answer was found, and the calls to
+   solve_problem and the time spent under those guesses;
+b. the number of sets of guesses made from a state that was also
+   guessed from elsewhere (the same key, see table_key), and the calls
+   to solve_problem under them;
+c. the number given (at most) of the largest subtrees in which no
+   answer was found, largest first.
+If the file ends partway through a record, as it may if the search
+traced was stopped, the part of a record is not counted, and a line
+saying that the trace was cut short and that the counts are partial is
+printed before them.
 
 Notes:
 
-size must be 1, 2, 3, or 4
-
-This does not check if a ship is already located in the given row
-starting at the given column.
+The records are written when the search under a guess is over, so a
+guess comes after every guess under it, and read backwards, the guess
+a set was made under comes before the set. The last guess read at
+each depth is kept (in last_found and in_repeat), so each record is
+matched with the guess above it. The counts at each depth include
+every guess at that depth, but the totals and the largest subtrees
+count a guess with no answer under it only if the guess above it
+found one (or it is at depth 0), since every guess under a guess with
+no answer has no answer either, and its calls are already counted.
+The same is done for guesses made from a state reached more than once.
 
-This builds a test row used by legal_row_across and
-legal_row_beside.  The ship to be tested is inserted in the test
-row starting at the given col. Squares of the ship that were
-previously blank are marked with Y. Blank squares in the test row
-outside the ship are marked as water. This is only for the convenience
-of legal_row_across and legal_row_beside, not because they are all
-necessarily water (although the two at the ends of the ship are
-necessarily water).
+The keys are counted in an open addressed table twice as big as the
+number of sets (see trace_slot).
 
 */
 
-int ship_fits_row_col(     /* ARGUMENTS                                 */
- int row,                  /* index of row being checked                */
- int col,                  /* index of column being checked             */
- int size,                 /* size of ship                              */
- int * ys,                 /* number of additional ship parts, set here */
- int * is_legal,           /* set here to 0 or 1                        */
- struct bap_world * world) /* puzzle model                              */
+int summarize_trace(       /* ARGUMENTS                                */
+ char * file_name,         /* name of trace file                       */
+ int number,               /* number of largest subtrees to list       */
+ struct bap_world * world) /* puzzle model, for messages               */
 {
-  const char * name SET_TO "ship_fits_row_col";
-  int cols;
-  char item1;
-  char item2;
-  char item3;
-  char item4;
-  char test[MAX_TEST];
-  int n;
-  int total;
+  const char * name SET_TO "summarize_trace";
+  const char * ships[5] SET_TO
+    {"", "submarine", "destroyer", "cruiser", "battleship"};
+  FILE * port;                    /* port to trace file                 */
+  struct trace_head head;         /* head of trace                      */
+  char * text;                    /* text of puzzle, not used           */
+  long long first;                /* position of first record in file   */
+  long long number_records;       /* number of whole records            */
+  long long cut;                  /* bytes of last record, if cut short */
+  struct trace_record * records;  /* all records, in order written      */
+  struct trace_record * record;   /* record being counted               */
+  struct trace_record * largest;  /* largest subtrees with no answer    */
+  struct trace_depth * depths;    /* counts at each depth               */
+  struct trace_depth total;       /* counts over all depths             */
+  int number_depths;              /* one more than the deepest depth    */
+  int number_largest;             /* number of subtrees in largest      */
+  int * last_found;               /* found of last guess read at depth  */
+  int * in_repeat;                /* 1 if last set read at depth was    */
+                                  /* made in a repeated state           */
+  int * fresh;                    /* 1 if next guess read at depth      */
+                                  /* starts a new set                   */
+  unsigned long long * keys;      /* keys of sets, zero if empty        */
+  long long * counts;             /* number of sets with each key       */
+  unsigned long long mask;        /* number of slots of keys - 1        */
+  long long slot;                 /* slot of key                        */
+  long long repeats;              /* sets made from a repeated state    */
+  long long repeat_nodes;         /* calls under outermost of those     */
+  int outer;                      /* 1 if record is outermost failure   */
+  int result;                     /* value returned by read_trace       */
+  long long n;
+  int k;
 
-  CHB(((size < 1) OR (size > 4)), "Bug bad size");
-  *ys SET_TO 0;
-  *is_legal SET_TO 1;
-  item1 SET_TO world->squares[row][col];
-  if (((square(row - 1, col - 1, world) ISNT '.') AND
-       (square(row - 1, col - 1, world) ISNT ' ')) OR
-      ((square(row, col - 1, world) ISNT '.') AND
-       (square(row, col - 1, world) ISNT ' ')) OR
-      ((square(row + 1, col - 1, world) ISNT '.') AND
-       (square(row + 1, col - 1, world) ISNT ' ')) OR
-      ((square(row - 1, col, world) ISNT '.') AND
-       (square(row - 1, col, world) ISNT ' ')) OR
-      ((square(row + 1, col, world) ISNT '.') AND
-       (square(row + 1, col, world) ISNT ' ')) OR
-      ((square(row - 1, col + 1, world) ISNT '.') AND
-       (square(row - 1, col + 1, world) ISNT ' ')) OR
-      ((square(row + 1, col + 1, world) ISNT '.') AND
-       (square(row + 1, col + 1, world) ISNT ' ')))
-    *is_legal SET_TO 0;
-  if (*is_legal AND (size > 1))
-    {
-      item2 SET_TO world->squares[row][col + 1];
-      if (((square(row - 1, col + 2, world) ISNT '.') AND
-	   (square(row - 1, col + 2, world) ISNT ' ')) OR
-	  ((square(row + 1, col + 2, world) ISNT '.') AND
-	   (square(row + 1, col + 2, world) ISNT ' ')))
-	*is_legal SET_TO 0;
-    }
-  if (*is_legal AND (size > 2))
-    {
-      item3 SET_TO world->squares[row][col + 2];
-      if (((square(row - 1, col + 3, world) ISNT '.') AND
-	   (square(row - 1, col + 3, world) ISNT ' ')) OR
-	  ((square(row + 1, col + 3, world) ISNT '.') AND
-	   (square(row + 1, col + 3, world) ISNT ' ')))
-	*is_legal SET_TO 0;
-    }
-  if (*is_legal AND (size > 3))
+  port SET_TO fopen(file_name, "rb");
+  CHB((port IS NULL), "Could not open trace");
+  result SET_TO read_trace(port, &head, &text, world);
+  free(text);
+  if (result ISNT OK)
+    fclose(port);
+  IFF(result);
+  first SET_TO ftell(port);
+  fseek(port, 0, SEEK_END);
+  number_records SET_TO
+    ((ftell(port) - first) / (long long)sizeof(struct trace_record));
+  cut SET_TO
+    ((ftell(port) - first) % (long long)sizeof(struct trace_record));
+  fseek(port, first, SEEK_SET);
+  records SET_TO (struct trace_record *)
+    malloc((number_records + 1) * sizeof(struct trace_record));
+  if (records ISNT NULL)
+    n SET_TO (long long)fread(records, sizeof(struct trace_record),
+			      number_records, port);
+  fclose(port);
+  CHB((records IS NULL), "Out of memory");
+  if (n ISNT number_records)
+    free(records);
+  CHB((n ISNT number_records), "Could not read trace");
+  number_depths SET_TO 1;
+  total.sets SET_TO 0;
+  for (n SET_TO 0; n < number_records; n++)
     {
-      item4 SET_TO world->squares[row][col + 3];
-      if (((square(row - 1, col + 4, world) ISNT '.') AND
-	   (square(row - 1, col + 4, world) ISNT ' ')) OR
-	  ((square(row + 1, col + 4, world) ISNT '.') AND
-	   (square(row + 1, col + 4, world) ISNT ' ')))
-	*is_legal SET_TO 0;
+      if (records[n].depth >= number_depths)
+	number_depths SET_TO (records[n].depth + 1);
+      if (records[n].index IS 0)
+	total.sets++;
     }
-  if (*is_legal)
+  for (mask SET_TO 1; mask < (unsigned long long)(2 * total.sets + 2);
+       mask SET_TO (2 * mask));
+  depths SET_TO (struct trace_depth *)
+    calloc(number_depths, sizeof(struct trace_depth));
+  last_found SET_TO (int *)calloc(number_depths, sizeof(int));
+  in_repeat SET_TO (int *)calloc(number_depths, sizeof(int));
+  fresh SET_TO (int *)calloc((number_depths + 1), sizeof(int));
+  keys SET_TO (unsigned long long *)calloc(mask, sizeof(unsigned long long));
+  counts SET_TO (long long *)calloc(mask, sizeof(long long));
+  largest SET_TO (struct trace_record *)
+    malloc(number * sizeof(struct trace_record));
+  mask SET_TO (mask - 1);
+  if ((depths IS NULL) OR (last_found IS NULL) OR (in_repeat IS NULL) OR
+      (fresh IS NULL) OR (keys IS NULL) OR (counts IS NULL) OR
+      (largest IS NULL))
     {
-      if (size IS 1)
-	{
-	  if (((item1 ISNT 'O') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
-	      ((square(row, col + 1, world) ISNT '.') AND
-	       (square(row, col + 1, world) ISNT ' ')))
-	    *is_legal SET_TO 0;
-	}
-      else if (size IS 2)
-	{
-	  if (((item1 ISNT '<') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
-	      ((item2 ISNT '>') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
-	      ((square(row, col + 2, world) ISNT '.') AND
-	       (square(row, col + 2, world) ISNT ' ')))
-	    *is_legal SET_TO 0;
-	}
-      else if (size IS 3)
-	{
-	  if (((item1 ISNT '<') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
-	      ((item2 ISNT '+') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
-	      ((item3 ISNT '>') AND (item3 ISNT 'X') AND (item3 ISNT ' ')) OR
-	      ((square(row, col + 3, world) ISNT '.') AND
-	       (square(row, col + 3, world) ISNT ' ')))
-	    *is_legal SET_TO 0;
-	}
-      else if (size IS 4)
-	{
-	  if (((item1 ISNT '<') AND (item1 ISNT 'X') AND (item1 ISNT ' ')) OR
-	      ((item2 ISNT '+') AND (item2 ISNT 'X') AND (item2 ISNT ' ')) OR
-	      ((item3 ISNT '+') AND (item3 ISNT 'X') AND (item3 ISNT ' ')) OR
-	      ((item4 ISNT '>') AND (item4 ISNT 'X') AND (item4 ISNT ' ')) OR
-	      ((square(row, col + 4, world) ISNT '.') AND
-	       (square(row, col + 4, world) ISNT ' ')))
-	    *is_legal SET_TO 0;
-	}
+      free(records);
+      free(depths);
+      free(last_found);
+      free(in_repeat);
+      free(fresh);
+      free(keys);
+      free(counts);
+      free(largest);
     }
-  if (*is_legal)
+  CHB(((depths IS NULL) OR (last_found IS NULL) OR (in_repeat IS NULL) OR
+       (fresh IS NULL) OR (keys IS NULL) OR (counts IS NULL) OR
+       (largest IS NULL)), "Out of memory");
+  for (n SET_TO 0; n < number_records; n++)
     {
-      cols SET_TO world->number_cols;
-      test[0] SET_TO '.';
-      test[cols + 1] SET_TO '.';
-      total SET_TO 0;
-      for (n SET_TO 0; n < cols; n++)
-	{
-	  if ((n < col) OR (n > (col + (size - 1))))
-	    {
-	      if ((square(row, n, world) IS ' ') OR
-		  (square(row, n, world) IS '.'))
-		test[n + 1] SET_TO '.';
-	      else
-		{
-		  test[n + 1] SET_TO square(row, n, world);
-		  total++;
-		}
-	    }
-	  else
-	    {
-	      total++;
-	      if (square(row, n, world) IS ' ')
-		{
-		  test[n + 1] SET_TO 'Y';
-		  *ys SET_TO (*ys + 1);
-		}
-	      else
-		test[n + 1] SET_TO square(row, n, world);
+      if (records[n].index IS 0)
+	{
+	  IFF(trace_slot(records[n].key, keys, mask, &slot));
+	  keys[slot] SET_TO records[n].key;
+	  counts[slot]++;
+	}
+    }
+  total.failed SET_TO 0;
+  total.guesses SET_TO 0;
+  total.offered SET_TO 0;
+  total.wasted SET_TO 0;
+  total.wasted_nanoseconds SET_TO 0;
+  repeats SET_TO 0;
+  repeat_nodes SET_TO 0;
+  number_largest SET_TO 0;
+  fresh[0] SET_TO 1;
+  for (n SET_TO (number_records - 1); n >= 0; n--)
+    {
+      record SET_TO &(records[n]);
+      k SET_TO record->depth;
+      if (fresh[k])
+	{
+	  fresh[k] SET_TO 0;
+	  depths[k].sets++;
+	  depths[k].offered SET_TO
+	    (depths[k].offered + record->number_guesses);
+	  IFF(trace_slot(record->key, keys, mask, &slot));
+	  in_repeat[k] SET_TO 0;
+	  if (counts[slot] > 1)
+	    {
+	      repeats++;
+	      in_repeat[k] SET_TO (((k IS 0) OR (in_repeat[k - 1] IS 0)) ? 2 : 1);
 	    }
+	  else if ((k > 0) AND in_repeat[k - 1])
+	    in_repeat[k] SET_TO 1;
 	}
-      if (total > world->rows[row].aim)
-	*is_legal SET_TO 0;
-      if (*is_legal)
-	IFF(legal_row_across(test + 1, row, is_legal, world));
-      if (*is_legal)
-	IFF(legal_row_beside(test + 1, row, is_legal, world));
+      fresh[k + 1] SET_TO 1;
+      last_found[k] SET_TO record->found;
+      if (in_repeat[k] IS 2)
+	repeat_nodes SET_TO (repeat_nodes + record->nodes);
+      depths[k].guesses++;
+      if (record->found)
+	continue;
+      depths[k].failed++;
+      depths[k].wasted SET_TO (depths[k].wasted + record->nodes);
+      depths[k].wasted_nanoseconds SET_TO
+	(depths[k].wasted_nanoseconds + record->nanoseconds);
+      outer SET_TO ((k IS 0) OR last_found[k - 1]);
+      if (outer IS 0)
+	continue;
+      total.wasted SET_TO (total.wasted + record->nodes);
+      total.wasted_nanoseconds SET_TO
+	(total.wasted_nanoseconds + record->nanoseconds);
+      for (k SET_TO number_largest;
+	   ((k > 0) AND (largest[k - 1].nodes < record->nodes)); k--)
+	{
+	  if (k < number)
+	    largest[k] SET_TO largest[k - 1];
+	}
+      if (k < number)
+	largest[k] SET_TO *record;
+      if (number_largest < number)
+	number_largest++;
     }
+  if (cut)
+    printf("Trace cut short: the last record has %lld of %d bytes, so "
+	   "only the %lld\nwhole records are counted, and the counts are "
+	   "partial.\n\n", cut, (int)sizeof(struct trace_record),
+	   number_records);
+  printf("%5s %10s %10s %10s %9s %10s %12s %12s\n", "depth", "sets",
+	 "offered", "tried", "branching", "failed", "wasted", "wasted ms");
+  for (k SET_TO 0; k < number_depths; k++)
+    {
+      printf("%5d %10lld %10lld %10lld %9.2f %10lld %12lld %12.3f\n", k,
+	     depths[k].sets, depths[k].offered, depths[k].guesses,
+	     ((depths[k].sets IS 0) ? 0.0 :
+	      ((double)depths[k].guesses / depths[k].sets)),
+	     depths[k].failed, depths[k].wasted,
+	     (depths[k].wasted_nanoseconds / 1e6));
+      total.offered SET_TO (total.offered + depths[k].offered);
+      total.guesses SET_TO (total.guesses + depths[k].guesses);
+      total.failed SET_TO (total.failed + depths[k].failed);
+    }
+  printf("%5s %10lld %10lld %10lld %9.2f %10lld %12lld %12.3f\n", "all",
+	 total.sets, total.offered, total.guesses,
+	 ((total.sets IS 0) ? 0.0 : ((double)total.guesses / total.sets)),
+	 total.failed, total.wasted, (total.wasted_nanoseconds / 1e6));
+  printf("\nRepeated states: %lld of %lld sets of guesses made from a state "
+	 "reached more\nthan once, with %lld calls under them\n",
+	 repeats, total.sets, repeat_nodes);
+  printf("\nLargest subtrees with no answer:\n");
+  for (k SET_TO 0; k < number_largest; k++)
+    printf("depth %d, guess %d of %d, %s %s row %d and column %d: "
+	   "%lld calls, %.3f ms\n", largest[k].depth,
+	   (largest[k].index + 1), largest[k].number_guesses,
+	   ships[((largest[k].the_guess.size < 1) OR
+		  (largest[k].the_guess.size > 4)) ? 0 :
+		 largest[k].the_guess.size],
+	   ((largest[k].the_guess.size IS 1) ? "is at" :
+	    largest[k].the_guess.in_row ? "is in row at" : "is in column at"),
+	   (largest[k].the_guess.row + 1), (largest[k].the_guess.col + 1),
+	   largest[k].nodes, (largest[k].nanoseconds / 1e6));
+  free(records);
+  free(depths);
+  free(last_found);
+  free(in_repeat);
+  free(fresh);
+  free(keys);
+  free(counts);
+  free(largest);
   return OK;
 }
 
 /*************************************************************************/
 
-/* solve_problem
+/* table_key
 
-Returned Value: int
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. One of the following functions returns ERROR:
-     assign_battleships, assign_cruisers, assign_destroyers,
-     assign_submarines, dex_squares, explain_bap, extend_middles, fill_bap,
-     locate_ships, mark_dones, place_battleships, place_cruisers,
-     place_destroyers, print_bap, try_cross, try_full, try_full_but_one,
-     try_guessing, try_square_blank, verify_squares.
+Returned Value: int (OK)
 
-Called By:
-  main
-  try_guessing
+Called By:  try_guessing
 
-Side Effects: The puzzle gets filled in, if possible. While this is
-happening, the bap_world gets changed continually.
+Side Effects: This sets *key to the key of the state of the world in
+the transposition table. It is world->hash with the ship counters of
+every strip and of the world folded in.
 
 Notes:
 
-This has a hard-coded list of things to try for solving
-the puzzle arranged in order from easy to hard:
+The squares alone do not fix the state, since ships may be assigned to
+strips without any of their parts being marked. The counters are
+folded in here rather than kept in world->hash, since they change far
+more often than the table is used.
 
-1.  Check the current state of the puzzle for being legal (verify_squares).
-2.  Locate previously unlocated identifiable ships. A ship is not
-    identifiable until it has no Xs in it and has all parts (ends
-    and middle, if any) in place (locate_ships).
-3.  Mark the rows and columns that are done (mark dones).
-4.  Fill with water the blanks of any strip that has all the ship parts
-    it needs but still has some blanks (fill_bap).
-5.  Extend with X's (unknown ship parts) any ship middles that
-    can be extended (extend_middles).
-6.  Change to a known ship part any unknown ship part whose identify
-    can be determined (dex_squares).
-7.  Fill with ship parts any unfilled strip that has only as many dry
-    squares as the number of ship parts it needs (try_full).
-8.  Fill with ship parts any squares of [any strip that has only one
-    fewer dry squares than the number of ship parts it needs] which must
-    be filled no matter where the one additional water square is
-    (legally) placed (try_full_but_one)
-9.  Assign battleships to strips, if possible (assign_battleships).
-10. Place battleship parts in strips where battleships are assigned,
-    if possible (place_battleships).
-11. Assign cruisers to strips, if possible (assign_cruisers).
-12. Place cruiser parts in strips where cruisers are assigned,
-    if possible (place_cruisers).
-13. Assign destroyers to strips, if possible (assign_destroyers).
-14. Place destroyer parts in strips where destroyers are assigned,
-    if possible (place_destroyers).
-15. Assign submarines to strips, if possible (assign_submarines).
-16. Look at each blank square, one at a time, and determine if it can
-    be covered by any available ship. If not, mark it water
-    (try_square_blank).
-17. Look for the situation described in documentation of try_cross
-    and mark ship parts (and water) if possible.
-18. If done, print the puzzle and the explanation of how it was solved.
-    If not, return whatever try_guessing returns.
+Zero marks an empty slot, so a key of zero is changed to one.
 
-The function goes down the list of things to try. verify_squares and
-locate_ships are always run. They do not fill in any squares. After
-that, as soon as one of the functions succeeds in filling in even one
-square, solve_problem goes back to the top of the list (skipping the
-remaining, harder, things to try) and goes down it again. The easier
-things to try (even the same thing that worked last time) may now work
-because more of the puzzle is filled in.
+*/
 
-If all the things to try do not solve the puzzle, call try_guessing,
-which calls solve_problem recursively. As a result of the recursive
-call, multiple solutions can be found.
+int table_key(               /* ARGUMENTS                */
+ unsigned long long * key,   /* set here to key of state */
+ struct bap_world * world)   /* puzzle model             */
+{
+  const char * name SET_TO "table_key";
+  unsigned long long fold;  /* counters folded together */
+  struct strip * strip;     /* row or column            */
+  int n;
+
+  fold SET_TO 0;
+  for (n SET_TO 0; n < (world->number_rows + world->number_cols); n++)
+    {
+      strip SET_TO ((n < world->number_rows) ? &(world->rows[n]) :
+		    &(world->cols[n - world->number_rows]));
+      fold SET_TO ((fold * 1000003) +
+		   (unsigned long long)(strip->battleships +
+					(8 * strip->cruisers) +
+					(64 * strip->destroyers) +
+					(512 * strip->submarines) +
+					(4096 * strip->done)));
+    }
+  fold SET_TO ((fold * 1000003) + world->battleships_ass);
+  fold SET_TO ((fold * 1000003) + world->battleships_left);
+  fold SET_TO ((fold * 1000003) + world->cruisers_ass);
+  fold SET_TO ((fold * 1000003) + world->cruisers_left);
+  fold SET_TO ((fold * 1000003) + world->destroyers_ass);
+  fold SET_TO ((fold * 1000003) + world->destroyers_left);
+  fold SET_TO ((fold * 1000003) + world->submarines_ass_col);
+  fold SET_TO ((fold * 1000003) + world->submarines_ass_row);
+  fold SET_TO ((fold * 1000003) + world->submarines_left_col);
+  fold SET_TO ((fold * 1000003) + world->submarines_left_row);
+  IFF(scramble_key(&fold));
+  *key SET_TO (world->hash ^ fold);
+  if (*key IS 0)
+    *key SET_TO 1;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* take_task
+
+Returned Value: int (OK)
+
+Called By:  work_queue
+
+Side Effects: This takes a task off a queue and sets *the_task to it,
+or sets *the_task to NULL if every queue is empty. The task most
+recently added to the given queue is taken if there is one. Otherwise,
+the oldest task on some other queue is taken.
+
+Notes:
+
+The lock on the pool must be held when this is called.
+
+Taking the newest task from a thread's own queue keeps the thread
+working on the part of the search tree it has most recently opened.
+Taking the oldest task from another queue takes a task from near the
+top of the tree, which is likely to be a big piece of work.
 
 */
 
-int solve_problem(         /* ARGUMENTS    */
- struct bap_world * world) /* puzzle model */
+int take_task(              /* ARGUMENTS                     */
+ struct queue * the_queue,  /* queue of thread wanting task  */
+ struct task ** the_task)   /* set here to task taken        */
 {
-  const char * name SET_TO "solve_problem";
+  const char * name SET_TO "take_task";
+  struct queue * other;  /* queue to take task from */
+  int n;
 
-  for (world->progress SET_TO 0; world->undone ISNT 0; world->progress SET_TO 0)
+  *the_task SET_TO NULL;
+  if (the_queue->number_tasks > 0)
     {
-      IFF(verify_squares(world));
-      IFF(locate_ships(world));
-      IFF(mark_dones(world));
-      if (world->progress)
-	continue;
-      IFF(fill_bap(world));
-      if (world->progress)
-	continue;
-      IFF(extend_middles(world));
-      if (world->progress)
-	continue;
-      IFF(dex_squares(world));
-      if (world->progress)
-	continue;
-      IFF(try_full(world));
-      if (world->progress)
-	continue;
-      IFF(try_full_but_one(world));
-      if (world->progress)
-	continue;
-      if (world->battleships_left)
-	{
-	  IFF(assign_battleships(world));
-	  if (world->progress)
-	    continue;
-	}
-      if (world->battleships_ass)
-	{
-	  IFF(place_battleships(world));
-	  if (world->progress)
-	    continue;
-	}
-      if (world->cruisers_left)
+      the_queue->number_tasks--;
+      *the_task SET_TO the_queue->tasks[(the_queue->first +
+					 the_queue->number_tasks) %
+					MAX_TASKS];
+    }
+  for (n SET_TO 1; ((*the_task IS NULL) AND
+		    (n < the_queue->pool->number_threads)); n++)
+    {
+      other SET_TO &(the_queue->pool->queues[(the_queue->worker + n) %
+					       the_queue->pool->number_threads]);
+      if (other->number_tasks > 0)
 	{
-	  IFF(assign_cruisers(world));
-	  if (world->progress)
-	    continue;
+	  *the_task SET_TO other->tasks[other->first];
+	  other->first SET_TO ((other->first + 1) % MAX_TASKS);
+	  other->number_tasks--;
 	}
-      if (world->cruisers_ass)
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* touch_number
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. touch_strips returns ERROR.
+
+Called By:
+  trail_number
+  undo_trail
+
+Side Effects: If world->worklist is set, this touches the strips that
+may read the given counter when it is about to change. A counter of a
+row is read when looking at that row and the rows beside it (see
+legal_row_beside), so those three rows are touched. Columns are the
+same. A location is read only when looking at its row and column, so
+those are touched. Nothing is touched for the other counters, which
+count ships for the whole puzzle; slack_strips touches what needs to
+be touched for them.
+
+*/
+
+int touch_number(          /* ARGUMENTS                      */
+ int * number,             /* counter that is about to change */
+ struct bap_world * world) /* puzzle model                   */
+{
+  const char * name SET_TO "touch_number";
+  long offset;  /* index of counter in locations */
+  int row;
+  int col;
+
+  if (world->worklist)
+    {
+      offset SET_TO (number - world->locations[0]);
+      if ((number >= (int *)world->rows) AND
+	  (number < (int *)(world->rows + world->number_rows)))
 	{
-	  IFF(place_cruisers(world));
-	  if (world->progress)
-	    continue;
+	  row SET_TO (((char *)number - (char *)world->rows) /
+		      sizeof(struct strip));
+	  IFF(touch_strips((row - 1), (row + 1), 0, -1, world));
 	}
-      if (world->destroyers_left)
+      else if ((number >= (int *)world->cols) AND
+	       (number < (int *)(world->cols + world->number_cols)))
 	{
-	  IFF(assign_destroyers(world));
-	  if (world->progress)
-	    continue;
+	  col SET_TO (((char *)number - (char *)world->cols) /
+		      sizeof(struct strip));
+	  IFF(touch_strips(0, -1, (col - 1), (col + 1), world));
 	}
-      if (world->destroyers_ass)
+      else if ((offset >= 0) AND
+	       (offset < ((long)world->number_rows * world->number_cols)))
 	{
-	  IFF(place_destroyers(world));
-	  if (world->progress)
-	    continue;
+	  row SET_TO (offset / world->number_cols);
+	  col SET_TO (offset % world->number_cols);
+	  IFF(touch_strips(row, row, col, col, world));
 	}
-      IFF(assign_submarines(world));
-      if (world->progress)
-	continue;
-      IFF(try_square_blank(world));
-      if (world->progress)
-	continue;
-      IFF(try_full_but_two(world));
-      if (world->progress)
-	continue;
-      IFF(try_cross(world));
-      if (world->progress)
-	continue;
-      else
-	break;
     }
-  if (world->undone IS 0)
+  return OK;
+}
+
+/*************************************************************************/
+
+/* touch_strips
+
+Returned Value: int (OK)
+
+Called By:
+  set_square
+  slack_strips
+  touch_number
+
+Side Effects: If world->worklist is set, this moves the clock on by
+one and marks the given rows and columns as changed at that time, so
+that every rule looks at them again (see QUEUED). Rows or columns
+outside the puzzle are ignored, so a first index larger than the last
+touches none.
+
+*/
+
+int touch_strips(          /* ARGUMENTS                       */
+ int first_row,            /* index of first row to touch     */
+ int last_row,             /* index of last row to touch      */
+ int first_col,            /* index of first column to touch  */
+ int last_col,             /* index of last column to touch   */
+ struct bap_world * world) /* puzzle model                    */
+{
+  const char * name SET_TO "touch_strips";
+  int row;
+  int col;
+
+  if (world->worklist)
     {
-      IFF(print_bap(world));
-      IFF(explain_bap(world));
+      world->clock++;
+      if (first_row < 0)
+	first_row SET_TO 0;
+      if (last_row > (world->number_rows - 1))
+	last_row SET_TO (world->number_rows - 1);
+      for (row SET_TO first_row; row <= last_row; row++)
+	world->rows[row].changed SET_TO world->clock;
+      if (first_col < 0)
+	first_col SET_TO 0;
+      if (last_col > (world->number_cols - 1))
+	last_col SET_TO (world->number_cols - 1);
+      for (col SET_TO first_col; col <= last_col; col++)
+	world->cols[col].changed SET_TO world->clock;
     }
-  else
+  return OK;
+}
+
+/*************************************************************************/
+
+/* trace_guess
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. profile_clock returns ERROR.
+  2. The record cannot be written: "Could not write trace".
+
+Called By:  try_guessing
+
+Side Effects: This finishes the record of a guess that has been tried,
+which try_guessing has filled in but for the time and the calls to
+solve_problem under the guess (record->nodes is the count before the
+guess was tried), and writes it to the trace.
+
+If the trace is being replayed, the record is instead compared with
+the next one in the trace file, leaving out the time. At the first
+that differs, or if the file has no more records, world->trace->differ
+is set to its number, and no more records are read.
+
+*/
+
+int trace_guess(                    /* ARGUMENTS                  */
+ struct trace_record * record,      /* record of guess tried      */
+ long long start,                   /* time guess was started     */
+ struct bap_world * world)          /* puzzle model               */
+{
+  const char * name SET_TO "trace_guess";
+  struct trace * trace;             /* trace of world             */
+  struct trace_record traced;       /* record read, if replaying  */
+  long long now;                    /* time guess was finished    */
+
+  trace SET_TO world->trace;
+  IFF(profile_clock(&now));
+  record->nanoseconds SET_TO (now - start);
+  record->nodes SET_TO (trace->nodes - record->nodes);
+  trace->number_records++;
+  if (trace->replay IS 0)
+    CHB((fwrite(record, sizeof(struct trace_record), 1, trace->port) ISNT 1),
+	"Could not write trace");
+  else if (trace->differ IS 0)
     {
-      IFF(try_guessing(world));
+      if ((fread(&traced, sizeof(struct trace_record), 1, trace->port)
+	   ISNT 1) OR
+	  (traced.key ISNT record->key) OR
+	  (traced.nodes ISNT record->nodes) OR
+	  (traced.depth ISNT record->depth) OR
+	  (traced.found ISNT record->found) OR
+	  (traced.index ISNT record->index) OR
+	  (traced.number_guesses ISNT record->number_guesses) OR
+	  (traced.the_guess.row ISNT record->the_guess.row) OR
+	  (traced.the_guess.col ISNT record->the_guess.col) OR
+	  (traced.the_guess.size ISNT record->the_guess.size) OR
+	  (traced.the_guess.in_row ISNT record->the_guess.in_row))
+	trace->differ SET_TO trace->number_records;
     }
   return OK;
 }
 
 /*************************************************************************/
 
-/* square
+/* trace_slot
 
-Returned Value: char
+Returned Value: int (OK)
 
-This returns the actual character of world->squares in the row, col
-position if the square is inside the defined area, and returns water
-('.') otherwise.
+Called By:  summarize_trace
+
+Side Effects: This sets *slot to the index of the slot of keys that
+holds key, or of the empty slot (zero) where it would go. keys has
+mask + 1 slots, a power of 2, and at least one of them is empty.
+
+*/
+
+int trace_slot(               /* ARGUMENTS                          */
+ unsigned long long key,      /* key of state (see table_key)       */
+ unsigned long long * keys,   /* slots of keys, zero if empty       */
+ unsigned long long mask,     /* number of slots - 1                */
+ long long * slot)            /* index of slot of key, set here     */
+{
+  const char * name SET_TO "trace_slot";
+
+  for (*slot SET_TO (long long)(key & mask);
+       ((keys[*slot] ISNT 0) AND (keys[*slot] ISNT key));
+       *slot SET_TO (long long)((*slot + 1) & mask));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* trail_number
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The trail is full: "Bug trail too long".
+  2. touch_number returns ERROR.
 
 Called By:
+  allocate_ship_col
+  allocate_ship_row
+  assign_battleships
+  assign_cruisers
+  assign_destroyers
+  assign_submarines
   assign_submarines_cols
   assign_submarines_rows
-  dex_ends_col
-  dex_ends_row
-  dex_square
-  extend_ends
-  extend_horizontal
-  extend_middle
-  extend_vertical
-  legal_col_across
-  legal_col_beside
-  legal_row_across
-  legal_row_beside
-  locate_ships
-  make_water
-  place_ships_col
-  place_ships_col_water
-  place_ships_row
-  place_ships_row_water
-  ship_fits_col_row
-  ship_fits_row_col
-  try_cross_col_fill_col
-  try_cross_col_fill_row
-  try_cross_row_fill_col
-  try_cross_row_fill_row
-  try_full
-  try_full_but_one_col
-  try_full_but_one_row
-  try_full_but_two_col
-  try_full_but_two_row
-  try_square_blank
-  verify_square
+  dex_square
+  enx_square
+  insert_guess_square
+  make_water
+  mark_dones
 
-Side Effects: none
+Side Effects: If a trail is in use, this records the current value of
+the given counter on the trail so that undo_trail can restore it. The
+strips that read the counter are touched (see touch_number).
 
 Notes:
 
-This is an array referencer for world->squares that pads the occupied
-squares with a virtually infinite amount of virtual water. Doing this
-allows the functions that use it to pretend the array consists of
-all inside squares (none along the edges), which simplifies things
-greatly.
-
-Virtual water is better than actual water because there is as much of
-it as necessary, and it is not necessary to fiddle with the world->squares
-array itself.
+This must be called before the counter is changed, not after.
 
 */
 
-char square(               /* ARGUMENTS              */
- int row,                  /* row index of square    */
- int col,                  /* column index of square */
- struct bap_world * world) /* puzzle model           */
+int trail_number(          /* ARGUMENTS                        */
+ int * number,             /* counter that is about to change  */
+ struct bap_world * world) /* puzzle model                     */
 {
-  const char * name SET_TO "square";
-  char return_value;
+  const char * name SET_TO "trail_number";
+  struct change * the_change;
 
-  if ((row > -1) AND
-      (row < world->number_rows) AND
-      (col > -1) AND
-      (col < world->number_cols))
-    return_value SET_TO world->squares[row][col];
-  else
-    return_value SET_TO '.';
-  return return_value;
+  if (world->trail)
+    {
+      CHB((world->trail->number_changes IS world->trail->size),
+	  "Bug trail too long");
+      the_change SET_TO
+	(world->trail->changes + world->trail->number_changes++);
+      the_change->number SET_TO number;
+      the_change->value SET_TO *number;
+    }
+  IFF(touch_number(number, world));
+  return OK;
 }
 
 /*************************************************************************/
 
-/* submarine_covers
+/* trail_square
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. ship_fits_row_col returns ERROR.
-  2. ship_fits_col_row returns ERROR.
+  1. The trail is full: "Bug trail too long".
 
 Called By:
-  make_guess_ship_col
-  make_guess_ship_row
-  try_square_blank
+  dex_square
+  enx_square
+  insert_guess_square
+  make_water
 
-Side Effects: This checks that it is OK for a submarine to be at the
-given row and column. It sets *cover to 1 if OK and to 0 if not.
+Side Effects: If a trail is in use, this records the current character
+in the square at the given row and column on the trail so that
+undo_trail can restore it.
 
 Notes:
 
-This calls both ship_fits_row_col and ship_fits_col_row so that both
-strips containing the submarine are checked and all four strips
-next to those two strips are also checked.
+This must be called before the square is changed, not after.
 
 */
 
-int submarine_covers(      /* ARGUMENTS              */
+int trail_square(          /* ARGUMENTS              */
  int row,                  /* row index of square    */
  int col,                  /* column index of square */
- int * cover,              /* set here to 0  or 1    */
  struct bap_world * world) /* puzzle model           */
 {
-  const char * name SET_TO "submarine_covers";
-  int ys;
+  const char * name SET_TO "trail_square";
+  struct change * the_change;
 
-  IFF(ship_fits_row_col(row, col, 1, &ys, cover, world));
-  if (*cover IS 1)
-    IFF(ship_fits_col_row(col, row, 1, &ys, cover, world));
+  if (world->trail)
+    {
+      CHB((world->trail->number_changes IS world->trail->size),
+	  "Bug trail too long");
+      the_change SET_TO
+	(world->trail->changes + world->trail->number_changes++);
+      the_change->number SET_TO NULL;
+      the_change->row SET_TO row;
+      the_change->col SET_TO col;
+      the_change->value SET_TO world->squares[row][col];
+    }
   return OK;
 }
 
@@ -6297,7 +14765,7 @@ Returned Value: int
   1. try_cross_row returns ERROR.
   2. try_cross_column returns ERROR.
 
-Called By:  solve_problem
+Called By:  run_rules
 
 Side Effects:
 
@@ -6431,18 +14899,18 @@ int try_cross_col(         /* ARGUMENTS     */
   int k;                          /* counter for columnss                   */
 
   number_test_cols SET_TO 0;
-  for (k SET_TO 0; k < world->number_cols; k++)
+  for (k SET_TO 0; k < COLS; k++)
     {
       if ((world->cols[k].aim - world->cols[k].got) IS 1)
 	test_cols[number_test_cols++] SET_TO k;
     }
   if (number_test_cols > 1)
     {
-      for (row1 SET_TO 0; row1 < (world->number_rows - 1); row1++)
+      for (row1 SET_TO 0; row1 < (ROWS - 1); row1++)
 	{
 	  if (world->progress)
 	    break;
-	  for (row2 SET_TO (row1 + 1); row2 < world->number_rows; row2++)
+	  for (row2 SET_TO (row1 + 1); row2 < ROWS; row2++)
 	    {
 	      if (world->progress)
 		break;
@@ -6483,7 +14951,7 @@ int try_cross_col_fill_col( /* ARGUMENTS            */
   int n;          /* row index */
 
   filled_one SET_TO 0;
-  for (n SET_TO 0; n < world->number_rows; n++)
+  for (n SET_TO 0; n < ROWS; n++)
     {
       if ((n ISNT row1) AND (n ISNT row2) AND (square(n, col, world) IS ' '))
 	{
@@ -6537,7 +15005,7 @@ int try_cross_col_fill_row( /* ARGUMENTS                   */
 
   m SET_TO 0;
   filled_one SET_TO 0;
-  for (k SET_TO 0; k < world->number_cols; k++)
+  for (k SET_TO 0; k < COLS; k++)
     {
       if (k IS yes_cols[m])
 	{
@@ -6668,18 +15136,18 @@ int try_cross_row(         /* ARGUMENTS    */
   int n;                          /* counter for rows                    */
 
   number_test_rows SET_TO 0;
-  for (n SET_TO 0; n < world->number_rows; n++)
+  for (n SET_TO 0; n < ROWS; n++)
     {
       if ((world->rows[n].aim - world->rows[n].got) IS 1)
 	test_rows[number_test_rows++] SET_TO n;
     }
   if (number_test_rows > 1)
     {
-      for (col1 SET_TO 0; col1 < (world->number_cols - 1); col1++)
+      for (col1 SET_TO 0; col1 < (COLS - 1); col1++)
 	{
 	  if (world->progress)
 	    break;
-	  for (col2 SET_TO (col1 + 1); col2 < world->number_cols; col2++)
+	  for (col2 SET_TO (col1 + 1); col2 < COLS; col2++)
 	    {
 	      if (world->progress)
 		break;
@@ -6730,7 +15198,7 @@ int try_cross_row_fill_col( /* ARGUMENTS                */
 
   m SET_TO 0;
   filled_one SET_TO 0;
-  for (n SET_TO 0; n < world->number_rows; n++)
+  for (n SET_TO 0; n < ROWS; n++)
     {
       if (n IS yes_rows[m])
 	{
@@ -6778,7 +15246,7 @@ int try_cross_row_fill_row( /* ARGUMENTS                 */
   int k;          /* column index */
 
   filled_one SET_TO 0;
-  for (k SET_TO 0; k < world->number_cols; k++)
+  for (k SET_TO 0; k < COLS; k++)
     {
       if ((k ISNT col1) AND (k ISNT col2) AND (square(row, k, world) IS ' '))
 	{
@@ -6879,7 +15347,7 @@ Returned Value: int
   1. enx_square returns ERROR.
   2. record_progress returns ERROR.
 
-Called By:  solve_problem
+Called By:  run_rules
 
 Side Effects: This reads the rows and columns looking for ones for
 which the aim number is the same as the dry number (meaning all the
@@ -6901,12 +15369,12 @@ int try_full(              /* ARGUMENTS    */
 
   world->number_in_rows SET_TO 0;
   world->number_in_cols SET_TO 0;
-  for (n SET_TO 0; n < world->number_rows; n++)
+  for (n SET_TO 0; n < ROWS; n++)
     {
       if ((world->rows[n].done) OR (world->rows[n].dry > world->rows[n].aim))
 	continue;
       filled_one SET_TO 0;
-      for (k SET_TO 0; k < world->number_cols; k++)
+      for (k SET_TO 0; k < COLS; k++)
 	{
 	  if (square(n, k, world) IS ' ')
 	    {
@@ -6917,12 +15385,12 @@ int try_full(              /* ARGUMENTS    */
       if (filled_one)
 	world->rows_in[world->number_in_rows++] SET_TO n;
     }
-  for (k SET_TO 0; k < world->number_cols; k++)
+  for (k SET_TO 0; k < COLS; k++)
     {
       if ((world->cols[k].done) OR (world->cols[k].dry > world->cols[k].aim))
 	continue;
       filled_one SET_TO 0;
-      for (n SET_TO 0; n < world->number_rows; n++)
+      for (n SET_TO 0; n < ROWS; n++)
 	{
 	  if (square(n, k, world) IS ' ')
 	    {
@@ -6949,7 +15417,7 @@ Returned Value: int
   2. try_full_but_one_col returns ERROR.
   3. record_progress returns ERROR.
 
-Called By:  solve_problem
+Called By:  run_rules
 
 Side Effects: This reads the rows and columns looking for ones for
 which the aim number is one less than the dry number (meaning one of the
@@ -6971,10 +15439,10 @@ int try_full_but_one(      /* ARGUMENTS    */
 
   world->number_in_rows SET_TO 0;
   world->number_in_cols SET_TO 0;
-  for (row SET_TO 0; row < world->number_rows; row++)
+  for (row SET_TO 0; row < ROWS; row++)
     if (world->rows[row].dry IS (world->rows[row].aim + 1))
       IFF(try_full_but_one_row(row, world));
-  for (col SET_TO 0; col < world->number_cols; col++)
+  for (col SET_TO 0; col < COLS; col++)
     if (world->cols[col].dry IS (world->cols[col].aim + 1))
       IFF(try_full_but_one_col(col, world));
   IFF(record_progress
@@ -7022,14 +15490,14 @@ int try_full_but_one_col(  /* ARGUMENTS     */
   filled_one SET_TO 0;
   found_legal SET_TO 0;
   test_array[0] SET_TO '.';
-  rows SET_TO world->number_rows;
+  rows SET_TO ROWS;
   test SET_TO (test_array + 1);
   test[rows] SET_TO '.';
-  for (row SET_TO 0; row < world->number_rows; row++)
+  for (row SET_TO 0; row < ROWS; row++)
     {
       if (world->squares[row][col] ISNT ' ')
 	continue;
-      for (n SET_TO 0; n < world->number_rows; n++)
+      for (n SET_TO 0; n < ROWS; n++)
 	{
 	  setting SET_TO square(n, col, world);
 	  test[n] SET_TO
@@ -7099,7 +15567,7 @@ int try_full_but_one_row(  /* ARGUMENTS    */
   int found_legal;
   char setting;
 
-  cols SET_TO world->number_cols;
+  cols SET_TO COLS;
   test_array[0] SET_TO '.';
   test SET_TO (test_array + 1);
   test[cols] SET_TO '.';
@@ -7142,7 +15610,7 @@ Returned Value: int
   2. try_full_but_two_col returns ERROR.
   3. record_progress returns ERROR.
 
-Called By:  solve_problem
+Called By:  run_rules
 
 Side Effects: This reads the rows and columns looking for ones for
 which the aim number is two less than the dry number (meaning two of
@@ -7170,7 +15638,7 @@ int try_full_but_two(      /* ARGUMENTS    */
 
   world->number_in_rows SET_TO 0;
   world->number_in_cols SET_TO 0;
-  for (row SET_TO 0; row < world->number_rows; row++)
+  for (row SET_TO 0; row < ROWS; row++)
     {
       if (world->progress)
 	break;
@@ -7178,7 +15646,7 @@ int try_full_but_two(      /* ARGUMENTS    */
 	IFF(try_full_but_two_row(row, world));
     }
   if (NOT (world->progress))
-    for (col SET_TO 0; col < world->number_cols; col++)
+    for (col SET_TO 0; col < COLS; col++)
       {
 	if (world->progress)
 	  break;
@@ -7249,7 +15717,7 @@ int try_full_but_two_col(  /* ARGUMENTS       */
   int found_legal;               /* flag set to 1 if legal column is found */
   char setting;                  /* character in a square                  */
 
-  rows SET_TO world->number_rows;
+  rows SET_TO ROWS;
   test_array[0] SET_TO '.';
   test SET_TO (test_array + 1);
   test[rows] SET_TO '.';
@@ -7366,7 +15834,7 @@ int try_full_but_two_row(  /* ARGUMENTS    */
   int found_legal;               /* flag set to 1 if legal row is found */
   char setting;                  /* character in a square               */
 
-  cols SET_TO world->number_cols;
+  cols SET_TO COLS;
   test_array[0] SET_TO '.';
   test SET_TO (test_array + 1);
   test[cols] SET_TO '.';
@@ -7429,6 +15897,75 @@ int try_full_but_two_row(  /* ARGUMENTS    */
 
 /*************************************************************************/
 
+/* try_guess_in_place
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. insert_guess_row or insert_guess_col returns ERROR:
+     "Bug guess could not be inserted".
+  2. undo_trail returns ERROR.
+
+Called By:  try_guessing
+
+Side Effects: This inserts the guess into the world, calls solve_problem
+on the same world, and sets *result to what solve_problem returns. Then
+it undoes every change made since the guess was inserted, so that the
+world is left as it was found. This is the in-place alternative to
+making a copy of the world with copy_bap for each guess.
+
+Notes:
+
+The explanation and the list of guesses tried are not put on the
+trail. They only grow at the end, so restoring logic_line, logic_strip,
+and number_guesses_tried is enough to undo them.
+
+If inserting the guess fails, the changes are undone before ERROR is
+returned, just as the copy made by copy_bap would have been thrown
+away.
+
+*/
+
+int try_guess_in_place(    /* ARGUMENTS                                */
+ struct guess * the_guess, /* guess to be tried                        */
+ int * result,             /* set here to what solve_problem returns   */
+ struct bap_world * world) /* puzzle model                             */
+{
+  const char * name SET_TO "try_guess_in_place";
+  int logic_line;           /* value of world->logic_line on entry   */
+  int logic_strip;          /* value of world->logic_strip on entry  */
+  int mark;                 /* number of changes on trail on entry   */
+  int number_guesses_tried; /* value of world->number_guesses_tried  */
+
+  logic_line SET_TO world->logic_line;
+  logic_strip SET_TO world->logic_strip;
+  mark SET_TO world->trail->number_changes;
+  number_guesses_tried SET_TO world->number_guesses_tried;
+  world->number_in_cols SET_TO 0;
+  world->number_in_rows SET_TO 0;
+  world->progress SET_TO 0;
+  if (the_guess->in_row)
+    *result SET_TO insert_guess_row(the_guess, world);
+  else
+    *result SET_TO insert_guess_col(the_guess, world);
+  if (*result IS OK)
+    {
+      *result SET_TO solve_problem(world);
+      IFF(undo_trail(mark, world));
+    }
+  else
+    {
+      IFF(undo_trail(mark, world));
+      CHK(1, "Bug guess could not be inserted");
+    }
+  world->logic_line SET_TO logic_line;
+  world->logic_strip SET_TO logic_strip;
+  world->number_guesses_tried SET_TO number_guesses_tried;
+  return OK;
+}
+
+/*************************************************************************/
+
 /* try_guessing
 
 Returned Value: int
@@ -7437,23 +15974,75 @@ Returned Value: int
   1. No answer is found: "Cannot solve puzzle".
   2. make_guesses_battleships returns ERROR.
   3. make_guesses_cruisers returns ERROR.
-  4. make_guesses_destroyers returns ERROR.
+  4. make_guesses_destroyers, make_guesses_submarines, or
+     make_guesses_fewest returns ERROR.
   5. copy_bap returns ERROR.
   6. insert_guess returns ERROR.
+  7. try_guess_in_place returns ERROR.
+  8. The list of guesses tried is full: "Bug too many guesses tried".
+  9. The branch is too deep: "Bug search too deep".
+  10. queue_guess returns ERROR.
+  11. table_key, probe_table, or store_table returns ERROR.
+  12. The state is in the table: "Known dead end".
+  13. arena_mark, arena_take, arena_shrink, arena_release, size_block,
+      or attach_block returns ERROR.
+  14. hash_squares, profile_clock, or trace_guess returns ERROR.
 
 Called By:  solve_problem
 
 Side Effects: This picks an exhaustive set of guesses for the largest
-remaining type of ship and tries the guesses one at a time until at
-least one works.
+remaining type of ship (or, if world->branch is BRANCH_FEWEST, for the
+type with the fewest guesses, using make_guesses_fewest) and tries the
+guesses one at a time until at least one works.
 
 If world->find_all is 1, this finds all solutions to the puzzle by trying
-all guesses. Otherwise, this stops at the first successful guess.
+all guesses. Otherwise, this stops at the first successful guess. When
+counting answers (world->count is not 0), this stops as soon as the job
+has counted that many; with a pool, save_answer cancels the search
+instead. When the messages of CHB are being kept (for bap_solve), this
+also stops once there is one, since an error in a guess would
+otherwise be taken as the guess having no answer.
 
 Each guess is recorded in the world model.
 
 Notes:
 
+If world->trail is not NULL, each guess is tried in place on the world
+itself by try_guess_in_place, and the changes are undone afterwards.
+Otherwise, each guess is tried on a fresh copy of the world.
+
+The guesses and the block of the copy of the world are taken from
+world->arena, so nothing is malloc'ed here. Everything taken from the
+arena while a guess is tried is given back before the next guess, and
+everything taken here is given back before this returns.
+
+The index of each guess is recorded in the path of the world in which
+it is tried. If world->pool is not NULL and the guesses are near the
+top of the search tree, each guess is put on a queue by queue_guess to
+be tried by whichever thread gets to it first. A guess put on a queue
+is not known to succeed here, so it is treated as failing; answers it
+leads to are saved by save_answer. The guess is added to the list of
+guesses tried only after it has been queued, so that the task has the
+same list of guesses tried as it would have had on one thread.
+
+If there is a transposition table, the state is looked up in it first,
+and if it is found, ERROR is returned at once, since guessing from the
+same state failed before. If every guess fails, the state is stored in
+the table. It is not stored if any guess was queued, since queued
+guesses are treated as failing only because their results are not yet
+known, or if the search has been cancelled.
+
+A state that failed has no answers other than ones already printed.
+The guesses_tried list only keeps a branch from repeating answers, so
+it is not part of the key, and a state that failed on one branch may
+be skipped on any other.
+
+If the search is being traced (world->trace is not NULL), the key of
+the state is found even with no table (the hash of the squares is made
+afresh, since set_square keeps it only for the table), and each guess
+tried is recorded by trace_guess with the time and the calls to
+solve_problem it took.
+
 */
 
 int try_guessing(          /* ARGUMENTS     */
@@ -7462,14 +16051,44 @@ int try_guessing(          /* ARGUMENTS     */
   const char * name SET_TO "try_guessing";
   int number_guesses;
   int n;
-  struct guess guesses[MAX_GUESSES];
+  struct guess * guesses; /* guesses, in the arena */
+  int queued;   /* set to 1 if guess put on a queue */
+  int any_queued; /* set to 1 if any guess put on a queue */
+  int found;    /* set to 1 if state found in table */
+  unsigned long long key; /* key of state in table */
   int result;
   int return_value;
   struct bap_world world_copy;
-
+  struct arena_mark mark;  /* arena before guesses taken             */
+  struct arena_mark mark2; /* arena after guesses and block taken    */
+  long copied;             /* bytes of block copied by copy_bap      */
+  long bytes;              /* size of block of world_copy            */
+  void * memory;
+  struct trace_record record; /* record of guess, if tracing   */
+  long long start;            /* time guess started, if tracing */
+
+  if (world->table OR world->trace)
+    {
+      if (world->table IS NULL)
+	IFF(hash_squares(world));
+      IFF(table_key(&key, world));
+    }
+  if (world->table)
+    {
+      IFF(probe_table(key, &found, world));
+      CHK(found, "Known dead end");
+    }
+  any_queued SET_TO 0;
   return_value SET_TO ERROR;
-  number_guesses SET_TO (MAX_GUESSES + 1);
-  if (world->battleships_left OR world->battleships_ass)
+  start SET_TO 0;
+  IFF(arena_mark(&mark, world));
+  IFF(arena_take(((long)world->max_guesses * sizeof(struct guess)),
+		 &memory, world));
+  guesses SET_TO (struct guess *)memory;
+  number_guesses SET_TO (world->max_guesses + 1);
+  if (world->branch IS BRANCH_FEWEST)
+    IFF(make_guesses_fewest(&number_guesses, guesses, world));
+  else if (world->battleships_left OR world->battleships_ass)
     IFF(make_guesses_battleships(&number_guesses, guesses, world));
   else if (world->cruisers_left OR world->cruisers_ass)
     IFF(make_guesses_cruisers(&number_guesses, guesses, world));
@@ -7482,23 +16101,89 @@ int try_guessing(          /* ARGUMENTS     */
     IFF(make_guesses_submarines(&number_guesses, guesses, world));
   else
     CHB(1, "Bug in try_guessing");
+  CHB((world->depth IS world->max_depth), "Bug search too deep");
+  IFF(arena_shrink(guesses, ((long)number_guesses * sizeof(struct guess)),
+		   world));
+  if (world->trail IS NULL)
+    {
+      IFF(size_block(world->number_rows, world->number_cols, &copied,
+		     &bytes));
+      IFF(arena_take(bytes, &memory, world));
+      IFF(attach_block((char *)memory, world->number_rows, world->number_cols,
+		       &world_copy));
+    }
+  IFF(arena_mark(&mark2, world));
+  if (world->trace)
+    {
+      record.key SET_TO key;
+      record.depth SET_TO world->depth;
+      record.number_guesses SET_TO number_guesses;
+    }
   for (n SET_TO 0; n < number_guesses; n++)
     {
-      IFF(copy_bap(&world_copy, world));
-      if (guesses[n].in_row)
-	IFF(insert_guess_row(&(guesses[n]), &world_copy));
+      if (world->pool AND
+	  __atomic_load_n(&(world->pool->cancel), __ATOMIC_ACQUIRE))
+	break;
+      if (world->trace)
+	{
+	  IFF(profile_clock(&start));
+	  record.nodes SET_TO world->trace->nodes;
+	}
+      queued SET_TO 0;
+      if (world->pool AND (world->depth < SPLIT_DEPTH))
+	IFF(queue_guess(&(guesses[n]), n, &queued, world));
+      if (queued)
+	{
+	  any_queued SET_TO 1;
+	  result SET_TO ERROR;
+	}
+      else if (world->trail)
+	{
+	  world->path[world->depth++] SET_TO n;
+	  IFF(try_guess_in_place(&(guesses[n]), &result, world));
+	  world->depth--;
+	}
       else
-	IFF(insert_guess_col(&(guesses[n]), &world_copy));
-      result SET_TO solve_problem(&world_copy);
+	{
+	  IFF(copy_bap(&world_copy, world));
+	  world_copy.path[world_copy.depth++] SET_TO n;
+	  if (guesses[n].in_row)
+	    IFF(insert_guess_row(&(guesses[n]), &world_copy));
+	  else
+	    IFF(insert_guess_col(&(guesses[n]), &world_copy));
+	  result SET_TO solve_problem(&world_copy);
+	}
+      if (world->trace)
+	{
+	  record.index SET_TO n;
+	  record.found SET_TO (result IS OK);
+	  record.the_guess SET_TO guesses[n];
+	  IFF(trace_guess(&record, start, world));
+	}
+      IFF(arena_release(&mark2, world));
+      if (world->job)
+	world->job->guesses++;
+      CHB((world->number_guesses_tried IS world->max_tried),
+	  "Bug too many guesses tried");
       IFF(copy_guess(&(world->guesses_tried[world->number_guesses_tried++]),
 		     &(guesses[n])));
+      if ((world->message ISNT NULL) AND (world->message[0] ISNT 0))
+	break;
       if (result IS OK)
 	{
 	  return_value SET_TO OK;
 	  if (world->find_all IS 0)
 	    break;
+	  else if (world->count AND world->job AND
+		   (world->job->number_answers >= world->count))
+	    break;
 	}
     }
+  if (world->table AND (return_value IS ERROR) AND (any_queued IS 0) AND
+      ((world->pool IS NULL) OR
+       (__atomic_load_n(&(world->pool->cancel), __ATOMIC_ACQUIRE) IS 0)))
+    IFF(store_table(key, world));
+  IFF(arena_release(&mark, world));
   IFF(return_value);
   return OK;
 }
@@ -7515,12 +16200,25 @@ Returned Value: int
   3. ship_covers_col returns ERROR.
   4. ship_covers_row returns ERROR.
   5. submarine_covers returns ERROR.
+  6. bits_cover_row or bits_cover_col returns ERROR.
 
-Called By:  solve_problem
+Called By:  run_rules
 
 Side Effects: If the square at the given row and column cannot be ship,
 it is marked as water.
 
+Notes:
+
+If world->bits is 1, the bit masks are used first to find the squares
+that might be covered by a ship in each row and column. A blank square
+that is in neither set cannot be ship, and the slower checks are made
+only for the other blank squares.
+
+Only blank squares in a queued row or column (see QUEUED) are checked.
+Any other blank square could be covered the last time this found
+nothing to mark, and nothing that decides it has changed since, so the
+square found is the same one a check of every square would find.
+
 */
 
 int try_square_blank(      /* ARGUMENTS    */
@@ -7530,7 +16228,18 @@ int try_square_blank(      /* ARGUMENTS    */
   int row;
   int col;
   int cover;
+  unsigned long long cols_cover[MAX_NUMBER_COLS]; /* maybe ship by column */
+  unsigned long long rows_cover[MAX_NUMBER_ROWS]; /* maybe ship by row    */
 
+  col SET_TO 0;
+  cover SET_TO 1;
+  if (world->bits)
+    {
+      for (row SET_TO 0; row < world->number_rows; row++)
+	IFF(bits_cover_row(row, &(rows_cover[row]), world));
+      for (col SET_TO 0; col < world->number_cols; col++)
+	IFF(bits_cover_col(col, &(cols_cover[col]), world));
+    }
   for (row SET_TO 0; row < world->number_rows; row++)
     {
       if (world->rows[row].done)
@@ -7539,7 +16248,14 @@ int try_square_blank(      /* ARGUMENTS    */
 	{
 	  if (square(row, col, world) ISNT ' ')
 	    continue;
+	  if (NOT (QUEUED(RULE_TRY_SQUARE_BLANK, world->rows[row]) OR
+		   QUEUED(RULE_TRY_SQUARE_BLANK, world->cols[col])))
+	    continue;
 	  cover SET_TO 0;
+	  if (world->bits AND
+	      (((rows_cover[row] >> col) & 1) IS 0) AND
+	      (((cols_cover[col] >> row) & 1) IS 0))
+	    break;
 	  if ((world->rows[row].submarines OR world->submarines_left_row))
 	    IFF(submarine_covers(row, col, &cover, world));
 	  if (cover)
@@ -7587,6 +16303,57 @@ int try_square_blank(      /* ARGUMENTS    */
 
 /*************************************************************************/
 
+/* undo_trail
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. mark is larger than the number of changes on the trail:
+     "Bug bad trail mark".
+  2. set_square returns ERROR.
+  3. touch_number returns ERROR.
+
+Called By:
+  find_hint
+  play_move
+  retract_move
+  try_guess_in_place
+
+Side Effects: This undoes, latest first, every change recorded on the
+trail after the first mark changes, and shortens the trail to mark
+changes. Squares are restored with set_square, so the bit masks are
+restored with them. The strips that read a restored counter are
+touched, as when it was changed (see touch_number).
+
+*/
+
+int undo_trail(            /* ARGUMENTS                            */
+ int mark,                 /* number of changes to keep on trail   */
+ struct bap_world * world) /* puzzle model                         */
+{
+  const char * name SET_TO "undo_trail";
+  struct change * the_change;
+  int n;
+
+  CHB((mark > world->trail->number_changes), "Bug bad trail mark");
+  for (n SET_TO (world->trail->number_changes - 1); n >= mark; n--)
+    {
+      the_change SET_TO (world->trail->changes + n);
+      if (the_change->number)
+	{
+	  IFF(touch_number(the_change->number, world));
+	  *(the_change->number) SET_TO the_change->value;
+	}
+      else
+	IFF(set_square(the_change->row, the_change->col,
+		       (char)the_change->value, world));
+    }
+  world->trail->number_changes SET_TO mark;
+  return OK;
+}
+
+/*************************************************************************/
+
 /* verify_square
 
 Returned Value: int
@@ -7757,7 +16524,7 @@ Returned Value: int
   2. A strip has too many ship parts: "Puzzle has no answer"
   3. A strip has too much water: "Puzzle has no answer"
 
-Called By:  solve_problem
+Called By:  run_rules
 
 Side Effects: This checks that the world->squares layout is not
 illegal. It looks at every square, and if it is a ship part, makes
@@ -7779,6 +16546,14 @@ checked here.
 This does not check that the ships themselves are legal (not too many
 of a given type, etc.).
 
+The counts of a strip (got, dry, and exes) are kept up to date as
+squares change (see set_square), so they are not counted here. Only
+the squares of queued rows, and the counts of queued rows and columns,
+are checked (see QUEUED). A square is checked against the squares
+beside it, and set_square touches the rows and columns through and
+beside a square that changes, so a square not checked has the same
+neighbors as when it was last found legal.
+
 */
 
 int verify_squares(        /* ARGUMENTS    */
@@ -7791,9 +16566,11 @@ int verify_squares(        /* ARGUMENTS    */
   struct strip rown;
   struct strip coln;
 
-  for (row SET_TO 0; row < world->number_rows; row++)
+  for (row SET_TO 0; row < ROWS; row++)
     {
-      for (col SET_TO 0; col < world->number_cols; col++)
+      if (NOT (QUEUED(RULE_VERIFY_SQUARES, world->rows[row])))
+	continue;
+      for (col SET_TO 0; col < COLS; col++)
 	{
 	  item SET_TO world->squares[row][col];
 	  if ((item ISNT '.') AND (item ISNT ' '))
@@ -7802,15 +16579,19 @@ int verify_squares(        /* ARGUMENTS    */
 	    }
 	}
     }
-  for (row SET_TO 0; row < world->number_rows; row++)
+  for (row SET_TO 0; row < ROWS; row++)
     {
       rown SET_TO world->rows[row];
+      if (NOT (QUEUED(RULE_VERIFY_SQUARES, rown)))
+	continue;
       CHK((rown.got > rown.aim), "Puzzle has no answer");
       CHK((rown.dry < rown.aim), "Puzzle has no answer");
     }
-  for (col SET_TO 0; col < world->number_cols; col++)
+  for (col SET_TO 0; col < COLS; col++)
     {
       coln SET_TO world->cols[col];
+      if (NOT (QUEUED(RULE_VERIFY_SQUARES, coln)))
+	continue;
       CHK((coln.got > coln.aim), "Puzzle has no answer");
       CHK((coln.dry < coln.aim), "Puzzle has no answer");
     }
@@ -7819,3 +16600,210 @@ int verify_squares(        /* ARGUMENTS    */
 
 /*************************************************************************/
 
+/* work_batch
+
+Returned Value: int (OK)
+
+Called By:
+  run_batch
+  run_batch_thread
+
+Side Effects: This takes the next puzzle of the batch that no thread
+has started and solves it (see solve_job), until every puzzle has been
+started.
+
+Notes:
+
+The lock on the batch is held only while the next puzzle is taken.
+Each job is written only by the thread solving it, and is read by
+run_batch only after every thread has finished.
+
+*/
+
+int work_batch(            /* ARGUMENTS          */
+ struct batch * the_batch) /* batch of puzzles   */
+{
+  const char * name SET_TO "work_batch";
+  int n;                   /* index of job taken */
+
+  for (; ; )
+    {
+      pthread_mutex_lock(&(the_batch->lock));
+      n SET_TO the_batch->next;
+      if (n < the_batch->number_jobs)
+	the_batch->next++;
+      pthread_mutex_unlock(&(the_batch->lock));
+      if (n >= the_batch->number_jobs)
+	break;
+      solve_job(&(the_batch->jobs[n]), the_batch);
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* work_queue
+
+Returned Value: int (OK)
+
+Called By:
+  run_pool
+  run_queue
+
+Side Effects: This takes tasks (see take_task) and runs them (see
+run_task) until there are no tasks left on any queue and no task is
+being run by any thread. A thread that finds all queues empty while
+other threads are still running tasks waits until a task is added or
+the last task is finished.
+
+Notes:
+
+The lock on the pool is held except while a task is being run. The
+count of pending tasks includes those being run, since a running task
+may add more tasks.
+
+*/
+
+int work_queue(             /* ARGUMENTS         */
+ struct queue * the_queue)  /* queue of thread   */
+{
+  const char * name SET_TO "work_queue";
+  struct pool * the_pool;   /* pool of threads                  */
+  struct task * the_task;   /* task taken from a queue          */
+
+  the_pool SET_TO the_queue->pool;
+  pthread_mutex_lock(&(the_pool->lock));
+  for (; (the_pool->pending > 0); )
+    {
+      take_task(the_queue, &the_task);
+      if (the_task)
+	{
+	  pthread_mutex_unlock(&(the_pool->lock));
+	  run_task(the_queue, the_task);
+	  pthread_mutex_lock(&(the_pool->lock));
+	  the_pool->pending--;
+	  if (the_pool->pending IS 0)
+	    pthread_cond_broadcast(&(the_pool->wake));
+	}
+      else
+	pthread_cond_wait(&(the_pool->wake), &(the_pool->lock));
+    }
+  pthread_mutex_unlock(&(the_pool->lock));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* write_problem
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The file cannot be opened for writing: "Could not open file".
+
+Called By:  generate_bap
+
+Side Effects: This writes the puzzle in the world as a problem file
+with the given name, in the form read_problem reads: a header giving
+the size and fleet, a blank line, the rows between lines of dashes,
+the column numbers, the ships, and "end".
+
+*/
+
+int write_problem(         /* ARGUMENTS                     */
+ char * file_name,         /* name of file to write         */
+ struct bap_world * world) /* puzzle model to write         */
+{
+  const char * name SET_TO "write_problem";
+  FILE * out_port;
+  int row;
+  int col;
+  int n;
+
+  out_port SET_TO fopen(file_name, "w");
+  CHB((out_port IS NULL), "Could not open file");
+  fprintf(out_port, "Battleships\nMade by bap generate\n%dx%d  %d %d %d %d\n",
+	  world->number_rows, world->number_cols, world->battleships_left,
+	  world->cruisers_left, world->destroyers_left,
+	  world->submarines_left_row);
+  fprintf(out_port, "\n ");
+  for (col SET_TO 0; col < world->number_cols; col++)
+    fprintf(out_port, " -");
+  fprintf(out_port, "\n");
+  for (row SET_TO 0; row < world->number_rows; row++)
+    {
+      fprintf(out_port, " |");
+      for (col SET_TO 0; col < world->number_cols; col++)
+	fprintf(out_port, "%c%c", world->squares[row][col],
+		((col < (world->number_cols - 1)) ? ' ' : '|'));
+      fprintf(out_port, "%d\n", world->rows[row].aim);
+    }
+  fprintf(out_port, " ");
+  for (col SET_TO 0; col < world->number_cols; col++)
+    fprintf(out_port, " -");
+  fprintf(out_port, "\n  ");
+  for (col SET_TO 0; col < (world->number_cols - 1); col++)
+    fprintf(out_port, "%-2d", world->cols[col].aim);
+  fprintf(out_port, "%d\n\n", world->cols[col].aim);
+  if (world->battleships_left)
+    {
+      for (n SET_TO 0; n < world->battleships_left; n++)
+	fprintf(out_port, "  <++>");
+      fprintf(out_port, "\n");
+    }
+  if (world->cruisers_left)
+    {
+      for (n SET_TO 0; n < world->cruisers_left; n++)
+	fprintf(out_port, "  <+>");
+      fprintf(out_port, "\n");
+    }
+  if (world->destroyers_left)
+    {
+      for (n SET_TO 0; n < world->destroyers_left; n++)
+	fprintf(out_port, "  <>");
+      fprintf(out_port, "\n");
+    }
+  if (world->submarines_left_row)
+    {
+      for (n SET_TO 0; n < world->submarines_left_row; n++)
+	fprintf(out_port, "  O");
+      fprintf(out_port, "\n");
+    }
+  fprintf(out_port, "end\n");
+  fclose(out_port);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* zobrist_key
+
+Returned Value: int (OK)
+
+Called By:
+  hash_squares
+  set_square
+
+Side Effects: This sets *key to the Zobrist key of the given character
+in the square at the given row and column. The key is made by
+scrambling the row, column, and character together, so no table of
+keys has to be kept.
+
+*/
+
+int zobrist_key(            /* ARGUMENTS                    */
+ int row,                   /* row index of square          */
+ int col,                   /* column index of square       */
+ char item,                 /* character in square          */
+ unsigned long long * key)  /* set here to key              */
+{
+  const char * name SET_TO "zobrist_key";
+
+  *key SET_TO ((((unsigned long long)row * MAX_NUMBER_COLS) + col) << 8);
+  *key SET_TO (*key | (unsigned char)item);
+  scramble_key(key);
+  return OK;
+}
+
+/*************************************************************************/
+
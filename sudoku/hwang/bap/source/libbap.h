@@ -0,0 +1,202 @@
+/*************************************************************************/
+
+/* libbap.h
+
+This is the interface of libbap, the battleships solver of bap.c built
+as a library (see the libbap target of the Makefile). A program using
+the library fills in a bap_request, calls bap_solve, reads what
+happened from the bap_result, and calls bap_free_result.
+
+The puzzle is given as text in the format of a problem file (see
+read_problem in bap.c) and is never read from or written to a file.
+Nothing is printed. Each answer may be handed to a function of the
+caller (take_answer), and the first answer found is kept in the result.
+If something goes wrong, the status of the result is BAP_ERROR and the
+message says what, in the form "function: error".
+
+bap_solve keeps everything it uses in memory it makes for the call and
+frees before it returns, so any number of threads may call it at once,
+each with its own request and result. Each call searches in the thread
+that makes it.
+
+BAP_SOLVED, BAP_NO_ANSWER, and BAP_ERROR are the ways a call may come
+out. A puzzle with no answer is BAP_NO_ANSWER, not BAP_ERROR.
+
+BAP_ENGINE_RULES and BAP_ENGINE_DLX are the engines that may be asked
+for, and BAP_STRATEGY_CONSTRUCT, BAP_STRATEGY_SEARCH_WATER, and
+BAP_STRATEGY_SEARCH_PURE the strategies of the rules engine, and
+BAP_BRANCH_LARGEST and BAP_BRANCH_FEWEST the orders in which it
+branches. They are the same as the --engine, --strategy, and --branch
+arguments of bap.
+
+BAP_MESSAGE_SIZE is the size of the message of a result.
+
+A puzzle may also be played a square at a time in a session. A program
+opens a session on the text of a puzzle with bap_open_session, puts
+water or ship parts in squares with bap_set_square, takes them back
+with bap_retract_square, asks what the solver would do next with
+bap_next_hint, and closes the session with bap_close_session. Each
+call that changes the squares gives back a hint as well, so a program
+need not ask for one. A hint is found by running the rules only on the
+rows and columns the last change touched, and a move is taken back by
+undoing it, so no call starts the puzzle over. A session may be used
+by one thread at a time.
+
+BAP_HINT and BAP_STUCK are the ways a hint may come out besides those
+of a call of bap_solve (see bap_hint).
+
+*/
+
+#ifndef LIBBAP_H
+#define LIBBAP_H
+
+#define BAP_SOLVED 0
+#define BAP_NO_ANSWER 1
+#define BAP_ERROR 2
+#define BAP_HINT 3
+#define BAP_STUCK 4
+#define BAP_ENGINE_RULES 0
+#define BAP_ENGINE_DLX 1
+#define BAP_STRATEGY_CONSTRUCT 0
+#define BAP_STRATEGY_SEARCH_WATER 1
+#define BAP_STRATEGY_SEARCH_PURE 2
+#define BAP_BRANCH_LARGEST 0
+#define BAP_BRANCH_FEWEST 1
+#define BAP_MESSAGE_SIZE 128
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bap_request
+
+A bap_request says what puzzle to solve and how. bap_init_request sets
+every field to its default, which solves the puzzle as "bap <file> one
+no" does once text is set.
+
+If find_all is 0, the search stops at the first answer. If limit is
+not 0, it stops once that many answers are found, as with "bap <file>
+count <limit>" (find_all need not be set), so a limit of 2 tells
+whether a puzzle has exactly one answer.
+
+If take_answer is not NULL, it is called with each answer as it is
+found, and with data. squares[row][col] is the square in the row and
+column ('.' for water, or one of "<>^v+O" for a ship part). The squares
+may be changed after take_answer returns, so anything wanted must be
+copied. take_answer should return 0; anything else stops the search,
+and the call comes out BAP_ERROR.
+
+*/
+
+struct bap_request
+{
+  int bits;           /* set to 1 to use the bit masks                  */
+  int branch;         /* BAP_BRANCH_LARGEST or BAP_BRANCH_FEWEST        */
+  void * data;        /* anything, passed to take_answer                */
+  int engine;         /* BAP_ENGINE_RULES or BAP_ENGINE_DLX             */
+  int find_all;       /* set to 1 if all answers to be found            */
+  int in_place;       /* set to 1 to search in place using a trail      */
+  int limit;          /* number of answers to stop at, or 0 for none    */
+  int rules;          /* bit on for each rule to run, or 0 for those of */
+                      /* the strategy (as --rules)                      */
+  int strategy;       /* BAP_STRATEGY_XXX of the rules engine           */
+  int (*take_answer)(char ** squares, int number_rows, int number_cols,
+		     void * data); /* function given each answer, or NULL */
+  const char * text;  /* puzzle in the format of a problem file         */
+  int worklist;       /* set to 1 to look only at touched strips        */
+};
+
+/* bap_result
+
+A bap_result says how a call of bap_solve came out. answer is made by
+bap_solve and freed by bap_free_result.
+
+*/
+
+struct bap_result
+{
+  char * answer;      /* squares of first answer, row by row, or NULL   */
+  long long guesses;  /* number of guesses tried                        */
+  char message[BAP_MESSAGE_SIZE]; /* error, or empty if none            */
+  long long nodes;    /* number of nodes searched                       */
+  int number_answers; /* number of answers found                        */
+  int number_cols;    /* number of columns in puzzle, or 0 if not read  */
+  int number_rows;    /* number of rows in puzzle, or 0 if not read     */
+  int status;         /* BAP_SOLVED, BAP_NO_ANSWER, or BAP_ERROR        */
+};
+
+/* bap_hint
+
+A bap_hint says what the rules do next with the squares of a session.
+The status is
+  BAP_HINT if a rule set squares. rule is its name, explanation says
+    what it did (a line for each step, as "bap <file> one yes"
+    explains), and changed lists the number_changed squares it set,
+    each as row * number_cols + col. A hint always sets at least one
+    square. Rules that only count or assign ships do not make a hint of
+    their own: the lines they record come first in the explanation of
+    the hint after them. squares is the squares as they would be once
+    the rule fired.
+  BAP_SOLVED if every row and column is done.
+  BAP_STUCK if no rule fires, so the next step would be a guess.
+  BAP_NO_ANSWER if the squares have no answer. If a rule found it, rule
+    is its name. If it was the move just asked for, the move is not
+    made and rule is NULL.
+  BAP_ERROR if the call went wrong (a move to a square already set, or
+    a row or column out of the puzzle, for example). message says what.
+Except for BAP_HINT, squares is the squares of the session as they are.
+The squares never change until a move is made: a hint is only given,
+and the move it suggests must be made with bap_set_square to be kept.
+changed, explanation, and squares point to memory kept by the session.
+They are good until the next call on the session.
+
+*/
+
+struct bap_hint
+{
+  const int * changed;      /* squares the hint sets                    */
+  const char * explanation; /* lines of explanation, or "" if none      */
+  char message[BAP_MESSAGE_SIZE]; /* error, or empty if none            */
+  int number_changed;       /* number of squares in changed             */
+  int number_cols;          /* number of columns in puzzle              */
+  int number_rows;          /* number of rows in puzzle                 */
+  const char * rule;        /* name of rule, or NULL                    */
+  const char * squares;     /* squares, row by row (see above)          */
+  int status;               /* BAP_HINT, BAP_STUCK, BAP_SOLVED,         */
+                            /* BAP_NO_ANSWER, or BAP_ERROR              */
+};
+
+/* bap_session
+
+A bap_session is made by bap_open_session and freed by
+bap_close_session. What is in it is kept in the library. The request
+given to bap_open_session says the puzzle, the strategy (which may not
+be BAP_STRATEGY_SEARCH_PURE), the rules, and whether to use the bit
+masks. The engine must be BAP_ENGINE_RULES. The rest is not used.
+
+A move puts one of ".<>^v+OX" in a square: water or an X in a blank,
+or a ship part in a blank or an X. Water is put around it, as the
+solver would. bap_retract_square takes back the last move made in the
+square, keeping the moves made after it.
+
+*/
+
+struct bap_session;
+
+int bap_close_session(struct bap_session * session);
+int bap_free_result(struct bap_result * result);
+int bap_init_request(struct bap_request * request);
+int bap_next_hint(struct bap_session * session, struct bap_hint * hint);
+int bap_open_session(struct bap_request * request,
+		     struct bap_session ** session, char * message);
+int bap_retract_square(struct bap_session * session, int row, int col,
+		       struct bap_hint * hint);
+int bap_set_square(struct bap_session * session, int row, int col,
+		   char item, struct bap_hint * hint);
+int bap_solve(struct bap_request * request, struct bap_result * result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
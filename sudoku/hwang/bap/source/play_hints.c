@@ -0,0 +1,745 @@
+/*************************************************************************/
+
+/* comments
+
+play_hints plays puzzles through from hints, using the session
+functions of libbap (see libbap.h), as a program giving hints would.
+It is the test of those functions run by script/test_hints.
+
+Each problem file named on the command line is solved by bap_solve,
+and then played in a session from its first hint to BAP_SOLVED: the
+first square of each hint is set as the hint would set it, and when
+the rules are stuck, a blank square is set from the answer, as a
+player making a guess would. The play fails if a hint sets no square
+(the same hint would be given again forever), if a hint sets a square
+other than as in the answer, if the session reports no answer or an
+error, if the puzzle is not solved within four moves a square, or if
+it is solved other than as the answer. A problem file bap_solve finds
+no answer to is not played.
+
+Every fifth move, a move made earlier, picked at random, is taken back
+with bap_retract_square and then made again (see take_back). The play
+fails if the hint once it is taken back is not the one a new session
+gives with the other moves made in order, or if the hint once it is
+made again is not the one given before it was taken back. rand is
+seeded with 1, so every run takes back the same moves.
+
+Each call of bap_next_hint, bap_set_square, and bap_retract_square on
+a 10x10 puzzle is timed. The calls are what a program giving hints
+would wait on, and must be quick on the most common size: a run fails
+if the 99th percentile of their times is 1 ms or more.
+
+For each file, a line saying how it was played or why it failed is
+printed, and then a line with the totals and one with the times. The
+exit status is 0 if every play succeeded and the times were quick
+enough, and 1 otherwise.
+
+*/
+
+/*************************************************************************/
+
+/* includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "libbap.h"
+
+/*************************************************************************/
+
+/* hash_defs */
+
+#define AND       &&
+#define IS        ==
+#define ISNT      !=
+#define NOT       !
+#define OR        ||
+#define SET_TO    =
+#define OK        0
+#define ERROR     -1
+#define MOST_MICROS 1000.0
+
+/*************************************************************************/
+
+/* structures
+
+A move is a move made in the session, as bap_set_square was given it.
+
+A saved_hint is a copy of what a bap_hint says, kept past the next call
+on the session. changed and squares have room for every square.
+
+A times holds the time each timed call took, in microseconds.
+
+*/
+
+struct move
+{
+  char item;  /* character put in square */
+  int row;    /* row index of square     */
+  int col;    /* column index of square  */
+};
+
+struct saved_hint
+{
+  int * changed;               /* squares the hint sets        */
+  int number_changed;          /* number of squares in changed */
+  char rule[BAP_MESSAGE_SIZE]; /* name of rule, or empty       */
+  char * squares;              /* squares, row by row          */
+  int status;                  /* status of hint               */
+};
+
+struct times
+{
+  double * micros;  /* times of calls, in microseconds      */
+  int number;       /* number of times in micros            */
+  int size;         /* number of times there is room for    */
+};
+
+/*************************************************************************/
+
+/* declare_functions */
+
+int add_time(struct timespec * start, struct times * times);
+int check_hint(struct bap_hint * hint, char * answer, int * wrong);
+int compare_micros(const void * micros1, const void * micros2);
+int main(int argc, char ** argv);
+int play_puzzle(char * file_name, struct times * times, int * played);
+int read_file(char * file_name, char ** text);
+int replay_moves(struct bap_request * request, struct move * moves,
+		 int number_moves, struct saved_hint * replayed);
+int same_hint(struct bap_hint * hint, struct saved_hint * saved,
+	      int squares);
+int save_hint(struct bap_hint * hint, struct saved_hint * saved,
+	      int squares);
+int take_back(struct bap_session * session, struct bap_request * request,
+	      struct move * moves, int * number_moves,
+	      struct bap_hint * hint, struct times * times,
+	      const char ** error);
+
+/*************************************************************************/
+
+/* functions */
+
+/*************************************************************************/
+
+/* add_time
+
+Returned Value: int
+  If there is no memory for another time, this returns ERROR.
+  Otherwise, it returns OK.
+
+Called By:
+  play_puzzle
+  take_back
+
+Side Effects: If times is not NULL, this adds to it the time from start
+to now, in microseconds. The array of times is made bigger as needed.
+
+*/
+
+int add_time(              /* ARGUMENTS                  */
+ struct timespec * start,  /* time call was started      */
+ struct times * times)     /* times, or NULL if not kept */
+{
+  const char * name SET_TO "add_time";
+  struct timespec stop;    /* time call was finished     */
+  double * micros;         /* bigger array of times      */
+  int size;                /* number of times in micros  */
+
+  if (times IS NULL)
+    return OK;
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  if (times->number IS times->size)
+    {
+      size SET_TO ((2 * times->size) + 1024);
+      micros SET_TO (double *)realloc(times->micros, (size * sizeof(double)));
+      if (micros IS NULL)
+	return ERROR;
+      times->micros SET_TO micros;
+      times->size SET_TO size;
+    }
+  times->micros[times->number++] SET_TO
+    ((1000000.0 * (stop.tv_sec - start->tv_sec)) +
+     ((stop.tv_nsec - start->tv_nsec) / 1000.0));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* check_hint
+
+Returned Value: int (OK)
+
+Called By:  play_puzzle
+
+Side Effects: This sets *wrong to the index of the first square the
+hint sets other than as in the answer (an X where the answer has water,
+or anything else that is not what the answer has), or to -1 if every
+square it sets agrees with the answer.
+
+*/
+
+int check_hint(          /* ARGUMENTS                            */
+ struct bap_hint * hint, /* hint given                           */
+ char * answer,          /* squares of answer, row by row        */
+ int * wrong)            /* index of wrong square or -1, set here */
+{
+  const char * name SET_TO "check_hint";
+  int index;  /* index of square set by hint */
+  int n;
+
+  *wrong SET_TO -1;
+  for (n SET_TO 0; ((n < hint->number_changed) AND (*wrong IS -1)); n++)
+    {
+      index SET_TO hint->changed[n];
+      if ((hint->squares[index] IS 'X') ? (answer[index] IS '.') :
+	  (hint->squares[index] ISNT answer[index]))
+	*wrong SET_TO index;
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* compare_micros
+
+Returned Value: int
+  This returns -1 if the first time is less than the second, 1 if it is
+  more, and 0 if they are the same.
+
+Called By:  main (through qsort)
+
+Side Effects: none
+
+*/
+
+int compare_micros(        /* ARGUMENTS              */
+ const void * micros1,     /* pointer to first time  */
+ const void * micros2)     /* pointer to second time */
+{
+  const char * name SET_TO "compare_micros";
+  double time1;
+  double time2;
+
+  time1 SET_TO *((const double *)micros1);
+  time2 SET_TO *((const double *)micros2);
+  return ((time1 < time2) ? -1 : (time1 > time2) ? 1 : 0);
+}
+
+/*************************************************************************/
+
+/* main
+
+Returned Value: int
+  This returns 1 if any puzzle failed to play through, the 99th
+  percentile of the times of calls on 10x10 puzzles is MOST_MICROS or
+  more, or no file was named, and 0 otherwise.
+
+Called By:  none (the executable)
+
+Side Effects: This plays each problem file named by argv[1] and after
+(see play_puzzle) and prints the number of puzzles played and the
+number that failed. Then it prints the number of calls timed on 10x10
+puzzles and the median, 99th percentile, and longest of their times.
+
+*/
+
+int main(        /* ARGUMENTS                         */
+ int argc,       /* one more than the number of files */
+ char ** argv)   /* names of problem files, from 1    */
+{
+  const char * name SET_TO "main";
+  struct times times; /* times of calls on 10x10 puzzles  */
+  double slowest;     /* time at 99th percentile          */
+  int failed;         /* number of puzzles that failed    */
+  int played;         /* set to 1 if puzzle was played    */
+  int total;          /* number of puzzles played         */
+  int slow;           /* set to 1 if slowest too slow     */
+  int n;
+
+  if (argc < 2)
+    {
+      printf("Usage: %s <problem file> ...\n", argv[0]);
+      return 1;
+    }
+  srand(1);
+  times.micros SET_TO NULL;
+  times.number SET_TO 0;
+  times.size SET_TO 0;
+  failed SET_TO 0;
+  total SET_TO 0;
+  slow SET_TO 0;
+  for (n SET_TO 1; n < argc; n++)
+    {
+      if (play_puzzle(argv[n], &times, &played) ISNT OK)
+	failed++;
+      total SET_TO (total + played);
+    }
+  printf("%d puzzles played, %d failed\n", total, failed);
+  if (times.number > 0)
+    {
+      qsort(times.micros, times.number, sizeof(double), compare_micros);
+      slowest SET_TO times.micros[((99 * times.number) + 99) / 100 - 1];
+      printf("%d calls on 10x10 puzzles: %.1f us median, %.1f us at 99th "
+	     "percentile, %.1f us at most\n", times.number,
+	     times.micros[times.number / 2], slowest,
+	     times.micros[times.number - 1]);
+      if (slowest >= MOST_MICROS)
+	{
+	  printf("99th percentile is %.0f us or more\n", MOST_MICROS);
+	  slow SET_TO 1;
+	}
+    }
+  free(times.micros);
+  return (((failed IS 0) AND (slow IS 0)) ? 0 : 1);
+}
+
+/*************************************************************************/
+
+/* play_puzzle
+
+Returned Value: int
+  If any of the following errors occur, this prints a line saying so
+  and returns ERROR. Otherwise, it returns OK.
+  1. read_file returns ERROR.
+  2. bap_solve or bap_open_session fails.
+  3. A hint sets no square.
+  4. A hint sets a square other than as in the answer.
+  5. A call gives back BAP_NO_ANSWER or BAP_ERROR.
+  6. The puzzle is not solved within four moves a square.
+  7. The squares once solved are not the answer.
+  8. take_back finds a hint other than it should be.
+  9. There is no memory for the moves or times.
+
+Called By:  main
+
+Side Effects: This solves the puzzle in the file named file_name with
+bap_solve, opens a session on it, and plays it from its first hint to
+BAP_SOLVED (see the comments section), taking back a move every fifth
+move (see take_back). If the puzzle is 10x10, the time of each call on
+the session is added to times. *played is set to 0 if bap_solve found
+no answer, and to 1 otherwise, whether or not the play failed. If the
+play succeeds, a line giving the number of hints made, of squares set
+from the answer when stuck, and of moves taken back is printed.
+
+*/
+
+int play_puzzle(         /* ARGUMENTS                          */
+ char * file_name,       /* name of problem file               */
+ struct times * times,   /* times of calls on 10x10 puzzles    */
+ int * played)           /* set to 1 if puzzle played          */
+{
+  const char * name SET_TO "play_puzzle";
+  struct bap_request request;     /* request, for bap_solve and session */
+  struct bap_result result;       /* result of bap_solve, with answer   */
+  struct bap_session * session;   /* session puzzle is played in        */
+  struct bap_hint hint;           /* hint given by last call            */
+  struct move * made;             /* moves made in session, in order    */
+  struct times * timed;           /* times, or NULL if not 10x10        */
+  struct timespec start;          /* time last call was started         */
+  char message[BAP_MESSAGE_SIZE]; /* message if session not opened      */
+  char * text;                    /* text of problem file               */
+  const char * error;             /* why play failed, or NULL           */
+  char item;                      /* character to put in square         */
+  int squares;                    /* number of squares in puzzle        */
+  int hints;                      /* number of hints made               */
+  int guesses;                    /* number of squares set from answer  */
+  int moves;                      /* number of moves made               */
+  int number_made;                /* number of moves in made            */
+  int taken;                      /* number of moves taken back         */
+  int wrong;                      /* index of square set wrongly, or -1 */
+  int index;                      /* index of square to set             */
+
+  *played SET_TO 0;
+  if (read_file(file_name, &text) ISNT OK)
+    {
+      printf("%s: could not read file\n", file_name);
+      return ERROR;
+    }
+  bap_init_request(&request);
+  request.text SET_TO text;
+  bap_solve(&request, &result);
+  if (result.status ISNT BAP_SOLVED)
+    {
+      *played SET_TO (result.status IS BAP_ERROR);
+      if (result.status IS BAP_ERROR)
+	printf("%s: bap_solve: %s\n", file_name, result.message);
+      bap_free_result(&result);
+      free(text);
+      return ((result.status IS BAP_NO_ANSWER) ? OK : ERROR);
+    }
+  *played SET_TO 1;
+  if (bap_open_session(&request, &session, message) ISNT 0)
+    {
+      printf("%s: bap_open_session: %s\n", file_name, message);
+      bap_free_result(&result);
+      free(text);
+      return ERROR;
+    }
+  squares SET_TO (result.number_rows * result.number_cols);
+  timed SET_TO (((result.number_rows IS 10) AND (result.number_cols IS 10)) ?
+		times : NULL);
+  made SET_TO (struct move *)malloc((4 * squares) * sizeof(struct move));
+  error SET_TO ((made IS NULL) ? "no memory for moves" : NULL);
+  hints SET_TO 0;
+  guesses SET_TO 0;
+  number_made SET_TO 0;
+  taken SET_TO 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  bap_next_hint(session, &hint);
+  if ((error IS NULL) AND (add_time(&start, timed) ISNT OK))
+    error SET_TO "no memory for times";
+  if (error ISNT NULL)
+    printf("%s: %s\n", file_name, error);
+  for (moves SET_TO 0; ((error IS NULL) AND (hint.status ISNT BAP_SOLVED));
+       moves++)
+    {
+      index SET_TO -1;
+      if (moves IS (4 * squares))
+	error SET_TO "not solved within four moves a square";
+      else if (hint.status IS BAP_NO_ANSWER)
+	error SET_TO "no answer";
+      else if (hint.status IS BAP_ERROR)
+	error SET_TO hint.message;
+      else if (hint.status IS BAP_STUCK)
+	{
+	  for (index SET_TO 0;
+	       ((index < squares) AND (hint.squares[index] ISNT ' ') AND
+		(hint.squares[index] ISNT 'X')); index++);
+	  if (index IS squares)
+	    error SET_TO "stuck with no blank square";
+	  else
+	    guesses++;
+	}
+      else if (hint.number_changed IS 0)
+	error SET_TO "hint sets no square";
+      else
+	{
+	  check_hint(&hint, result.answer, &wrong);
+	  if (wrong ISNT -1)
+	    error SET_TO "hint sets a square other than as in the answer";
+	  else
+	    {
+	      index SET_TO hint.changed[0];
+	      hints++;
+	    }
+	}
+      if (error ISNT NULL)
+	{
+	  printf("%s: move %d: %s%s%s\n", file_name, moves, error,
+		 ((hint.rule IS NULL) ? "" : ", rule "),
+		 ((hint.rule IS NULL) ? "" : hint.rule));
+	  continue;
+	}
+      item SET_TO ((hint.status IS BAP_STUCK) ? result.answer[index] :
+		   hint.squares[index]);
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      bap_set_square(session, (index / result.number_cols),
+		     (index % result.number_cols), item, &hint);
+      if (add_time(&start, timed) ISNT OK)
+	{
+	  error SET_TO "no memory for times";
+	  printf("%s: move %d: %s\n", file_name, moves, error);
+	}
+      if ((hint.status IS BAP_HINT) OR (hint.status IS BAP_STUCK) OR
+	  (hint.status IS BAP_SOLVED))
+	{
+	  made[number_made].item SET_TO item;
+	  made[number_made].row SET_TO (index / result.number_cols);
+	  made[number_made].col SET_TO (index % result.number_cols);
+	  number_made++;
+	}
+      if ((error IS NULL) AND (((moves + 1) % 5) IS 0) AND
+	  (number_made > 1) AND (hint.status ISNT BAP_ERROR) AND
+	  (hint.status ISNT BAP_NO_ANSWER))
+	{
+	  take_back(session, &request, made, &number_made, &hint, timed,
+		    &error);
+	  taken++;
+	  if (error ISNT NULL)
+	    printf("%s: move %d: %s\n", file_name, moves, error);
+	}
+    }
+  if ((error IS NULL) AND
+      (memcmp(hint.squares, result.answer, squares) ISNT 0))
+    {
+      error SET_TO "solved other than as the answer";
+      printf("%s: %s\n", file_name, error);
+    }
+  if (error IS NULL)
+    printf("%s: %d hints, %d squares set from answer, %d moves taken back\n",
+	   file_name, hints, guesses, taken);
+  bap_close_session(session);
+  bap_free_result(&result);
+  free(made);
+  free(text);
+  return ((error IS NULL) ? OK : ERROR);
+}
+
+/*************************************************************************/
+
+/* read_file
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The file cannot be opened.
+  2. There is no memory for the text.
+
+Called By:  play_puzzle
+
+Side Effects: This mallocs a string holding the text of the file named
+file_name and sets *text to point to it. The caller frees it.
+
+*/
+
+int read_file(           /* ARGUMENTS                 */
+ char * file_name,       /* name of file to read      */
+ char ** text)           /* text of file, set here    */
+{
+  const char * name SET_TO "read_file";
+  FILE * in_port;
+  long size;    /* number of characters in file */
+
+  *text SET_TO NULL;
+  in_port SET_TO fopen(file_name, "r");
+  if (in_port IS NULL)
+    return ERROR;
+  fseek(in_port, 0, SEEK_END);
+  size SET_TO ftell(in_port);
+  fseek(in_port, 0, SEEK_SET);
+  *text SET_TO (char *)malloc(size + 1);
+  if (*text ISNT NULL)
+    (*text)[fread(*text, 1, size, in_port)] SET_TO 0;
+  fclose(in_port);
+  return ((*text IS NULL) ? ERROR : OK);
+}
+
+/*************************************************************************/
+
+/* replay_moves
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. bap_open_session fails.
+  2. A move cannot be made (its hint is BAP_ERROR).
+  3. save_hint returns ERROR.
+
+Called By:  take_back
+
+Side Effects: This opens a new session on the puzzle of the request,
+makes the given moves in it in order, saves the hint given after the
+last of them (or the first hint if there are none) in replayed, and
+closes the session.
+
+*/
+
+int replay_moves(               /* ARGUMENTS                      */
+ struct bap_request * request,  /* request session was opened on  */
+ struct move * moves,           /* moves to make, in order        */
+ int number_moves,              /* number of moves                */
+ struct saved_hint * replayed)  /* hint after last move, set here */
+{
+  const char * name SET_TO "replay_moves";
+  struct bap_session * session;   /* new session                   */
+  struct bap_hint hint;           /* hint given by last call       */
+  char message[BAP_MESSAGE_SIZE]; /* message if session not opened */
+  int failed;                     /* set to ERROR if a call failed */
+  int n;
+
+  if (bap_open_session(request, &session, message) ISNT 0)
+    return ERROR;
+  bap_next_hint(session, &hint);
+  for (n SET_TO 0; ((n < number_moves) AND (hint.status ISNT BAP_ERROR));
+       n++)
+    bap_set_square(session, moves[n].row, moves[n].col, moves[n].item,
+		   &hint);
+  failed SET_TO ((hint.status IS BAP_ERROR) ? ERROR :
+		 save_hint(&hint, replayed,
+			   (hint.number_rows * hint.number_cols)));
+  bap_close_session(session);
+  return failed;
+}
+
+/*************************************************************************/
+
+/* same_hint
+
+Returned Value: int
+  This returns 1 if the hint says the same as the saved hint (the same
+  status, rule, changed squares, and squares), and 0 otherwise.
+
+Called By:  take_back
+
+Side Effects: none
+
+*/
+
+int same_hint(                 /* ARGUMENTS                    */
+ struct bap_hint * hint,       /* hint given                   */
+ struct saved_hint * saved,    /* hint saved earlier           */
+ int squares)                  /* number of squares in puzzle  */
+{
+  const char * name SET_TO "same_hint";
+
+  return ((hint->status IS saved->status) AND
+	  (strcmp(((hint->rule IS NULL) ? "" : hint->rule), saved->rule)
+	   IS 0) AND
+	  (hint->number_changed IS saved->number_changed) AND
+	  (memcmp(hint->changed, saved->changed,
+		  (hint->number_changed * sizeof(int))) IS 0) AND
+	  (memcmp(hint->squares, saved->squares, squares) IS 0));
+}
+
+/*************************************************************************/
+
+/* save_hint
+
+Returned Value: int
+  If the hint sets more squares than the puzzle has, this returns
+  ERROR. Otherwise, it returns OK.
+
+Called By:
+  replay_moves
+  take_back
+
+Side Effects: This copies the status, rule, changed squares, and
+squares of the hint into saved, whose changed and squares have room
+for the given number of squares.
+
+*/
+
+int save_hint(                 /* ARGUMENTS                    */
+ struct bap_hint * hint,       /* hint to save                 */
+ struct saved_hint * saved,    /* saved hint, set here         */
+ int squares)                  /* number of squares in puzzle  */
+{
+  const char * name SET_TO "save_hint";
+
+  if (hint->number_changed > squares)
+    return ERROR;
+  saved->status SET_TO hint->status;
+  snprintf(saved->rule, BAP_MESSAGE_SIZE, "%s",
+	   ((hint->rule IS NULL) ? "" : hint->rule));
+  saved->number_changed SET_TO hint->number_changed;
+  memcpy(saved->changed, hint->changed, (hint->number_changed * sizeof(int)));
+  memcpy(saved->squares, hint->squares, squares);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* take_back
+
+Returned Value: int
+  If there is no memory for the saved hints, this sets *error and
+  returns ERROR. Otherwise, it returns OK, with *error set if the move
+  could not be taken back and made again as it should be.
+
+Called By:  play_puzzle
+
+Side Effects: This picks one of the moves made before the last, at
+random, and takes it back with bap_retract_square. If a later move was
+made in the same square, that one is taken back instead, since it is
+the one bap_retract_square takes back. The move is taken out of moves
+and then made again with bap_set_square, going last. The time of each
+call is added to times.
+
+*error is set to say what went wrong if the move cannot be taken back,
+if the hint once it is taken back is not the one replay_moves gets by
+making the moves that are left in a new session, if the move cannot be
+made again, or if the hint once it is made again is not the one given
+before it was taken back.
+
+Notes:
+
+A move of water or an X may find its square already set, by the water
+or X put around a ship part in a later move. The squares are then the
+same without the move, so it is left out, and the hint is got with
+bap_next_hint instead.
+
+*/
+
+int take_back(                 /* ARGUMENTS                       */
+ struct bap_session * session, /* session moves are made in       */
+ struct bap_request * request, /* request session was opened on   */
+ struct move * moves,          /* moves made in session, in order */
+ int * number_moves,           /* number of moves, changed here   */
+ struct bap_hint * hint,       /* hint of last call, changed here */
+ struct times * times,         /* times, or NULL if not kept      */
+ const char ** error)          /* what went wrong, set here       */
+{
+  const char * name SET_TO "take_back";
+  struct saved_hint before;    /* hint before move taken back      */
+  struct saved_hint replayed;  /* hint given by new session        */
+  struct move the_move;        /* move taken back                  */
+  struct timespec start;       /* time last call was started       */
+  int squares;                 /* number of squares in puzzle      */
+  int taken;                   /* index of move taken back         */
+  int n;
+
+  squares SET_TO (hint->number_rows * hint->number_cols);
+  before.changed SET_TO (int *)malloc(2 * squares * sizeof(int));
+  before.squares SET_TO (char *)malloc(2 * squares);
+  if ((before.changed IS NULL) OR (before.squares IS NULL))
+    {
+      free(before.changed);
+      free(before.squares);
+      *error SET_TO "no memory for saved hints";
+      return ERROR;
+    }
+  replayed.changed SET_TO (before.changed + squares);
+  replayed.squares SET_TO (before.squares + squares);
+  save_hint(hint, &before, squares);
+  taken SET_TO (rand() % (*number_moves - 1));
+  for (n SET_TO (taken + 1); n < *number_moves; n++)
+    {
+      if ((moves[n].row IS moves[taken].row) AND
+	  (moves[n].col IS moves[taken].col))
+	taken SET_TO n;
+    }
+  the_move SET_TO moves[taken];
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  bap_retract_square(session, the_move.row, the_move.col, hint);
+  if (add_time(&start, times) ISNT OK)
+    *error SET_TO "no memory for times";
+  else if (hint->status IS BAP_ERROR)
+    *error SET_TO hint->message;
+  if (*error ISNT NULL)
+    {
+      free(before.changed);
+      free(before.squares);
+      return OK;
+    }
+  for (n SET_TO (taken + 1); n < *number_moves; n++)
+    moves[n - 1] SET_TO moves[n];
+  (*number_moves)--;
+  if (replay_moves(request, moves, *number_moves, &replayed) ISNT OK)
+    *error SET_TO "moves left could not be made in a new session";
+  else if (NOT same_hint(hint, &replayed, squares))
+    *error SET_TO "hint once move is taken back is not as in a new session";
+  else
+    {
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      bap_set_square(session, the_move.row, the_move.col, the_move.item,
+		     hint);
+      if ((hint->status IS BAP_ERROR) AND
+	  (strstr(hint->message, "already set") ISNT NULL))
+	bap_next_hint(session, hint);
+      else if (hint->status ISNT BAP_ERROR)
+	moves[(*number_moves)++] SET_TO the_move;
+      if (add_time(&start, times) ISNT OK)
+	*error SET_TO "no memory for times";
+      else if (hint->status IS BAP_ERROR)
+	*error SET_TO hint->message;
+      else if (NOT same_hint(hint, &before, squares))
+	*error SET_TO "hint once move is made again is not as before";
+    }
+  free(before.changed);
+  free(before.squares);
+  return OK;
+}
+
+/*************************************************************************/
@@ -10,6 +10,12 @@ uses that order, so that makes the choice.
 
 This version has the try_contradict function removed.
 
+If "-j N" is given with N greater than 1, the search is shared among N
+threads (see run_pool). Guesses near the top of the search tree become
+tasks on per-thread queues, and idle threads take tasks from the queues
+of busy ones. With "all", the answers are printed in the same order as
+with one thread.
+
 */
 
 /*************************************************************************/
@@ -19,8 +25,10 @@ This version has the try_contradict function removed.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <pthread.h>
 
 /*************************************************************************/
 
@@ -29,6 +37,16 @@ This version has the try_contradict function removed.
 For the largest problems yet found, MAX_NUMBER_ROWS and MAX_NUMBER_COLS
 need to be set to 200.
 
+MAX_STRIP_SIZE must be at least the larger of MAX_NUMBER_ROWS and
+MAX_NUMBER_COLS.
+
+MAX_THREADS is the largest number of threads that may be asked for with
+-j. MAX_TASKS is the number of tasks each thread's queue can hold. A
+thread that finds its queue full follows up the guess itself instead.
+Guesses made at depths less than SPLIT_DEPTH are put on the queues as
+tasks when there is more than one thread; deeper guesses are followed
+up by the thread that made them.
+
 */
 
 #define AND       &&
@@ -45,6 +63,16 @@ need to be set to 200.
 #define STALLED 1
 #define MAX_LOGIC 1024
 #define MAX_STRIP_BLOCKS 20
+#define MAX_STRIP_SIZE 80
+#define RULE_FULL_BOUNDED 0
+#define RULE_EMPTY_OUTSIDE 1
+#define RULE_EMPTY_NO_ROOM 2
+#define RULE_BLOCK 3
+#define RULE_ONE 4
+#define NUMBER_RULES 5
+#define MAX_THREADS 64
+#define MAX_TASKS 64
+#define SPLIT_DEPTH 3
 
 /*************************************************************************/
 
@@ -72,6 +100,13 @@ need to be set to 200.
    return ERROR; }         \
  else
 
+/* QUEUED is 1 if the given strip has been touched (see touch_strip)
+since the given rule last started, so the rule must look at it again,
+and 0 if nothing in the strip has changed since. */
+
+#define QUEUED(rule, the_strip) \
+ ((the_strip).changed > world->clean[rule])
+
 /*************************************************************************/
 
 /* structures
@@ -94,8 +129,57 @@ The "space" attribute of the paint_world structure is a double to allow
 it to be large. It would make more sense to have it be a long int, but
 gen_gen_c does not allow the "long" modifier.
 
+Each strip records the time on the clock of the world at which it was
+last touched (changed), either by a square in it being marked or by
+one of its patches being moved. The world records, for each of the
+rules that work on one strip at a time (try_full_bounded,
+try_empty_outside, try_empty_no_room, try_block, and try_one), the
+time at which the rule last started (clean). A rule looks only at the
+strips touched since then (see QUEUED), since running a rule again on
+a strip in which nothing has changed changes nothing. The clock and the
+times the rules last started are put back when a guess is taken back
+(see try_guessing), so a guess looks only at what it touches, the clock
+counts only the touches along one line of guesses, and an int is big
+enough.
+
+The squares of the puzzle are kept twice, by row in squares and by
+column in transpose, so that a column, like a row, lies in one piece of
+memory. put_square writes both. The functions that run through a whole
+strip read it through a pointer to its line (see get_line) rather than
+calling get_square for each square, so they do not test use_rows or
+the bounds of the puzzle for each square.
+
+The search is made in one world. Each change solve_problem makes to the
+world (a square marked, a patch moved or done, a counter changed) is
+recorded first on the trail of the world as the place that changed and
+the value it had. A guess is taken back by undoing the changes
+recorded since it was made, latest first (see undo_trail). The trail is
+made longer as needed, so the search may go as deep as the puzzle
+needs, and it holds only the changes along the line of guesses being
+tried. The logic lines are not on the trail. They are written only past
+world->logic_line, which is on the trail.
+
+When the search is shared among threads, a task is a copy of the world
+just after a guess has been made, waiting on a queue to be solved. Each
+thread has a queue, and each has its own trail, which the world of the
+task it is solving is given. The pool holds the queues and the answers
+found, and its lock guards everything in it. The path of a world is
+the start of the block of each guess made to reach it, for the guesses
+made at depths less than SPLIT_DEPTH. Below that, one thread follows up
+every guess, so answers with the same path are found in order, and
+comparing paths is enough to put the answers in the order a single
+thread would have found them (see sort_answers).
+
 */
 
+struct change
+{
+  int * number;   /* counter that was changed, or NULL for a square     */
+  int row;        /* row index of square that was changed               */
+  int col;        /* column index of square that was changed            */
+  int value;      /* value of square or counter before the change       */
+};
+
 struct patch
 {
   int done;   /* non-zero means patch is done               */
@@ -106,20 +190,31 @@ struct patch
 
 struct strip
 {
+  int changed;                            /* clock when last touched         */
   int number_patches;                     /* number of patches in the strip  */
   struct patch patches[MAX_STRIP_BLOCKS]; /* the patches of the strip        */
   int undone;                             /* number of patches not done      */
   int total;                              /* total squares to fill in strip  */
 };
 
+struct trail
+{
+  struct change * changes;  /* changes in the order they were made */
+  int number_changes;       /* number of changes recorded          */
+  int size;                 /* number of changes there is room for */
+};
+
 struct paint_world
 {
   struct strip cols[MAX_NUMBER_COLS];  /* data on columns                    */
   int in_cols[MAX_NUMBER_COLS];   /* columns on which progress made          */
+  int clean[NUMBER_RULES];        /* clock when each rule last started       */
+  int clock;                      /* number of times strips touched          */
   int col_lines;                  /* number column lines, is max col targets */
   char col_numbers[MAX_STRIP_BLOCKS][TEXT_SIZE]; /* numbers above columns    */
   int depth;                      /* search depth                            */
   int find_all;                   /* set to 1 if all answers to be found     */
+  int jobs;                       /* number of threads to search with        */
   char logic[MAX_LOGIC][TEXT_SIZE];  /* explanation of changes in puzzle     */
   int logic_line;                 /* number of next line of logic to write   */
   int number_cols;                /* number of columns in puzzle             */
@@ -127,6 +222,8 @@ struct paint_world
   int number_rows;                /* number of rows in puzzle                */
   int number_in_rows;             /* number of rows on which progress made   */
   int number_spaces;              /* number of blanks or digits before |     */
+  int path[SPLIT_DEPTH];          /* start of block of each guess made       */
+  struct pool * pool;             /* pool of threads searching, or NULL      */
   int print_all;                  /* set to 1 for printing partial solutions */
   int progress_puzzle;            /* set to 1 if any square marked in puzzle */
   int progress_strip;             /* set to 1 if any square marked in strip  */
@@ -135,9 +232,37 @@ struct paint_world
   char row_numbers[MAX_NUMBER_ROWS][TEXT_SIZE]; /* numbers beside rows       */
   double space;                   /* estimated size space yet to be searched */
   char squares[MAX_NUMBER_ROWS][MAX_NUMBER_COLS]; /* array of squares        */
+  char transpose[MAX_NUMBER_COLS][MAX_NUMBER_ROWS]; /* squares by column     */
+  struct trail * trail;           /* changes that may be undone              */
   int undone;                     /* number of strips not done               */
   int use_rows;                   /* 1 to use rows first 0 for columns first */
   int verbose;                    /* verbose (non-zero) or not (zero)        */
+  int worker;                     /* index of thread working on this world   */
+};
+
+struct queue
+{
+  int first;                      /* index of oldest task in tasks       */
+  int number_tasks;               /* number of tasks waiting             */
+  struct pool * pool;             /* pool the queue belongs to           */
+  struct paint_world * tasks[MAX_TASKS]; /* tasks waiting, oldest first  */
+  pthread_t thread;               /* thread that owns the queue          */
+  struct trail * trail;           /* trail for thread                    */
+  int worker;                     /* index of queue in pool              */
+};
+
+struct pool
+{
+  struct paint_world ** answers;  /* answers found, in order found       */
+  int cancel;                     /* set to 1 to stop all searching; once */
+                                  /* threads run, read and set atomically */
+  pthread_mutex_t lock;           /* lock on everything in pool          */
+  int number_answers;             /* number of answers found             */
+  int number_threads;             /* number of threads searching         */
+  int pending;                    /* tasks queued or running             */
+  struct queue queues[MAX_THREADS]; /* one queue of tasks per thread     */
+  int size_answers;               /* number of answers there is room for */
+  pthread_cond_t wake;            /* signalled when task added or done   */
 };
 
 /*************************************************************************/
@@ -146,16 +271,17 @@ struct paint_world
 
 */
 
+int add_change(struct change ** the_change, struct paint_world * world);
 int add_patch(struct strip * a_strip, int length);
 int balanced(struct paint_world * world);
 int balanced_down(struct paint_world * world);
 int balanced_left(struct paint_world * world);
 int balanced_right(struct paint_world * world);
 int balanced_up(struct paint_world * world);
+int clone_world(struct paint_world ** clone, struct paint_world * world);
 int copy_patch(struct patch * to, struct patch * from);
 int copy_strip(struct strip * to, struct strip * from,
   struct paint_world * world);
-int copy_world(struct paint_world * to, struct paint_world * world);
 int enx_square(int index1, int index2, struct paint_world * world);
 int explain_paint(struct paint_world * world);
 int extend_block(int index1, int index2, int min_target, int length,
@@ -172,6 +298,7 @@ int find_min_starts(int index1, int stop, struct strip * a_strip, int * found,
   struct paint_world * world);
 int find_min_target(int index, struct strip * a_strip, int * size,
   struct paint_world * world);
+int get_line(int index1, char ** line, struct paint_world * world);
 int get_paint1(char * file_name, struct paint_world * world);
 int get_paint2(char * file_name, struct paint_world * world);
 char get_square(int index1, int index2, struct paint_world * world);
@@ -182,6 +309,7 @@ int init_solution(struct paint_world * world);
 int init_world(struct paint_world * world);
 int logic_ok(struct paint_world * world);
 int main(int argc, char ** argv);
+int make_trail(struct trail ** the_trail, struct paint_world * world);
 int mark_block_strip(int index1, int stop, struct strip * a_strip,
   struct paint_world * world);
 int mark_empty_square(int index1, int index2, struct paint_world * world);
@@ -196,9 +324,14 @@ int mark_strip(int index1a, int index1b, int index2, char * save_strip,
   struct paint_world * world);
 int max(int int1, int int2);
 int min(int int1, int int2);
+int move_patches(struct strip * a_strip, struct strip * new_strip,
+  int * moved, struct paint_world * world);
+int path_before(struct paint_world * world1, struct paint_world * world2,
+  int * before);
 int print_paint(struct paint_world * world);
 int put_logic(int index, struct paint_world * world);
 int put_square(int index1, int index2, char item, struct paint_world * world);
+int queue_world(int * queued, struct paint_world * world);
 int read_arguments(int argc, char ** argv, struct paint_world * world);
 int read_col_numbers(FILE * in_port, int * col_total,
   struct paint_world * world);
@@ -206,11 +339,23 @@ int read_problem(char * file_name, struct paint_world * world);
 int read_row_numbers(FILE * in_port, int * row_total,
   struct paint_world * world);
 int record_progress(char * tried, struct paint_world * world);
+int run_pool(struct paint_world * world);
+void * run_queue(void * queue_pointer);
+int run_task(struct queue * the_queue, struct paint_world * task);
+int save_answer(struct paint_world * world);
+int settle_strip(int index1, int stop, struct strip * a_strip,
+  struct paint_world * world);
 int shift_patches_left(int pat, int index2, int * shifted,
   struct strip * a_strip);
 int shift_patches_right(int pat, int index2, int stop, int * shifted,
   struct strip * a_strip);
 int solve_problem(struct paint_world * world);
+int sort_answers(struct pool * the_pool);
+int take_task(struct queue * the_queue, struct paint_world ** task);
+int touch_square(int index1, int index2, struct paint_world * world);
+int touch_strip(struct strip * a_strip, struct paint_world * world);
+int trail_number(int * number, struct paint_world * world);
+int trail_square(int row, int col, struct paint_world * world);
 int try_block(struct paint_world * world);
 int try_corner_col(int row, int col, int i, int j,
   struct paint_world * world);
@@ -235,32 +380,56 @@ int try_guessing(struct paint_world * world);
 int try_one(struct paint_world * world);
 int try_one_strip(int index1, int stop, struct strip * a_strip,
   struct paint_world * world);
+int undo_trail(int mark, struct paint_world * world);
+int work_queue(struct queue * the_queue);
 
 /*************************************************************************/
 
-/* globals
+/* define_functions
 
-The worlds array is declared because:
-1. A copy of the paint_world world is needed in try_guessing for search.
-2. Try_guessing is called recursively.
-3. If a paint_world is declared in try_guessing as an automatic variable,
-   it uses stack space. Since paint_world is a big structure, it uses
-   a lot of space on the stack, and eventually the stack overflows
-   if recursions goes deep. Global variables do not use stack space.
+*/
 
-The deepest recursion has been observed to go is 52 levels deep, so
-100 worlds is probably enough.
+/*************************************************************************/
 
-*/
+/* add_change
 
-struct paint_world worlds[100]; /* array of worlds for search */
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for a longer trail: "Out of memory".
 
-/*************************************************************************/
+Called By:
+  trail_number
+  trail_square
 
-/* define_functions
+Side Effects: This sets the_change to point to the next unused change
+on the trail of the world and counts it as used. If the trail is full,
+it is first made twice as long.
 
 */
 
+int add_change(               /* ARGUMENTS                      */
+ struct change ** the_change, /* next change on trail, set here */
+ struct paint_world * world)  /* puzzle model                   */
+{
+  const char * name SET_TO "add_change";
+  struct trail * trail;
+  struct change * changes; /* changes moved to a longer block */
+
+  trail SET_TO world->trail;
+  if (trail->number_changes IS trail->size)
+    {
+      changes SET_TO (struct change *)
+	realloc(trail->changes,
+		(2 * (long)trail->size * sizeof(struct change)));
+      CHB((changes IS NULL), "Out of memory");
+      trail->changes SET_TO changes;
+      trail->size SET_TO (2 * trail->size);
+    }
+  *the_change SET_TO (trail->changes + trail->number_changes++);
+  return OK;
+}
+
 /*************************************************************************/
 
 /* add_patch
@@ -686,6 +855,56 @@ int balanced_up(             /* ARGUMENTS    */
 
 /*************************************************************************/
 
+/* clone_world
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the copy: "Out of memory".
+
+Called By:
+  queue_world
+  run_pool
+  save_answer
+
+Side Effects: This makes *clone a copy of the world, made with calloc,
+which the caller must free. The copy has no trail.
+
+Notes:
+
+The world holds no pointers but its trail and its pool, so a copy of
+its bytes is a copy of the world. The copy shares the pool.
+
+The logic lines from world->logic_line on are not copied. calloc gives
+memory that is all 0, as those lines must be (see logic_ok), and the
+system does not give the program the pages of a big block that are
+never written. Since most of the world is logic lines, a copy takes
+little more memory than the part of the world that is in use.
+
+*/
+
+int clone_world(               /* ARGUMENTS                       */
+ struct paint_world ** clone,  /* copy of world made, set here    */
+ struct paint_world * world)   /* world to copy                   */
+{
+  const char * name SET_TO "clone_world";
+  long head;                   /* bytes of world before logic     */
+  long tail;                   /* bytes of world before rest      */
+
+  *clone SET_TO (struct paint_world *)calloc(1, sizeof(struct paint_world));
+  CHB((*clone IS NULL), "Out of memory");
+  head SET_TO ((char *)(world->logic) - (char *)world);
+  tail SET_TO ((char *)(world->logic + MAX_LOGIC) - (char *)world);
+  memcpy(*clone, world, head);
+  memcpy((*clone)->logic, world->logic, ((long)world->logic_line * TEXT_SIZE));
+  memcpy(((char *)*clone + tail), ((char *)world + tail),
+	 (sizeof(struct paint_world) - tail));
+  (*clone)->trail SET_TO NULL;
+  return OK;
+}
+
+/*************************************************************************/
+
 /* copy_patch
 
 Returned Value: int (OK)
@@ -719,12 +938,12 @@ Returned Value: int
   1. copy_patch returns ERROR.
 
 Called By:
-  copy_world
+  mark_patches_strip
   try_corner_col
   try_corner_row
   try_edge_test_col
   try_edge_test_row
-  try_one_strip
+  try_guessing
 
 Side Effects: This copies the "from" strip onto the "to" strip.
 
@@ -742,6 +961,7 @@ int copy_strip(              /* ARGUMENTS          */
   const char * name SET_TO "copy_strip";
   int n;
 
+  to->changed SET_TO from->changed;
   to->number_patches SET_TO from->number_patches;
   for (n SET_TO 0; n < to->number_patches; n++)
     {
@@ -754,112 +974,25 @@ int copy_strip(              /* ARGUMENTS          */
 
 /*************************************************************************/
 
-/* copy_world
-
-Returned Value: int 
-  If any of the following errors occur, this returns ERROR.
-  Otherwise, it returns OK.
-  1. copy_strip does not return OK.
-
-Called By:  try_guessing
-
-Side Effects: This copies the "world" world onto the "to" world.
-
-Notes:
-
-The world is called "world" rather than "from" because IFF needs there
-to be a "world" argument.
-
-The last character of each logic line is copied explicitly so that
-it will be possible to detect long lines. See documentation of logic_ok.
-
-*/
-
-int copy_world(              /* ARGUMENTS          */
- struct paint_world * to,    /* world to copy into */
- struct paint_world * world) /* world to copy from */
-{
-  const char * name SET_TO "copy_world";
-  int row;
-  int col;
-  int n;
-  int last;
-
-  last SET_TO TEXT_SIZE;
-  last SET_TO (last - 1);
-  for (col SET_TO 0; col < world->number_cols; col++)
-    {
-      IFF(copy_strip(&(to->cols[col]), &(world->cols[col]), world));
-    }
-  for (n SET_TO 0; n < world->number_in_cols; n++)
-    {
-      to->in_cols[n] SET_TO world->in_cols[n];
-    }
-  to->col_lines SET_TO world->col_lines;
-  for (n SET_TO 0; n < world->col_lines; n++)
-    {
-      strncpy(to->col_numbers[n], world->col_numbers[n], TEXT_SIZE);
-    }
-  to->find_all SET_TO world->find_all;
-  for (n SET_TO 0; n < world->logic_line; n++)
-    {
-      strncpy(to->logic[n], world->logic[n], TEXT_SIZE);
-      to->logic[n][last] SET_TO world->logic[n][last];
-    }
-  for (n SET_TO world->logic_line; n < MAX_LOGIC; n++)
-    to->logic[n][last] SET_TO 0;
-  to->logic_line SET_TO world->logic_line;
-  to->number_cols SET_TO world->number_cols;
-  to->number_in_cols SET_TO world->number_in_cols;
-  to->number_rows SET_TO world->number_rows;
-  to->number_in_rows SET_TO world->number_in_rows;
-  to->number_spaces SET_TO world->number_spaces;
-  to->print_all SET_TO world->print_all;
-  to->progress_puzzle SET_TO world->progress_puzzle;
-  to->progress_strip SET_TO world->progress_strip;
-  for (row SET_TO 0; row < world->number_rows; row++)
-    {
-      IFF(copy_strip(&(to->rows[row]), &(world->rows[row]), world));
-    }
-  for (n SET_TO 0; n < world->number_in_rows; n++)
-    {
-      to->in_rows[n] SET_TO world->in_rows[n];
-    }
-  for (row SET_TO 0; row < world->number_rows; row++)
-    {
-      strncpy(to->row_numbers[row], world->row_numbers[row], TEXT_SIZE);
-    }
-  for (row SET_TO 0; row < world->number_rows; row++)
-    {
-      for (col SET_TO 0; col < world->number_cols; col++)
-	{
-	  to->squares[row][col] SET_TO world->squares[row][col];
-	}
-    }
-  to->undone SET_TO world->undone;
-  to->use_rows SET_TO world->use_rows;
-  to->verbose SET_TO world->verbose;
-  return OK;
-}
-
-/*************************************************************************/
-
 /* enx_square
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
   1. The square is neither blank nor already marked with an X: "bad square".
+  2. put_square returns ERROR.
+  3. touch_square returns ERROR.
 
 Called By:
   extend_block
   init_patches_strip
   mark_patches_strip
-  try_one_strip
+  settle_strip
 
 Side Effects: If the square at [index1, index2] (for world->use_rows
 or at [index2, index1] for not world->use_rows) is blank, this puts an
-X in it and sets world->progress_puzzle and world->progress_strip to 1.
+X in it, touches the row and column of the square, and sets
+world->progress_puzzle and world->progress_strip to 1.
 
 Might add an in-bounds check on index1 and index2.
 
@@ -876,7 +1009,8 @@ int enx_square(              /* ARGUMENTS              */
     {
       if (world->squares[index1][index2] IS ' ')
 	{
-	  world->squares[index1][index2] SET_TO 'X';
+	  IFF(put_square(index1, index2, 'X', world));
+	  IFF(touch_square(index1, index2, world));
 	  world->progress_puzzle SET_TO 1;
 	  world->progress_strip SET_TO 1;
 	}
@@ -890,7 +1024,8 @@ int enx_square(              /* ARGUMENTS              */
     {
       if (world->squares[index2][index1] IS ' ')
 	{
-	  world->squares[index2][index1] SET_TO 'X';
+	  IFF(put_square(index1, index2, 'X', world));
+	  IFF(touch_square(index1, index2, world));
 	  world->progress_puzzle SET_TO 1;
 	  world->progress_strip SET_TO 1;
 	}
@@ -909,7 +1044,9 @@ int enx_square(              /* ARGUMENTS              */
 
 Returned Value: int (OK)
 
-Called By:  solve_problem
+Called By:
+  run_pool
+  solve_problem
 
 Side Effects: This prints the explanation of the steps in solving the
 puzzle, which has been accumulated in the world->logic array of strings.
@@ -1248,7 +1385,9 @@ int find_max_ends(            /* ARGUMENTS                              */
   int pat;
   int shifted;
   struct patch * a_patch;
+  char * line;                /* squares of the strip */
 
+  IFF(get_line(index1, &line, world));
   pat SET_TO 0;
   for (index2 SET_TO 0; ((index2 < stop) AND (pat < a_strip->number_patches)); )
     {
@@ -1257,7 +1396,7 @@ int find_max_ends(            /* ARGUMENTS                              */
 	{
 	  pat++;
 	}
-      else if (get_square(index1, index2, world) IS 'X')
+      else if (line[index2] IS 'X')
 	{
 	  if ((a_patch->end - a_patch->target + 1) > index2)
 	    {
@@ -1270,7 +1409,7 @@ int find_max_ends(            /* ARGUMENTS                              */
 	  else
 	    index2++;
 	}
-      else if (get_square(index1, index2, world) IS '.')
+      else if (line[index2] IS '.')
 	{
 	  if ((a_patch->end - a_patch->target + 1) <= index2)
 	    {
@@ -1286,7 +1425,7 @@ int find_max_ends(            /* ARGUMENTS                              */
 	index2++;
     }
   for (; index2 < stop; index2++)
-    CHK((get_square(index1, index2, world) IS 'X'), "puzzle has no answer");
+    CHK((line[index2] IS 'X'), "puzzle has no answer");
   return OK;
 }
 
@@ -1305,7 +1444,6 @@ Called By:
   try_corner_row
   try_edge_test_col
   try_edge_test_row
-  try_one_strip
 
 Side Effects: This finds the smallest possible values for the starts
 of the patches of the given strip, consistent with what is known about
@@ -1404,7 +1542,9 @@ int find_min_starts(         /* ARGUMENTS                                 */
   int pat;
   struct patch * a_patch;
   int shifted;
+  char * line;                /* squares of the strip */
 
+  IFF(get_line(index1, &line, world));
   pat SET_TO (a_strip->number_patches - 1);
   shifted SET_TO 1;
   for (index2 SET_TO (stop - 1); ((index2 > -1) AND (pat > -1)); )
@@ -1414,7 +1554,7 @@ int find_min_starts(         /* ARGUMENTS                                 */
 	{
 	  pat--;
 	}
-      else if (get_square(index1, index2, world) IS 'X')
+      else if (line[index2] IS 'X')
 	{
 	  if ((a_patch->start + a_patch->target - 1) < index2)
 	    {
@@ -1428,7 +1568,7 @@ int find_min_starts(         /* ARGUMENTS                                 */
 	  else
 	    index2--;
 	}
-      else if (get_square(index1, index2, world) IS '.')
+      else if (line[index2] IS '.')
 	{
 	  if ((a_patch->start + a_patch->target - 1) >= index2)
 	    {
@@ -1450,7 +1590,7 @@ int find_min_starts(         /* ARGUMENTS                                 */
       *found SET_TO 1;
       for (; index2 > -1; index2--)
 	{
-	  if (get_square(index1, index2, world) IS 'X')
+	  if (line[index2] IS 'X')
 	    {
 	      *found SET_TO 0;
 	      break;
@@ -1509,6 +1649,52 @@ int find_min_target(         /* ARGUMENTS                     */
 
 /*************************************************************************/
 
+/* get_line
+
+Returned Value: int (OK)
+
+Called By:
+  find_max_ends
+  find_min_starts
+  mark_block_strip
+  mark_empty_strip2
+  mark_patches_strip
+  settle_strip
+
+Side Effects: line is set to point to the squares of the row whose
+index is index1 if world->use_rows is 1 (in world->squares) or of the
+column whose index is index1 if world->use_rows is 0 (in
+world->transpose). (*line)[index2] is then the square that
+get_square(index1, index2, world) returns.
+
+Notes:
+
+Unlike get_square, this does not pad the strip with empty squares, so
+only the squares from 0 up to one less than the length of the strip
+may be read through line. index1 must be the index of a row or column
+of the puzzle.
+
+The squares must not be changed through line, since that would change
+only one of world->squares and world->transpose. Use put_square.
+
+*/
+
+int get_line(                /* ARGUMENTS                        */
+ int index1,                 /* index of row or column           */
+ char ** line,               /* pointer to squares of strip, set */
+ struct paint_world * world) /* puzzle model                     */
+{
+  const char * name SET_TO "get_line";
+
+  if (world->use_rows)
+    *line SET_TO world->squares[index1];
+  else
+    *line SET_TO world->transpose[index1];
+  return OK;
+}
+
+/*************************************************************************/
+
 /* get_paint1
 
 Returned Value: int
@@ -1746,9 +1932,9 @@ int get_paint2(              /* ARGUMENTS            */
 Returned Value: char
 
 This returns the actual character of world->squares (in the [index1,
-index2] position if world->use_rows is 1 or in the [index2, index1]
-position if world->use_rows is 0) if the square is inside the defined
-area, and returns empty ('.') otherwise.
+index2] position if world->use_rows is 1) or of world->transpose (in
+the [index1, index2] position if world->use_rows is 0) if the square
+is inside the defined area, and returns empty ('.') otherwise.
 
 Called By:
   balanced_down
@@ -1757,13 +1943,8 @@ Called By:
   balanced_up
   extend_block
   find_best_patch
-  find_max_ends
-  find_min_starts
   init_patches_strip
-  mark_block_strip
   mark_empty_square
-  mark_empty_strip2
-  mark_patches_strip
   mark_strip
   try_corner_col
   try_corner_row
@@ -1771,7 +1952,6 @@ Called By:
   try_edge_col
   try_edge_row
   try_guessing
-  try_one_strip
 
 Side Effects: none
 
@@ -1800,7 +1980,8 @@ char get_square(             /* ARGUMENTS              */
       (index2 < world->number_cols)) ? world->squares[index1][index2] :
      ((NOT (world->use_rows)) AND
       (index1 < world->number_cols) AND
-      (index2 < world->number_rows)) ? world->squares[index2][index1] : '.');
+      (index2 < world->number_rows)) ? world->transpose[index1][index2] :
+     '.');
   return result;
 }
 
@@ -1998,6 +2179,7 @@ int init_world(              /* ARGUMENTS    */
 
   for (col SET_TO 0; col < MAX_NUMBER_COLS; col++)
     {
+      world->cols[col].changed SET_TO 0;
       world->cols[col].total SET_TO 0;
       world->cols[col].undone SET_TO 0;
       world->cols[col].number_patches SET_TO 0;
@@ -2010,12 +2192,16 @@ int init_world(              /* ARGUMENTS    */
 	}
       world->in_cols[col] SET_TO 0;
     }
+  for (n SET_TO 0; n < NUMBER_RULES; n++)
+    world->clean[n] SET_TO -1;
+  world->clock SET_TO 0;
   world->col_lines SET_TO 0;
   for (n SET_TO 0; n < MAX_STRIP_BLOCKS; n++)
     for (m SET_TO 0; m < TEXT_SIZE; m++)
       world->col_numbers[n][m] SET_TO 0;
   world->depth SET_TO 0;
   world->find_all SET_TO 0;
+  world->jobs SET_TO 1;
   for (n SET_TO 0; n < MAX_LOGIC; n++)
     for (m SET_TO 0; m < TEXT_SIZE; m++)
       world->logic[n][m] SET_TO 0;
@@ -2025,11 +2211,15 @@ int init_world(              /* ARGUMENTS    */
   world->number_rows SET_TO 0;
   world->number_in_rows SET_TO 0;
   world->number_spaces SET_TO 0;
+  for (n SET_TO 0; n < SPLIT_DEPTH; n++)
+    world->path[n] SET_TO 0;
+  world->pool SET_TO NULL;
   world->print_all SET_TO 0;
   world->progress_puzzle SET_TO 0;
   world->progress_strip SET_TO 0;
   for (row SET_TO 0; row < MAX_NUMBER_ROWS; row++)
     {
+      world->rows[row].changed SET_TO 0;
       world->rows[row].total SET_TO 0;
       world->rows[row].undone SET_TO 0;
       world->rows[row].number_patches SET_TO 0;
@@ -2048,12 +2238,15 @@ int init_world(              /* ARGUMENTS    */
       for (col SET_TO 0; col < MAX_NUMBER_COLS; col++)
 	{
 	  world->squares[row][col] SET_TO ' ';
+	  world->transpose[col][row] SET_TO ' ';
 	}
     }
   world->space SET_TO 1;
+  world->trail SET_TO NULL;
   world->undone SET_TO 0;
   world->use_rows SET_TO 1;
   world->verbose SET_TO 0;
+  world->worker SET_TO 0;
   return OK;
 }
 
@@ -2065,10 +2258,12 @@ Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
   1. More than (MAX_LOGIC - 10) logic lines are used: "too many logic lines".
+  2. trail_number returns ERROR.
 
 Called By:  record_progress
 
-Side Effects: world->logic_line may be incremented
+Side Effects: world->logic_line is incremented at least once. Its
+value before is recorded on the trail.
 
 Notes:
 
@@ -2080,11 +2275,11 @@ characters. There are no dividers between the lines, so several lines
 may be used as one line. The record_progress function may have written
 beyond the end of the line it started writing on. That is detected
 here by seeing if there is a 0 in the last position of the previous
-line. All the last positions are initialized to 0 (and the last
-positions are copied in copy_world), so if the last position of the
-line is not zero, writing must have gone into the next line. In this
-case, the world->logic line is incremented more than once to get beyond
-the end of the string.
+line. All the last positions are initialized to 0 (and those from
+world->logic_line on are set to 0 again when try_guessing takes back a
+guess), so if the last position of the line is not zero, writing must
+have gone into the next line. In this case, the world->logic line is
+incremented more than once to get beyond the end of the string.
 
 To be sure there is always lots of room at the end of the array (to
 allow for long lines), this signals an error if the the logic_line
@@ -2103,6 +2298,7 @@ int logic_ok(                /* ARGUMENTS                */
   stop SET_TO (stop - 10);
   last SET_TO TEXT_SIZE;
   last SET_TO (last - 1);
+  IFF(trail_number(&(world->logic_line), world));
   for (; world->logic[world->logic_line][last] ISNT 0; world->logic_line++)
     CHB((world->logic_line > stop), "too many logic lines");
   world->logic_line++;
@@ -2120,7 +2316,10 @@ Side Effects: This
 3. calls read_problem to read the puzzle, record data, and make
    a lot of format checks.
 4. calls init_solution to initialize the solving process.
-5. calls solve_problem to solve the puzzle.
+5. calls solve_problem to solve the puzzle, or run_pool if more than
+   one thread is to search.
+The world is made with malloc, since it is too big to be put on the
+stack safely, and the trail is made once the puzzle is read.
 
 Notes:
 
@@ -2135,7 +2334,8 @@ The executable takes two command arguments. The first argument is the
 name of the file containing the puzzle. The second argument must be
 "yes" or "no", with "yes" meaning that the partially solved puzzle
 should be printed each time a rule is applied and has succeeded in
-marking one or more squares full or empty.
+marking one or more squares full or empty. If "-j N" is given after
+those, N threads share the search (see run_pool).
 
 Always finding all solutions is currently implemented.
 
@@ -2156,15 +2356,65 @@ int main(      /* ARGUMENTS                             */
  char ** argv) /* function name and arguments           */
 {
   const char * name SET_TO "main";
-  struct paint_world world1;
   struct paint_world * world;
 
-  world SET_TO worlds;
+  world SET_TO (struct paint_world *)malloc(sizeof(struct paint_world));
+  CHB((world IS NULL), "Out of memory");
   IFF(init_world(world));
   IFF(read_arguments(argc, argv, world));
   IFF(read_problem(argv[1], world));
+  IFF(make_trail(&(world->trail), world));
   IFF(init_solution(world));
-  CHB((solve_problem(world) ISNT OK), "puzzle has no answer");
+  if (world->jobs > 1)
+    IFF(run_pool(world));
+  else
+    CHB((solve_problem(world) ISNT OK), "puzzle has no answer");
+  free(world->trail->changes);
+  free(world->trail);
+  free(world);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* make_trail
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the trail: "Out of memory".
+
+Called By:
+  main
+  run_pool
+
+Side Effects: This makes an empty trail and sets the_trail to point to
+it.
+
+Notes:
+
+A square is marked at most once on a line of guesses, and marking it
+records the square and the times its row and column changed on the
+trail, so the trail starts out with room for four changes for each
+square. add_change makes it longer if more are needed.
+
+*/
+
+int make_trail(              /* ARGUMENTS                */
+ struct trail ** the_trail,  /* trail made, set here     */
+ struct paint_world * world) /* puzzle model             */
+{
+  const char * name SET_TO "make_trail";
+  struct trail * trail;
+
+  trail SET_TO (struct trail *)malloc(sizeof(struct trail));
+  CHB((trail IS NULL), "Out of memory");
+  trail->size SET_TO ((4 * world->number_rows * world->number_cols) + 64);
+  trail->changes SET_TO (struct change *)
+    malloc((long)trail->size * sizeof(struct change));
+  CHB((trail->changes IS NULL), "Out of memory");
+  trail->number_changes SET_TO 0;
+  *the_trail SET_TO trail;
   return OK;
 }
 
@@ -2205,12 +2455,14 @@ int mark_block_strip(        /* ARGUMENTS                       */
   char item;
   int length;
   int done;
+  char * line;                /* squares of the strip */
 
   world->progress_strip SET_TO 0;
+  IFF(get_line(index1, &line, world));
   length SET_TO 0;
   for (index2 SET_TO 0; index2 <= stop; index2++)
     {
-      item SET_TO get_square(index1, index2, world);
+      item SET_TO ((index2 < stop) ? line[index2] : '.');
       if ((item IS '.') OR (item IS ' '))
 	{
 	  if (length)
@@ -2275,6 +2527,8 @@ Returned Value: int
   Otherwise, it returns OK.
   1. A square that should be marked empty is neither blank nor already
      marked empty: "puzzle has no answer".
+  2. put_square returns ERROR.
+  3. touch_square returns ERROR.
 
 Called By:
   init_patches_strip
@@ -2282,15 +2536,15 @@ Called By:
   mark_empty_strip
   mark_empty_strip2
   mark_patches_strip
+  settle_strip
   try_corner_col
   try_corner_row
   try_edge_square_col
   try_edge_square_row
-  try_one_strip
 
 Side Effects: If the given square is not already marked empty, it is
-marked empty and world->progress_puzzle and world->progress_strip are
-both set to 1.
+marked empty, its row and column are touched, and
+world->progress_puzzle and world->progress_strip are both set to 1.
 
 */
 
@@ -2303,7 +2557,8 @@ int mark_empty_square(       /* ARGUMENTS                              */
 
   if (get_square(index1, index2, world) IS ' ')
     {
-      put_square(index1, index2, '.', world);
+      IFF(put_square(index1, index2, '.', world));
+      IFF(touch_square(index1, index2, world));
       world->progress_puzzle SET_TO 1;
       world->progress_strip SET_TO 1;
     }
@@ -2398,12 +2653,15 @@ int mark_empty_strip2(       /* ARGUMENTS                                    */
   int index2;
   char item;
   int length;
+  char * line;                /* squares of the strip */
 
   world->progress_strip SET_TO 0;
+  IFF(get_line(index1, &line, world));
   on_blanks SET_TO 0;
+  length SET_TO 0;
   for (index2 SET_TO 0; index2 < stop; index2++)
     {
-      item SET_TO get_square(index1, index2, world);
+      item SET_TO line[index2];
       if (item IS '.')
 	{
 	  if (on_blanks)
@@ -2426,7 +2684,7 @@ int mark_empty_strip2(       /* ARGUMENTS                                    */
 		}
 	      on_blanks SET_TO 0;
 	    }
-	  if (get_square(index1, (index2 + 1), world) IS ' ')
+	  if (((index2 + 1) < stop) AND (line[index2 + 1] IS ' '))
 	    {
 	      length SET_TO 0;
 	      on_blanks SET_TO 1;
@@ -2456,12 +2714,16 @@ int mark_empty_strip2(       /* ARGUMENTS                                    */
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. find_min_starts returns ERROR.
-  2. find_min_starts does not find min_starts: "puzzle has no answer"
-  3. find_max_ends returns ERROR.
-  4. enx_square returns ERROR.
-  5. mark_empty_square returns ERROR.
-  6. put_logic returns ERROR.
+  1. copy_strip returns ERROR.
+  2. find_min_starts returns ERROR.
+  3. find_min_starts does not find min_starts: "puzzle has no answer"
+  4. find_max_ends returns ERROR.
+  5. move_patches returns ERROR.
+  6. touch_strip returns ERROR.
+  7. enx_square returns ERROR.
+  8. trail_number returns ERROR.
+  9. mark_empty_square returns ERROR.
+ 10. put_logic returns ERROR.
 
 Called By:  try_full_bounded
 
@@ -2470,7 +2732,12 @@ full are marked full. If the patch becomes done (indicated by the target
 being the same size as [end plus one] minus start), the undone of the
 strip is decremented. If the undone of the strip becomes zero, the
 undone of the puzzle is decremented and any blank squares in the strip
-are marked empty.
+are marked empty. If any patch is moved, the strip is touched.
+
+Notes:
+
+The starts and ends are found in a copy of a_strip, so that only the
+patches that move go on the trail (see move_patches).
 
 */
 
@@ -2485,11 +2752,19 @@ int mark_patches_strip(      /* ARGUMENTS                         */
   struct patch * patchn;
   int index2;              /* index of column or row */
   int found;
+  int moved;               /* set to 1 if any patch moved         */
+  char * line;             /* squares of the strip                */
+  struct strip new_strip;  /* a_strip with patches moved          */
 
   world->progress_strip SET_TO 0;
-  IFF(find_min_starts(index1, stop, a_strip, &found, world));
+  IFF(get_line(index1, &line, world));
+  IFF(copy_strip(&new_strip, a_strip, world));
+  IFF(find_min_starts(index1, stop, &new_strip, &found, world));
   CHK((NOT found), "puzzle has no answer");
-  IFF(find_max_ends(index1, stop, a_strip, world));
+  IFF(find_max_ends(index1, stop, &new_strip, world));
+  IFF(move_patches(a_strip, &new_strip, &moved, world));
+  if (moved)
+    IFF(touch_strip(a_strip, world));
   for (pat SET_TO 0; pat < a_strip->number_patches; pat++)
     {
       patchn SET_TO &(a_strip->patches[pat]);
@@ -2499,13 +2774,15 @@ int mark_patches_strip(      /* ARGUMENTS                         */
 	       index2 < (patchn->start + patchn->target);
 	       index2++)
 	    {
-	      if (get_square(index1, index2, world) ISNT 'X')
+	      if (line[index2] ISNT 'X')
 		{
 		  IFF(enx_square(index1, index2, world));
 		}
 	    }
 	  if (((patchn->end + 1) - patchn->start) IS patchn->target)
 	    {
+	      IFF(trail_number(&(patchn->done), world));
+	      IFF(trail_number(&(a_strip->undone), world));
 	      patchn->done SET_TO 1;
 	      a_strip->undone--;
 	    }
@@ -2513,10 +2790,11 @@ int mark_patches_strip(      /* ARGUMENTS                         */
     }
   if (a_strip->undone IS 0)
     {
+      IFF(trail_number(&(world->undone), world));
       world->undone--;
       for (index2 SET_TO 0; index2 < stop; index2++)
 	{
-	  if (get_square(index1, index2, world) IS ' ')
+	  if (line[index2] IS ' ')
 	    IFF(mark_empty_square(index1, index2, world));
 	}
     }
@@ -2534,6 +2812,7 @@ Returned Value: int
   Otherwise, it returns OK.
   1. find_last_undone_target returns ERROR.
   2. find_first_undone_target returns ERROR.
+  3. put_square returns ERROR.
 
 Called By:
   try_corner_col
@@ -2543,8 +2822,9 @@ Called By:
 
 Side Effects: This marks squares of the strip whose index is index1 (a
 row if use_rows, a column if use_cols). Before marking the squares, it
-copies their original values into save_strip, so they can be restored
-later.
+copies their original values into save_strip. The squares are marked
+with put_square, so they are recorded on the trail, and the caller
+takes them back out with undo_trail.
 
 If it is impossible to fill in the strip because squares have already
 been filled differently from what is required, *marked is set to 0.
@@ -2574,6 +2854,7 @@ int mark_strip(         /* ARGUMENTS                                       */
   int size2;
 
   *marked SET_TO 1;
+  size2 SET_TO 0;
   for (n SET_TO 0; n < size1; n++)
     {
       save_strip[n] SET_TO get_square(index1a, (index2 + (sign * n)), world);
@@ -2596,7 +2877,7 @@ int mark_strip(         /* ARGUMENTS                                       */
 		  break;
 		}
 	      else
-		put_square(index1a, (index2 + (sign * n)), '.', world);
+		IFF(put_square(index1a, (index2 + (sign * n)), '.', world));
 	    }
 	  else
 	    {
@@ -2606,7 +2887,7 @@ int mark_strip(         /* ARGUMENTS                                       */
 		  break;
 		}
 	      else
-		put_square(index1a, (index2 + (sign * n)), 'X', world);
+		IFF(put_square(index1a, (index2 + (sign * n)), 'X', world));
 	    }
 	}
     }
@@ -2622,6 +2903,7 @@ Returned Value: int (the larger of int1 and int2)
 Called By:
   find_best_patch
   mark_empty_strip2
+  settle_strip
   try_edge_square_col
   try_edge_square_row
 
@@ -2669,6 +2951,106 @@ int min(   /* ARGUMENTS       */
 
 /*************************************************************************/
 
+/* move_patches
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. trail_number returns ERROR.
+
+Called By:
+  mark_patches_strip
+  try_guessing
+
+Side Effects: Each patch of a_strip whose start or end is not the same
+as that of the same patch of new_strip is given the start and end of
+that patch, and the start and end it had are recorded on the trail.
+*moved is set to 1 if any patch of a_strip is moved and to 0 if not.
+
+Notes:
+
+new_strip is a copy of a_strip in which the patches have been moved,
+so that only the starts and ends that change go on the trail.
+
+*/
+
+int move_patches(            /* ARGUMENTS                          */
+ struct strip * a_strip,     /* strip whose patches are moved      */
+ struct strip * new_strip,   /* copy of a_strip with patches moved */
+ int * moved,                /* set here to 1 if any patch moved   */
+ struct paint_world * world) /* puzzle model                       */
+{
+  const char * name SET_TO "move_patches";
+  int pat;
+  struct patch * a_patch;   /* patch of a_strip             */
+  struct patch * new_patch; /* same patch of new_strip      */
+
+  *moved SET_TO 0;
+  for (pat SET_TO 0; pat < a_strip->number_patches; pat++)
+    {
+      a_patch SET_TO &(a_strip->patches[pat]);
+      new_patch SET_TO &(new_strip->patches[pat]);
+      if (a_patch->start ISNT new_patch->start)
+	{
+	  IFF(trail_number(&(a_patch->start), world));
+	  a_patch->start SET_TO new_patch->start;
+	  *moved SET_TO 1;
+	}
+      if (a_patch->end ISNT new_patch->end)
+	{
+	  IFF(trail_number(&(a_patch->end), world));
+	  a_patch->end SET_TO new_patch->end;
+	  *moved SET_TO 1;
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* path_before
+
+Returned Value: int (OK)
+
+Called By:  sort_answers
+
+Side Effects: This sets *before to 1 if the path of guesses that led to
+world1 comes before the path that led to world2 in the order a single
+thread would have tried them. Otherwise, it sets *before to 0.
+
+Notes:
+
+Paths are compared index by index, as far as SPLIT_DEPTH. If one path
+is the start of the other, *before is set to 0. Two answers whose paths
+are the same that far were found by one thread in the order a single
+thread would have found them, and sort_answers keeps them in that
+order.
+
+*/
+
+int path_before(              /* ARGUMENTS                         */
+ struct paint_world * world1, /* puzzle model holding one answer   */
+ struct paint_world * world2, /* puzzle model holding other answer */
+ int * before)                /* set here to 1 or 0                */
+{
+  const char * name SET_TO "path_before";
+  int n;
+
+  *before SET_TO 0;
+  for (n SET_TO 0; ((n < world1->depth) AND (n < world2->depth) AND
+		    (n < SPLIT_DEPTH)); n++)
+    {
+      if (world1->path[n] ISNT world2->path[n])
+	{
+	  *before SET_TO (world1->path[n] < world2->path[n]);
+	  break;
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
 /* print_paint
 
 Returned Value: int (OK)
@@ -2676,6 +3058,7 @@ Returned Value: int (OK)
 Called By:
   get_paint2
   record_progress
+  run_pool
   solve_problem
 
 Side Effects: the puzzle is printed at its current stage of solution.
@@ -2758,25 +3141,33 @@ int put_logic(               /* ARGUMENTS              */
 
 /* put_square
 
-Returned Value: int (OK)
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. trail_square returns ERROR.
 
 Called By:
+  enx_square
   mark_empty_square
   mark_strip
-  try_corner_col
-  try_corner_row
-  try_edge_test_col
-  try_edge_test_row
-  try_one_strip
 
 Side Effects: the given character (item) is put into the puzzle at the
 [index1, index2] position if world->use_rows or at the [index2, index1]
-position, if not.
+position, if not. It is put into world->transpose, too, at the other
+position, so the two stay the same. The character the square had is
+recorded on the trail first.
 
 Notes:
 
 This is not checking that the square is in bounds.
 
+This does not touch the row and column of the square (see
+touch_square), since try_corner_col and the others use it to put in
+squares to test and then take them back out (with undo_trail), which
+changes nothing.
+The squares that are marked to stay go through mark_empty_square or
+enx_square, which do the touching.
+
 */
 
 int put_square(              /* ARGUMENTS            */
@@ -2788,28 +3179,98 @@ int put_square(              /* ARGUMENTS            */
   const char * name SET_TO "put_square";
 
   if (world->use_rows)
-    world->squares[index1][index2] SET_TO item;
+    {
+      IFF(trail_square(index1, index2, world));
+      world->squares[index1][index2] SET_TO item;
+      world->transpose[index2][index1] SET_TO item;
+    }
   else
-    world->squares[index2][index1] SET_TO item;
+    {
+      IFF(trail_square(index2, index1, world));
+      world->squares[index2][index1] SET_TO item;
+      world->transpose[index1][index2] SET_TO item;
+    }
   return OK;
 }
 
 /*************************************************************************/
 
-/* read_arguments
+/* queue_world
 
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. argc is not 4 or 5.
-  2. argv[2] is not "all" or "one.
-  3. argv[3] is not "yes" or "no".
-  4. argc is 5 and argv[4] is not "v".
+  1. clone_world returns ERROR.
 
-Called By:  main
+Called By:  try_guessing
+
+Side Effects: This makes a task holding a copy of the world, in which
+a guess has just been made, and puts it on the queue of the thread
+working on the world. *queued is set to 1 if the task was put on the
+queue. If the queue is full, no task is made and *queued is set to 0,
+so that the caller will follow up the guess itself.
+
+Notes:
 
-Side Effects: The value of world->print_all is set. If there is an
-argument error, a usage message is printed.
+Only the thread that owns a queue adds tasks to it, so if there is
+room when the lock is released, there is still room after the task has
+been made.
+
+*/
+
+int queue_world(             /* ARGUMENTS                         */
+ int * queued,               /* set here to 1 if queued, 0 if not */
+ struct paint_world * world) /* puzzle model                      */
+{
+  const char * name SET_TO "queue_world";
+  struct queue * the_queue;   /* queue of thread working on world */
+  struct paint_world * task;  /* task made here                   */
+  int room;                   /* set to 1 if queue is not full    */
+
+  the_queue SET_TO &(world->pool->queues[world->worker]);
+  pthread_mutex_lock(&(world->pool->lock));
+  room SET_TO (the_queue->number_tasks < MAX_TASKS);
+  pthread_mutex_unlock(&(world->pool->lock));
+  *queued SET_TO 0;
+  if (room)
+    {
+      IFF(clone_world(&task, world));
+      pthread_mutex_lock(&(world->pool->lock));
+      the_queue->tasks[(the_queue->first + the_queue->number_tasks) %
+		       MAX_TASKS] SET_TO task;
+      the_queue->number_tasks++;
+      world->pool->pending++;
+      pthread_cond_signal(&(world->pool->wake));
+      pthread_mutex_unlock(&(world->pool->lock));
+      *queued SET_TO 1;
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* read_arguments
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. argc is less than 4.
+  2. argv[2] is not "all" or "one.
+  3. argv[3] is not "yes" or "no".
+  4. An argument after argv[3] is not "v" or "-j" followed by a number
+     of threads from 1 to MAX_THREADS.
+  5. More than one thread is asked for with "yes".
+
+Called By:  main
+
+Side Effects: The values of world->find_all, world->print_all,
+world->verbose, and world->jobs are set. If there is an argument
+error, a usage message is printed.
+
+Notes:
+
+More than one thread may not be asked for with "yes", since the
+threads would print the puzzle mixed together.
 
 */
 
@@ -2819,10 +3280,29 @@ int read_arguments(          /* ARGUMENTS                             */
  struct paint_world * world) /* puzzle model                          */
 {
   const char * name SET_TO "read_arguments";
+  int bad;  /* set to 1 if any argument is bad */
+  int n;
 
-  if (((argc IS 4) OR ((argc IS 5) AND (strcmp(argv[4], "v") IS 0))) AND
+  bad SET_TO 0;
+  world->verbose SET_TO 0;
+  world->jobs SET_TO 1;
+  for (n SET_TO 4; n < argc; n++)
+    {
+      if ((strcmp(argv[n], "-j") IS 0) AND ((n + 1) < argc))
+	{
+	  world->jobs SET_TO atoi(argv[++n]);
+	  if ((world->jobs < 1) OR (world->jobs > MAX_THREADS))
+	    bad SET_TO 1;
+	}
+      else if (strcmp(argv[n], "v") IS 0)
+	world->verbose SET_TO 1;
+      else
+	bad SET_TO 1;
+    }
+  if ((bad IS 0) AND (argc >= 4) AND
       ((strcmp(argv[2], "all") IS 0) OR (strcmp(argv[2], "one") IS 0)) AND
-      ((strcmp(argv[3], "no") IS 0) OR (strcmp(argv[3], "yes") IS 0)))
+      ((strcmp(argv[3], "no") IS 0) OR
+       ((strcmp(argv[3], "yes") IS 0) AND (world->jobs IS 1))))
     {
       if (strcmp(argv[2], "all") IS 0)
 	world->find_all SET_TO 1;
@@ -2832,19 +3312,17 @@ int read_arguments(          /* ARGUMENTS                             */
 	world->print_all SET_TO 1;
       else
 	world->print_all SET_TO 0;
-      if (argc IS 5)
-	world->verbose SET_TO 1;
-      else
-	world->verbose SET_TO 0;
     }
   else
     {
-      printf("Usage: %s <file name> <all|one> <yes|no> [v]\n", argv[0]);
+      printf("Usage: %s <file name> <all|one> <yes|no> [v] [-j <threads>]\n",
+	     argv[0]);
       printf("all = find all solutions\n");
       printf("one = find one solution\n");
       printf("yes = print puzzle when done and when a rule makes progress\n");
       printf("no = print puzzle only when done\n");
       printf("v = verbose (prints more messages)\n");
+      printf("-j = search with the given number of threads (not with yes)\n");
       CHB(1, " ");
     }
   return OK;
@@ -3150,6 +3628,385 @@ int record_progress(         /* ARGUMENTS       */
 
 /*************************************************************************/
 
+/* run_pool
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for the pool: "Out of memory".
+  2. make_trail or clone_world returns ERROR.
+  3. A thread cannot be started: "Cannot start thread".
+  4. No answer is found: "puzzle has no answer".
+  5. sort_answers returns ERROR.
+  6. print_paint returns ERROR.
+  7. explain_paint returns ERROR.
+
+Called By:  main
+
+Side Effects: This solves the puzzle with world->jobs threads. A pool
+with one queue of tasks per thread is made, and a task holding a copy
+of the world is put on the first queue. The main thread works on the
+first queue and the other threads work on the others until every task
+is finished (see work_queue). Then the answers are printed.
+
+If all answers are wanted, they are printed in the order a single
+thread would have found them. Otherwise, the first answer found is
+printed, which need not be the answer a single thread would have found
+if the puzzle has more than one.
+
+Notes:
+
+Each thread is given its own trail, since a trail is used by one world
+at a time.
+
+*/
+
+int run_pool(                /* ARGUMENTS    */
+ struct paint_world * world) /* puzzle model */
+{
+  const char * name SET_TO "run_pool";
+  struct pool * the_pool;    /* pool of threads made here */
+  struct paint_world * task; /* first task                */
+  int n;
+
+  the_pool SET_TO (struct pool *)malloc(sizeof(struct pool));
+  CHB((the_pool IS NULL), "Out of memory");
+  pthread_mutex_init(&(the_pool->lock), NULL);
+  pthread_cond_init(&(the_pool->wake), NULL);
+  the_pool->answers SET_TO NULL;
+  the_pool->cancel SET_TO 0;
+  the_pool->number_answers SET_TO 0;
+  the_pool->number_threads SET_TO world->jobs;
+  the_pool->pending SET_TO 0;
+  the_pool->size_answers SET_TO 0;
+  for (n SET_TO 0; n < the_pool->number_threads; n++)
+    {
+      the_pool->queues[n].first SET_TO 0;
+      the_pool->queues[n].number_tasks SET_TO 0;
+      the_pool->queues[n].pool SET_TO the_pool;
+      the_pool->queues[n].worker SET_TO n;
+      IFF(make_trail(&(the_pool->queues[n].trail), world));
+    }
+  world->pool SET_TO the_pool;
+  IFF(clone_world(&task, world));
+  the_pool->queues[0].tasks[0] SET_TO task;
+  the_pool->queues[0].number_tasks SET_TO 1;
+  the_pool->pending SET_TO 1;
+  for (n SET_TO 1; n < the_pool->number_threads; n++)
+    {
+      CHB((pthread_create(&(the_pool->queues[n].thread), NULL, run_queue,
+			  &(the_pool->queues[n])) ISNT 0),
+	  "Cannot start thread");
+    }
+  IFF(work_queue(&(the_pool->queues[0])));
+  for (n SET_TO 1; n < the_pool->number_threads; n++)
+    {
+      pthread_join(the_pool->queues[n].thread, NULL);
+    }
+  CHB((the_pool->number_answers IS 0), "puzzle has no answer");
+  if (world->find_all)
+    IFF(sort_answers(the_pool));
+  for (n SET_TO 0; n < the_pool->number_answers; n++)
+    {
+      IFF(print_paint(the_pool->answers[n]));
+      IFF(explain_paint(the_pool->answers[n]));
+      free(the_pool->answers[n]);
+    }
+  for (n SET_TO 0; n < the_pool->number_threads; n++)
+    {
+      free(the_pool->queues[n].trail->changes);
+      free(the_pool->queues[n].trail);
+    }
+  free(the_pool->answers);
+  pthread_cond_destroy(&(the_pool->wake));
+  pthread_mutex_destroy(&(the_pool->lock));
+  free(the_pool);
+  world->pool SET_TO NULL;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* run_queue
+
+Returned Value: void * (NULL)
+
+Called By:  run_pool (by way of pthread_create)
+
+Side Effects: This is where each thread but the main thread starts. It
+calls work_queue on the queue it is given.
+
+Notes:
+
+This is the one function that does not return int, because
+pthread_create requires a function that takes and returns void *.
+
+*/
+
+void * run_queue(       /* ARGUMENTS                     */
+ void * queue_pointer)  /* queue of thread, as a void *  */
+{
+  work_queue((struct queue *)queue_pointer);
+  return NULL;
+}
+
+/*************************************************************************/
+
+/* run_task
+
+Returned Value: int (OK)
+
+Called By:  work_queue
+
+Side Effects: This gives the world of the task the trail of the thread,
+emptied first, and calls solve_problem on that world, unless the
+search has been cancelled. The task is freed before returning.
+
+Notes:
+
+Any answers are saved by solve_problem (see save_answer), so ERROR from
+solve_problem means only that this branch of the search found none, and
+it is not passed on.
+
+*/
+
+int run_task(                 /* ARGUMENTS              */
+ struct queue * the_queue,    /* queue of thread        */
+ struct paint_world * task)   /* task to run            */
+{
+  const char * name SET_TO "run_task";
+
+  task->trail SET_TO the_queue->trail;
+  task->trail->number_changes SET_TO 0;
+  task->worker SET_TO the_queue->worker;
+  if (__atomic_load_n(&(the_queue->pool->cancel), __ATOMIC_ACQUIRE) IS 0)
+    solve_problem(task);
+  free(task);
+  return OK;
+}
+
+/*************************************************************************/
+
+/* save_answer
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. There is no memory for a longer list of answers: "Out of memory".
+  2. clone_world returns ERROR.
+
+Called By:  solve_problem
+
+Side Effects: This saves a copy of the solved world in the list of
+answers of the pool, making the list longer if it is full. If only one
+answer is wanted, the search is cancelled, and answers found by other
+threads before they notice are not saved.
+
+*/
+
+int save_answer(             /* ARGUMENTS            */
+ struct paint_world * world) /* puzzle model, solved */
+{
+  const char * name SET_TO "save_answer";
+  struct paint_world * answer;   /* copy of world to save          */
+  struct paint_world ** answers; /* longer list of answers         */
+  struct pool * the_pool;        /* pool of threads                */
+  int result;                    /* ERROR if list not made longer  */
+
+  the_pool SET_TO world->pool;
+  IFF(clone_world(&answer, world));
+  result SET_TO OK;
+  pthread_mutex_lock(&(the_pool->lock));
+  if (the_pool->number_answers IS the_pool->size_answers)
+    {
+      answers SET_TO (struct paint_world **)
+	realloc(the_pool->answers,
+		((2 * the_pool->size_answers) + 16) *
+		sizeof(struct paint_world *));
+      if (answers IS NULL)
+	result SET_TO ERROR;
+      else
+	{
+	  the_pool->answers SET_TO answers;
+	  the_pool->size_answers SET_TO ((2 * the_pool->size_answers) + 16);
+	}
+    }
+  if ((result IS OK) AND
+      (world->find_all OR (the_pool->number_answers IS 0)))
+    {
+      the_pool->answers[the_pool->number_answers++] SET_TO answer;
+      answer SET_TO NULL;
+    }
+  if (world->find_all IS 0)
+    __atomic_store_n(&(the_pool->cancel), 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&(the_pool->lock));
+  free(answer);
+  CHB((result ISNT OK), "Out of memory");
+  return OK;
+}
+
+/*************************************************************************/
+
+/* settle_strip
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. The blocks of a_strip cannot be placed: "puzzle has no answer".
+  2. mark_empty_square returns ERROR.
+  3. enx_square returns ERROR.
+
+Called By:  try_one_strip
+
+Side Effects: In a_strip, each blank square that no placement of the
+blocks covers is marked empty, and each blank square that every
+placement of the blocks covers is marked full. A placement puts each
+block inside its patch, in order, with at least one square between
+blocks, on no empty square, and covering every full square.
+
+Notes:
+
+This does in one pass what trying each blank square full and empty
+with find_min_starts would do, but in time proportional to the length
+of the strip times the number of patches.
+
+It works on two tables. left[pat][index2] is 1 if the first pat blocks
+can be placed in the squares before index2, and right[pat][index2] is
+1 if the blocks from pat on can be placed in the squares from index2
+on. A block can be at a place if the squares it covers are not empty,
+the squares just before and after it are not full, and the blocks
+before it fit in left and the blocks after it fit in right. A square
+can be empty if it is not full and, for some pat, the first pat blocks
+fit before it and the rest fit after it.
+
+dots[index2] and exes[index2] are the numbers of empty and of full
+squares before index2, so whether a block may cover a run of squares
+is found by subtracting. Counting up in covers from where each possible
+block starts and down from where it ends gives, by summing, whether any
+possible block covers each square.
+
+*/
+
+int settle_strip(            /* ARGUMENTS                             */
+ int index1,                 /* index of the strip containing a_strip */
+ int stop,                   /* length of a_strip                     */
+ struct strip * a_strip,     /* the strip being settled               */
+ struct paint_world * world) /* puzzle model                          */
+{
+  const char * name SET_TO "settle_strip";
+  char * line;               /* squares of a_strip                     */
+  int dots[MAX_STRIP_SIZE + 1]; /* number of empty squares before index */
+  int exes[MAX_STRIP_SIZE + 1]; /* number of full squares before index  */
+  char left[MAX_STRIP_BLOCKS + 1][MAX_STRIP_SIZE + 1];
+  char right[MAX_STRIP_BLOCKS + 1][MAX_STRIP_SIZE + 1];
+  int covers[MAX_STRIP_SIZE + 1]; /* change in possible blocks covering */
+  int last;                   /* number of patches in a_strip           */
+  int index2;
+  int pat;
+  int start;
+  int end;                    /* index just after block                 */
+  int fits;
+  int can_be_empty;
+  int covered;
+  struct patch * a_patch;
+
+  IFF(get_line(index1, &line, world));
+  last SET_TO a_strip->number_patches;
+  dots[0] SET_TO 0;
+  exes[0] SET_TO 0;
+  right[0][0] SET_TO 0;
+  for (index2 SET_TO 0; index2 < stop; index2++)
+    {
+      dots[index2 + 1] SET_TO (dots[index2] + (line[index2] IS '.'));
+      exes[index2 + 1] SET_TO (exes[index2] + (line[index2] IS 'X'));
+      covers[index2] SET_TO 0;
+    }
+  covers[stop] SET_TO 0;
+  for (index2 SET_TO 0; index2 <= stop; index2++)
+    left[0][index2] SET_TO (exes[index2] IS 0);
+  for (pat SET_TO 1; pat <= last; pat++)
+    {
+      a_patch SET_TO &(a_strip->patches[pat - 1]);
+      left[pat][0] SET_TO 0;
+      for (index2 SET_TO 1; index2 <= stop; index2++)
+	{
+	  start SET_TO (index2 - a_patch->target);
+	  fits SET_TO
+	    ((start >= 0) AND (start >= a_patch->start) AND
+	     (index2 <= (a_patch->end + 1)) AND (dots[index2] IS dots[start]) AND
+	     ((start IS 0) ? (pat IS 1) :
+	      ((line[start - 1] ISNT 'X') AND left[pat - 1][start - 1])));
+	  left[pat][index2] SET_TO
+	    (fits OR (left[pat][index2 - 1] AND (line[index2 - 1] ISNT 'X')));
+	}
+    }
+  for (index2 SET_TO 0; index2 <= stop; index2++)
+    right[last][index2] SET_TO (exes[stop] IS exes[index2]);
+  for (pat SET_TO (last - 1); pat > -1; pat--)
+    {
+      a_patch SET_TO &(a_strip->patches[pat]);
+      right[pat][stop] SET_TO 0;
+      for (index2 SET_TO (stop - 1); index2 > -1; index2--)
+	{
+	  end SET_TO (index2 + a_patch->target);
+	  fits SET_TO
+	    ((index2 >= a_patch->start) AND (end <= (a_patch->end + 1)) AND
+	     (end <= stop) AND (dots[end] IS dots[index2]) AND
+	     ((end IS stop) ? (pat IS (last - 1)) :
+	      ((line[end] ISNT 'X') AND right[pat + 1][end + 1])));
+	  right[pat][index2] SET_TO
+	    (fits OR (right[pat][index2 + 1] AND (line[index2] ISNT 'X')));
+	}
+    }
+  CHK((NOT right[0][0]), "puzzle has no answer");
+  for (pat SET_TO 0; pat < last; pat++)
+    {
+      a_patch SET_TO &(a_strip->patches[pat]);
+      for (start SET_TO max(a_patch->start, 0); start < stop; start++)
+	{
+	  end SET_TO (start + a_patch->target);
+	  if ((end > stop) OR (end > (a_patch->end + 1)))
+	    break;
+	  if ((dots[end] IS dots[start]) AND
+	      ((start IS 0) ? (pat IS 0) :
+	       ((line[start - 1] ISNT 'X') AND left[pat][start - 1])) AND
+	      ((end IS stop) ? (pat IS (last - 1)) :
+	       ((line[end] ISNT 'X') AND right[pat + 1][end + 1])))
+	    {
+	      covers[start]++;
+	      covers[end]--;
+	    }
+	}
+    }
+  covered SET_TO 0;
+  for (index2 SET_TO 0; index2 < stop; index2++)
+    {
+      covered SET_TO (covered + covers[index2]);
+      if (line[index2] ISNT ' ')
+	continue;
+      can_be_empty SET_TO 0;
+      for (pat SET_TO 0; pat <= last; pat++)
+	{
+	  if (left[pat][index2] AND right[pat][index2 + 1])
+	    {
+	      can_be_empty SET_TO 1;
+	      break;
+	    }
+	}
+      if (covered IS 0)
+	{
+	  IFF(mark_empty_square(index1, index2, world));
+	}
+      else if (NOT can_be_empty)
+	{
+	  IFF(enx_square(index1, index2, world));
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
 /* shift_patches_left
 
 Returned Value: int
@@ -3305,9 +4162,11 @@ Returned Value: int
   8. try_full_bounded returns ERROR.
   9. try_guessing returns ERROR.
  10. try_one returns ERROR.
+ 11. save_answer returns ERROR.
 
 Called By:
   main
+  run_task
   try_guessing
 
 Side Effects: This goes through a loop repeatedly.
@@ -3331,7 +4190,8 @@ If none of the methods marks a square, the loop is exited.  This
 happens if either (a) the puzzle is done or (b) the puzzle is not
 done, but none of the methods is able to make progress.  If the puzzle
 is not done, try_guessing is called. If the puzzle is done, the
-answer is printed.
+answer is printed, or saved to be printed later if threads are
+searching (see save_answer).
 
 Notes:
 
@@ -3437,8 +4297,13 @@ int solve_problem(           /* ARGUMENTS    */
     }
   if (world->undone IS 0)
     {
-      IFF(print_paint(world));
-      IFF(explain_paint(world));
+      if (world->pool)
+	IFF(save_answer(world));
+      else
+	{
+	  IFF(print_paint(world));
+	  IFF(explain_paint(world));
+	}
     }
   else
     {
@@ -3449,6 +4314,251 @@ int solve_problem(           /* ARGUMENTS    */
 
 /*************************************************************************/
 
+/* sort_answers
+
+Returned Value: int (OK)
+
+Called By:  run_pool
+
+Side Effects: This sorts the answers in the pool into the order in
+which a single thread would have found them, by comparing the paths of
+guesses that led to them (see path_before).
+
+Notes:
+
+This is an insertion sort, so answers with the same path stay in the
+order in which they were found. The answers are usually nearly in
+order already.
+
+*/
+
+int sort_answers(          /* ARGUMENTS          */
+ struct pool * the_pool)   /* pool of threads    */
+{
+  const char * name SET_TO "sort_answers";
+  struct paint_world * answer; /* answer being inserted             */
+  int before;                  /* 1 if answer goes before other one */
+  int m;
+  int n;
+
+  for (n SET_TO 1; n < the_pool->number_answers; n++)
+    {
+      answer SET_TO the_pool->answers[n];
+      for (m SET_TO n; m > 0; m--)
+	{
+	  path_before(answer, the_pool->answers[m - 1], &before);
+	  if (before IS 0)
+	    break;
+	  the_pool->answers[m] SET_TO the_pool->answers[m - 1];
+	}
+      the_pool->answers[m] SET_TO answer;
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* take_task
+
+Returned Value: int (OK)
+
+Called By:  work_queue
+
+Side Effects: This takes a task off a queue and sets *task to it, or
+sets *task to NULL if every queue is empty. The task most recently
+added to the given queue is taken if there is one. Otherwise, the
+oldest task on some other queue is taken.
+
+Notes:
+
+The lock on the pool must be held when this is called.
+
+Taking the newest task from a thread's own queue keeps the thread
+working on the part of the search tree it has most recently opened.
+Taking the oldest task from another queue takes a task from near the
+top of the tree, which is likely to be a big piece of work.
+
+*/
+
+int take_task(                 /* ARGUMENTS                    */
+ struct queue * the_queue,     /* queue of thread wanting task */
+ struct paint_world ** task)   /* set here to task taken       */
+{
+  const char * name SET_TO "take_task";
+  struct pool * the_pool; /* pool of threads          */
+  struct queue * other;   /* queue to take task from  */
+  int n;
+
+  the_pool SET_TO the_queue->pool;
+  *task SET_TO NULL;
+  if (the_queue->number_tasks > 0)
+    {
+      the_queue->number_tasks--;
+      *task SET_TO the_queue->tasks[(the_queue->first +
+				     the_queue->number_tasks) % MAX_TASKS];
+    }
+  for (n SET_TO 1; ((*task IS NULL) AND (n < the_pool->number_threads)); n++)
+    {
+      other SET_TO &(the_pool->queues[(the_queue->worker + n) %
+				      the_pool->number_threads]);
+      if (other->number_tasks > 0)
+	{
+	  *task SET_TO other->tasks[other->first];
+	  other->first SET_TO ((other->first + 1) % MAX_TASKS);
+	  other->number_tasks--;
+	}
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* touch_square
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. touch_strip returns ERROR.
+
+Called By:
+  enx_square
+  mark_empty_square
+
+Side Effects: The row and the column in which the square at
+[index1, index2] (for world->use_rows or at [index2, index1] for not
+world->use_rows) lies are touched.
+
+*/
+
+int touch_square(            /* ARGUMENTS              */
+ int index1,                 /* first index of square  */
+ int index2,                 /* second index of square */
+ struct paint_world * world) /* puzzle model           */
+{
+  const char * name SET_TO "touch_square";
+
+  if (world->use_rows)
+    {
+      IFF(touch_strip(&(world->rows[index1]), world));
+      IFF(touch_strip(&(world->cols[index2]), world));
+    }
+  else
+    {
+      IFF(touch_strip(&(world->cols[index1]), world));
+      IFF(touch_strip(&(world->rows[index2]), world));
+    }
+  return OK;
+}
+
+/*************************************************************************/
+
+/* touch_strip
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. trail_number returns ERROR.
+
+Called By:
+  mark_patches_strip
+  touch_square
+  try_guessing
+
+Side Effects: The clock of the world is moved on by one, and the time
+on it is recorded as the time a_strip changed, so that every rule that
+works on one strip at a time looks at a_strip again (see QUEUED). The
+time a_strip changed before is recorded on the trail first.
+
+*/
+
+int touch_strip(             /* ARGUMENTS              */
+ struct strip * a_strip,     /* the strip that changed */
+ struct paint_world * world) /* puzzle model           */
+{
+  const char * name SET_TO "touch_strip";
+
+  IFF(trail_number(&(a_strip->changed), world));
+  world->clock++;
+  a_strip->changed SET_TO world->clock;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* trail_number
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. add_change returns ERROR.
+
+Called By:
+  logic_ok
+  mark_patches_strip
+  move_patches
+  touch_strip
+  try_guessing
+
+Side Effects: This records the current value of the given counter on
+the trail so that undo_trail can restore it.
+
+Notes:
+
+This must be called before the counter is changed, not after.
+
+*/
+
+int trail_number(            /* ARGUMENTS                       */
+ int * number,               /* counter that is about to change */
+ struct paint_world * world) /* puzzle model                    */
+{
+  const char * name SET_TO "trail_number";
+  struct change * the_change;
+
+  IFF(add_change(&the_change, world));
+  the_change->number SET_TO number;
+  the_change->value SET_TO *number;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* trail_square
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. add_change returns ERROR.
+
+Called By:  put_square
+
+Side Effects: This records the current character in the square at the
+given row and column on the trail so that undo_trail can restore it.
+
+Notes:
+
+This must be called before the square is changed, not after.
+
+*/
+
+int trail_square(            /* ARGUMENTS              */
+ int row,                    /* row index of square    */
+ int col,                    /* column index of square */
+ struct paint_world * world) /* puzzle model           */
+{
+  const char * name SET_TO "trail_square";
+  struct change * the_change;
+
+  IFF(add_change(&the_change, world));
+  the_change->number SET_TO NULL;
+  the_change->row SET_TO row;
+  the_change->col SET_TO col;
+  the_change->value SET_TO world->squares[row][col];
+  return OK;
+}
+
+/*************************************************************************/
+
 /* try_block
 
 Returned Value: int
@@ -3463,7 +4573,8 @@ Side Effects: For each strip of the puzzle, if a block of squares is
 as long as the largest target of the strip that might cover it, dots
 are placed at the ends of the block. Also, if the block is shorter
 than the minimum target of the strip that might cover it, the ends of
-the block are extended, if possible.
+the block are extended, if possible. Only the strips touched since
+try_block last started are looked at (see QUEUED).
 
 Notes:
 
@@ -3486,19 +4597,24 @@ int try_block(               /* ARGUMENTS    */
   const char * name SET_TO "try_block";
   int row;
   int col;
+  int rule_clock; /* clock when rule started */
 
+  rule_clock SET_TO world->clock;
   world->number_in_rows SET_TO 0;
   world->use_rows SET_TO 1;
   for (row SET_TO 0; row < world->number_rows; row++)
-    if (world->rows[row].undone)
+    if (world->rows[row].undone AND
+	QUEUED(RULE_BLOCK, world->rows[row]))
       IFF(mark_block_strip
 	  (row, world->number_cols, &(world->rows[row]), world));
   world->number_in_cols SET_TO 0;
   world->use_rows SET_TO 0;
   for (col SET_TO 0; col < world->number_cols; col++)
-    if (world->cols[col].undone)
+    if (world->cols[col].undone AND
+	QUEUED(RULE_BLOCK, world->cols[col]))
       IFF(mark_block_strip
 	  (col, world->number_rows, &(world->cols[col]), world));
+  world->clean[RULE_BLOCK] SET_TO rule_clock;
   IFF(record_progress("mark empty or full squares for block in ", world));
   return OK;
 }
@@ -3515,7 +4631,8 @@ Returned Value: int
   3. mark_strip returns ERROR.
   4. copy_strip returns ERROR.
   5. find_min_starts returns ERROR.
-  6. mark_empty_square returns ERROR.
+  6. undo_trail returns ERROR.
+  7. mark_empty_square returns ERROR.
 
 Called By:  try_corners
 
@@ -3543,10 +4660,12 @@ int try_corner_col(          /* ARGUMENTS                           */
   int size;                  /* length of patch                     */
   int marked;
   int found;
+  int mark;                  /* number of changes on trail before test */
   struct strip strip_copy;
 
   stop_row SET_TO ((i IS 1) ? -1 : world->number_rows);
   stop_col SET_TO ((j IS 1) ? -1 : world->number_cols);
+  size SET_TO 0;
   for (length SET_TO 0;
        ((get_square((row + length), (col - j), world) IS '.') AND
 	(get_square((row + length), col, world) IS ' '));
@@ -3575,6 +4694,7 @@ int try_corner_col(          /* ARGUMENTS                           */
 	IFF(find_first_undone_target(&(world->cols[col]), &size, world));
       else
 	IFF(find_last_undone_target(&(world->cols[col]), &size, world));
+      mark SET_TO world->trail->number_changes;
       world->use_rows SET_TO 0;
       IFF(mark_strip((col + j), col, row, save_col, min(size, length), &marked,
 		     world->rows, i, world));
@@ -3587,8 +4707,7 @@ int try_corner_col(          /* ARGUMENTS                           */
 	      ((col + j), world->number_rows, &strip_copy, &found, world));
 	  world->use_rows SET_TO 1;
 	}
-      for (n SET_TO 0; n < min(size, length); n++)
-	put_square((row + (n * i)), (col + j), save_col[n], world);
+      IFF(undo_trail(mark, world));
       if ((NOT marked) OR (NOT found))
 	IFF(mark_empty_square(row, col, world));
     }
@@ -3607,7 +4726,8 @@ Returned Value: int
   3. mark_strip returns ERROR.
   4. copy_strip returns ERROR.
   5. find_min_starts returns ERROR.
-  6. mark_empty_square returns ERROR.
+  6. undo_trail returns ERROR.
+  7. mark_empty_square returns ERROR.
 
 Called By:  try_corners
 
@@ -3635,10 +4755,12 @@ int try_corner_row(          /* ARGUMENTS                           */
   int size;                  /* length of patch                     */
   int marked;
   int found;
+  int mark;                  /* number of changes on trail before test */
   struct strip strip_copy;
 
   stop_row SET_TO ((i IS 1) ? -1 : world->number_rows);
   stop_col SET_TO ((j IS 1) ? -1 : world->number_cols);
+  size SET_TO 0;
   for (length SET_TO 0;
        ((get_square((row - i), (col + length), world) IS '.') AND
 	(get_square(row, (col + length), world) IS ' '));
@@ -3667,6 +4789,7 @@ int try_corner_row(          /* ARGUMENTS                           */
 	IFF(find_first_undone_target(&(world->rows[row]), &size, world));
       else
 	IFF(find_last_undone_target(&(world->rows[row]), &size, world));
+      mark SET_TO world->trail->number_changes;
       IFF(mark_strip((row + i), row, col, save_row, min(size, length), &marked,
 		     world->cols, j, world));
       if (marked)
@@ -3675,8 +4798,7 @@ int try_corner_row(          /* ARGUMENTS                           */
 	  IFF(find_min_starts
 	      ((row + i), world->number_cols, &strip_copy, &found, world));
 	}
-      for (n SET_TO 0; n < min(size, length); n++)
-	put_square((row + i), (col + (n * j)), save_row[n], world);
+      IFF(undo_trail(mark, world));
       if ((NOT marked) OR (NOT found))
 	IFF(mark_empty_square(row, col, world));
     }
@@ -4066,6 +5188,7 @@ Returned Value: int
   1. find_min_starts returns ERROR.
   2. copy_strip returns ERROR.
   3. mark_strip returns ERROR.
+  4. undo_trail returns ERROR.
 
 Called By:  try_edge_square_col
 
@@ -4090,9 +5213,10 @@ int try_edge_test_col( /* ARGUMENTS                                     */
   char save_col[MAX_NUMBER_ROWS];
   int marked;
   int found;
+  int mark;      /* number of changes on trail before test */
   struct strip strip_copy;
-  int n;
 
+  mark SET_TO world->trail->number_changes;
   world->use_rows SET_TO 0;
   IFF(mark_strip
       (beside, col, row, save_col, size, &marked, world->rows, 1, world));
@@ -4103,8 +5227,7 @@ int try_edge_test_col( /* ARGUMENTS                                     */
 	  (beside, world->number_rows, &strip_copy, &found, world));
     }
   world->use_rows SET_TO 1;
-  for (n SET_TO 0; n < size; n++)
-    put_square((row + n), beside, save_col[n], world);
+  IFF(undo_trail(mark, world));
   if (marked AND found)
     *is_empty SET_TO 0;
   return OK;
@@ -4120,6 +5243,7 @@ Returned Value: int
   1. find_min_starts returns ERROR.
   2. copy_strip returns ERROR.
   3. mark_strip returns ERROR.
+  4. undo_trail returns ERROR.
 
 Called By:  try_edge_square_row
 
@@ -4144,9 +5268,10 @@ int try_edge_test_row( /* ARGUMENTS                                     */
   char save_row[MAX_NUMBER_COLS];
   int marked;
   int found;
+  int mark;      /* number of changes on trail before test */
   struct strip strip_copy;
-  int n;
 
+  mark SET_TO world->trail->number_changes;
   IFF(mark_strip
       (beside, row, col, save_row, size, &marked, world->cols, 1, world));
   if (marked)
@@ -4155,8 +5280,7 @@ int try_edge_test_row( /* ARGUMENTS                                     */
       IFF(find_min_starts
 	  (beside, world->number_cols, &strip_copy, &found, world));
     }
-  for (n SET_TO 0; n < size; n++)
-    put_square(beside, (col + n), save_row[n], world);
+  IFF(undo_trail(mark, world));
   if (marked AND found)
     *is_empty SET_TO 0;
   return OK;
@@ -4282,7 +5406,8 @@ Called By:  solve_problem
 
 Side Effects: squares of the puzzle certain to be empty because they
 are part of a blank block between two empty squares that is too small
-to fit any available patch are marked empty.
+to fit any available patch are marked empty. Only the strips touched
+since try_empty_no_room last started are looked at (see QUEUED).
 
 */
 
@@ -4292,19 +5417,24 @@ int try_empty_no_room(        /* ARGUMENTS    */
   const char * name SET_TO "try_empty_no_room";
   int row;
   int col;
+  int rule_clock; /* clock when rule started */
 
+  rule_clock SET_TO world->clock;
   world->number_in_rows SET_TO 0;
   world->use_rows SET_TO 1;
   for (row SET_TO 0; row < world->number_rows; row++)
-    if (world->rows[row].undone)
+    if (world->rows[row].undone AND
+	QUEUED(RULE_EMPTY_NO_ROOM, world->rows[row]))
       IFF(mark_empty_strip2
 	  (row, world->number_cols, &(world->rows[row]), world));
   world->number_in_cols SET_TO 0;
   world->use_rows SET_TO 0;
   for (col SET_TO 0; col < world->number_cols; col++)
-    if (world->cols[col].undone)
+    if (world->cols[col].undone AND
+	QUEUED(RULE_EMPTY_NO_ROOM, world->cols[col]))
       IFF(mark_empty_strip2
 	  (col, world->number_rows, &(world->cols[col]), world));
+  world->clean[RULE_EMPTY_NO_ROOM] SET_TO rule_clock;
   IFF(record_progress("mark empty squares where no room in ", world));
   return OK;
 }
@@ -4322,7 +5452,9 @@ Returned Value: int
 Called By:  solve_problem
 
 Side Effects: squares of the puzzle certain to be empty because they
-lie outside the bounds of any patch in a strip are marked empty.
+lie outside the bounds of any patch in a strip are marked empty. Only
+the strips touched since try_empty_outside last started are looked at
+(see QUEUED).
 
 */
 
@@ -4332,19 +5464,24 @@ int try_empty_outside(       /* ARGUMENTS    */
   const char * name SET_TO "try_empty_outside";
   int row;
   int col;
+  int rule_clock; /* clock when rule started */
 
+  rule_clock SET_TO world->clock;
   world->number_in_rows SET_TO 0;
   world->use_rows SET_TO 1;
   for (row SET_TO 0; row < world->number_rows; row++)
-    if (world->rows[row].undone)
+    if (world->rows[row].undone AND
+	QUEUED(RULE_EMPTY_OUTSIDE, world->rows[row]))
       IFF(mark_empty_strip
 	  (row, world->number_cols, &(world->rows[row]), world));
   world->number_in_cols SET_TO 0;
   world->use_rows SET_TO 0;
   for (col SET_TO 0; col < world->number_cols; col++)
-    if (world->cols[col].undone)
+    if (world->cols[col].undone AND
+	QUEUED(RULE_EMPTY_OUTSIDE, world->cols[col]))
       IFF(mark_empty_strip
 	  (col, world->number_rows, &(world->cols[col]), world));
+  world->clean[RULE_EMPTY_OUTSIDE] SET_TO rule_clock;
   IFF(record_progress("mark surely empty squares in ", world));
   return OK;
 }
@@ -4363,7 +5500,8 @@ Called By:  solve_problem
 
 Side Effects: The start and end of each patch of each strip (row or
 column) are marked. Any squares between the start and end of a patch
-that must be full are marked full.
+that must be full are marked full. Only the strips touched since
+try_full_bounded last started are looked at (see QUEUED).
 
 */
 
@@ -4373,11 +5511,14 @@ int try_full_bounded(        /* ARGUMENTS      */
   const char * name SET_TO "try_full_bounded";
   int row;
   int col;
+  int rule_clock; /* clock when rule started */
 
+  rule_clock SET_TO world->clock;
   world->number_in_rows SET_TO 0;
   world->use_rows SET_TO 1;
   for (row SET_TO 0; row < world->number_rows; row++)
-    if (world->rows[row].undone)
+    if (world->rows[row].undone AND
+	QUEUED(RULE_FULL_BOUNDED, world->rows[row]))
       {
 	IFF(mark_patches_strip
 	    (row, world->number_cols, &(world->rows[row]), world));
@@ -4385,11 +5526,13 @@ int try_full_bounded(        /* ARGUMENTS      */
   world->number_in_cols SET_TO 0;
   world->use_rows SET_TO 0;
   for (col SET_TO 0; col < world->number_cols; col++)
-    if (world->cols[col].undone)
+    if (world->cols[col].undone AND
+	QUEUED(RULE_FULL_BOUNDED, world->cols[col]))
       {
 	IFF(mark_patches_strip
 	    (col, world->number_rows, &(world->cols[col]), world));
       }
+  world->clean[RULE_FULL_BOUNDED] SET_TO rule_clock;
   IFF(record_progress("mark surely full squares and empties in ", world));
   return OK;
 }
@@ -4402,18 +5545,37 @@ Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
   1. find_best_patch returns ERROR.
-  2. copy_world returns ERROR.
-  3. mark_patches_strip returns ERROR.
-  4. record_progress returns ERROR.
-  5. put_logic returns ERROR.
+  2. undo_trail returns ERROR.
+  3. copy_strip returns ERROR.
+  4. shift_patches_right returns ERROR.
+  5. shift_patches_left returns ERROR.
+  6. trail_number returns ERROR.
+  7. move_patches returns ERROR.
+  8. touch_strip returns ERROR.
+  9. put_logic returns ERROR.
+ 10. record_progress returns ERROR.
+ 11. balanced returns ERROR.
+ 12. queue_world returns ERROR.
+ 13. No guess followed up here leads to an answer.
 
 Called By:  solve_problem
 
 Side Effects:
 
-This finds the best patch to guess. Then it makes copies of the
-world with that patch done in each possible position of the block
-in the patch. It tries to solve each copy.
+This finds the best patch to guess. Then, for each possible position
+of the block in the patch, it makes that patch done in that position
+and tries to solve the puzzle. Each guess is taken back (see
+undo_trail) before the next one is made and before this returns, so
+the world is left as it was found.
+
+If threads are searching and the guess is made at a depth less than
+SPLIT_DEPTH, a copy of the world with the guess made is put on the
+queue of the thread as a task (see queue_world) instead of being
+followed up here, unless the queue is full. The start of the block is
+recorded in the path of the world first, so that the answers can be put
+in order (see sort_answers). The depth and space of each guess are not
+printed, since the threads would print them mixed together. Once one
+answer is found when only one is wanted, no more guesses are made.
 
 A position of the block in the patch will not be possible if any of
 the following obtains:
@@ -4444,7 +5606,15 @@ To insert a guess, this only moves the start and end of the patch for
 which the guess is being made. When solve_problem runs again,
 try_full_bounded will insert X's if needed. This means that the
 appearance of the puzzle does not change when it is announced that a
-guess has been made.
+guess has been made. The strip of the guess is touched so that the
+rules look at it. The patches are shifted in a copy of the strip, so
+that a guess that cannot be made changes nothing.
+
+The depth, the clock, and the times at which the rules last started
+are put on the trail when a guess is made, so they are put back with
+it. The space is a double, which cannot go on the trail, so it is kept
+here. When a guess is taken back, the last position of each logic
+line from world->logic_line on is set back to 0 (see logic_ok).
 
 The "many" variable is decremented after being used so that the printed
 number is an estimate of the size of the space remaining to be searched.
@@ -4459,29 +5629,46 @@ int try_guessing(            /* ARGUMENTS      */
   int is_row;             /* set to 1 if selected strip is row, to 0 if col */
   int patch_index;        /* index in strip of patch selected for guessing  */
   struct patch * a_patch; /* the patch selected for guessing                */
-  struct paint_world * world_copy;
+  struct strip * a_strip; /* the strip selected for guessing                */
+  struct strip new_strip; /* a_strip with the guess made                    */
   int stop;
   int result;
   int return_value;
   int start;
   int n;
   int shifted;
+  int moved;
+  int queued;         /* set to 1 if guess put on queue as a task          */
+  int mark;           /* number of changes on trail before guesses         */
+  int last;           /* index of last character of a logic line           */
+  double space;       /* world->space before guesses                       */
   int many;           /* number of remaining choices of where to put guess */
   char buffer[TEXT_SIZE];
 
   return_value SET_TO ERROR;
-  world_copy SET_TO (worlds + world->depth + 1);
+  last SET_TO TEXT_SIZE;
+  last SET_TO (last - 1);
+  mark SET_TO world->trail->number_changes;
+  space SET_TO world->space;
   IFF(find_best_patch(&strip_index, &is_row, &patch_index, &many, world));
   if (is_row)
-    a_patch SET_TO &(world->rows[strip_index].patches[patch_index]);
+    a_strip SET_TO &(world->rows[strip_index]);
   else
-    a_patch SET_TO &(world->cols[strip_index].patches[patch_index]);
+    a_strip SET_TO &(world->cols[strip_index]);
+  a_patch SET_TO &(a_strip->patches[patch_index]);
   stop SET_TO ((a_patch->end + 2) - a_patch->target);
   for (start SET_TO a_patch->start; start < stop; start++)
     {
+      if (world->pool AND
+	  __atomic_load_n(&(world->pool->cancel), __ATOMIC_ACQUIRE))
+	break;
+      IFF(undo_trail(mark, world));
+      world->space SET_TO space;
+      for (n SET_TO world->logic_line; n < MAX_LOGIC; n++)
+	world->logic[n][last] SET_TO 0;
+      world->use_rows SET_TO 1;
       if (is_row)
 	{
-	  world->use_rows SET_TO 1;
 	  for (n SET_TO 0; n < a_patch->target; n++)
 	    if (get_square(strip_index, (start + n), world) IS '.')
 	      break;
@@ -4489,27 +5676,12 @@ int try_guessing(            /* ARGUMENTS      */
 	      (get_square(strip_index, (start - 1), world) IS 'X') OR
 	      (get_square(strip_index, (start + n), world) IS 'X'))
 	    continue;
-	  IFF(copy_world(world_copy, world));
-	  world_copy->number_in_rows SET_TO 0;
-	  world_copy->number_in_cols SET_TO 0;
+	  IFF(copy_strip(&new_strip, a_strip, world));
 	  IFF(shift_patches_right(patch_index, start, world->number_cols,
-				  &shifted, &(world_copy->rows[strip_index])));
-	  if (NOT shifted)
-	    continue;
-	  IFF(shift_patches_left(patch_index, (start + (a_patch->target - 1)),
-				 &shifted, &(world_copy->rows[strip_index])));
-	  if (NOT shifted)
-	    continue;
-	  IFF(put_logic(strip_index, world_copy));
-	  world_copy->use_rows SET_TO 0;
-	  IFF(put_logic(start, world_copy));
-	  world_copy->use_rows SET_TO 1;
-	  sprintf
-	    (buffer, "guess block %d of row starts at ", (patch_index + 1));
+				  &shifted, &new_strip));
 	}
       else
 	{
-	  world->use_rows SET_TO 1;
 	  for (n SET_TO 0; n < a_patch->target; n++)
 	    if (get_square((start + n), strip_index, world) IS '.')
 	      break;
@@ -4517,32 +5689,59 @@ int try_guessing(            /* ARGUMENTS      */
 	      (get_square((start - 1), strip_index, world) IS 'X') OR
 	      (get_square((start + n), strip_index, world) IS 'X'))
 	    continue;
-	  IFF(copy_world(world_copy, world));
-	  world_copy->number_in_rows SET_TO 0;
-	  world_copy->number_in_cols SET_TO 0;
+	  IFF(copy_strip(&new_strip, a_strip, world));
 	  IFF(shift_patches_right(patch_index, start, world->number_rows,
-				  &shifted, &(world_copy->cols[strip_index])));
-	  if (NOT shifted)
-	    continue;
-	  IFF(shift_patches_left(patch_index, (start + (a_patch->target - 1)),
-				 &shifted, &(world_copy->cols[strip_index])));
-	  if (NOT shifted)
-	    continue;
-	  IFF(put_logic(start, world_copy));
-	  world_copy->use_rows SET_TO 0;
-	  IFF(put_logic(strip_index, world_copy));
-	  world_copy->use_rows SET_TO 1;
+				  &shifted, &new_strip));
+	}
+      if (NOT shifted)
+	continue;
+      IFF(shift_patches_left(patch_index, (start + (a_patch->target - 1)),
+			     &shifted, &new_strip));
+      if (NOT shifted)
+	continue;
+      IFF(trail_number(&(world->depth), world));
+      IFF(trail_number(&(world->clock), world));
+      for (n SET_TO 0; n < NUMBER_RULES; n++)
+	IFF(trail_number(&(world->clean[n]), world));
+      IFF(move_patches(a_strip, &new_strip, &moved, world));
+      IFF(touch_strip(a_strip, world));
+      world->number_in_rows SET_TO 0;
+      world->number_in_cols SET_TO 0;
+      if (is_row)
+	{
+	  IFF(put_logic(strip_index, world));
+	  world->use_rows SET_TO 0;
+	  IFF(put_logic(start, world));
+	  world->use_rows SET_TO 1;
+	  sprintf
+	    (buffer, "guess block %d of row starts at ", (patch_index + 1));
+	}
+      else
+	{
+	  IFF(put_logic(start, world));
+	  world->use_rows SET_TO 0;
+	  IFF(put_logic(strip_index, world));
+	  world->use_rows SET_TO 1;
 	  sprintf
 	    (buffer, "guess block %d of column starts at ", (patch_index + 1));
 	}
-      world_copy->progress_puzzle SET_TO 1;
-      world_copy->depth SET_TO (world->depth + 1);
-      world_copy->space SET_TO (world->space * many);
+      world->progress_puzzle SET_TO 1;
+      if (world->depth < SPLIT_DEPTH)
+	world->path[world->depth] SET_TO start;
+      world->depth SET_TO (world->depth + 1);
+      world->space SET_TO (space * many);
       many--;
-      printf("%d %.0lf\n", world_copy->depth, world_copy->space);
-      IFF(record_progress(buffer, world_copy));
-      IFF(balanced(world_copy));
-      result SET_TO solve_problem(world_copy);
+      if (world->pool IS NULL)
+	printf("%d %.0lf\n", world->depth, world->space);
+      IFF(record_progress(buffer, world));
+      IFF(balanced(world));
+      queued SET_TO 0;
+      if (world->pool AND (world->depth <= SPLIT_DEPTH))
+	IFF(queue_world(&queued, world));
+      if (queued)
+	result SET_TO ERROR;
+      else
+	result SET_TO solve_problem(world);
       if (result IS OK)
 	{
 	  return_value SET_TO OK;
@@ -4550,6 +5749,10 @@ int try_guessing(            /* ARGUMENTS      */
 	    break;
 	}
     }
+  IFF(undo_trail(mark, world));
+  world->space SET_TO space;
+  for (n SET_TO world->logic_line; n < MAX_LOGIC; n++)
+    world->logic[n][last] SET_TO 0;
   IFF(return_value);
   return OK;
 }
@@ -4568,13 +5771,15 @@ Called By:  solve_problem
 
 Side Effects: For each strip of the puzzle, if a blank square in the
 strip cannot be full, it is marked empty, and if it cannot be empty,
-it is marked full.
+it is marked full. Only the strips touched since try_one last started
+are looked at (see QUEUED).
 
 Notes:
 
-This is a time-consuming procedure, since every blank square of the
-puzzle is likely to be tested four times (row and column, full or
-empty) and the entire strip is copied and modified for each test.
+This was once the most time-consuming procedure, since every blank
+square of the puzzle was tested four times (row and column, full or
+empty) and the entire strip was copied and modified for each test.
+Now each strip is settled in one pass (see settle_strip).
 
 */
 
@@ -4584,17 +5789,22 @@ int try_one(                 /* ARGUMENTS    */
   const char * name SET_TO "try_one";
   int row;
   int col;
+  int rule_clock; /* clock when rule started */
 
+  rule_clock SET_TO world->clock;
   world->number_in_rows SET_TO 0;
   world->use_rows SET_TO 1;
   for (row SET_TO 0; row < world->number_rows; row++)
-    if (world->rows[row].undone)
+    if (world->rows[row].undone AND
+	QUEUED(RULE_ONE, world->rows[row]))
       IFF(try_one_strip(row, world->number_cols, &(world->rows[row]), world));
   world->number_in_cols SET_TO 0;
   world->use_rows SET_TO 0;
   for (col SET_TO 0; col < world->number_cols; col++)
-    if (world->cols[col].undone)
+    if (world->cols[col].undone AND
+	QUEUED(RULE_ONE, world->cols[col]))
       IFF(try_one_strip(col, world->number_rows, &(world->cols[col]), world));
+  world->clean[RULE_ONE] SET_TO rule_clock;
   IFF(record_progress("mark single empty or full squares in ", world));
   return OK;
 }
@@ -4606,11 +5816,8 @@ int try_one(                 /* ARGUMENTS    */
 Returned Value: int
   If any of the following errors occur, this returns ERROR.
   Otherwise, it returns OK.
-  1. copy_strip returns ERROR.
-  2. find_min_starts returns ERROR.
-  3. mark_empty_square returns ERROR.
-  4. enx_square returns ERROR.
-  5. put_logic returns ERROR.
+  1. settle_strip returns ERROR.
+  2. put_logic returns ERROR.
 
 Called By:  try_one
 
@@ -4618,16 +5825,18 @@ Side Effects: In a_strip, each blank square that cannot be full
 (because a_strip cannot be covered by its patches if it is full)
 is marked empty. Similarly, in a_strip, each square that cannot be
 empty (because a_strip cannot be covered by its patches if it is
-empty) is marked full.
+empty) is marked full. If any square is marked, a_strip is added to
+the strips on which progress has been made.
 
 Notes:
 
-This assumes without testing that if a square cannot be full it must
-be empty, and conversely. Thus, ill-formed puzzles where neither full
-nor empty works for a square will not be detected here.
+This used to copy the strip and run find_min_starts twice for each
+blank square, once with the square full and once with it empty. That
+was the bottleneck on Fujiwara's puzzles. settle_strip finds the same
+squares (and any that the ends of the patches show, too) in one pass.
 
-mark_empty_square requires square to be blank previously in "if(NOT found)".
-enx_square requires square to be blank previously in second "if(NOT found)".
+Since settle_strip finds whether the strip can be covered at all, a
+strip that cannot be covered either way is detected here.
 
 */
 
@@ -4638,42 +5847,119 @@ int try_one_strip(           /* ARGUMENTS                             */
  struct paint_world * world) /* puzzle model                          */
 {
   const char * name SET_TO "try_one_strip";
-  int index2;
-  struct strip test_strip;
-  char item;
-  int found;
 
   world->progress_strip SET_TO 0;
-  for (index2 SET_TO 0; index2 < stop; index2++)
+  IFF(settle_strip(index1, stop, a_strip, world));
+  if (world->progress_strip)
+    IFF(put_logic(index1, world));
+  return OK;
+}
+
+/*************************************************************************/
+
+/* undo_trail
+
+Returned Value: int
+  If any of the following errors occur, this returns ERROR.
+  Otherwise, it returns OK.
+  1. mark is larger than the number of changes on the trail:
+     "bad trail mark".
+
+Called By:
+  try_corner_col
+  try_corner_row
+  try_edge_test_col
+  try_edge_test_row
+  try_guessing
+
+Side Effects: This undoes, latest first, every change recorded on the
+trail after the first mark changes, and shortens the trail to mark
+changes. A square is put back in both world->squares and
+world->transpose.
+
+Notes:
+
+Nothing is touched here. The times at which the strips changed are
+put back with everything else, so the rules see the world as it was
+when the mark was made.
+
+*/
+
+int undo_trail(              /* ARGUMENTS                          */
+ int mark,                   /* number of changes to keep on trail */
+ struct paint_world * world) /* puzzle model                       */
+{
+  const char * name SET_TO "undo_trail";
+  struct change * the_change;
+  int n;
+
+  CHB((mark > world->trail->number_changes), "bad trail mark");
+  for (n SET_TO (world->trail->number_changes - 1); n >= mark; n--)
     {
-      item SET_TO get_square(index1, index2, world);
-      if (item IS ' ')
+      the_change SET_TO (world->trail->changes + n);
+      if (the_change->number)
+	*(the_change->number) SET_TO the_change->value;
+      else
 	{
-	  IFF(copy_strip(&test_strip, a_strip, world));
-	  put_square(index1, index2, 'X', world);
-	  IFF(find_min_starts(index1, stop, &test_strip, &found, world));
-	  if (NOT found)
-	    {
-	      put_square(index1, index2, ' ', world);
-	      IFF(mark_empty_square(index1, index2, world));
-	    }
-	  else
-	    {
-	      IFF(copy_strip(&test_strip, a_strip, world));
-	      put_square(index1, index2, '.', world);
-	      IFF(find_min_starts(index1, stop, &test_strip, &found, world));
-	      if (NOT found)
-		{
-		  put_square(index1, index2, ' ', world);
-		  IFF(enx_square(index1, index2, world));
-		}
-	      else
-		put_square(index1, index2, ' ', world);
-	    }
+	  world->squares[the_change->row][the_change->col] SET_TO
+	    (char)the_change->value;
+	  world->transpose[the_change->col][the_change->row] SET_TO
+	    (char)the_change->value;
 	}
     }
-  if (world->progress_strip)
-    IFF(put_logic(index1, world));
+  world->trail->number_changes SET_TO mark;
+  return OK;
+}
+
+/*************************************************************************/
+
+/* work_queue
+
+Returned Value: int (OK)
+
+Called By:
+  run_pool
+  run_queue
+
+Side Effects: This takes tasks (see take_task) and runs them (see
+run_task) until there are no tasks left on any queue and no task is
+being run by any thread. A thread that finds all queues empty while
+other threads are still running tasks waits until a task is added or
+the last task is finished.
+
+Notes:
+
+The lock on the pool is held except while a task is being run. The
+count of pending tasks includes those being run, since a running task
+may add more tasks.
+
+*/
+
+int work_queue(             /* ARGUMENTS         */
+ struct queue * the_queue)  /* queue of thread   */
+{
+  const char * name SET_TO "work_queue";
+  struct pool * the_pool;   /* pool of threads                  */
+  struct paint_world * task; /* task taken from a queue         */
+
+  the_pool SET_TO the_queue->pool;
+  pthread_mutex_lock(&(the_pool->lock));
+  for (; (the_pool->pending > 0); )
+    {
+      take_task(the_queue, &task);
+      if (task)
+	{
+	  pthread_mutex_unlock(&(the_pool->lock));
+	  run_task(the_queue, task);
+	  pthread_mutex_lock(&(the_pool->lock));
+	  the_pool->pending--;
+	  if (the_pool->pending IS 0)
+	    pthread_cond_broadcast(&(the_pool->wake));
+	}
+      else
+	pthread_cond_wait(&(the_pool->wake), &(the_pool->lock));
+    }
+  pthread_mutex_unlock(&(the_pool->lock));
   return OK;
 }
 